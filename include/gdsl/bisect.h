@@ -0,0 +1,65 @@
+#ifndef GDSL_BISECT_H
+#define GDSL_BISECT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "gdsl/merkle.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Replay divergence bisection.
+ *
+ * Two replays of one capture (old and new driver, two builds) agree up to
+ * some checkpoint and differ from there on. The first divergent checkpoint is
+ * found by binary search over the checkpoints, comparing only their
+ * heap_merkle_roots, which takes O(log n) comparisons. The pages that differ
+ * there are then found by descending the two page hash trees from the root
+ * into the subtrees whose hashes differ, so that no pages have to be compared
+ * or diffed.
+ *
+ * The search assumes that runs do not converge again after diverging. A run
+ * that does converge again is reported at some divergent checkpoint, but not
+ * necessarily at the first one.
+ */
+
+#define GDSL_BISECT_NONE SIZE_MAX
+
+/* Returns 1 when the two runs agree at checkpoint, 0 when they differ and
+ * -1 on error. */
+typedef int (*gdsl_bisect_probe_fn)(void *ctx, size_t checkpoint);
+
+/* Binary search over checkpoints [0, count) with probe. Sets *out_checkpoint
+ * to the first divergent checkpoint, or GDSL_BISECT_NONE when all agree.
+ * out_probes (optional) receives the number of probes made. */
+int gdsl_bisect_search(size_t count,
+                       gdsl_bisect_probe_fn probe,
+                       void *ctx,
+                       size_t *out_checkpoint,
+                       size_t *out_probes);
+
+/* gdsl_bisect_search over two recorded root sequences of count entries. */
+int gdsl_bisect_checkpoints(const gdsl_merkle_hash_t *roots_a,
+                            const gdsl_merkle_hash_t *roots_b,
+                            size_t count,
+                            size_t *out_checkpoint);
+
+/* Indices of the pages whose hashes differ between two trees of the same
+ * page size, in ascending order. Pages that only one heap has count as
+ * different. Like gdsl_read_changed_set, out_pages may be NULL to count
+ * only, and -1 is returned when more than max_pages differ (with *out_count
+ * set). */
+int gdsl_bisect_pages(const gdsl_merkle_tree_t *a,
+                      const gdsl_merkle_tree_t *b,
+                      size_t *out_pages,
+                      size_t max_pages,
+                      size_t *out_count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GDSL_BISECT_H
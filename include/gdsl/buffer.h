@@ -0,0 +1,57 @@
+#ifndef GDSL_BUFFER_H
+#define GDSL_BUFFER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Page-granular buffers for large diff payloads and patch outputs.
+ *
+ * Buffers are anonymous mappings, so no page is touched before the
+ * placement policy applies. Release them with gdsl_buffer_free, never free().
+ * Buffers of at least GDSL_BUFFER_HUGE_PAGE_SIZE are mapped 2 MiB aligned and
+ * rounded up to a whole number of huge pages.
+ */
+
+#define GDSL_BUFFER_HUGE_PAGE_SIZE ((size_t)2 << 20)
+
+/* Back the buffer with explicit huge pages (MAP_HUGETLB). Falls back to
+ * transparent huge pages when the hugetlb pool cannot satisfy it. */
+#define GDSL_BUFFER_HUGE_PAGES (1u << 0)
+/* Ask for transparent huge pages (madvise(MADV_HUGEPAGE)). */
+#define GDSL_BUFFER_TRANSPARENT_HUGE_PAGES (1u << 1)
+/* Pre-fault every page at allocation (MAP_POPULATE). Ignored with
+ * GDSL_NUMA_FIRST_TOUCH, where the owning workers fault the pages instead. */
+#define GDSL_BUFFER_POPULATE (1u << 2)
+/* The buffer is produced and consumed front to back (MADV_SEQUENTIAL). */
+#define GDSL_BUFFER_SEQUENTIAL (1u << 3)
+
+typedef enum {
+    /* Kernel default: pages land on whichever node faults them first. */
+    GDSL_NUMA_DEFAULT = 0,
+    /* Pages are spread round-robin over all online nodes. */
+    GDSL_NUMA_INTERLEAVE = 1,
+    /* Pages are first touched by the pool worker that owns their range, so
+     * they land on that worker's node (see gdsl_pool_parallel_for_static). */
+    GDSL_NUMA_FIRST_TOUCH = 2
+} gdsl_numa_policy_t;
+
+typedef struct {
+    gdsl_numa_policy_t numa_policy;
+    /* GDSL_BUFFER_* flags. */
+    uint32_t flags;
+} gdsl_buffer_options_t;
+
+uint8_t *gdsl_buffer_alloc(size_t length, const gdsl_buffer_options_t *options);
+
+void gdsl_buffer_free(uint8_t *buffer, size_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GDSL_BUFFER_H
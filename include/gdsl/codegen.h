@@ -0,0 +1,62 @@
+#ifndef GDSL_CODEGEN_H
+#define GDSL_CODEGEN_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "gdsl/verify.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Specialised verifier generator.
+ *
+ * Emits a standalone C99 verifier for a fixed opcode subset and conformance
+ * level. The transition tables are derived from the library's own rules by
+ * walking every state reachable from the initial one, so the generated code
+ * agrees with gdsl_verify on streams made of the chosen opcodes. Unreachable
+ * states and unused opcodes are dropped, and operand-size checks disappear
+ * when every chosen opcode is one byte wide. Bytes outside the subset are
+ * rejected as unknown opcodes. Multi-device opcodes (SET_DEVICE, SET_QUEUE,
+ * SEMAPHORE_SIGNAL/WAIT), binding opcodes (PIPE_BIND .. QUERY_END) and
+ * control opcodes (CONST_I32 .. ENDIF) need state a table cannot hold and
+ * are refused.
+ *
+ * The generated API is
+ *
+ *   int <prefix>_verify(const uint8_t *stream, size_t length,
+ *                       <prefix>_verify_result_t *result);
+ *
+ * returning -1 for invalid arguments and 0 otherwise, with counts and the
+ * first error in result.
+ */
+
+typedef struct {
+    gdsl_verify_level_t level;
+    /* Opcode values to support; duplicates are ignored. */
+    const uint8_t *opcodes;
+    size_t opcode_count;
+    /* C identifier prefix of the generated symbols. */
+    const char *prefix;
+    /* When set, the source includes this header (written to header_out) for
+     * the declarations instead of carrying them itself. */
+    const char *header_name;
+} gdsl_codegen_options_t;
+
+/* Writes the verifier source to source_out and, when header_name is set, its
+ * header to header_out. */
+int gdsl_codegen_verifier(const gdsl_codegen_options_t *options,
+                          FILE *source_out,
+                          FILE *header_out);
+
+/* Opcode value for a mnemonic such as "BARRIER", or -1. */
+int gdsl_codegen_opcode(const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GDSL_CODEGEN_H
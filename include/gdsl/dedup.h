@@ -0,0 +1,103 @@
+#ifndef GDSL_DEDUP_H
+#define GDSL_DEDUP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "gdsl/verify.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Canonical stream hashing and deduplication.
+ *
+ * The canonical hash covers a stream with its debug-only instructions (LABEL,
+ * MARKER_PUSH, MARKER_POP, LOG) removed. No rule reads those and none changes
+ * the verifier state, so streams with the same canonical hash get the same
+ * verdict and counts at every level; only instruction indices differ. It is a
+ * 128-bit non-cryptographic hash: fine for identifying recordings of one
+ * fleet, not a defence against crafted collisions.
+ *
+ * The dedup index maps a canonical hash to the stored copy of the stream, the
+ * verification certificates issued for it and the base it was diffed against.
+ * A pipeline admits each upload first; a duplicate comes back with the
+ * existing entry, so storing, verifying and diffing it again can be skipped.
+ * All index functions are thread-safe.
+ */
+
+typedef struct {
+    uint64_t lo;
+    uint64_t hi;
+} gdsl_stream_hash_t;
+
+int gdsl_stream_hash(const uint8_t *stream, size_t length, gdsl_stream_hash_t *out);
+
+/* No diff base recorded. */
+#define GDSL_DEDUP_NONE UINT64_MAX
+
+/* Verdict of gdsl_verify at one level; instruction indices are left out
+ * because they depend on the debug instructions. */
+typedef struct {
+    int success;
+    uint64_t error_count;
+    uint64_t warning_count;
+    uint64_t info_count;
+} gdsl_dedup_certificate_t;
+
+typedef struct {
+    gdsl_stream_hash_t hash;
+    /* Caller's handle for the stored copy (the first one admitted). */
+    uint64_t stream_id;
+    /* stream_id of the diff base, or GDSL_DEDUP_NONE. */
+    uint64_t diff_base_id;
+    /* Bit (1u << level) is set for every level with a certificate. */
+    uint32_t verified_levels;
+    gdsl_dedup_certificate_t certificates[GDSL_VERIFY_LEVEL_DOMAIN + 1];
+} gdsl_dedup_entry_t;
+
+typedef struct gdsl_dedup_index gdsl_dedup_index_t;
+
+/* capacity is a hint for the expected number of streams; 0 selects 1024. */
+int gdsl_dedup_index_create(size_t capacity, gdsl_dedup_index_t **out_index);
+
+void gdsl_dedup_index_destroy(gdsl_dedup_index_t *index);
+
+size_t gdsl_dedup_index_count(gdsl_dedup_index_t *index);
+
+/* Hashes stream and registers it under stream_id unless an equivalent stream
+ * is already known. Returns 1 for a duplicate (out holds the existing entry
+ * and the upload need not be stored), 0 when the stream was registered (the
+ * caller stores it as stream_id) and -1 on failure. out may be NULL. */
+int gdsl_dedup_admit(gdsl_dedup_index_t *index,
+                     const uint8_t *stream,
+                     size_t length,
+                     uint64_t stream_id,
+                     gdsl_dedup_entry_t *out);
+
+/* Returns 1 and copies the entry when hash is known, 0 otherwise. */
+int gdsl_dedup_lookup(gdsl_dedup_index_t *index,
+                      const gdsl_stream_hash_t *hash,
+                      gdsl_dedup_entry_t *out);
+
+/* Certificate for the stream with canonical hash at level: taken from the
+ * index when present (returns 1), otherwise obtained from gdsl_verify on
+ * stream and recorded on the entry (returns 0). Returns -1 on failure. */
+int gdsl_dedup_verify(gdsl_dedup_index_t *index,
+                      const gdsl_stream_hash_t *hash,
+                      const uint8_t *stream,
+                      size_t length,
+                      gdsl_verify_level_t level,
+                      gdsl_dedup_certificate_t *out);
+
+/* Records the diff base of a known stream; -1 when hash is unknown. */
+int gdsl_dedup_set_diff_base(gdsl_dedup_index_t *index,
+                             const gdsl_stream_hash_t *hash,
+                             uint64_t diff_base_id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GDSL_DEDUP_H
@@ -0,0 +1,64 @@
+#ifndef GDSL_DIAGNOSTICS_H
+#define GDSL_DIAGNOSTICS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "gdsl/verify.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Deterministic diagnostics merge for parallel verification.
+ *
+ * Each worker appends to its own unbounded buffer without locking; merging
+ * sorts everything by content, folds entries with the same severity and
+ * message into one (occurrence count, first and last instruction index) and
+ * writes them into a report in order of first occurrence. The result depends
+ * only on the set of diagnostics added, never on how they were spread over
+ * workers, so reports are byte-identical for any thread count.
+ */
+
+typedef struct gdsl_diag_collector gdsl_diag_collector_t;
+
+/* worker_count is usually gdsl_pool_thread_count(pool). */
+int gdsl_diag_collector_create(size_t worker_count,
+                               gdsl_diag_collector_t **out_collector);
+
+void gdsl_diag_collector_destroy(gdsl_diag_collector_t *collector);
+
+/* Drops every buffered diagnostic; the collector can be reused. */
+void gdsl_diag_collector_reset(gdsl_diag_collector_t *collector);
+
+/* Appends one diagnostic to worker's buffer. Only that worker may call this
+ * concurrently with others. */
+int gdsl_diag_collector_add(gdsl_diag_collector_t *collector,
+                            size_t worker,
+                            uint64_t instruction_index,
+                            gdsl_verify_severity_t severity,
+                            const char *message);
+
+/* Appends every diagnostic of report (for example one verified segment) to
+ * worker's buffer, shifting instruction indices by index_base and byte
+ * offsets by offset_base. The report's counts are added as well, so
+ * diagnostics it had to drop still count. */
+int gdsl_diag_collector_add_report(gdsl_diag_collector_t *collector,
+                                   size_t worker,
+                                   const gdsl_verify_report_t *report,
+                                   uint64_t index_base,
+                                   uint64_t offset_base);
+
+/* Merges all buffers into report, which is reset first: counts, diagnostics,
+ * GDSL_VERIFY_REPORT_AGGREGATED / _DIAGNOSTICS_TRUNCATED and success are
+ * filled in; stream-level fields such as instruction_count are left to the
+ * caller. Must not run concurrently with add. */
+int gdsl_diag_collector_merge(gdsl_diag_collector_t *collector,
+                              gdsl_verify_report_t *report);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GDSL_DIAGNOSTICS_H
@@ -4,6 +4,9 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "gdsl/buffer.h"
+#include "gdsl/pool.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -20,16 +23,66 @@ typedef struct {
     size_t page_index;
     size_t length;
     size_t data_offset;
+    /* 0 when the chunk's bytes are in the payload at data_offset. Otherwise
+     * they are copied from byte data_offset of references[reference - 1] of
+     * gdsl_diff_multi / gdsl_patch_multi. */
+    size_t reference;
 } gdsl_diff_chunk_t;
 
+/* header.flags: some chunks copy from references instead of the payload, so
+ * the diff can only be applied with gdsl_patch_multi. */
+#define GDSL_DIFF_FLAG_REFERENCES 1u
+
+/* How gdsl_diff_result_t.payload is held; gdsl_diff_result_destroy uses it
+ * to pick the matching release. */
+#define GDSL_DIFF_STORAGE_HEAP 0u
+#define GDSL_DIFF_STORAGE_MAPPED 1u
+/* A shared mapping of an unlinked spill file (payload_fd). */
+#define GDSL_DIFF_STORAGE_FILE 2u
+
 typedef struct {
     gdsl_diff_header_t header;
     gdsl_diff_chunk_t *chunks;
     size_t chunk_count;
     uint8_t *payload;
     size_t payload_length;
+    uint32_t payload_storage;
+    /* GDSL_DIFF_STORAGE_FILE only: the spill file, whose bytes
+     * [0, payload_length) are mapped at payload. */
+    int payload_fd;
 } gdsl_diff_result_t;
 
+typedef struct {
+    /* Optional pool; NULL diffs/patches serially on the calling thread. */
+    gdsl_pool_t *pool;
+    /* Placement and paging of the diff payload and patch output (NUMA
+     * policy, huge pages, pre-faulting). Anything other than the defaults
+     * makes them gdsl_buffer allocations: the payload is then
+     * released by gdsl_diff_result_destroy as usual, but a patch output must
+     * be released with gdsl_buffer_free instead of free(). With
+     * GDSL_NUMA_FIRST_TOUCH, page ranges are partitioned statically so the
+     * worker that writes a range is the one whose node owns it. */
+    gdsl_buffer_options_t memory;
+    /* Diff payloads and patch outputs of at least this many bytes are
+     * written with non-temporal stores; smaller ones use regular copies.
+     * 0 selects the default (32 MiB); SIZE_MAX disables streaming. */
+    size_t streaming_threshold;
+    /* Diff payloads larger than this many bytes are not allocated in memory
+     * but spilled to an unlinked temporary file (O_TMPFILE where supported)
+     * that the result maps; the kernel can then write the payload back and
+     * evict it instead of the process running out of memory. 0 means no
+     * budget. */
+    size_t memory_budget;
+    /* Directory for spill files; NULL uses $TMPDIR, then /tmp. */
+    const char *spill_directory;
+} gdsl_diff_options_t;
+
+/* A prior snapshot a multi-reference diff may copy pages from. */
+typedef struct {
+    const uint8_t *data;
+    size_t length;
+} gdsl_diff_reference_t;
+
 void gdsl_diff_result_destroy(gdsl_diff_result_t *result);
 
 int gdsl_diff(const uint8_t *base,
@@ -38,12 +91,101 @@ int gdsl_diff(const uint8_t *base,
               size_t target_length,
               gdsl_diff_result_t *out);
 
+int gdsl_diff_ex(const uint8_t *base,
+                 size_t base_length,
+                 const uint8_t *target,
+                 size_t target_length,
+                 const gdsl_diff_options_t *options,
+                 gdsl_diff_result_t *out);
+
+/* Multi-reference diff, like reference frames in a video codec. references[0]
+ * is the base: pages equal to it are left out, as with gdsl_diff. A changed
+ * full page that exactly matches any full page of any reference (found by
+ * page hash, confirmed bytewise) becomes a chunk that copies that page
+ * instead of carrying its bytes; earlier references are preferred. Cyclic
+ * workloads, whose pages equal their state 2 or N checkpoints back, then need
+ * almost no payload. */
+int gdsl_diff_multi(const gdsl_diff_reference_t *references,
+                    size_t reference_count,
+                    const uint8_t *target,
+                    size_t target_length,
+                    const gdsl_diff_options_t *options,
+                    gdsl_diff_result_t *out);
+
 int gdsl_patch(const uint8_t *base,
                size_t base_length,
                const gdsl_diff_result_t *diff,
                uint8_t **out_buffer,
                size_t *out_length);
 
+int gdsl_patch_ex(const uint8_t *base,
+                  size_t base_length,
+                  const gdsl_diff_result_t *diff,
+                  const gdsl_diff_options_t *options,
+                  uint8_t **out_buffer,
+                  size_t *out_length);
+
+/* Applies a diff from gdsl_diff_multi (or any diff) to references[0], taking
+ * referencing chunks from the same references the diff was made with.
+ * gdsl_patch and gdsl_patch_ex reject diffs with referencing chunks. */
+int gdsl_patch_multi(const gdsl_diff_reference_t *references,
+                     size_t reference_count,
+                     const gdsl_diff_result_t *diff,
+                     const gdsl_diff_options_t *options,
+                     uint8_t **out_buffer,
+                     size_t *out_length);
+
+/* Size of a diff without building it. */
+typedef struct {
+    size_t chunk_count;
+    size_t payload_bytes;
+    size_t pages_scanned;
+    size_t total_pages;
+    /* The scan stopped once payload_bytes exceeded the byte budget, so the
+     * counts are lower bounds. */
+    int over_budget;
+} gdsl_diff_stat_t;
+
+/* Exact chunk and payload byte counts of gdsl_diff(base, target), with no
+ * allocation and no copies. byte_budget != 0 stops the scan as soon as the
+ * payload would exceed it (e.g. to pick a keyframe instead). */
+int gdsl_diff_stat(const uint8_t *base,
+                   size_t base_length,
+                   const uint8_t *target,
+                   size_t target_length,
+                   size_t byte_budget,
+                   gdsl_diff_stat_t *out);
+
+typedef struct {
+    /* Fraction of pages compared, in (0, 1]; 0 selects 1/64. At least one
+     * page is sampled from every stratum of 1/fraction pages. */
+    double sample_fraction;
+    /* Seed for the page picked in each stratum. */
+    uint64_t seed;
+} gdsl_diff_estimate_options_t;
+
+typedef struct {
+    size_t total_pages;
+    size_t sampled_pages;
+    size_t changed_samples;
+    /* Estimated fraction of changed pages and its 95% confidence interval
+     * (Wilson score; exact when every page was sampled). */
+    double change_ratio;
+    double ratio_low;
+    double ratio_high;
+    /* change_ratio applied to target_length. */
+    size_t estimated_payload_bytes;
+} gdsl_diff_estimate_t;
+
+/* Approximate change ratio of gdsl_diff(base, target) from a sample of
+ * pages; options may be NULL. Costs sample_fraction of a full scan. */
+int gdsl_diff_estimate(const uint8_t *base,
+                       size_t base_length,
+                       const uint8_t *target,
+                       size_t target_length,
+                       const gdsl_diff_estimate_options_t *options,
+                       gdsl_diff_estimate_t *out);
+
 int gdsl_read_changed_set(const gdsl_diff_result_t *diff,
                           size_t *out_pages,
                           size_t max_pages,
@@ -0,0 +1,57 @@
+#ifndef GDSL_ENCODE_H
+#define GDSL_ENCODE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Compact stream encoding.
+ *
+ * Layout (little-endian):
+ *
+ *   header   "GDSZ", u8 version, u8 tail_length, u16 reserved, u64 raw_length
+ *   block*   varint raw_bytes, varint payload_bytes, payload
+ *   tail     tail_length raw bytes
+ *
+ * A payload is a sequence of runs: the opcode byte, a varint run length and,
+ * for opcodes with operands, one operand field per instruction (a varint of
+ * the little-endian operand value when it is at most 8 bytes wide, the raw
+ * bytes otherwise). Bytes that are not opcodes are runs of one-byte
+ * instructions, so any byte string round-trips. Blocks end on instruction
+ * boundaries and hold about GDSL_ENCODE_BLOCK_SIZE raw bytes; the tail keeps
+ * a final instruction cut off by the end of the stream.
+ *
+ * gdsl_verify_encoded verifies an encoded stream without inflating it.
+ */
+
+#define GDSL_ENCODE_VERSION 1
+#define GDSL_ENCODE_HEADER_SIZE 16
+#define GDSL_ENCODE_BLOCK_SIZE ((size_t)64 << 10)
+
+/* Encodes stream into a malloc'd buffer released with free(). */
+int gdsl_encode(const uint8_t *stream,
+                size_t length,
+                uint8_t **out_buffer,
+                size_t *out_length);
+
+/* Restores the raw stream into a malloc'd buffer released with free().
+ * Returns -1 for malformed input. */
+int gdsl_decode(const uint8_t *encoded,
+                size_t length,
+                uint8_t **out_buffer,
+                size_t *out_length);
+
+/* Raw length recorded in the header, or -1 for malformed input. */
+int gdsl_encoded_raw_length(const uint8_t *encoded,
+                            size_t length,
+                            uint64_t *out_length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GDSL_ENCODE_H
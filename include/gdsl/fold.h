@@ -0,0 +1,55 @@
+#ifndef GDSL_FOLD_H
+#define GDSL_FOLD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Constant folding and branch pruning.
+ *
+ * CONST_I32, ADD, SUB and MUL compute on GDSL_FOLD_REGISTERS 32-bit
+ * registers; IF_EQ/IF_NE/IF_GT/IF_LT compare two of them (signed) and guard
+ * the instructions up to the matching ELSE or ENDIF. Registers start
+ * unknown. A register holds a constant when every path to it assigns the
+ * same value, so a condition over constants is decided at record time.
+ *
+ * gdsl_verify applies the same analysis: an arm that cannot run is not
+ * verified, and an IF with an unknown condition has both arms verified from
+ * the same entry state, which they must leave in agreement. gdsl_fold emits
+ * the stream with every decided IF replaced by its live arm. Verifying the
+ * pruned stream gives the same diagnostics as the original (only instruction
+ * indices move), so it can be executed in its place.
+ */
+
+#define GDSL_FOLD_REGISTERS 16
+/* Deepest IF nesting analysed; deeper IFs are reported by gdsl_verify. */
+#define GDSL_FOLD_MAX_DEPTH 32
+
+typedef struct {
+    /* IFs replaced by one arm, and IFs kept because the condition is not
+     * known. */
+    uint64_t branches_folded;
+    uint64_t branches_kept;
+    uint64_t instructions_removed;
+    uint64_t bytes_removed;
+} gdsl_fold_stats_t;
+
+/* Writes the pruned stream to a malloc'd buffer released with free(). A
+ * stream that is malformed, or whose IF/ELSE/ENDIF structure or registers
+ * are invalid, is copied unchanged so that gdsl_verify still reports it.
+ * stats may be NULL. */
+int gdsl_fold(const uint8_t *stream,
+              size_t length,
+              uint8_t **out_stream,
+              size_t *out_length,
+              gdsl_fold_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GDSL_FOLD_H
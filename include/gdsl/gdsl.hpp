@@ -0,0 +1,348 @@
+#ifndef GDSL_GDSL_HPP
+#define GDSL_GDSL_HPP
+
+/*
+ * Header-only C++20 layer over the C library.
+ *
+ * Inputs are std::span / std::string_view views, so callers pass their own
+ * buffers without copying. Results own the C library's storage directly and
+ * are move-only: gdsl::diff owns a gdsl_diff_result_t's chunks and payload
+ * (whatever its payload_storage), gdsl::patched owns a gdsl_patch output and
+ * gdsl::verify_report owns one report. Moving hands the pointers over; no
+ * chunk, payload or report bytes are ever copied at the boundary.
+ *
+ * The C library has no allocator hooks of its own (diff and patch storage is
+ * malloc'd, mapped or spilled as gdsl_diff_options_t directs). Memory this
+ * layer allocates itself, such as the report of gdsl::verify_report, comes
+ * from a std::pmr::memory_resource, so reports can live in an engine's
+ * arena.
+ *
+ * Errors are reported as the C functions report them (0 / -1). Nothing here
+ * throws except a memory resource that fails to allocate a report.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iterator>
+#include <memory_resource>
+#include <ranges>
+#include <span>
+#include <string_view>
+#include <utility>
+
+#include "gdsl/diff.h"
+#include "gdsl/verify.h"
+
+namespace gdsl {
+
+using bytes = std::span<const std::uint8_t>;
+
+inline bytes as_bytes(std::string_view text) noexcept {
+    return {reinterpret_cast<const std::uint8_t *>(text.data()), text.size()};
+}
+
+/* ---- diffs ---- */
+
+/* One chunk of a diff with the bytes it carries. data is empty for chunks
+ * that copy from a reference (chunk.reference != 0). */
+struct chunk_ref {
+    const gdsl_diff_chunk_t &chunk;
+    bytes data;
+
+    std::size_t page_index() const noexcept { return chunk.page_index; }
+    std::size_t reference() const noexcept { return chunk.reference; }
+};
+
+/* Random-access view pairing each chunk with its payload bytes. */
+class chunk_view : public std::ranges::view_interface<chunk_view> {
+public:
+    class iterator {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using iterator_concept = std::random_access_iterator_tag;
+        using value_type = chunk_ref;
+        using difference_type = std::ptrdiff_t;
+        using reference = chunk_ref;
+
+        iterator() = default;
+        iterator(const gdsl_diff_result_t *result, std::size_t index) noexcept
+            : result_(result), index_(index) {}
+
+        chunk_ref operator*() const noexcept { return (*this)[0]; }
+        chunk_ref operator[](difference_type offset) const noexcept {
+            const gdsl_diff_chunk_t &chunk = result_->chunks[index_ + offset];
+            bytes data;
+            if (chunk.reference == 0 && chunk.length > 0) {
+                data = bytes(result_->payload + chunk.data_offset, chunk.length);
+            }
+            return chunk_ref{chunk, data};
+        }
+
+        iterator &operator++() noexcept { ++index_; return *this; }
+        iterator operator++(int) noexcept { iterator old = *this; ++index_; return old; }
+        iterator &operator--() noexcept { --index_; return *this; }
+        iterator operator--(int) noexcept { iterator old = *this; --index_; return old; }
+        iterator &operator+=(difference_type n) noexcept { index_ += n; return *this; }
+        iterator &operator-=(difference_type n) noexcept { index_ -= n; return *this; }
+        friend iterator operator+(iterator it, difference_type n) noexcept { return it += n; }
+        friend iterator operator+(difference_type n, iterator it) noexcept { return it += n; }
+        friend iterator operator-(iterator it, difference_type n) noexcept { return it -= n; }
+        friend difference_type operator-(const iterator &a, const iterator &b) noexcept {
+            return static_cast<difference_type>(a.index_) -
+                   static_cast<difference_type>(b.index_);
+        }
+        friend bool operator==(const iterator &a, const iterator &b) noexcept {
+            return a.index_ == b.index_;
+        }
+        friend auto operator<=>(const iterator &a, const iterator &b) noexcept {
+            return a.index_ <=> b.index_;
+        }
+
+    private:
+        const gdsl_diff_result_t *result_ = nullptr;
+        std::size_t index_ = 0;
+    };
+
+    chunk_view() = default;
+    explicit chunk_view(const gdsl_diff_result_t *result) noexcept : result_(result) {}
+
+    iterator begin() const noexcept { return iterator(result_, 0); }
+    iterator end() const noexcept { return iterator(result_, result_ ? result_->chunk_count : 0); }
+
+private:
+    const gdsl_diff_result_t *result_ = nullptr;
+};
+
+class diff {
+public:
+    diff() noexcept : result_{} {}
+    /* Takes ownership of a result filled by the C API and clears it, so only
+     * this object destroys the storage. */
+    explicit diff(gdsl_diff_result_t &&result) noexcept : result_(result) {
+        result = gdsl_diff_result_t{};
+    }
+    ~diff() { reset(); }
+
+    diff(const diff &) = delete;
+    diff &operator=(const diff &) = delete;
+    diff(diff &&other) noexcept : result_(other.result_) { other.result_ = gdsl_diff_result_t{}; }
+    diff &operator=(diff &&other) noexcept {
+        if (this != &other) {
+            reset();
+            result_ = other.result_;
+            other.result_ = gdsl_diff_result_t{};
+        }
+        return *this;
+    }
+
+    void reset() noexcept {
+        gdsl_diff_result_destroy(&result_);
+        result_ = gdsl_diff_result_t{};
+    }
+
+    const gdsl_diff_header_t &header() const noexcept { return result_.header; }
+    std::size_t target_length() const noexcept {
+        return static_cast<std::size_t>(result_.header.target_length);
+    }
+    bool has_references() const noexcept {
+        return (result_.header.flags & GDSL_DIFF_FLAG_REFERENCES) != 0;
+    }
+    std::span<const gdsl_diff_chunk_t> raw_chunks() const noexcept {
+        return {result_.chunks, result_.chunk_count};
+    }
+    chunk_view chunks() const noexcept { return chunk_view(&result_); }
+    bytes payload() const noexcept { return {result_.payload, result_.payload_length}; }
+
+    /* The underlying result, for C APIs such as gdsl_store_append. */
+    const gdsl_diff_result_t *get() const noexcept { return &result_; }
+    /* Destroys the current contents and exposes the result for a C call to
+     * fill. */
+    gdsl_diff_result_t *out() noexcept {
+        reset();
+        return &result_;
+    }
+
+private:
+    gdsl_diff_result_t result_;
+};
+
+[[nodiscard]] inline int make_diff(bytes base,
+                                   bytes target,
+                                   diff &out,
+                                   const gdsl_diff_options_t *options = nullptr) noexcept {
+    return gdsl_diff_ex(base.data(), base.size(), target.data(), target.size(), options,
+                        out.out());
+}
+
+[[nodiscard]] inline int make_diff(std::span<const gdsl_diff_reference_t> references,
+                                   bytes target,
+                                   diff &out,
+                                   const gdsl_diff_options_t *options = nullptr) noexcept {
+    return gdsl_diff_multi(references.data(), references.size(), target.data(),
+                           target.size(), options, out.out());
+}
+
+[[nodiscard]] inline int diff_stat(bytes base,
+                                   bytes target,
+                                   gdsl_diff_stat_t &out,
+                                   std::size_t byte_budget = 0) noexcept {
+    return gdsl_diff_stat(base.data(), base.size(), target.data(), target.size(), byte_budget,
+                          &out);
+}
+
+/* Output of a patch: malloc'd, or a gdsl_buffer mapping when the options
+ * placed it (gdsl_diff_options_t.memory). */
+class patched {
+public:
+    patched() noexcept = default;
+    ~patched() { reset(); }
+
+    patched(const patched &) = delete;
+    patched &operator=(const patched &) = delete;
+    patched(patched &&other) noexcept
+        : data_(std::exchange(other.data_, nullptr)),
+          size_(std::exchange(other.size_, 0)),
+          mapped_(other.mapped_) {}
+    patched &operator=(patched &&other) noexcept {
+        if (this != &other) {
+            reset();
+            data_ = std::exchange(other.data_, nullptr);
+            size_ = std::exchange(other.size_, 0);
+            mapped_ = other.mapped_;
+        }
+        return *this;
+    }
+
+    void reset() noexcept {
+        if (mapped_) {
+            gdsl_buffer_free(data_, size_);
+        } else {
+            std::free(data_);
+        }
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    std::span<std::uint8_t> span() noexcept { return {data_, size_}; }
+    bytes span() const noexcept { return {data_, size_}; }
+    std::size_t size() const noexcept { return size_; }
+
+private:
+    friend int patch(bytes, const diff &, patched &, const gdsl_diff_options_t *) noexcept;
+    friend int patch(std::span<const gdsl_diff_reference_t>, const diff &, patched &,
+                     const gdsl_diff_options_t *) noexcept;
+
+    std::uint8_t *data_ = nullptr;
+    std::size_t size_ = 0;
+    bool mapped_ = false;
+};
+
+namespace detail {
+
+inline bool uses_buffer_layer(const gdsl_diff_options_t *options) noexcept {
+    return options && (options->memory.numa_policy != GDSL_NUMA_DEFAULT ||
+                       options->memory.flags != 0);
+}
+
+} // namespace detail
+
+[[nodiscard]] inline int patch(bytes base,
+                               const diff &d,
+                               patched &out,
+                               const gdsl_diff_options_t *options = nullptr) noexcept {
+    out.reset();
+    out.mapped_ = detail::uses_buffer_layer(options);
+    return gdsl_patch_ex(base.data(), base.size(), d.get(), options, &out.data_, &out.size_);
+}
+
+[[nodiscard]] inline int patch(std::span<const gdsl_diff_reference_t> references,
+                               const diff &d,
+                               patched &out,
+                               const gdsl_diff_options_t *options = nullptr) noexcept {
+    out.reset();
+    out.mapped_ = detail::uses_buffer_layer(options);
+    return gdsl_patch_multi(references.data(), references.size(), d.get(), options,
+                            &out.data_, &out.size_);
+}
+
+inline gdsl_diff_reference_t reference(bytes snapshot) noexcept {
+    return gdsl_diff_reference_t{snapshot.data(), snapshot.size()};
+}
+
+/* ---- verification ---- */
+
+inline std::string_view message(const gdsl_verify_diagnostic_t &diagnostic) noexcept {
+    return std::string_view(diagnostic.message);
+}
+
+/* A verification report allocated from a memory resource. Reports are large
+ * (the diagnostics array is inline), so this type only moves the pointer. */
+class verify_report {
+public:
+    explicit verify_report(
+        std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+        : resource_(resource),
+          report_(static_cast<gdsl_verify_report_t *>(
+              resource->allocate(sizeof(gdsl_verify_report_t), alignof(gdsl_verify_report_t)))) {
+        *report_ = gdsl_verify_report_t{};
+    }
+    ~verify_report() {
+        if (report_) {
+            resource_->deallocate(report_, sizeof(gdsl_verify_report_t),
+                                  alignof(gdsl_verify_report_t));
+        }
+    }
+
+    verify_report(const verify_report &) = delete;
+    verify_report &operator=(const verify_report &) = delete;
+    verify_report(verify_report &&other) noexcept
+        : resource_(other.resource_), report_(std::exchange(other.report_, nullptr)) {}
+    verify_report &operator=(verify_report &&other) noexcept {
+        if (this != &other) {
+            std::swap(resource_, other.resource_);
+            std::swap(report_, other.report_);
+        }
+        return *this;
+    }
+
+    bool success() const noexcept { return report_->success != 0; }
+    std::uint64_t instruction_count() const noexcept { return report_->instruction_count; }
+    std::uint64_t error_count() const noexcept { return report_->error_count; }
+    std::uint64_t warning_count() const noexcept { return report_->warning_count; }
+
+    std::span<const gdsl_verify_diagnostic_t> diagnostics() const noexcept {
+        return {report_->diagnostics, report_->diagnostic_count};
+    }
+    auto diagnostics(gdsl_verify_severity_t severity) const noexcept {
+        return diagnostics() | std::views::filter([severity](const gdsl_verify_diagnostic_t &d) {
+                   return d.severity == severity;
+               });
+    }
+
+    const gdsl_verify_report_t *get() const noexcept { return report_; }
+    gdsl_verify_report_t *get() noexcept { return report_; }
+    std::pmr::memory_resource *resource() const noexcept { return resource_; }
+
+private:
+    std::pmr::memory_resource *resource_;
+    gdsl_verify_report_t *report_;
+};
+
+[[nodiscard]] inline int verify(bytes stream,
+                                gdsl_verify_level_t level,
+                                verify_report &report,
+                                const gdsl_verify_options_t *options = nullptr) noexcept {
+    return gdsl_verify_ex(stream.data(), stream.size(), level, options, report.get());
+}
+
+[[nodiscard]] inline int verify(std::string_view stream,
+                                gdsl_verify_level_t level,
+                                verify_report &report,
+                                const gdsl_verify_options_t *options = nullptr) noexcept {
+    return verify(as_bytes(stream), level, report, options);
+}
+
+} // namespace gdsl
+
+#endif // GDSL_GDSL_HPP
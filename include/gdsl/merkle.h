@@ -0,0 +1,62 @@
+#ifndef GDSL_MERKLE_H
+#define GDSL_MERKLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "gdsl/pool.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Page hash trees of a heap (the heap_merkle_root of a checkpoint).
+ *
+ * The leaves hash the heap's pages (the last one may be short); every
+ * interior node hashes its two children, and a node without a sibling moves
+ * up unchanged. Level 0 holds the leaves and the root is the last node. The
+ * hash is the library's 128-bit content hash: it identifies heaps of one
+ * capture, it is not a defence against crafted collisions.
+ */
+
+/* Page size of gdsl_diff, so that pages of a tree and of a diff coincide. */
+#define GDSL_MERKLE_DEFAULT_PAGE_SIZE 4096u
+
+typedef struct {
+    uint64_t lo;
+    uint64_t hi;
+} gdsl_merkle_hash_t;
+
+typedef struct {
+    gdsl_merkle_hash_t *nodes;
+    size_t node_count;
+    size_t page_count;
+    size_t page_size;
+    uint64_t length;
+} gdsl_merkle_tree_t;
+
+/* Builds the tree of heap. page_size 0 selects the default; pool may be NULL. */
+int gdsl_merkle_build(const uint8_t *heap,
+                      size_t length,
+                      size_t page_size,
+                      gdsl_pool_t *pool,
+                      gdsl_merkle_tree_t *out);
+
+void gdsl_merkle_destroy(gdsl_merkle_tree_t *tree);
+
+gdsl_merkle_hash_t gdsl_merkle_root(const gdsl_merkle_tree_t *tree);
+
+/* Root of the tree of heap without keeping the tree. */
+int gdsl_merkle_heap_root(const uint8_t *heap,
+                          size_t length,
+                          size_t page_size,
+                          gdsl_merkle_hash_t *out);
+
+int gdsl_merkle_equal(gdsl_merkle_hash_t a, gdsl_merkle_hash_t b);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GDSL_MERKLE_H
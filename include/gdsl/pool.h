@@ -0,0 +1,90 @@
+#ifndef GDSL_POOL_H
+#define GDSL_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Shared work-stealing thread pool.
+ *
+ * A pool owns a fixed set of worker threads, each with its own Chase-Lev
+ * deque. Parallel entry points (gdsl_diff_ex, gdsl_patch_ex,
+ * gdsl_verify_batch, ...) take an optional pool; passing NULL runs the work
+ * serially on the calling thread.
+ *
+ * The calling thread always participates in its own parallel_for, so a pool
+ * created with thread_count = N spawns N - 1 background threads. Idle workers
+ * block instead of spinning, which lets the pool share cores with an engine
+ * that keeps its own thread budget.
+ */
+
+typedef struct gdsl_pool gdsl_pool_t;
+
+typedef struct {
+    /* Total participants including the calling thread. 0 selects the number
+     * of online CPUs minus reserved_threads (at least 1). */
+    size_t thread_count;
+    /* CPUs left to the host engine when thread_count is 0. */
+    size_t reserved_threads;
+    /* Optional CPU per background worker: worker i (1-based) is pinned to
+     * cpu_affinity[(i - 1) % cpu_affinity_count]. */
+    const int *cpu_affinity;
+    size_t cpu_affinity_count;
+    /* When set (and cpu_affinity is NULL), background workers are spread
+     * evenly over the online NUMA nodes in node order and pinned to CPUs of
+     * their node. */
+    int numa_aware;
+} gdsl_pool_options_t;
+
+/* Processes [begin, end). worker is in [0, gdsl_pool_thread_count()) and is
+ * stable for the duration of the call, so it can index per-worker scratch. */
+typedef void (*gdsl_pool_range_fn)(void *ctx,
+                                   size_t begin,
+                                   size_t end,
+                                   size_t worker);
+
+int gdsl_pool_create(const gdsl_pool_options_t *options, gdsl_pool_t **out_pool);
+
+void gdsl_pool_destroy(gdsl_pool_t *pool);
+
+/* Returns 1 for a NULL pool. */
+size_t gdsl_pool_thread_count(const gdsl_pool_t *pool);
+
+/* NUMA node of worker, or -1 when unknown. The calling thread (worker 0) is
+ * never pinned and always reports -1. */
+int gdsl_pool_worker_node(const gdsl_pool_t *pool, size_t worker);
+
+/* Number of distinct nodes the workers are pinned to (0 when unknown). */
+size_t gdsl_pool_node_count(const gdsl_pool_t *pool);
+
+/* Splits [begin, end) into ranges of at least grain items and runs fn over
+ * them, stealing across workers. Returns once every item was processed.
+ * Concurrent calls from threads outside the pool are serialised; nested calls
+ * from inside fn are allowed. */
+int gdsl_pool_parallel_for(gdsl_pool_t *pool,
+                           size_t begin,
+                           size_t end,
+                           size_t grain,
+                           gdsl_pool_range_fn fn,
+                           void *ctx);
+
+/* Splits [begin, end) into one contiguous partition per participating
+ * worker, in worker order, with no stealing: the same range always runs on
+ * the same worker, which makes first-touch page placement stick. NUMA-aware
+ * pools leave the unpinned caller out of the partitioning. Calls made from
+ * inside a pool task fall back to gdsl_pool_parallel_for. */
+int gdsl_pool_parallel_for_static(gdsl_pool_t *pool,
+                                  size_t begin,
+                                  size_t end,
+                                  gdsl_pool_range_fn fn,
+                                  void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GDSL_POOL_H
@@ -0,0 +1,81 @@
+#ifndef GDSL_REPLAY_H
+#define GDSL_REPLAY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "gdsl/merkle.h"
+#include "gdsl/pool.h"
+#include "gdsl/slice.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Parallel replay of checkpoint intervals.
+ *
+ * The executor itself stays sequential (assumption A3): it is called with one
+ * materialised slice (gdsl_slice_materialise) and the heap the slice starts
+ * from, and runs it to the end. What runs concurrently is the intervals.
+ * Each interval starts from its keyframe: the base heap patched with the
+ * slice's keyframe diff (gdsl_slice_t.diff, taken against the base heap), or
+ * the base heap itself when the slice has none. The keyframe is taken as the
+ * heap at the slice's CHECKPOINT, so captures snapshot right before their
+ * checkpoints. After an interval has run, its heap's merkle root is compared
+ * with the root recorded for the CHECKPOINT that ends it.
+ */
+
+/* Runs stream on heap; returns 0 on success. Called from pool workers, so
+ * it must be safe to call concurrently. */
+typedef int (*gdsl_replay_execute_fn)(void *ctx,
+                                      const uint8_t *stream,
+                                      size_t length,
+                                      uint8_t *heap,
+                                      size_t heap_length);
+
+typedef enum {
+    /* The interval ran and its root matches the recorded one. */
+    GDSL_REPLAY_CONSISTENT = 0,
+    /* The interval ran; nothing was recorded for it (the last interval). */
+    GDSL_REPLAY_UNCHECKED,
+    /* The interval ran and its root differs from the recorded one. */
+    GDSL_REPLAY_DIVERGED,
+    /* The keyframe could not be materialised or the executor failed. */
+    GDSL_REPLAY_FAILED
+} gdsl_replay_status_t;
+
+typedef struct {
+    gdsl_replay_status_t status;
+    /* Root of the heap at the end of the interval (FAILED: zero). */
+    gdsl_merkle_hash_t root;
+} gdsl_replay_interval_t;
+
+typedef struct {
+    const uint8_t *base_heap;
+    size_t base_heap_length;
+    /* Page size of the merkle trees; 0 selects the default. */
+    size_t page_size;
+    /* heap_merkle_root recorded at each CHECKPOINT, by ordinal. */
+    const gdsl_merkle_hash_t *checkpoint_roots;
+    size_t checkpoint_root_count;
+    gdsl_replay_execute_fn execute;
+    void *ctx;
+    /* Optional pool; NULL replays the intervals one after another. */
+    gdsl_pool_t *pool;
+} gdsl_replay_options_t;
+
+/* Replays every slice of slices, writing one entry per slice to intervals.
+ * Returns -1 for invalid arguments; failures and divergences are reported
+ * per interval. */
+int gdsl_replay_intervals(const uint8_t *stream,
+                          size_t length,
+                          const gdsl_slice_set_t *slices,
+                          const gdsl_replay_options_t *options,
+                          gdsl_replay_interval_t *intervals);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GDSL_REPLAY_H
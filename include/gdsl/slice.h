@@ -0,0 +1,88 @@
+#ifndef GDSL_SLICE_H
+#define GDSL_SLICE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "gdsl/diff.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Stream slicing for parallel replay.
+ *
+ * gdsl_slice cuts a stream before CHECKPOINT instructions. Slice k replays
+ * stream[begin_offset, end_offset) between a synthesised prologue and
+ * epilogue. The prologue rebuilds the verifier's state at the cut: every
+ * device's phase, domain and open snapshot, the bound pipelines and buffers
+ * and open pass/query scopes of devices still recording, the buffers still
+ * allocated, the semaphore signals not waited on yet, the constant registers
+ * and the selected device and queues. The epilogue takes every device to
+ * END_STREAM. A slice of a stream that verifies without errors then verifies
+ * without errors on its own (at DOMAIN level, without race detection).
+ *
+ * A cut must not fall inside an IF, nor between a SEMAPHORE_WAIT and a
+ * signal recorded after it.
+ */
+
+#define GDSL_SLICE_NONE UINT64_MAX
+
+typedef struct {
+    uint64_t begin_offset;
+    uint64_t end_offset;
+    uint64_t begin_index;
+    uint64_t end_index;
+    /* Empty for the first slice and the last slice respectively. */
+    uint8_t *prologue;
+    size_t prologue_length;
+    uint8_t *epilogue;
+    size_t epilogue_length;
+    /* Ordinal of the CHECKPOINT the slice starts at among all CHECKPOINTs of
+     * the stream; GDSL_SLICE_NONE for the first slice. */
+    uint64_t checkpoint;
+    /* The keyframe: ordinal of the last safe snapshot region that ends
+     * before the slice, or GDSL_SLICE_NONE, and its diff when
+     * gdsl_slice_options_t.snapshot_diffs has one. */
+    uint64_t snapshot;
+    const gdsl_diff_result_t *diff;
+} gdsl_slice_t;
+
+typedef struct {
+    gdsl_slice_t *slices;
+    size_t count;
+} gdsl_slice_set_t;
+
+typedef struct {
+    /* Diff recorded for each snapshot region, by ordinal (entries may be
+     * NULL). */
+    const gdsl_diff_result_t *const *snapshot_diffs;
+    size_t snapshot_diff_count;
+} gdsl_slice_options_t;
+
+/* Cuts stream before the instructions at cut_points (instruction indices,
+ * strictly increasing, each a CHECKPOINT) into cut_count + 1 slices. Returns
+ * -1 for an invalid cut point or when out of memory. options may be NULL. */
+int gdsl_slice(const uint8_t *stream,
+               size_t length,
+               const uint64_t *cut_points,
+               size_t cut_count,
+               const gdsl_slice_options_t *options,
+               gdsl_slice_set_t *out);
+
+/* Writes prologue, instructions and epilogue of slice to a malloc'd buffer
+ * released with free(). */
+int gdsl_slice_materialise(const uint8_t *stream,
+                           size_t length,
+                           const gdsl_slice_t *slice,
+                           uint8_t **out_stream,
+                           size_t *out_length);
+
+void gdsl_slice_set_destroy(gdsl_slice_set_t *set);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GDSL_SLICE_H
@@ -0,0 +1,88 @@
+#ifndef GDSL_STORE_H
+#define GDSL_STORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "gdsl/diff.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Crash-consistent on-disk diff store.
+ *
+ * Checkpoint diffs are appended to a write-ahead log file as self-checking
+ * records (header, chunk table and payload under one 128-bit checksum).
+ * gdsl_store_append returns once its record is durable. Writers that arrive
+ * while a flush is in progress are gathered into the next group commit: one
+ * writer writes the whole batch with sequential writes and issues a single
+ * fdatasync for all of them, so durability costs one sync per batch rather
+ * than one per diff.
+ *
+ * Opening a store scans the log and validates every record. A torn or
+ * corrupt tail (a crash in the middle of a batch) is truncated at the last
+ * valid record, so the history after recovery is always a prefix of what was
+ * appended.
+ *
+ * Records use the host's byte order and are not meant to move between hosts
+ * of different endianness.
+ */
+
+typedef struct gdsl_store gdsl_store_t;
+
+typedef struct {
+    /* Microseconds a commit leader waits for more writers before it writes
+     * the batch; 0 batches only writers that arrive during a sync. */
+    uint32_t group_delay_us;
+} gdsl_store_options_t;
+
+typedef struct {
+    /* Valid records found by the recovery scan. */
+    size_t record_count;
+    /* Bytes kept, and bytes of torn or corrupt tail truncated. */
+    uint64_t valid_bytes;
+    uint64_t truncated_bytes;
+} gdsl_store_recovery_t;
+
+typedef struct {
+    size_t record_count;
+    /* Group commits (fdatasync calls) since the store was opened. */
+    uint64_t commit_count;
+    uint64_t durable_bytes;
+} gdsl_store_stats_t;
+
+/* Opens (or creates) the log at path and recovers it. out_recovery is
+ * optional. */
+int gdsl_store_open(const char *path,
+                    const gdsl_store_options_t *options,
+                    gdsl_store_t **out_store,
+                    gdsl_store_recovery_t *out_recovery);
+
+/* Appends diff as the record for checkpoint and blocks until it is durable.
+ * Safe to call from several threads. out_index (optional) receives the
+ * record's index. After a write or sync error the store stays failed and
+ * every append returns -1. */
+int gdsl_store_append(gdsl_store_t *store,
+                      uint64_t checkpoint,
+                      const gdsl_diff_result_t *diff,
+                      size_t *out_index);
+
+/* Reads durable record index back into a heap-owned diff (release with
+ * gdsl_diff_result_destroy). The checksum is checked again. */
+int gdsl_store_read(gdsl_store_t *store,
+                    size_t index,
+                    uint64_t *out_checkpoint,
+                    gdsl_diff_result_t *out);
+
+void gdsl_store_stats(gdsl_store_t *store, gdsl_store_stats_t *out);
+
+/* Closes the store. No appends may be in progress. */
+void gdsl_store_close(gdsl_store_t *store);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GDSL_STORE_H
@@ -4,12 +4,15 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "gdsl/pool.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 #define GDSL_VERIFY_MAX_DIAGNOSTICS 64
 #define GDSL_VERIFY_MAX_MESSAGE 256
+#define GDSL_VERIFY_DEFAULT_WINDOW ((size_t)64 << 20)
 
 typedef enum {
     GDSL_VERIFY_SEVERITY_INFO = 0,
@@ -24,26 +27,174 @@ typedef enum {
 } gdsl_verify_level_t;
 
 typedef struct {
-    size_t instruction_index;
+    uint64_t instruction_index;
     gdsl_verify_severity_t severity;
     char message[GDSL_VERIFY_MAX_MESSAGE];
+    /* Byte offset of the instruction in the stream. */
+    uint64_t byte_offset;
+    /* Occurrences folded into this entry and the index of the last one; 1 and
+     * instruction_index unless the report is GDSL_VERIFY_REPORT_AGGREGATED. */
+    uint64_t occurrence_count;
+    uint64_t last_instruction_index;
 } gdsl_verify_diagnostic_t;
 
+/* Verification stopped before the end of the stream because a limit in
+ * gdsl_verify_options_t was reached; success is 0 in that case. */
+#define GDSL_VERIFY_REPORT_STOPPED_EARLY (1u << 0)
+/* More diagnostics were raised than fit in diagnostics[]; the counts still
+ * include them. */
+#define GDSL_VERIFY_REPORT_DIAGNOSTICS_TRUNCATED (1u << 1)
+/* More snapshot regions were found than fit in
+ * gdsl_verify_options_t.snapshots; snapshot_count still includes them. */
+#define GDSL_VERIFY_REPORT_SNAPSHOTS_TRUNCATED (1u << 2)
+/* Diagnostics with the same severity and message share one entry, in order
+ * of first occurrence. */
+#define GDSL_VERIFY_REPORT_AGGREGATED (1u << 3)
+
 typedef struct {
     int success;
-    size_t instruction_count;
-    size_t error_count;
-    size_t warning_count;
-    size_t info_count;
+    uint64_t instruction_count;
+    uint64_t error_count;
+    uint64_t warning_count;
+    uint64_t info_count;
     size_t diagnostic_count;
     gdsl_verify_diagnostic_t diagnostics[GDSL_VERIFY_MAX_DIAGNOSTICS];
+    uint32_t flags;
+    uint64_t dropped_diagnostic_count;
+    /* Instruction index verification stopped at (GDSL_VERIFY_REPORT_STOPPED_EARLY). */
+    uint64_t stop_index;
+    /* Snapshot regions seen (DOMAIN level with gdsl_verify_options_t.snapshots). */
+    uint64_t snapshot_count;
 } gdsl_verify_report_t;
 
+/* Phase values reported in gdsl_verify_snapshot_t.entry_phase. */
+typedef enum {
+    GDSL_VERIFY_PHASE_BUILD = 0,
+    GDSL_VERIFY_PHASE_RECORD,
+    GDSL_VERIFY_PHASE_SUBMITTED,
+    GDSL_VERIFY_PHASE_IDLE,
+    GDSL_VERIFY_PHASE_FINISHED
+} gdsl_verify_phase_t;
+
+/* The region was entered in Idle/host with no snapshot open, was closed by
+ * SNAPSHOT_END and raised no errors in between. */
+#define GDSL_VERIFY_SNAPSHOT_SAFE (1u << 0)
+/* The stream (or an early stop) ended before SNAPSHOT_END; end_index and
+ * end_offset point at where verification ended. */
+#define GDSL_VERIFY_SNAPSHOT_UNTERMINATED (1u << 1)
+/* More buffers were live at SNAPSHOT_BEGIN than fit in the rest of
+ * gdsl_verify_options_t.snapshot_resources; resource_count covers the ids
+ * that were stored. */
+#define GDSL_VERIFY_SNAPSHOT_RESOURCES_TRUNCATED (1u << 2)
+
+/* Summary of one SNAPSHOT_BEGIN .. SNAPSHOT_END region. */
+typedef struct {
+    uint64_t begin_index;
+    uint64_t end_index;
+    uint64_t begin_offset;
+    uint64_t end_offset;
+    /* State at SNAPSHOT_BEGIN. */
+    gdsl_verify_phase_t entry_phase;
+    int entry_device_domain;
+    uint32_t flags;
+    /* Errors raised from SNAPSHOT_BEGIN through SNAPSHOT_END inclusive. */
+    uint64_t error_count;
+    /* Buffers the snapshot captures: those allocated and not yet freed (on
+     * any device) at SNAPSHOT_BEGIN, as ascending ids in
+     * snapshot_resources[resource_offset, resource_offset + resource_count).
+     * Zero unless gdsl_verify_options_t.snapshot_resources is set. */
+    uint64_t resource_offset;
+    uint64_t resource_count;
+} gdsl_verify_snapshot_t;
+
+/* Stop at the first error (same as max_errors = 1). */
+#define GDSL_VERIFY_FAIL_FAST (1u << 0)
+/* Stop once diagnostics[] is full instead of counting on silently. */
+#define GDSL_VERIFY_STOP_WHEN_FULL (1u << 1)
+/* Fold repeated diagnostics into one entry (GDSL_VERIFY_REPORT_AGGREGATED).
+ * STOP_WHEN_FULL then counts distinct entries. */
+#define GDSL_VERIFY_AGGREGATE (1u << 2)
+/* At DOMAIN level, report buffer accesses from different queues that no
+ * semaphore or fence orders (see SET_QUEUE). */
+#define GDSL_VERIFY_DETECT_RACES (1u << 3)
+
+typedef struct {
+    /* GDSL_VERIFY_* flags. */
+    uint32_t flags;
+    /* Stop after this many errors; 0 means no limit. */
+    uint64_t max_errors;
+    /* Optional snapshot index. At DOMAIN level, the first snapshot_capacity
+     * regions are written here in stream order. */
+    gdsl_verify_snapshot_t *snapshots;
+    size_t snapshot_capacity;
+    /* Optional storage for the live-buffer sets of the indexed regions, which
+     * take consecutive ranges of it in stream order. */
+    uint32_t *snapshot_resources;
+    size_t snapshot_resource_capacity;
+    /* Bytes mapped at a time by gdsl_verify_file; 0 selects
+     * GDSL_VERIFY_DEFAULT_WINDOW. Rounded up to at least two pages. */
+    size_t window_size;
+    /* Optional pool for gdsl_verify_ex: the sub-streams of a multi-device
+     * stream are then verified concurrently, one pass per device, and joined
+     * at their semaphore edges. The report is the same either way. Ignored
+     * with early-exit limits, GDSL_VERIFY_AGGREGATE, GDSL_VERIFY_DETECT_RACES
+     * or a snapshot index. */
+    gdsl_pool_t *pool;
+} gdsl_verify_options_t;
+
 int gdsl_verify(const uint8_t *stream,
                 size_t length,
                 gdsl_verify_level_t level,
                 gdsl_verify_report_t *report);
 
+/* gdsl_verify with early-exit limits and an optional snapshot index; NULL
+ * options behaves like gdsl_verify. */
+int gdsl_verify_ex(const uint8_t *stream,
+                   size_t length,
+                   gdsl_verify_level_t level,
+                   const gdsl_verify_options_t *options,
+                   gdsl_verify_report_t *report);
+
+/* Verifies the stream stored in the file at path through a sliding read-only
+ * mapping of options->window_size bytes, releasing pages behind the cursor,
+ * so resident memory stays bounded however large the file is. Indices and
+ * byte offsets are 64-bit even on 32-bit hosts. The report is identical to
+ * gdsl_verify_ex over the whole file. Returns -1 when the file cannot be
+ * opened or mapped. */
+int gdsl_verify_file(const char *path,
+                     gdsl_verify_level_t level,
+                     const gdsl_verify_options_t *options,
+                     gdsl_verify_report_t *report);
+
+/* Verifies a stream in the gdsl_encode format (gdsl/encode.h) run by run,
+ * without inflating it. The report is identical to verifying the decoded
+ * stream. Returns -1 for a malformed encoding. */
+int gdsl_verify_encoded(const uint8_t *encoded,
+                        size_t length,
+                        gdsl_verify_level_t level,
+                        const gdsl_verify_options_t *options,
+                        gdsl_verify_report_t *report);
+
+/* Region of snapshots[0, count) containing instruction_index, or NULL. The
+ * array must be in stream order as gdsl_verify_ex writes it. */
+const gdsl_verify_snapshot_t *gdsl_verify_find_snapshot(
+    const gdsl_verify_snapshot_t *snapshots,
+    size_t count,
+    uint64_t instruction_index);
+
+typedef struct {
+    const uint8_t *stream;
+    size_t length;
+    gdsl_verify_report_t *report;
+} gdsl_verify_batch_item_t;
+
+/* Verifies independent streams, one per item, spread across pool (or serially
+ * when pool is NULL). Each report is identical to a gdsl_verify call. */
+int gdsl_verify_batch(const gdsl_verify_batch_item_t *items,
+                      size_t count,
+                      gdsl_verify_level_t level,
+                      gdsl_pool_t *pool);
+
 #ifdef __cplusplus
 }
 #endif
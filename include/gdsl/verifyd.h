@@ -0,0 +1,131 @@
+#ifndef GDSL_VERIFYD_H
+#define GDSL_VERIFYD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "gdsl/pool.h"
+#include "gdsl/verify.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Local verification service over shared memory.
+ *
+ * A region holds a fixed number of slots plus a lock-free MPSC ring of
+ * submitted slot indices. A client claims a free slot, writes its stream
+ * straight into the slot's data area, pushes the slot index and waits on the
+ * slot; the server (gdsl-verifyd) verifies on its pool against a result
+ * cache shared by every client and writes a compact report back into the
+ * slot. Wakeups use process-shared futexes on region words, so nothing is
+ * copied through sockets.
+ *
+ * The region contains no pointers and can be mapped at different addresses
+ * in different processes (shm_open, or MAP_SHARED before fork).
+ */
+
+#define GDSL_VERIFYD_MESSAGE 128
+
+/* The report was served from the result cache. */
+#define GDSL_VERIFYD_REPORT_CACHED (1u << 0)
+
+typedef struct {
+    int32_t success;
+    uint32_t flags;
+    uint64_t instruction_count;
+    uint64_t error_count;
+    uint64_t warning_count;
+    uint64_t info_count;
+    uint64_t diagnostic_count;
+    /* First ERROR diagnostic, if any. */
+    uint64_t first_error_index;
+    char first_error[GDSL_VERIFYD_MESSAGE];
+} gdsl_verifyd_report_t;
+
+/* Bytes needed for a region. slot_count is rounded up to a power of two. */
+size_t gdsl_verifyd_region_size(uint32_t slot_count, uint32_t slot_data_size);
+
+int gdsl_verifyd_region_init(void *region,
+                             size_t region_size,
+                             uint32_t slot_count,
+                             uint32_t slot_data_size);
+
+/* Maps the POSIX shared memory object name. With create set, the object is
+ * created (or resized) and initialised; otherwise an existing one is
+ * attached. Release with gdsl_verifyd_unmap. */
+int gdsl_verifyd_map(const char *name,
+                     int create,
+                     uint32_t slot_count,
+                     uint32_t slot_data_size,
+                     void **out_region,
+                     size_t *out_size);
+
+void gdsl_verifyd_unmap(void *region, size_t region_size);
+
+/* ---- server ---- */
+
+typedef struct gdsl_verifyd_server gdsl_verifyd_server_t;
+
+typedef struct {
+    /* Optional pool for verifying several submissions at once. */
+    gdsl_pool_t *pool;
+    /* Result cache entries (rounded up to a power of two); 0 selects 4096. */
+    size_t cache_entries;
+    /* Polls before the server sleeps on the doorbell; 0 selects a default
+     * that keeps back-to-back submissions off the futex path (and no
+     * spinning at all on single-CPU hosts). */
+    uint32_t spin_iterations;
+} gdsl_verifyd_server_options_t;
+
+int gdsl_verifyd_server_create(void *region,
+                               const gdsl_verifyd_server_options_t *options,
+                               gdsl_verifyd_server_t **out_server);
+
+void gdsl_verifyd_server_destroy(gdsl_verifyd_server_t *server);
+
+/* Serves every submission currently queued without blocking and returns how
+ * many were completed. */
+size_t gdsl_verifyd_server_poll(gdsl_verifyd_server_t *server);
+
+/* Serves submissions until gdsl_verifyd_request_stop is called on the
+ * region. */
+int gdsl_verifyd_server_run(gdsl_verifyd_server_t *server);
+
+/* Asks a running server to return; safe to call from a signal handler or
+ * another process. */
+void gdsl_verifyd_request_stop(void *region);
+
+/* ---- client ---- */
+
+typedef struct {
+    void *region;
+    uint32_t slot;
+    uint8_t *data;
+    size_t capacity;
+} gdsl_verifyd_slot_t;
+
+/* Claims a free slot whose data area can hold at least length bytes. The
+ * caller writes the stream into slot->data and then submits it. */
+int gdsl_verifyd_acquire(void *region, size_t length, gdsl_verifyd_slot_t *slot);
+
+/* Submits the first length bytes of slot->data, waits for the server and
+ * frees the slot. */
+int gdsl_verifyd_submit(gdsl_verifyd_slot_t *slot,
+                        size_t length,
+                        gdsl_verify_level_t level,
+                        gdsl_verifyd_report_t *report);
+
+/* acquire + copy + submit. */
+int gdsl_verifyd_verify(void *region,
+                        const uint8_t *stream,
+                        size_t length,
+                        gdsl_verify_level_t level,
+                        gdsl_verifyd_report_t *report);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GDSL_VERIFYD_H
@@ -0,0 +1,161 @@
+#include "gdsl/bisect.h"
+
+int gdsl_bisect_search(size_t count,
+                       gdsl_bisect_probe_fn probe,
+                       void *ctx,
+                       size_t *out_checkpoint,
+                       size_t *out_probes) {
+    if (!probe || !out_checkpoint) {
+        return -1;
+    }
+    /* The first divergent checkpoint is in [lo, hi]; hi == count is none. */
+    size_t lo = 0;
+    size_t hi = count;
+    size_t probes = 0;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        int agree = probe(ctx, mid);
+        probes++;
+        if (agree < 0) {
+            return -1;
+        }
+        if (agree) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    *out_checkpoint = lo == count ? GDSL_BISECT_NONE : lo;
+    if (out_probes) {
+        *out_probes = probes;
+    }
+    return 0;
+}
+
+typedef struct {
+    const gdsl_merkle_hash_t *a;
+    const gdsl_merkle_hash_t *b;
+} gdsl_bisect_roots_t;
+
+static int roots_agree(void *ctx, size_t checkpoint) {
+    const gdsl_bisect_roots_t *roots = (const gdsl_bisect_roots_t *)ctx;
+    return gdsl_merkle_equal(roots->a[checkpoint], roots->b[checkpoint]);
+}
+
+int gdsl_bisect_checkpoints(const gdsl_merkle_hash_t *roots_a,
+                            const gdsl_merkle_hash_t *roots_b,
+                            size_t count,
+                            size_t *out_checkpoint) {
+    if ((!roots_a || !roots_b) && count > 0) {
+        return -1;
+    }
+    gdsl_bisect_roots_t roots;
+    roots.a = roots_a;
+    roots.b = roots_b;
+    return gdsl_bisect_search(count, roots_agree, &roots, out_checkpoint, NULL);
+}
+
+typedef struct {
+    size_t *pages;
+    size_t max_pages;
+    size_t count;
+} gdsl_bisect_pages_t;
+
+static void report_page(gdsl_bisect_pages_t *out, size_t page) {
+    if (out->pages && out->count < out->max_pages) {
+        out->pages[out->count] = page;
+    }
+    out->count++;
+}
+
+/* Levels of a tree over page_count leaves: level sizes and where each level
+ * starts in the node array. Returns the number of levels. */
+#define GDSL_BISECT_MAX_LEVELS 65
+
+static size_t tree_levels(size_t page_count, size_t *sizes, size_t *begins) {
+    size_t levels = 0;
+    size_t begin = 0;
+    for (size_t size = page_count; ; size = (size + 1) / 2) {
+        sizes[levels] = size;
+        begins[levels] = begin;
+        begin += size;
+        levels++;
+        if (size == 1) {
+            break;
+        }
+    }
+    return levels;
+}
+
+/* Depth-first, left child first, so pages come out in ascending order. */
+static void descend(const gdsl_merkle_tree_t *a,
+                    const gdsl_merkle_tree_t *b,
+                    gdsl_bisect_pages_t *out) {
+    size_t sizes[GDSL_BISECT_MAX_LEVELS];
+    size_t begins[GDSL_BISECT_MAX_LEVELS];
+    size_t levels = tree_levels(a->page_count, sizes, begins);
+
+    struct {
+        size_t level;
+        size_t index;
+    } stack[2 * GDSL_BISECT_MAX_LEVELS];
+    size_t depth = 0;
+    stack[depth].level = levels - 1;
+    stack[depth].index = 0;
+    depth++;
+    while (depth > 0) {
+        depth--;
+        size_t level = stack[depth].level;
+        size_t index = stack[depth].index;
+        size_t node = begins[level] + index;
+        if (gdsl_merkle_equal(a->nodes[node], b->nodes[node])) {
+            continue;
+        }
+        if (level == 0) {
+            report_page(out, index);
+            continue;
+        }
+        size_t left = 2 * index;
+        if (left + 1 < sizes[level - 1]) {
+            stack[depth].level = level - 1;
+            stack[depth].index = left + 1;
+            depth++;
+        }
+        stack[depth].level = level - 1;
+        stack[depth].index = left;
+        depth++;
+    }
+}
+
+int gdsl_bisect_pages(const gdsl_merkle_tree_t *a,
+                      const gdsl_merkle_tree_t *b,
+                      size_t *out_pages,
+                      size_t max_pages,
+                      size_t *out_count) {
+    if (!a || !b || !out_count || !a->nodes || !b->nodes || a->page_size != b->page_size) {
+        return -1;
+    }
+    gdsl_bisect_pages_t out;
+    out.pages = out_pages;
+    out.max_pages = max_pages;
+    out.count = 0;
+
+    if (a->page_count == b->page_count) {
+        descend(a, b, &out);
+    } else {
+        /* Trees of different shapes do not line up above the leaves. */
+        size_t common = a->page_count < b->page_count ? a->page_count : b->page_count;
+        size_t total = a->page_count < b->page_count ? b->page_count : a->page_count;
+        for (size_t page = 0; page < common; ++page) {
+            if (!gdsl_merkle_equal(a->nodes[page], b->nodes[page])) {
+                report_page(&out, page);
+            }
+        }
+        for (size_t page = common; page < total; ++page) {
+            report_page(&out, page);
+        }
+    }
+
+    *out_count = out.count;
+    return out_pages && out.count > max_pages ? -1 : 0;
+}
@@ -0,0 +1,128 @@
+#define _GNU_SOURCE
+
+#include "gdsl/buffer.h"
+
+#include "numa.h"
+
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static size_t round_up(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+static size_t system_page_size(void) {
+    long size = sysconf(_SC_PAGESIZE);
+    return size > 0 ? (size_t)size : 4096;
+}
+
+/* The mapped length is a pure function of the requested one, so
+ * gdsl_buffer_free can recompute it without any bookkeeping. */
+static size_t mapped_length(size_t length) {
+    if (length >= GDSL_BUFFER_HUGE_PAGE_SIZE) {
+        return round_up(length, GDSL_BUFFER_HUGE_PAGE_SIZE);
+    }
+    return round_up(length, system_page_size());
+}
+
+/* Maps length bytes at a huge-page-aligned address by over-mapping and
+ * trimming, so THP can back the whole range. */
+static void *map_aligned(size_t length) {
+    size_t span = length + GDSL_BUFFER_HUGE_PAGE_SIZE;
+    uint8_t *raw = (uint8_t *)mmap(NULL, span, PROT_READ | PROT_WRITE,
+                                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) {
+        return MAP_FAILED;
+    }
+
+    uintptr_t start = (uintptr_t)raw;
+    uintptr_t aligned = round_up(start, GDSL_BUFFER_HUGE_PAGE_SIZE);
+    size_t head = aligned - start;
+    size_t tail = span - head - length;
+    if (head > 0) {
+        munmap(raw, head);
+    }
+    if (tail > 0) {
+        munmap((uint8_t *)aligned + length, tail);
+    }
+    return (void *)aligned;
+}
+
+static void prefault(void *mapping, size_t length) {
+    size_t page = system_page_size();
+    for (size_t offset = 0; offset < length; offset += page) {
+        ((volatile uint8_t *)mapping)[offset] = 0;
+    }
+}
+
+uint8_t *gdsl_buffer_alloc(size_t length, const gdsl_buffer_options_t *options) {
+    if (length == 0) {
+        return NULL;
+    }
+
+    uint32_t flags = options ? options->flags : 0;
+    gdsl_numa_policy_t policy = options ? options->numa_policy : GDSL_NUMA_DEFAULT;
+    size_t map_length = mapped_length(length);
+    int huge = map_length >= GDSL_BUFFER_HUGE_PAGE_SIZE;
+    int populate = (flags & GDSL_BUFFER_POPULATE) &&
+                   policy != GDSL_NUMA_FIRST_TOUCH;
+    /* MAP_POPULATE faults at mmap time, which is only right when no madvise
+     * or mbind has to land first. */
+    int populate_in_mmap = populate && policy == GDSL_NUMA_DEFAULT &&
+                           !(flags & GDSL_BUFFER_SEQUENTIAL);
+    int use_thp = huge && (flags & GDSL_BUFFER_TRANSPARENT_HUGE_PAGES);
+
+    void *mapping = MAP_FAILED;
+#if defined(MAP_HUGETLB)
+    if (huge && (flags & GDSL_BUFFER_HUGE_PAGES)) {
+        mapping = mmap(NULL, map_length, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB |
+                           (populate_in_mmap ? MAP_POPULATE : 0),
+                       -1, 0);
+        /* An empty hugetlb pool is common; THP is the fallback. */
+        use_thp = mapping == MAP_FAILED;
+    }
+#endif
+
+    if (mapping == MAP_FAILED) {
+        if (use_thp) {
+            mapping = map_aligned(map_length);
+            populate_in_mmap = 0;
+        } else {
+            mapping = mmap(NULL, map_length, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS |
+                               (populate_in_mmap ? MAP_POPULATE : 0),
+                           -1, 0);
+        }
+        if (mapping == MAP_FAILED) {
+            return NULL;
+        }
+    }
+
+#if defined(MADV_HUGEPAGE)
+    if (use_thp) {
+        (void)madvise(mapping, map_length, MADV_HUGEPAGE);
+    }
+#endif
+    if (flags & GDSL_BUFFER_SEQUENTIAL) {
+        (void)madvise(mapping, map_length, MADV_SEQUENTIAL);
+    }
+    if (policy == GDSL_NUMA_INTERLEAVE) {
+        /* Placement is a hint; a kernel without mbind still gets a usable
+         * buffer. */
+        (void)gdsl_numa_interleave(mapping, map_length);
+    }
+    if (populate && !populate_in_mmap) {
+        prefault(mapping, map_length);
+    }
+
+    return (uint8_t *)mapping;
+}
+
+void gdsl_buffer_free(uint8_t *buffer, size_t length) {
+    if (!buffer || length == 0) {
+        return;
+    }
+    munmap(buffer, mapped_length(length));
+}
@@ -0,0 +1,405 @@
+#include "gdsl/codegen.h"
+
+#include "opcodes.h"
+#include "verify_rules.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GDSL_CODEGEN_MAX_MESSAGES 64
+
+typedef struct {
+    uint8_t next;
+    uint8_t errors;
+    uint8_t warnings;
+    /* Message id of the first error, meaningful when errors > 0. */
+    uint8_t message;
+} gdsl_codegen_step_t;
+
+typedef struct {
+    gdsl_verify_level_t level;
+    uint8_t opcodes[256];
+    size_t opcode_count;
+    int variable_size;
+
+    /* Reachable state keys, in discovery order; state 0 is the initial one. */
+    size_t keys[GDSL_VERIFY_STATE_KEYS];
+    int state_of_key[GDSL_VERIFY_STATE_KEYS];
+    size_t state_count;
+
+    gdsl_codegen_step_t steps[GDSL_VERIFY_STATE_KEYS][256];
+    gdsl_codegen_step_t finals[GDSL_VERIFY_STATE_KEYS];
+
+    const char *messages[GDSL_CODEGEN_MAX_MESSAGES];
+    char message_text[GDSL_CODEGEN_MAX_MESSAGES][GDSL_VERIFY_MAX_MESSAGE];
+    size_t message_count;
+} gdsl_codegen_model_t;
+
+static int intern_message(gdsl_codegen_model_t *model, const char *text) {
+    for (size_t i = 0; i < model->message_count; ++i) {
+        if (strcmp(model->messages[i], text) == 0) {
+            return (int)i;
+        }
+    }
+    if (model->message_count == GDSL_CODEGEN_MAX_MESSAGES) {
+        return -1;
+    }
+    size_t id = model->message_count++;
+    snprintf(model->message_text[id], GDSL_VERIFY_MAX_MESSAGE, "%s", text);
+    model->messages[id] = model->message_text[id];
+    return (int)id;
+}
+
+/* Folds the diagnostics of one probe into a step. */
+static int summarise(gdsl_codegen_model_t *model,
+                     const gdsl_verify_report_t *report,
+                     gdsl_codegen_step_t *step) {
+    step->errors = (uint8_t)report->error_count;
+    step->warnings = (uint8_t)report->warning_count;
+    step->message = 0;
+    for (size_t i = 0; i < report->diagnostic_count; ++i) {
+        const gdsl_verify_diagnostic_t *diag = &report->diagnostics[i];
+        if (diag->severity == GDSL_VERIFY_SEVERITY_ERROR) {
+            int id = intern_message(model, diag->message);
+            if (id < 0) {
+                return -1;
+            }
+            step->message = (uint8_t)id;
+            break;
+        }
+    }
+    return 0;
+}
+
+static int state_for_key(gdsl_codegen_model_t *model, size_t key) {
+    if (model->state_of_key[key] < 0) {
+        model->state_of_key[key] = (int)model->state_count;
+        model->keys[model->state_count++] = key;
+    }
+    return model->state_of_key[key];
+}
+
+static int build_model(const gdsl_codegen_options_t *options,
+                       gdsl_codegen_model_t *model,
+                       gdsl_verify_report_t *scratch) {
+    memset(model, 0, sizeof(*model));
+    model->level = options->level;
+    for (size_t i = 0; i < GDSL_VERIFY_STATE_KEYS; ++i) {
+        model->state_of_key[i] = -1;
+    }
+
+    int seen[256] = {0};
+    for (size_t i = 0; i < options->opcode_count; ++i) {
+        uint8_t opcode = options->opcodes[i];
+        if (!gdsl_opcode_table[opcode].name ||
+            (gdsl_opcode_table[opcode].flags &
+             (GDSL_OPCODE_FLAG_SYNC | GDSL_OPCODE_FLAG_BINDING |
+              GDSL_OPCODE_FLAG_CONTROL))) {
+            return -1;
+        }
+        if (!seen[opcode]) {
+            seen[opcode] = 1;
+            model->opcodes[model->opcode_count++] = opcode;
+            if (gdsl_opcode_table[opcode].size != 1) {
+                model->variable_size = 1;
+            }
+        }
+    }
+    if (model->opcode_count == 0 ||
+        intern_message(model, "unknown opcode") != 0 ||
+        intern_message(model, "truncated instruction") != 1) {
+        return -1;
+    }
+
+    /* Breadth-first walk over the states reachable with the chosen opcodes;
+     * bytes outside the subset never change the state. */
+    state_for_key(model, gdsl_verify_rules_initial());
+    for (size_t state = 0; state < model->state_count; ++state) {
+        size_t key = model->keys[state];
+        for (size_t column = 0; column < model->opcode_count; ++column) {
+            memset(scratch, 0, sizeof(*scratch));
+            size_t next = gdsl_verify_rules_step(model->level, key,
+                                                 model->opcodes[column], scratch);
+            gdsl_codegen_step_t *step = &model->steps[state][column];
+            if (summarise(model, scratch, step) != 0) {
+                return -1;
+            }
+            step->next = (uint8_t)state_for_key(model, next);
+        }
+
+        memset(scratch, 0, sizeof(*scratch));
+        gdsl_verify_rules_finish(key, scratch);
+        if (summarise(model, scratch, &model->finals[state]) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static const char *level_name(gdsl_verify_level_t level) {
+    switch (level) {
+    case GDSL_VERIFY_LEVEL_SYNTAX:
+        return "SYNTAX";
+    case GDSL_VERIFY_LEVEL_PHASE:
+        return "PHASE";
+    default:
+        return "DOMAIN";
+    }
+}
+
+static void emit_quoted(FILE *out, const char *text) {
+    fputc('"', out);
+    for (const char *c = text; *c; ++c) {
+        if (*c == '"' || *c == '\\') {
+            fputc('\\', out);
+        }
+        fputc(*c, out);
+    }
+    fputc('"', out);
+}
+
+static void emit_declarations(FILE *out, const char *prefix) {
+    /* Continuation lines line up after "int <prefix>_verify(". */
+    int width = (int)strlen(prefix) + 11;
+    fprintf(out,
+            "typedef struct {\n"
+            "    int success;\n"
+            "    uint64_t instruction_count;\n"
+            "    uint64_t error_count;\n"
+            "    uint64_t warning_count;\n"
+            "    /* First error, when error_count > 0. */\n"
+            "    uint64_t first_error_index;\n"
+            "    const char *first_error;\n"
+            "} %s_verify_result_t;\n\n"
+            "int %s_verify(const uint8_t *stream,\n"
+            "%*s size_t length,\n"
+            "%*s %s_verify_result_t *result);\n",
+            prefix, prefix, width, "", width, "", prefix);
+}
+
+static void emit_banner(FILE *out, const gdsl_codegen_model_t *model) {
+    fprintf(out,
+            "/* Generated by gdsl-verifier-gen; do not edit.\n"
+            " * Level %s, %zu opcodes, %zu of %d states:\n *",
+            level_name(model->level), model->opcode_count, model->state_count,
+            GDSL_VERIFY_STATE_KEYS);
+    for (size_t i = 0; i < model->opcode_count; ++i) {
+        fprintf(out, " %s", gdsl_opcode_table[model->opcodes[i]].name);
+    }
+    fprintf(out, "\n */\n\n");
+}
+
+static void emit_source(FILE *out,
+                        const gdsl_codegen_options_t *options,
+                        const gdsl_codegen_model_t *model) {
+    const char *p = options->prefix;
+    int note_width = (int)strlen(p) + 17;
+    int verify_width = (int)strlen(p) + 11;
+
+    emit_banner(out, model);
+    if (options->header_name) {
+        fprintf(out, "#include \"%s\"\n\n", options->header_name);
+    } else {
+        fprintf(out, "#include <stddef.h>\n#include <stdint.h>\n\n");
+        emit_declarations(out, p);
+        fprintf(out, "\n");
+    }
+
+    fprintf(out, "static const char *const %s_messages[%zu] = {\n", p,
+            model->message_count);
+    for (size_t i = 0; i < model->message_count; ++i) {
+        fprintf(out, "    ");
+        emit_quoted(out, model->messages[i]);
+        fprintf(out, ",\n");
+    }
+    fprintf(out, "};\n\n");
+
+    /* Column 0 marks bytes outside the subset. */
+    fprintf(out, "static const uint8_t %s_column[256] = {\n", p);
+    for (size_t i = 0; i < model->opcode_count; ++i) {
+        fprintf(out, "    [0x%02x] = %zu, /* %s */\n", model->opcodes[i], i + 1,
+                gdsl_opcode_table[model->opcodes[i]].name);
+    }
+    fprintf(out, "};\n\n");
+
+    if (model->variable_size) {
+        fprintf(out, "static const uint8_t %s_size[%zu] = {1", p,
+                model->opcode_count + 1);
+        for (size_t i = 0; i < model->opcode_count; ++i) {
+            fprintf(out, ", %u", gdsl_opcode_table[model->opcodes[i]].size);
+        }
+        fprintf(out, "};\n\n");
+    }
+
+    fprintf(out,
+            "typedef struct {\n"
+            "    uint8_t next;\n"
+            "    uint8_t errors;\n"
+            "    uint8_t warnings;\n"
+            "    uint8_t message;\n"
+            "} %s_step_t;\n\n",
+            p);
+    fprintf(out, "static const %s_step_t %s_steps[%zu][%zu] = {\n", p, p,
+            model->state_count, model->opcode_count);
+    for (size_t s = 0; s < model->state_count; ++s) {
+        fprintf(out, "    {");
+        for (size_t c = 0; c < model->opcode_count; ++c) {
+            const gdsl_codegen_step_t *step = &model->steps[s][c];
+            fprintf(out, "%s{%u, %u, %u, %u}", c ? ", " : "", step->next,
+                    step->errors, step->warnings, step->message);
+        }
+        fprintf(out, "},\n");
+    }
+    fprintf(out, "};\n\n");
+
+    fprintf(out, "static const %s_step_t %s_final[%zu] = {\n    ", p, p,
+            model->state_count);
+    for (size_t s = 0; s < model->state_count; ++s) {
+        const gdsl_codegen_step_t *step = &model->finals[s];
+        fprintf(out, "%s{0, %u, %u, %u}", s ? ", " : "", step->errors,
+                step->warnings, step->message);
+    }
+    fprintf(out, "\n};\n\n");
+
+    fprintf(out,
+            "static void %s_note(%s_verify_result_t *result,\n"
+            "%*s const %s_step_t *step,\n"
+            "%*s uint64_t index) {\n"
+            "    if (step->errors && result->error_count == 0) {\n"
+            "        result->first_error_index = index;\n"
+            "        result->first_error = %s_messages[step->message];\n"
+            "    }\n"
+            "    result->error_count += step->errors;\n"
+            "    result->warning_count += step->warnings;\n"
+            "}\n\n",
+            p, p, note_width, "", p, note_width, "", p);
+
+    fprintf(out,
+            "int %s_verify(const uint8_t *stream,\n"
+            "%*s size_t length,\n"
+            "%*s %s_verify_result_t *result) {\n"
+            "    static const %s_step_t unknown = {0, 1, 0, 0};\n"
+            "    if (!result || (!stream && length > 0)) {\n"
+            "        return -1;\n"
+            "    }\n"
+            "    result->success = 0;\n"
+            "    result->instruction_count = 0;\n"
+            "    result->error_count = 0;\n"
+            "    result->warning_count = 0;\n"
+            "    result->first_error_index = 0;\n"
+            "    result->first_error = 0;\n\n"
+            "    unsigned state = 0;\n"
+            "    uint64_t index = 0;\n"
+            "    size_t offset = 0;\n"
+            "    while (offset < length) {\n"
+            "        unsigned column = %s_column[stream[offset]];\n"
+            "        if (column == 0) {\n"
+            "            %s_note(result, &unknown, index);\n"
+            "            offset += 1;\n"
+            "            index++;\n"
+            "            continue;\n"
+            "        }\n",
+            p, verify_width, "", verify_width, "", p, p, p, p);
+    if (model->variable_size) {
+        fprintf(out,
+                "        if (%s_size[column] > length - offset) {\n"
+                "            static const %s_step_t truncated = {0, 1, 0, 1};\n"
+                "            %s_note(result, &truncated, index);\n"
+                "            break;\n"
+                "        }\n",
+                p, p, p);
+    }
+    char advance[96];
+    if (model->variable_size) {
+        snprintf(advance, sizeof(advance), "%s_size[column]", p);
+    } else {
+        snprintf(advance, sizeof(advance), "1");
+    }
+    fprintf(out,
+            "        const %s_step_t *step = &%s_steps[state][column - 1];\n"
+            "        %s_note(result, step, index);\n"
+            "        state = step->next;\n"
+            "        result->instruction_count++;\n"
+            "        offset += %s;\n"
+            "        index++;\n"
+            "    }\n\n"
+            "    %s_note(result, &%s_final[state], index);\n"
+            "    result->success = result->error_count == 0;\n"
+            "    return 0;\n"
+            "}\n",
+            p, p, p, advance, p, p);
+}
+
+static void emit_header(FILE *out,
+                        const gdsl_codegen_options_t *options,
+                        const gdsl_codegen_model_t *model) {
+    char guard[128];
+    size_t n = 0;
+    for (const char *c = options->prefix; *c && n + 10 < sizeof(guard); ++c) {
+        guard[n++] = (char)toupper((unsigned char)*c);
+    }
+    memcpy(guard + n, "_VERIFY_H", 10);
+
+    emit_banner(out, model);
+    fprintf(out, "#ifndef %s\n#define %s\n\n", guard, guard);
+    fprintf(out, "#include <stddef.h>\n#include <stdint.h>\n\n");
+    fprintf(out, "#ifdef __cplusplus\nextern \"C\" {\n#endif\n\n");
+    emit_declarations(out, options->prefix);
+    fprintf(out, "\n#ifdef __cplusplus\n}\n#endif\n\n#endif\n");
+}
+
+static int valid_prefix(const char *prefix) {
+    if (!prefix || !*prefix || isdigit((unsigned char)prefix[0]) ||
+        strlen(prefix) > 64) {
+        return 0;
+    }
+    for (const char *c = prefix; *c; ++c) {
+        if (!isalnum((unsigned char)*c) && *c != '_') {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int gdsl_codegen_verifier(const gdsl_codegen_options_t *options,
+                          FILE *source_out,
+                          FILE *header_out) {
+    if (!options || !source_out || !valid_prefix(options->prefix) ||
+        (!options->opcodes && options->opcode_count > 0) ||
+        (options->header_name && !header_out)) {
+        return -1;
+    }
+
+    gdsl_codegen_model_t *model =
+        (gdsl_codegen_model_t *)malloc(sizeof(gdsl_codegen_model_t));
+    gdsl_verify_report_t *scratch =
+        (gdsl_verify_report_t *)malloc(sizeof(gdsl_verify_report_t));
+    if (!model || !scratch || build_model(options, model, scratch) != 0) {
+        free(scratch);
+        free(model);
+        return -1;
+    }
+    free(scratch);
+
+    emit_source(source_out, options, model);
+    if (options->header_name) {
+        emit_header(header_out, options, model);
+    }
+    int rc = ferror(source_out) || (header_out && ferror(header_out)) ? -1 : 0;
+    free(model);
+    return rc;
+}
+
+int gdsl_codegen_opcode(const char *name) {
+    if (!name) {
+        return -1;
+    }
+    for (int opcode = 0; opcode < 256; ++opcode) {
+        const char *candidate = gdsl_opcode_table[opcode].name;
+        if (candidate && strcmp(candidate, name) == 0) {
+            return opcode;
+        }
+    }
+    return -1;
+}
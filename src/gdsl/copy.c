@@ -0,0 +1,97 @@
+#include "copy.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__SSE2__)
+/* Aligns dst to 16 bytes with a regular copy, then streams whole vectors. */
+static void copy_stream_sse2(uint8_t *dst, const uint8_t *src, size_t length) {
+    size_t head = (16 - ((uintptr_t)dst & 15)) & 15;
+    if (head > length) {
+        head = length;
+    }
+    memcpy(dst, src, head);
+    dst += head;
+    src += head;
+    length -= head;
+
+    size_t blocks = length / 64;
+    for (size_t i = 0; i < blocks; ++i) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(src + 0));
+        __m128i b = _mm_loadu_si128((const __m128i *)(src + 16));
+        __m128i c = _mm_loadu_si128((const __m128i *)(src + 32));
+        __m128i d = _mm_loadu_si128((const __m128i *)(src + 48));
+        _mm_stream_si128((__m128i *)(dst + 0), a);
+        _mm_stream_si128((__m128i *)(dst + 16), b);
+        _mm_stream_si128((__m128i *)(dst + 32), c);
+        _mm_stream_si128((__m128i *)(dst + 48), d);
+        dst += 64;
+        src += 64;
+    }
+    length -= blocks * 64;
+
+    while (length >= 16) {
+        _mm_stream_si128((__m128i *)dst, _mm_loadu_si128((const __m128i *)src));
+        dst += 16;
+        src += 16;
+        length -= 16;
+    }
+    memcpy(dst, src, length);
+}
+
+static void zero_stream_sse2(uint8_t *dst, size_t length) {
+    size_t head = (16 - ((uintptr_t)dst & 15)) & 15;
+    if (head > length) {
+        head = length;
+    }
+    memset(dst, 0, head);
+    dst += head;
+    length -= head;
+
+    __m128i zero = _mm_setzero_si128();
+    while (length >= 16) {
+        _mm_stream_si128((__m128i *)dst, zero);
+        dst += 16;
+        length -= 16;
+    }
+    memset(dst, 0, length);
+}
+#endif
+
+void gdsl_copy(void *dst, const void *src, size_t length, int streaming) {
+#if defined(__SSE2__)
+    if (streaming) {
+        copy_stream_sse2((uint8_t *)dst, (const uint8_t *)src, length);
+        return;
+    }
+#else
+    (void)streaming;
+#endif
+    memcpy(dst, src, length);
+}
+
+void gdsl_zero(void *dst, size_t length, int streaming) {
+#if defined(__SSE2__)
+    if (streaming) {
+        zero_stream_sse2((uint8_t *)dst, length);
+        return;
+    }
+#else
+    (void)streaming;
+#endif
+    memset(dst, 0, length);
+}
+
+void gdsl_copy_fence(int streaming) {
+#if defined(__SSE2__)
+    if (streaming) {
+        _mm_sfence();
+    }
+#else
+    (void)streaming;
+#endif
+}
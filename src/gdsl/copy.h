@@ -0,0 +1,18 @@
+#ifndef GDSL_COPY_INTERNAL_H
+#define GDSL_COPY_INTERNAL_H
+
+#include <stddef.h>
+
+/* Copy kernels for bulk payload movement. With streaming set, data goes out
+ * through non-temporal stores and does not displace the caller's working
+ * set; otherwise these are plain memcpy/memset. Streaming stores are weakly
+ * ordered: the thread that issued them must call gdsl_copy_fence before the
+ * data is handed to another thread. */
+
+void gdsl_copy(void *dst, const void *src, size_t length, int streaming);
+
+void gdsl_zero(void *dst, size_t length, int streaming);
+
+void gdsl_copy_fence(int streaming);
+
+#endif // GDSL_COPY_INTERNAL_H
@@ -0,0 +1,357 @@
+#include "gdsl/dedup.h"
+
+#include "dedup_scan.h"
+#include "hash.h"
+#include "opcodes.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/*
+ * Canonical scan. Most bytes are one-byte instructions that are hashed as
+ * they are; only debug opcodes and multi-byte opcodes need a closer look.
+ * Those "special" opcodes are collected once from the opcode table, and the
+ * scan finds the next one sixteen bytes at a time: a range compare against
+ * the lowest and highest special opcode picks out candidates, and the bitmap
+ * confirms them, so the vector test costs the same however many opcodes are
+ * special. One-byte opcodes inside the range (BEGIN_PASS, ELSE, ...) are
+ * the only false candidates. Everything between two debug instructions is
+ * fed to the hash as one span, straight from the stream.
+ */
+typedef struct {
+    uint32_t mask[8];
+    uint8_t low;
+    uint8_t high;
+    size_t value_count;
+} gdsl_special_set_t;
+
+static gdsl_special_set_t gdsl_special_set;
+static pthread_once_t gdsl_special_once = PTHREAD_ONCE_INIT;
+
+static void build_special_set(void) {
+    gdsl_special_set_t *set = &gdsl_special_set;
+    for (unsigned opcode = 0; opcode < 256; ++opcode) {
+        const gdsl_opcode_metadata_t *meta = &gdsl_opcode_table[opcode];
+        if (!meta->name ||
+            (meta->size == 1 && !(meta->flags & GDSL_OPCODE_FLAG_DEBUG))) {
+            continue;
+        }
+        set->mask[opcode >> 5] |= 1u << (opcode & 31);
+        if (set->value_count == 0) {
+            set->low = (uint8_t)opcode;
+        }
+        set->high = (uint8_t)opcode;
+        set->value_count++;
+    }
+}
+
+static int special_contains(const gdsl_special_set_t *set, uint8_t opcode) {
+    return (set->mask[opcode >> 5] >> (opcode & 31)) & 1u;
+}
+
+int gdsl_stream_scan_vectorized(void) {
+#if defined(__SSE2__)
+    pthread_once(&gdsl_special_once, build_special_set);
+    return gdsl_special_set.value_count > 0;
+#else
+    return 0;
+#endif
+}
+
+/* Number of bytes before the first special opcode in bytes. */
+static size_t plain_run_length(const gdsl_special_set_t *set,
+                               const uint8_t *bytes,
+                               size_t length) {
+    size_t run = 0;
+#if defined(__SSE2__)
+    if (set->value_count == 0) {
+        return length;
+    }
+    /* byte - low <= high - low, unsigned: min(x, span) == x. */
+    const __m128i low = _mm_set1_epi8((char)set->low);
+    const __m128i span = _mm_set1_epi8((char)(set->high - set->low));
+    while (run + 16 <= length) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(bytes + run));
+        __m128i offset = _mm_sub_epi8(chunk, low);
+        __m128i hit = _mm_cmpeq_epi8(_mm_min_epu8(offset, span), offset);
+        unsigned found = (unsigned)_mm_movemask_epi8(hit);
+        while (found) {
+            size_t at = run + (size_t)__builtin_ctz(found);
+            if (special_contains(set, bytes[at])) {
+                return at;
+            }
+            found &= found - 1;
+        }
+        run += 16;
+    }
+#endif
+    while (run < length && !special_contains(set, bytes[run])) {
+        run++;
+    }
+    return run;
+}
+
+int gdsl_stream_hash(const uint8_t *stream, size_t length, gdsl_stream_hash_t *out) {
+    if (!out || (!stream && length > 0)) {
+        return -1;
+    }
+    pthread_once(&gdsl_special_once, build_special_set);
+    const gdsl_special_set_t *set = &gdsl_special_set;
+
+    gdsl_hash128_stream_t hasher;
+    gdsl_hash128_stream_init(&hasher);
+
+    size_t span = 0;
+    size_t pos = 0;
+    while (pos < length) {
+        pos += plain_run_length(set, stream + pos, length - pos);
+        if (pos >= length) {
+            break;
+        }
+        const gdsl_opcode_metadata_t *meta = &gdsl_opcode_table[stream[pos]];
+        if (meta->size == 0 || meta->size > length - pos) {
+            /* Malformed from here on; the verifier stops at this byte, so
+             * the rest is hashed verbatim. */
+            break;
+        }
+        if (meta->flags & GDSL_OPCODE_FLAG_DEBUG) {
+            gdsl_hash128_stream_update(&hasher, stream + span, pos - span);
+            span = pos + meta->size;
+        }
+        pos += meta->size;
+    }
+    gdsl_hash128_stream_update(&hasher, stream + span, length - span);
+
+    gdsl_hash128_t hash = gdsl_hash128_stream_final(&hasher);
+    out->lo = hash.lo;
+    out->hi = hash.hi;
+    return 0;
+}
+
+/*
+ * Index: open addressing with linear probing, kept at most half full. A
+ * single mutex guards it; verification runs outside the lock, so two
+ * uploads of the same new stream may both verify it, with the same result.
+ */
+typedef struct {
+    int used;
+    gdsl_dedup_entry_t entry;
+} gdsl_dedup_slot_t;
+
+struct gdsl_dedup_index {
+    pthread_mutex_t lock;
+    gdsl_dedup_slot_t *slots;
+    size_t mask;
+    size_t count;
+};
+
+static size_t round_pow2(size_t value) {
+    size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+static int hash_equal(const gdsl_stream_hash_t *a, const gdsl_stream_hash_t *b) {
+    return a->lo == b->lo && a->hi == b->hi;
+}
+
+/* Slot holding hash, or the empty slot where it would go. */
+static gdsl_dedup_slot_t *index_find(gdsl_dedup_slot_t *slots,
+                                     size_t mask,
+                                     const gdsl_stream_hash_t *hash) {
+    size_t i = (size_t)hash->lo & mask;
+    while (slots[i].used && !hash_equal(&slots[i].entry.hash, hash)) {
+        i = (i + 1) & mask;
+    }
+    return &slots[i];
+}
+
+static int index_grow(gdsl_dedup_index_t *index) {
+    size_t capacity = (index->mask + 1) * 2;
+    gdsl_dedup_slot_t *slots =
+        (gdsl_dedup_slot_t *)calloc(capacity, sizeof(gdsl_dedup_slot_t));
+    if (!slots) {
+        return -1;
+    }
+    for (size_t i = 0; i <= index->mask; ++i) {
+        if (index->slots[i].used) {
+            *index_find(slots, capacity - 1, &index->slots[i].entry.hash) =
+                index->slots[i];
+        }
+    }
+    free(index->slots);
+    index->slots = slots;
+    index->mask = capacity - 1;
+    return 0;
+}
+
+int gdsl_dedup_index_create(size_t capacity, gdsl_dedup_index_t **out_index) {
+    if (!out_index) {
+        return -1;
+    }
+    *out_index = NULL;
+    if (capacity == 0) {
+        capacity = 1024;
+    }
+    if (capacity > SIZE_MAX / 2 / sizeof(gdsl_dedup_slot_t)) {
+        return -1;
+    }
+
+    gdsl_dedup_index_t *index = (gdsl_dedup_index_t *)calloc(1, sizeof(*index));
+    if (!index) {
+        return -1;
+    }
+    size_t slots = round_pow2(capacity * 2);
+    index->slots = (gdsl_dedup_slot_t *)calloc(slots, sizeof(gdsl_dedup_slot_t));
+    if (!index->slots) {
+        free(index);
+        return -1;
+    }
+    index->mask = slots - 1;
+    pthread_mutex_init(&index->lock, NULL);
+
+    *out_index = index;
+    return 0;
+}
+
+void gdsl_dedup_index_destroy(gdsl_dedup_index_t *index) {
+    if (!index) {
+        return;
+    }
+    pthread_mutex_destroy(&index->lock);
+    free(index->slots);
+    free(index);
+}
+
+size_t gdsl_dedup_index_count(gdsl_dedup_index_t *index) {
+    if (!index) {
+        return 0;
+    }
+    pthread_mutex_lock(&index->lock);
+    size_t count = index->count;
+    pthread_mutex_unlock(&index->lock);
+    return count;
+}
+
+int gdsl_dedup_admit(gdsl_dedup_index_t *index,
+                     const uint8_t *stream,
+                     size_t length,
+                     uint64_t stream_id,
+                     gdsl_dedup_entry_t *out) {
+    gdsl_stream_hash_t hash;
+    if (!index || gdsl_stream_hash(stream, length, &hash) != 0) {
+        return -1;
+    }
+
+    int rc = -1;
+    pthread_mutex_lock(&index->lock);
+    gdsl_dedup_slot_t *slot = index_find(index->slots, index->mask, &hash);
+    if (slot->used) {
+        rc = 1;
+    } else if ((index->count + 1) * 2 > index->mask + 1 &&
+               index_grow(index) != 0) {
+        slot = NULL;
+    } else {
+        slot = index_find(index->slots, index->mask, &hash);
+        memset(slot, 0, sizeof(*slot));
+        slot->used = 1;
+        slot->entry.hash = hash;
+        slot->entry.stream_id = stream_id;
+        slot->entry.diff_base_id = GDSL_DEDUP_NONE;
+        index->count++;
+        rc = 0;
+    }
+    if (slot && out) {
+        *out = slot->entry;
+    }
+    pthread_mutex_unlock(&index->lock);
+    return rc;
+}
+
+int gdsl_dedup_lookup(gdsl_dedup_index_t *index,
+                      const gdsl_stream_hash_t *hash,
+                      gdsl_dedup_entry_t *out) {
+    if (!index || !hash) {
+        return 0;
+    }
+    pthread_mutex_lock(&index->lock);
+    gdsl_dedup_slot_t *slot = index_find(index->slots, index->mask, hash);
+    int found = slot->used;
+    if (found && out) {
+        *out = slot->entry;
+    }
+    pthread_mutex_unlock(&index->lock);
+    return found;
+}
+
+int gdsl_dedup_verify(gdsl_dedup_index_t *index,
+                      const gdsl_stream_hash_t *hash,
+                      const uint8_t *stream,
+                      size_t length,
+                      gdsl_verify_level_t level,
+                      gdsl_dedup_certificate_t *out) {
+    if (!index || !hash || !out || level < GDSL_VERIFY_LEVEL_SYNTAX ||
+        level > GDSL_VERIFY_LEVEL_DOMAIN) {
+        return -1;
+    }
+    uint32_t bit = 1u << level;
+
+    pthread_mutex_lock(&index->lock);
+    gdsl_dedup_slot_t *slot = index_find(index->slots, index->mask, hash);
+    int cached = slot->used && (slot->entry.verified_levels & bit);
+    if (cached) {
+        *out = slot->entry.certificates[level];
+    }
+    pthread_mutex_unlock(&index->lock);
+    if (cached) {
+        return 1;
+    }
+
+    gdsl_verify_report_t *report =
+        (gdsl_verify_report_t *)malloc(sizeof(gdsl_verify_report_t));
+    if (!report) {
+        return -1;
+    }
+    if (gdsl_verify(stream, length, level, report) != 0) {
+        free(report);
+        return -1;
+    }
+    out->success = report->success;
+    out->error_count = report->error_count;
+    out->warning_count = report->warning_count;
+    out->info_count = report->info_count;
+    free(report);
+
+    pthread_mutex_lock(&index->lock);
+    slot = index_find(index->slots, index->mask, hash);
+    if (slot->used) {
+        slot->entry.certificates[level] = *out;
+        slot->entry.verified_levels |= bit;
+    }
+    pthread_mutex_unlock(&index->lock);
+    return 0;
+}
+
+int gdsl_dedup_set_diff_base(gdsl_dedup_index_t *index,
+                             const gdsl_stream_hash_t *hash,
+                             uint64_t diff_base_id) {
+    if (!index || !hash) {
+        return -1;
+    }
+    pthread_mutex_lock(&index->lock);
+    gdsl_dedup_slot_t *slot = index_find(index->slots, index->mask, hash);
+    int rc = -1;
+    if (slot->used) {
+        slot->entry.diff_base_id = diff_base_id;
+        rc = 0;
+    }
+    pthread_mutex_unlock(&index->lock);
+    return rc;
+}
@@ -0,0 +1,9 @@
+#ifndef GDSL_DEDUP_SCAN_INTERNAL_H
+#define GDSL_DEDUP_SCAN_INTERNAL_H
+
+/* 1 when gdsl_stream_hash looks for special opcodes sixteen bytes at a time
+ * with the built-in opcode table, 0 when it falls back to the byte loop.
+ * Exposed so the tests notice if the vector scan stops being used. */
+int gdsl_stream_scan_vectorized(void);
+
+#endif // GDSL_DEDUP_SCAN_INTERNAL_H
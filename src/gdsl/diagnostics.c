@@ -0,0 +1,262 @@
+#include "gdsl/diagnostics.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    gdsl_verify_diagnostic_t *entries;
+    size_t count;
+    size_t capacity;
+    uint64_t error_count;
+    uint64_t warning_count;
+    uint64_t info_count;
+    /* Keeps neighbouring workers' counters off each other's cache line. */
+    char padding[16];
+} gdsl_diag_buffer_t;
+
+struct gdsl_diag_collector {
+    gdsl_diag_buffer_t *buffers;
+    size_t worker_count;
+};
+
+int gdsl_diag_collector_create(size_t worker_count,
+                               gdsl_diag_collector_t **out_collector) {
+    if (!out_collector || worker_count == 0) {
+        return -1;
+    }
+    *out_collector = NULL;
+
+    gdsl_diag_collector_t *collector =
+        (gdsl_diag_collector_t *)calloc(1, sizeof(*collector));
+    if (!collector) {
+        return -1;
+    }
+    collector->buffers =
+        (gdsl_diag_buffer_t *)calloc(worker_count, sizeof(gdsl_diag_buffer_t));
+    if (!collector->buffers) {
+        free(collector);
+        return -1;
+    }
+    collector->worker_count = worker_count;
+
+    *out_collector = collector;
+    return 0;
+}
+
+void gdsl_diag_collector_destroy(gdsl_diag_collector_t *collector) {
+    if (!collector) {
+        return;
+    }
+    for (size_t i = 0; i < collector->worker_count; ++i) {
+        free(collector->buffers[i].entries);
+    }
+    free(collector->buffers);
+    free(collector);
+}
+
+void gdsl_diag_collector_reset(gdsl_diag_collector_t *collector) {
+    if (!collector) {
+        return;
+    }
+    for (size_t i = 0; i < collector->worker_count; ++i) {
+        gdsl_diag_buffer_t *buffer = &collector->buffers[i];
+        buffer->count = 0;
+        buffer->error_count = 0;
+        buffer->warning_count = 0;
+        buffer->info_count = 0;
+    }
+}
+
+static gdsl_verify_diagnostic_t *append_entry(gdsl_diag_buffer_t *buffer) {
+    if (buffer->count == buffer->capacity) {
+        size_t capacity = buffer->capacity ? buffer->capacity * 2 : 16;
+        gdsl_verify_diagnostic_t *entries = (gdsl_verify_diagnostic_t *)realloc(
+            buffer->entries, capacity * sizeof(*entries));
+        if (!entries) {
+            return NULL;
+        }
+        buffer->entries = entries;
+        buffer->capacity = capacity;
+    }
+    return &buffer->entries[buffer->count++];
+}
+
+static void count_severity(gdsl_diag_buffer_t *buffer,
+                           gdsl_verify_severity_t severity,
+                           uint64_t occurrences) {
+    if (severity == GDSL_VERIFY_SEVERITY_ERROR) {
+        buffer->error_count += occurrences;
+    } else if (severity == GDSL_VERIFY_SEVERITY_WARNING) {
+        buffer->warning_count += occurrences;
+    } else {
+        buffer->info_count += occurrences;
+    }
+}
+
+int gdsl_diag_collector_add(gdsl_diag_collector_t *collector,
+                            size_t worker,
+                            uint64_t instruction_index,
+                            gdsl_verify_severity_t severity,
+                            const char *message) {
+    if (!collector || worker >= collector->worker_count || !message) {
+        return -1;
+    }
+
+    gdsl_diag_buffer_t *buffer = &collector->buffers[worker];
+    gdsl_verify_diagnostic_t *diag = append_entry(buffer);
+    if (!diag) {
+        return -1;
+    }
+    memset(diag, 0, sizeof(*diag));
+    diag->instruction_index = instruction_index;
+    diag->severity = severity;
+    strncpy(diag->message, message, GDSL_VERIFY_MAX_MESSAGE - 1);
+    diag->occurrence_count = 1;
+    diag->last_instruction_index = instruction_index;
+
+    count_severity(buffer, severity, 1);
+    return 0;
+}
+
+int gdsl_diag_collector_add_report(gdsl_diag_collector_t *collector,
+                                   size_t worker,
+                                   const gdsl_verify_report_t *report,
+                                   uint64_t index_base,
+                                   uint64_t offset_base) {
+    if (!collector || worker >= collector->worker_count || !report) {
+        return -1;
+    }
+
+    gdsl_diag_buffer_t *buffer = &collector->buffers[worker];
+    for (size_t i = 0; i < report->diagnostic_count; ++i) {
+        gdsl_verify_diagnostic_t *diag = append_entry(buffer);
+        if (!diag) {
+            return -1;
+        }
+        const gdsl_verify_diagnostic_t *source = &report->diagnostics[i];
+        memset(diag, 0, sizeof(*diag));
+        diag->instruction_index = source->instruction_index + index_base;
+        diag->byte_offset = source->byte_offset + offset_base;
+        diag->severity = source->severity;
+        strncpy(diag->message, source->message, GDSL_VERIFY_MAX_MESSAGE - 1);
+        diag->occurrence_count = source->occurrence_count;
+        diag->last_instruction_index =
+            source->last_instruction_index + index_base;
+        if (diag->occurrence_count == 0) {
+            diag->occurrence_count = 1;
+            diag->last_instruction_index = diag->instruction_index;
+        }
+    }
+
+    buffer->error_count += report->error_count;
+    buffer->warning_count += report->warning_count;
+    buffer->info_count += report->info_count;
+    return 0;
+}
+
+/* Groups equal (severity, message) pairs together; ties are broken on the
+ * remaining fields so the order is total. */
+static int compare_by_key(const void *a, const void *b) {
+    const gdsl_verify_diagnostic_t *x = (const gdsl_verify_diagnostic_t *)a;
+    const gdsl_verify_diagnostic_t *y = (const gdsl_verify_diagnostic_t *)b;
+    if (x->severity != y->severity) {
+        return x->severity < y->severity ? 1 : -1;
+    }
+    int order = strcmp(x->message, y->message);
+    if (order != 0) {
+        return order;
+    }
+    if (x->instruction_index != y->instruction_index) {
+        return x->instruction_index < y->instruction_index ? -1 : 1;
+    }
+    if (x->last_instruction_index != y->last_instruction_index) {
+        return x->last_instruction_index < y->last_instruction_index ? -1 : 1;
+    }
+    if (x->occurrence_count != y->occurrence_count) {
+        return x->occurrence_count < y->occurrence_count ? -1 : 1;
+    }
+    return 0;
+}
+
+/* Report order: first occurrence, then severity (errors first), then text. */
+static int compare_by_index(const void *a, const void *b) {
+    const gdsl_verify_diagnostic_t *x = (const gdsl_verify_diagnostic_t *)a;
+    const gdsl_verify_diagnostic_t *y = (const gdsl_verify_diagnostic_t *)b;
+    if (x->instruction_index != y->instruction_index) {
+        return x->instruction_index < y->instruction_index ? -1 : 1;
+    }
+    return compare_by_key(a, b);
+}
+
+int gdsl_diag_collector_merge(gdsl_diag_collector_t *collector,
+                              gdsl_verify_report_t *report) {
+    if (!collector || !report) {
+        return -1;
+    }
+
+    memset(report, 0, sizeof(*report));
+    report->flags = GDSL_VERIFY_REPORT_AGGREGATED;
+
+    size_t total = 0;
+    for (size_t i = 0; i < collector->worker_count; ++i) {
+        const gdsl_diag_buffer_t *buffer = &collector->buffers[i];
+        total += buffer->count;
+        report->error_count += buffer->error_count;
+        report->warning_count += buffer->warning_count;
+        report->info_count += buffer->info_count;
+    }
+
+    gdsl_verify_diagnostic_t *all = NULL;
+    if (total > 0) {
+        all = (gdsl_verify_diagnostic_t *)malloc(total * sizeof(*all));
+        if (!all) {
+            return -1;
+        }
+    }
+    size_t filled = 0;
+    for (size_t i = 0; i < collector->worker_count; ++i) {
+        const gdsl_diag_buffer_t *buffer = &collector->buffers[i];
+        if (buffer->count > 0) {
+            memcpy(all + filled, buffer->entries, buffer->count * sizeof(*all));
+            filled += buffer->count;
+        }
+    }
+
+    /* Fold each run of equal keys into its first entry. */
+    size_t groups = 0;
+    if (total > 0) {
+        qsort(all, total, sizeof(*all), compare_by_key);
+        for (size_t i = 0; i < total; ++i) {
+            gdsl_verify_diagnostic_t *diag = &all[i];
+            gdsl_verify_diagnostic_t *group = groups ? &all[groups - 1] : NULL;
+            if (group && group->severity == diag->severity &&
+                strcmp(group->message, diag->message) == 0) {
+                group->occurrence_count += diag->occurrence_count;
+                if (diag->last_instruction_index > group->last_instruction_index) {
+                    group->last_instruction_index = diag->last_instruction_index;
+                }
+                continue;
+            }
+            if (groups != i) {
+                all[groups] = *diag;
+            }
+            groups++;
+        }
+        qsort(all, groups, sizeof(*all), compare_by_index);
+    }
+
+    size_t kept = groups < GDSL_VERIFY_MAX_DIAGNOSTICS ? groups
+                                                       : GDSL_VERIFY_MAX_DIAGNOSTICS;
+    if (kept > 0) {
+        memcpy(report->diagnostics, all, kept * sizeof(*all));
+    }
+    report->diagnostic_count = kept;
+    if (groups > kept) {
+        report->dropped_diagnostic_count = groups - kept;
+        report->flags |= GDSL_VERIFY_REPORT_DIAGNOSTICS_TRUNCATED;
+    }
+    report->success = (report->error_count == 0);
+
+    free(all);
+    return 0;
+}
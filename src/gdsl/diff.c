@@ -1,11 +1,23 @@
+#define _GNU_SOURCE
+
 #include "gdsl/diff.h"
 
+#include "copy.h"
+#include "hash.h"
+
+#include <errno.h>
+#include <fcntl.h>
 #include <limits.h>
+#include <math.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 #define GDSL_DIFF_VERSION 1u
 #define GDSL_DEFAULT_PAGE_SIZE 4096u
+#define GDSL_DEFAULT_STREAMING_THRESHOLD ((size_t)32 << 20)
 
 static size_t page_count_for_length(size_t length, size_t page_size) {
     if (length == 0) {
@@ -50,23 +62,130 @@ void gdsl_diff_result_destroy(gdsl_diff_result_t *result) {
     }
 
     free(result->chunks);
-    free(result->payload);
+    if (result->payload_storage == GDSL_DIFF_STORAGE_MAPPED) {
+        gdsl_buffer_free(result->payload, result->payload_length);
+    } else if (result->payload_storage == GDSL_DIFF_STORAGE_FILE) {
+        if (result->payload) {
+            munmap(result->payload, result->payload_length);
+        }
+        close(result->payload_fd);
+        result->payload_fd = -1;
+    } else {
+        free(result->payload);
+    }
     result->chunks = NULL;
     result->payload = NULL;
     result->chunk_count = 0;
     result->payload_length = 0;
+    result->payload_storage = GDSL_DIFF_STORAGE_HEAP;
     result->header.chunk_count = 0;
     result->header.target_length = 0;
 }
 
+static int uses_buffer_layer(const gdsl_diff_options_t *options) {
+    return options && (options->memory.numa_policy != GDSL_NUMA_DEFAULT ||
+                       options->memory.flags != 0);
+}
+
+static int partition_statically(const gdsl_diff_options_t *options) {
+    return options && options->pool &&
+           options->memory.numa_policy == GDSL_NUMA_FIRST_TOUCH;
+}
+
+/* Runs fn over [0, count) either with stealing or with the fixed
+ * worker-to-range mapping first-touch placement relies on. */
+static int run_blocks(const gdsl_diff_options_t *options,
+                      size_t count,
+                      size_t grain,
+                      gdsl_pool_range_fn fn,
+                      void *ctx) {
+    gdsl_pool_t *pool = options ? options->pool : NULL;
+    if (partition_statically(options)) {
+        return gdsl_pool_parallel_for_static(pool, 0, count, fn, ctx);
+    }
+    return gdsl_pool_parallel_for(pool, 0, count, grain, fn, ctx);
+}
+
+/* Operations that move at least the threshold in total use non-temporal
+ * stores: their output is not read again soon and would otherwise evict the
+ * caller's working set. */
+static int use_streaming(const gdsl_diff_options_t *options, size_t total_bytes) {
+    size_t threshold = GDSL_DEFAULT_STREAMING_THRESHOLD;
+    if (options && options->streaming_threshold != 0) {
+        threshold = options->streaming_threshold;
+    }
+    return total_bytes >= threshold;
+}
+
+static int open_spill_file(const gdsl_diff_options_t *options) {
+    const char *directory = options->spill_directory;
+    if (!directory) {
+        directory = getenv("TMPDIR");
+    }
+    if (!directory || directory[0] == '\0') {
+        directory = "/tmp";
+    }
+#ifdef O_TMPFILE
+    int fd = open(directory, O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+    if (fd >= 0 || (errno != EOPNOTSUPP && errno != EISDIR && errno != EINVAL)) {
+        return fd;
+    }
+#endif
+    /* Filesystems without O_TMPFILE: create and unlink straight away. */
+    char path[4096];
+    if (snprintf(path, sizeof(path), "%s/gdsl-diff-XXXXXX", directory) >= (int)sizeof(path)) {
+        return -1;
+    }
+    int named = mkstemp(path);
+    if (named >= 0) {
+        unlink(path);
+    }
+    return named;
+}
+
+/* Maps a spill file of payload_size bytes as the payload. */
+static int spill_payload(gdsl_diff_result_t *out,
+                         size_t payload_size,
+                         const gdsl_diff_options_t *options) {
+    int fd = open_spill_file(options);
+    if (fd < 0) {
+        return -1;
+    }
+    void *payload = MAP_FAILED;
+    if (ftruncate(fd, (off_t)payload_size) == 0) {
+        payload = mmap(NULL, payload_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if (payload == MAP_FAILED) {
+        close(fd);
+        return -1;
+    }
+    out->payload = (uint8_t *)payload;
+    out->payload_fd = fd;
+    out->payload_storage = GDSL_DIFF_STORAGE_FILE;
+    return 0;
+}
+
 static int ensure_capacity(gdsl_diff_result_t *out,
                            size_t chunk_count,
-                           size_t payload_size) {
+                           size_t payload_size,
+                           const gdsl_diff_options_t *options) {
     out->chunks = (gdsl_diff_chunk_t *)malloc(chunk_count * sizeof(gdsl_diff_chunk_t));
     if (!out->chunks && chunk_count > 0) {
         return -1;
     }
-    out->payload = (uint8_t *)malloc(payload_size);
+    if (options && options->memory_budget != 0 && payload_size > options->memory_budget) {
+        if (spill_payload(out, payload_size, options) != 0) {
+            free(out->chunks);
+            out->chunks = NULL;
+            return -1;
+        }
+    } else if (uses_buffer_layer(options)) {
+        out->payload = gdsl_buffer_alloc(payload_size, &options->memory);
+        out->payload_storage = GDSL_DIFF_STORAGE_MAPPED;
+    } else {
+        out->payload = (uint8_t *)malloc(payload_size);
+        out->payload_storage = GDSL_DIFF_STORAGE_HEAP;
+    }
     if (!out->payload && payload_size > 0) {
         free(out->chunks);
         out->chunks = NULL;
@@ -77,11 +196,315 @@ static int ensure_capacity(gdsl_diff_result_t *out,
     return 0;
 }
 
+/* Pages are scanned and emitted in blocks so that both passes can be split
+ * across a pool, and so that the second pass reuses the change flags of the
+ * first instead of comparing every page twice. */
+#define GDSL_DIFF_BLOCK_PAGES 64u
+
+/* Per-page verdicts of the scan pass. */
+#define GDSL_DIFF_PAGE_UNCHANGED 0u
+#define GDSL_DIFF_PAGE_CHANGED 1u
+#define GDSL_DIFF_PAGE_REFERENCED 2u
+
+/* Full pages of the references of a multi-reference diff, keyed by the low
+ * half of their hash128. Linear probing over slots inserted in reference
+ * order, so a lookup meets the earliest matching reference first. */
+typedef struct {
+    uint64_t key;
+    size_t reference; /* reference number + 1; 0 marks an empty slot */
+    size_t offset;    /* byte offset of the page in its reference */
+} gdsl_diff_index_slot_t;
+
+typedef struct {
+    gdsl_diff_index_slot_t *slots;
+    size_t mask;
+} gdsl_diff_page_index_t;
+
+typedef struct {
+    const uint8_t *base;
+    size_t base_length;
+    const uint8_t *target;
+    size_t target_length;
+    size_t page_size;
+    size_t total_pages;
+    uint8_t *changed;
+    size_t *block_chunks;
+    size_t *block_payload;
+    int streaming;
+    gdsl_diff_result_t *out;
+    /* Multi-reference mode only: where each referenced page comes from. */
+    const gdsl_diff_reference_t *references;
+    const gdsl_diff_page_index_t *index;
+    size_t *match_reference;
+    size_t *match_offset;
+} gdsl_diff_scan_t;
+
+static size_t page_target_span(const gdsl_diff_scan_t *scan, size_t page_index) {
+    size_t page_offset = page_index * scan->page_size;
+    return min_size(scan->page_size, scan->target_length - page_offset);
+}
+
+static int page_changed(const gdsl_diff_scan_t *scan, size_t page_index) {
+    size_t page_offset = page_index * scan->page_size;
+    size_t target_span = page_target_span(scan, page_index);
+    const uint8_t *target_ptr = scan->target + page_offset;
+
+    /* Bytes past the end of base compare as zero. */
+    size_t base_available = 0;
+    if (page_offset < scan->base_length) {
+        base_available = min_size(target_span, scan->base_length - page_offset);
+        if (memcmp(scan->base + page_offset, target_ptr, base_available) != 0) {
+            return 1;
+        }
+    }
+    for (size_t i = base_available; i < target_span; ++i) {
+        if (target_ptr[i] != 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Looks a changed full target page up among the reference pages. */
+static int find_reference_page(const gdsl_diff_scan_t *scan, size_t page_index) {
+    const uint8_t *page = scan->target + page_index * scan->page_size;
+    uint64_t key = gdsl_hash128(page, scan->page_size).lo;
+    const gdsl_diff_page_index_t *index = scan->index;
+    for (size_t slot = (size_t)key & index->mask; index->slots[slot].reference != 0;
+         slot = (slot + 1) & index->mask) {
+        const gdsl_diff_index_slot_t *entry = &index->slots[slot];
+        if (entry->key != key) {
+            continue;
+        }
+        const gdsl_diff_reference_t *reference = &scan->references[entry->reference - 1];
+        if (memcmp(reference->data + entry->offset, page, scan->page_size) == 0) {
+            scan->match_reference[page_index] = entry->reference;
+            scan->match_offset[page_index] = entry->offset;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void scan_blocks(void *ctx, size_t begin, size_t end, size_t worker) {
+    gdsl_diff_scan_t *scan = (gdsl_diff_scan_t *)ctx;
+    (void)worker;
+
+    for (size_t block = begin; block < end; ++block) {
+        size_t first = block * GDSL_DIFF_BLOCK_PAGES;
+        size_t last = min_size(first + GDSL_DIFF_BLOCK_PAGES, scan->total_pages);
+        size_t chunks = 0;
+        size_t payload = 0;
+        for (size_t page_index = first; page_index < last; ++page_index) {
+            uint8_t changed = GDSL_DIFF_PAGE_UNCHANGED;
+            if (page_changed(scan, page_index)) {
+                size_t span = page_target_span(scan, page_index);
+                changed = GDSL_DIFF_PAGE_CHANGED;
+                if (scan->index && span == scan->page_size &&
+                    find_reference_page(scan, page_index)) {
+                    changed = GDSL_DIFF_PAGE_REFERENCED;
+                } else {
+                    payload += span;
+                }
+                chunks++;
+            }
+            scan->changed[page_index] = changed;
+        }
+        scan->block_chunks[block] = chunks;
+        scan->block_payload[block] = payload;
+    }
+}
+
+static void emit_blocks(void *ctx, size_t begin, size_t end, size_t worker) {
+    gdsl_diff_scan_t *scan = (gdsl_diff_scan_t *)ctx;
+    gdsl_diff_result_t *out = scan->out;
+    (void)worker;
+
+    for (size_t block = begin; block < end; ++block) {
+        size_t first = block * GDSL_DIFF_BLOCK_PAGES;
+        size_t last = min_size(first + GDSL_DIFF_BLOCK_PAGES, scan->total_pages);
+        size_t emitted = scan->block_chunks[block];
+        size_t payload_offset = scan->block_payload[block];
+        for (size_t page_index = first; page_index < last; ++page_index) {
+            if (!scan->changed[page_index]) {
+                continue;
+            }
+            size_t target_span = page_target_span(scan, page_index);
+            gdsl_diff_chunk_t *chunk = &out->chunks[emitted++];
+            chunk->page_index = page_index;
+            chunk->length = target_span;
+            if (scan->changed[page_index] == GDSL_DIFF_PAGE_REFERENCED) {
+                chunk->data_offset = scan->match_offset[page_index];
+                chunk->reference = scan->match_reference[page_index];
+                continue;
+            }
+            chunk->data_offset = payload_offset;
+            chunk->reference = 0;
+
+            gdsl_copy(out->payload + payload_offset,
+                      scan->target + page_index * scan->page_size,
+                      target_span, scan->streaming);
+            payload_offset += target_span;
+        }
+    }
+    gdsl_copy_fence(scan->streaming);
+}
+
+typedef struct {
+    const gdsl_diff_reference_t *references;
+    const size_t *first_entry; /* reference_count + 1 prefix sums */
+    size_t reference_count;
+    size_t entry_count;
+    size_t page_size;
+    uint64_t *keys;
+} gdsl_diff_page_hashes_t;
+
+static void hash_blocks(void *ctx, size_t begin, size_t end, size_t worker) {
+    gdsl_diff_page_hashes_t *hashes = (gdsl_diff_page_hashes_t *)ctx;
+    (void)worker;
+
+    size_t first = begin * GDSL_DIFF_BLOCK_PAGES;
+    size_t last = min_size(end * GDSL_DIFF_BLOCK_PAGES, hashes->entry_count);
+    size_t reference = 0;
+    for (size_t entry = first; entry < last; ++entry) {
+        while (entry >= hashes->first_entry[reference + 1]) {
+            reference++;
+        }
+        size_t offset = (entry - hashes->first_entry[reference]) * hashes->page_size;
+        hashes->keys[entry] =
+            gdsl_hash128(hashes->references[reference].data + offset, hashes->page_size).lo;
+    }
+}
+
+/* Hashes every full page of every reference (in parallel) and inserts them
+ * in reference order. */
+static int build_page_index(const gdsl_diff_reference_t *references,
+                            size_t reference_count,
+                            size_t page_size,
+                            const gdsl_diff_options_t *options,
+                            gdsl_diff_page_index_t *index) {
+    index->slots = NULL;
+    index->mask = 0;
+
+    size_t *first_entry = (size_t *)malloc((reference_count + 1) * sizeof(size_t));
+    if (!first_entry) {
+        return -1;
+    }
+    size_t entry_count = 0;
+    for (size_t i = 0; i < reference_count; ++i) {
+        first_entry[i] = entry_count;
+        entry_count += references[i].length / page_size;
+    }
+    first_entry[reference_count] = entry_count;
+
+    size_t capacity = 16;
+    while (capacity < 2 * entry_count) {
+        if (capacity > SIZE_MAX / 2 / sizeof(gdsl_diff_index_slot_t)) {
+            free(first_entry);
+            return -1;
+        }
+        capacity *= 2;
+    }
+    gdsl_diff_page_hashes_t hashes;
+    hashes.references = references;
+    hashes.first_entry = first_entry;
+    hashes.reference_count = reference_count;
+    hashes.entry_count = entry_count;
+    hashes.page_size = page_size;
+    hashes.keys = (uint64_t *)malloc((entry_count ? entry_count : 1) * sizeof(uint64_t));
+    index->slots = (gdsl_diff_index_slot_t *)calloc(capacity, sizeof(gdsl_diff_index_slot_t));
+    index->mask = capacity - 1;
+    int rc = -1;
+    if (!hashes.keys || !index->slots) {
+        goto cleanup;
+    }
+
+    size_t block_count = (entry_count + GDSL_DIFF_BLOCK_PAGES - 1) / GDSL_DIFF_BLOCK_PAGES;
+    if (run_blocks(options, block_count, 1, hash_blocks, &hashes) != 0) {
+        goto cleanup;
+    }
+    size_t reference = 0;
+    for (size_t entry = 0; entry < entry_count; ++entry) {
+        while (entry >= first_entry[reference + 1]) {
+            reference++;
+        }
+        size_t slot = (size_t)hashes.keys[entry] & index->mask;
+        while (index->slots[slot].reference != 0) {
+            slot = (slot + 1) & index->mask;
+        }
+        index->slots[slot].key = hashes.keys[entry];
+        index->slots[slot].reference = reference + 1;
+        index->slots[slot].offset = (entry - first_entry[reference]) * page_size;
+    }
+    rc = 0;
+
+cleanup:
+    if (rc != 0) {
+        free(index->slots);
+        index->slots = NULL;
+    }
+    free(hashes.keys);
+    free(first_entry);
+    return rc;
+}
+
 int gdsl_diff(const uint8_t *base,
               size_t base_length,
               const uint8_t *target,
               size_t target_length,
               gdsl_diff_result_t *out) {
+    return gdsl_diff_ex(base, base_length, target, target_length, NULL, out);
+}
+
+static int diff_pages(const uint8_t *base,
+                      size_t base_length,
+                      const gdsl_diff_reference_t *references,
+                      size_t reference_count,
+                      const uint8_t *target,
+                      size_t target_length,
+                      const gdsl_diff_options_t *options,
+                      gdsl_diff_result_t *out);
+
+int gdsl_diff_ex(const uint8_t *base,
+                 size_t base_length,
+                 const uint8_t *target,
+                 size_t target_length,
+                 const gdsl_diff_options_t *options,
+                 gdsl_diff_result_t *out) {
+    return diff_pages(base, base_length, NULL, 0, target, target_length, options, out);
+}
+
+int gdsl_diff_multi(const gdsl_diff_reference_t *references,
+                    size_t reference_count,
+                    const uint8_t *target,
+                    size_t target_length,
+                    const gdsl_diff_options_t *options,
+                    gdsl_diff_result_t *out) {
+    if (!out) {
+        return -1;
+    }
+    if (!references || reference_count == 0) {
+        memset(out, 0, sizeof(*out));
+        return -1;
+    }
+    for (size_t i = 0; i < reference_count; ++i) {
+        if (!references[i].data && references[i].length > 0) {
+            memset(out, 0, sizeof(*out));
+            return -1;
+        }
+    }
+    return diff_pages(references[0].data, references[0].length, references,
+                      reference_count, target, target_length, options, out);
+}
+
+static int diff_pages(const uint8_t *base,
+                      size_t base_length,
+                      const gdsl_diff_reference_t *references,
+                      size_t reference_count,
+                      const uint8_t *target,
+                      size_t target_length,
+                      const gdsl_diff_options_t *options,
+                      gdsl_diff_result_t *out) {
     if (!out) {
         return -1;
     }
@@ -99,130 +522,161 @@ int gdsl_diff(const uint8_t *base,
         return -1;
     }
 
-    size_t page_size = out->header.page_size;
-    size_t max_length = base_length > target_length ? base_length : target_length;
-    size_t total_pages = page_count_for_length(max_length, page_size);
-
-    size_t chunk_count = 0;
-    size_t payload_size = 0;
-
-    for (size_t page_index = 0; page_index < total_pages; ++page_index) {
-        size_t page_offset = page_index * page_size;
-        size_t page_end = page_offset + page_size;
-        if (page_end > max_length) {
-            page_end = max_length;
-        }
-        size_t span = page_end - page_offset;
-        if (span == 0) {
-            continue;
-        }
+    gdsl_diff_scan_t scan;
+    memset(&scan, 0, sizeof(scan));
+    scan.base = base;
+    scan.base_length = base_length;
+    scan.target = target;
+    scan.target_length = target_length;
+    scan.page_size = out->header.page_size;
+    scan.total_pages = page_count_for_length(target_length, scan.page_size);
+    scan.out = out;
+
+    if (scan.total_pages == 0) {
+        return 0;
+    }
 
-        size_t target_span = 0;
-        if (page_offset < target_length) {
-            size_t remaining = target_length - page_offset;
-            target_span = min_size(span, remaining);
-        }
-        if (target_span == 0) {
-            continue;
+    size_t block_count = (scan.total_pages + GDSL_DIFF_BLOCK_PAGES - 1) /
+                         GDSL_DIFF_BLOCK_PAGES;
+    gdsl_diff_page_index_t index = {NULL, 0};
+    scan.changed = (uint8_t *)malloc(scan.total_pages);
+    scan.block_chunks = (size_t *)malloc(block_count * sizeof(size_t));
+    scan.block_payload = (size_t *)malloc(block_count * sizeof(size_t));
+    int rc = -1;
+    if (!scan.changed || !scan.block_chunks || !scan.block_payload) {
+        goto cleanup;
+    }
+    if (references) {
+        scan.references = references;
+        scan.match_reference = (size_t *)malloc(scan.total_pages * sizeof(size_t));
+        scan.match_offset = (size_t *)malloc(scan.total_pages * sizeof(size_t));
+        if (!scan.match_reference || !scan.match_offset ||
+            build_page_index(references, reference_count, scan.page_size, options,
+                             &index) != 0) {
+            goto cleanup;
         }
+        scan.index = &index;
+    }
 
-        const uint8_t *base_ptr = page_offset < base_length ? base + page_offset : NULL;
-        size_t base_available = base_ptr ? min_size(target_span, base_length - page_offset) : 0;
-
-        const uint8_t *target_ptr = (target && target_span > 0) ? target + page_offset : NULL;
-        size_t target_available = target_ptr ? target_span : 0;
-
-        int changed = 0;
-        for (size_t i = 0; i < target_span; ++i) {
-            uint8_t base_byte = (i < base_available) ? base_ptr[i] : 0;
-            uint8_t target_byte = (i < target_available) ? target_ptr[i] : 0;
-            if (base_byte != target_byte) {
-                changed = 1;
-                break;
-            }
-        }
+    if (run_blocks(options, block_count, 1, scan_blocks, &scan) != 0) {
+        goto cleanup;
+    }
 
-        if (changed) {
-            chunk_count++;
-            payload_size += target_span;
-        }
+    /* Exclusive prefix sums give every block its first chunk index and
+     * payload offset for the emit pass. */
+    size_t chunk_count = 0;
+    size_t payload_size = 0;
+    for (size_t block = 0; block < block_count; ++block) {
+        size_t chunks = scan.block_chunks[block];
+        size_t payload = scan.block_payload[block];
+        scan.block_chunks[block] = chunk_count;
+        scan.block_payload[block] = payload_size;
+        chunk_count += chunks;
+        payload_size += payload;
     }
 
     if (chunk_count == 0) {
-        out->header.chunk_count = 0;
-        out->chunk_count = 0;
-        return 0;
+        rc = 0;
+        goto cleanup;
     }
 
-    if (ensure_capacity(out, chunk_count, payload_size) != 0) {
-        return -1;
+    if (ensure_capacity(out, chunk_count, payload_size, options) != 0) {
+        goto cleanup;
     }
+    scan.streaming = use_streaming(options, payload_size);
 
-    size_t payload_offset = 0;
-    size_t emitted = 0;
-
-    for (size_t page_index = 0; page_index < total_pages; ++page_index) {
-        size_t page_offset = page_index * page_size;
-        size_t page_end = page_offset + page_size;
-        if (page_end > max_length) {
-            page_end = max_length;
-        }
-        size_t span = page_end - page_offset;
-        if (span == 0) {
-            continue;
-        }
-
-        size_t target_span = 0;
-        if (page_offset < target_length) {
-            size_t remaining = target_length - page_offset;
-            target_span = min_size(span, remaining);
-        }
-        if (target_span == 0) {
-            continue;
-        }
-
-        const uint8_t *base_ptr = page_offset < base_length ? base + page_offset : NULL;
-        size_t base_available = base_ptr ? min_size(target_span, base_length - page_offset) : 0;
-
-        const uint8_t *target_ptr = (target && target_span > 0) ? target + page_offset : NULL;
-        size_t target_available = target_ptr ? target_span : 0;
+    if (run_blocks(options, block_count, 1, emit_blocks, &scan) != 0) {
+        gdsl_diff_result_destroy(out);
+        out->header.target_length = target_length;
+        goto cleanup;
+    }
 
-        int changed = 0;
-        for (size_t i = 0; i < target_span; ++i) {
-            uint8_t base_byte = (i < base_available) ? base_ptr[i] : 0;
-            uint8_t target_byte = (i < target_available) ? target_ptr[i] : 0;
-            if (base_byte != target_byte) {
-                changed = 1;
-                break;
-            }
+    out->header.chunk_count = (uint32_t)chunk_count;
+    for (size_t i = 0; scan.index && i < chunk_count; ++i) {
+        if (out->chunks[i].reference != 0) {
+            out->header.flags |= GDSL_DIFF_FLAG_REFERENCES;
+            break;
         }
+    }
+    rc = 0;
+
+cleanup:
+    free(scan.changed);
+    free(scan.block_chunks);
+    free(scan.block_payload);
+    free(scan.match_reference);
+    free(scan.match_offset);
+    free(index.slots);
+    return rc;
+}
 
-        if (!changed) {
-            continue;
-        }
+typedef struct {
+    const uint8_t *base;
+    size_t base_length;
+    const gdsl_diff_reference_t *references;
+    const gdsl_diff_result_t *diff;
+    size_t page_size;
+    size_t target_length;
+    int streaming;
+    uint8_t *buffer;
+} gdsl_patch_apply_t;
+
+static void patch_init_bytes(const gdsl_patch_apply_t *apply,
+                             size_t begin,
+                             size_t end) {
+    size_t copy_end = min_size(end, apply->base ? apply->base_length : 0);
+    if (copy_end > begin) {
+        gdsl_copy(apply->buffer + begin, apply->base + begin, copy_end - begin,
+                  apply->streaming);
+        begin = copy_end;
+    }
+    if (end > begin) {
+        gdsl_zero(apply->buffer + begin, end - begin, apply->streaming);
+    }
+}
 
-        gdsl_diff_chunk_t *chunk = &out->chunks[emitted];
-        chunk->page_index = page_index;
-        chunk->length = target_span;
-        chunk->data_offset = payload_offset;
+static void patch_copy_chunk(const gdsl_patch_apply_t *apply,
+                             const gdsl_diff_chunk_t *chunk) {
+    if (chunk->length == 0) {
+        return;
+    }
+    const uint8_t *source = chunk->reference != 0
+                                ? apply->references[chunk->reference - 1].data
+                                : apply->diff->payload;
+    gdsl_copy(apply->buffer + chunk->page_index * apply->page_size,
+              source + chunk->data_offset, chunk->length, apply->streaming);
+}
 
-        for (size_t i = 0; i < target_span; ++i) {
-            uint8_t value = (i < target_available) ? target_ptr[i] : 0;
-            out->payload[payload_offset + i] = value;
+/* Disjoint, sorted chunks: each block of pages is initialised from base and
+ * then overwritten by the chunks that land in it, so a block is touched by
+ * one worker only. */
+static void patch_blocks(void *ctx, size_t begin, size_t end, size_t worker) {
+    gdsl_patch_apply_t *apply = (gdsl_patch_apply_t *)ctx;
+    const gdsl_diff_result_t *diff = apply->diff;
+    size_t block_bytes = GDSL_DIFF_BLOCK_PAGES * apply->page_size;
+    (void)worker;
+
+    size_t first_byte = begin * block_bytes;
+    size_t last_byte = min_size(end * block_bytes, apply->target_length);
+    patch_init_bytes(apply, first_byte, last_byte);
+
+    size_t first_page = begin * GDSL_DIFF_BLOCK_PAGES;
+    size_t last_page = end * GDSL_DIFF_BLOCK_PAGES;
+    size_t lo = 0;
+    size_t hi = diff->chunk_count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (diff->chunks[mid].page_index < first_page) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
         }
-
-        payload_offset += target_span;
-        emitted++;
     }
-
-    out->chunk_count = emitted;
-    out->header.chunk_count = (uint32_t)emitted;
-    out->payload_length = payload_offset;
-    if (payload_offset == 0) {
-        free(out->payload);
-        out->payload = NULL;
+    for (size_t i = lo;
+         i < diff->chunk_count && diff->chunks[i].page_index < last_page; ++i) {
+        patch_copy_chunk(apply, &diff->chunks[i]);
     }
-    return 0;
+    gdsl_copy_fence(apply->streaming);
 }
 
 int gdsl_patch(const uint8_t *base,
@@ -230,6 +684,48 @@ int gdsl_patch(const uint8_t *base,
                const gdsl_diff_result_t *diff,
                uint8_t **out_buffer,
                size_t *out_length) {
+    return gdsl_patch_ex(base, base_length, diff, NULL, out_buffer, out_length);
+}
+
+static int patch_pages(const uint8_t *base,
+                       size_t base_length,
+                       const gdsl_diff_reference_t *references,
+                       size_t reference_count,
+                       const gdsl_diff_result_t *diff,
+                       const gdsl_diff_options_t *options,
+                       uint8_t **out_buffer,
+                       size_t *out_length);
+
+int gdsl_patch_ex(const uint8_t *base,
+                  size_t base_length,
+                  const gdsl_diff_result_t *diff,
+                  const gdsl_diff_options_t *options,
+                  uint8_t **out_buffer,
+                  size_t *out_length) {
+    return patch_pages(base, base_length, NULL, 0, diff, options, out_buffer, out_length);
+}
+
+int gdsl_patch_multi(const gdsl_diff_reference_t *references,
+                     size_t reference_count,
+                     const gdsl_diff_result_t *diff,
+                     const gdsl_diff_options_t *options,
+                     uint8_t **out_buffer,
+                     size_t *out_length) {
+    if (!references || reference_count == 0) {
+        return -1;
+    }
+    return patch_pages(references[0].data, references[0].length, references,
+                       reference_count, diff, options, out_buffer, out_length);
+}
+
+static int patch_pages(const uint8_t *base,
+                       size_t base_length,
+                       const gdsl_diff_reference_t *references,
+                       size_t reference_count,
+                       const gdsl_diff_result_t *diff,
+                       const gdsl_diff_options_t *options,
+                       uint8_t **out_buffer,
+                       size_t *out_length) {
     if (!diff || !out_buffer || !out_length) {
         return -1;
     }
@@ -247,7 +743,7 @@ int gdsl_patch(const uint8_t *base,
         }
         if (diff->payload_length == 0 || !diff->payload) {
             for (size_t i = 0; i < diff->chunk_count; ++i) {
-                if (diff->chunks[i].length > 0) {
+                if (diff->chunks[i].length > 0 && diff->chunks[i].reference == 0) {
                     return -1;
                 }
             }
@@ -261,58 +757,93 @@ int gdsl_patch(const uint8_t *base,
         return 0;
     }
 
-    uint8_t *buffer = (uint8_t *)malloc(target_length);
-    if (!buffer) {
-        return -1;
-    }
-
-    memset(buffer, 0, target_length);
-    if (base && base_length > 0) {
-        size_t copy = min_size(base_length, target_length);
-        memcpy(buffer, base, copy);
-    }
-
+    /* Validate every chunk up front so the apply pass cannot fail midway.
+     * Chunks that are sorted, non-overlapping and at most a page long (as
+     * gdsl_diff emits them) can be applied per block in parallel; anything
+     * else keeps later-wins order. */
+    int disjoint = 1;
+    size_t previous_end = 0;
     for (size_t i = 0; i < diff->chunk_count; ++i) {
         const gdsl_diff_chunk_t *chunk = &diff->chunks[i];
         size_t page_offset = 0;
         if (checked_mul(chunk->page_index, page_size, &page_offset) != 0) {
-            free(buffer);
             return -1;
         }
         if (page_offset > target_length) {
-            free(buffer);
             return -1;
         }
         size_t end_offset = 0;
         if (checked_add(page_offset, chunk->length, &end_offset) != 0) {
-            free(buffer);
             return -1;
         }
         if (end_offset > target_length) {
-            free(buffer);
+            return -1;
+        }
+        if (chunk->reference > reference_count) {
             return -1;
         }
         if (chunk->length > 0) {
-            if (!diff->payload ||
-                chunk->data_offset > diff->payload_length) {
-                free(buffer);
+            const uint8_t *source = diff->payload;
+            size_t source_length = diff->payload_length;
+            if (chunk->reference != 0) {
+                source = references[chunk->reference - 1].data;
+                source_length = references[chunk->reference - 1].length;
+            }
+            if (!source || chunk->data_offset > source_length) {
                 return -1;
             }
-            size_t payload_end = 0;
-            if (checked_add(chunk->data_offset, chunk->length, &payload_end) !=
+            size_t source_end = 0;
+            if (checked_add(chunk->data_offset, chunk->length, &source_end) !=
                 0) {
-                free(buffer);
                 return -1;
             }
-            if (payload_end > diff->payload_length) {
-                free(buffer);
+            if (source_end > source_length) {
                 return -1;
             }
+        }
+        if ((i > 0 && page_offset < previous_end) || chunk->length > page_size) {
+            disjoint = 0;
+        }
+        previous_end = end_offset;
+    }
 
-            memcpy(buffer + page_offset,
-                   diff->payload + chunk->data_offset,
-                   chunk->length);
+    int mapped = uses_buffer_layer(options);
+    uint8_t *buffer = mapped ? gdsl_buffer_alloc(target_length, &options->memory)
+                             : (uint8_t *)malloc(target_length);
+    if (!buffer) {
+        return -1;
+    }
+
+    gdsl_patch_apply_t apply;
+    apply.base = base;
+    apply.base_length = base_length;
+    apply.references = references;
+    apply.diff = diff;
+    apply.page_size = page_size;
+    apply.target_length = target_length;
+    apply.streaming = use_streaming(options, target_length);
+    apply.buffer = buffer;
+
+    int rc = 0;
+    if (disjoint) {
+        size_t block_bytes = GDSL_DIFF_BLOCK_PAGES * page_size;
+        size_t block_count = (target_length + block_bytes - 1) / block_bytes;
+        rc = run_blocks(options, block_count, 1, patch_blocks, &apply);
+    } else {
+        /* Overlapping chunks must apply in order for later-wins semantics. */
+        patch_init_bytes(&apply, 0, target_length);
+        for (size_t i = 0; i < diff->chunk_count; ++i) {
+            patch_copy_chunk(&apply, &diff->chunks[i]);
         }
+        gdsl_copy_fence(apply.streaming);
+    }
+    if (rc != 0) {
+        if (mapped) {
+            gdsl_buffer_free(buffer, target_length);
+        } else {
+            free(buffer);
+        }
+        return -1;
     }
 
     *out_buffer = buffer;
@@ -320,6 +851,123 @@ int gdsl_patch(const uint8_t *base,
     return 0;
 }
 
+static void stat_scan_init(gdsl_diff_scan_t *scan,
+                           const uint8_t *base,
+                           size_t base_length,
+                           const uint8_t *target,
+                           size_t target_length) {
+    memset(scan, 0, sizeof(*scan));
+    scan->base = base;
+    scan->base_length = base_length;
+    scan->target = target;
+    scan->target_length = target_length;
+    scan->page_size = GDSL_DEFAULT_PAGE_SIZE;
+    scan->total_pages = page_count_for_length(target_length, scan->page_size);
+}
+
+int gdsl_diff_stat(const uint8_t *base,
+                   size_t base_length,
+                   const uint8_t *target,
+                   size_t target_length,
+                   size_t byte_budget,
+                   gdsl_diff_stat_t *out) {
+    if (!out) {
+        return -1;
+    }
+    memset(out, 0, sizeof(*out));
+    if ((!base && base_length > 0) || (!target && target_length > 0)) {
+        return -1;
+    }
+
+    gdsl_diff_scan_t scan;
+    stat_scan_init(&scan, base, base_length, target, target_length);
+    out->total_pages = scan.total_pages;
+    for (size_t page_index = 0; page_index < scan.total_pages; ++page_index) {
+        out->pages_scanned++;
+        if (!page_changed(&scan, page_index)) {
+            continue;
+        }
+        out->chunk_count++;
+        out->payload_bytes += page_target_span(&scan, page_index);
+        if (byte_budget != 0 && out->payload_bytes > byte_budget) {
+            out->over_budget = 1;
+            break;
+        }
+    }
+    return 0;
+}
+
+#define GDSL_DIFF_DEFAULT_SAMPLE_FRACTION (1.0 / 64.0)
+
+static uint64_t splitmix64(uint64_t *state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+int gdsl_diff_estimate(const uint8_t *base,
+                       size_t base_length,
+                       const uint8_t *target,
+                       size_t target_length,
+                       const gdsl_diff_estimate_options_t *options,
+                       gdsl_diff_estimate_t *out) {
+    if (!out) {
+        return -1;
+    }
+    memset(out, 0, sizeof(*out));
+    double fraction = options && options->sample_fraction != 0.0
+                          ? options->sample_fraction
+                          : GDSL_DIFF_DEFAULT_SAMPLE_FRACTION;
+    if ((!base && base_length > 0) || (!target && target_length > 0) ||
+        !(fraction > 0.0 && fraction <= 1.0)) {
+        return -1;
+    }
+
+    gdsl_diff_scan_t scan;
+    stat_scan_init(&scan, base, base_length, target, target_length);
+    size_t total = scan.total_pages;
+    out->total_pages = total;
+    if (total == 0) {
+        return 0;
+    }
+
+    /* Stratified sampling: one random page from each of `samples` equal
+     * strata, so clustered changes cannot hide between samples. */
+    size_t samples = (size_t)ceil((double)total * fraction);
+    if (samples == 0) {
+        samples = 1;
+    }
+    if (samples > total) {
+        samples = total;
+    }
+    uint64_t state = options ? options->seed : 0;
+    for (size_t stratum = 0; stratum < samples; ++stratum) {
+        size_t first = (size_t)((uint64_t)stratum * total / samples);
+        size_t last = (size_t)((uint64_t)(stratum + 1) * total / samples);
+        size_t page_index = first + (size_t)(splitmix64(&state) % (last - first));
+        out->changed_samples += (size_t)page_changed(&scan, page_index);
+    }
+    out->sampled_pages = samples;
+
+    double n = (double)samples;
+    double p = (double)out->changed_samples / n;
+    out->change_ratio = p;
+    if (samples == total) {
+        out->ratio_low = p;
+        out->ratio_high = p;
+    } else {
+        const double z = 1.959963984540054;
+        double z2 = z * z;
+        double centre = (p + z2 / (2.0 * n)) / (1.0 + z2 / n);
+        double half = z * sqrt(p * (1.0 - p) / n + z2 / (4.0 * n * n)) / (1.0 + z2 / n);
+        out->ratio_low = centre - half < 0.0 ? 0.0 : centre - half;
+        out->ratio_high = centre + half > 1.0 ? 1.0 : centre + half;
+    }
+    out->estimated_payload_bytes = (size_t)(p * (double)target_length);
+    return 0;
+}
+
 int gdsl_read_changed_set(const gdsl_diff_result_t *diff,
                           size_t *out_pages,
                           size_t max_pages,
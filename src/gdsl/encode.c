@@ -0,0 +1,358 @@
+#include "gdsl/encode.h"
+
+#include "encode_reader.h"
+#include "opcodes.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static const uint8_t gdsl_encode_magic[4] = {'G', 'D', 'S', 'Z'};
+
+typedef struct {
+    uint8_t *data;
+    size_t length;
+    size_t capacity;
+} gdsl_byte_buffer_t;
+
+static int buffer_reserve(gdsl_byte_buffer_t *buffer, size_t extra) {
+    if (buffer->capacity - buffer->length >= extra) {
+        return 0;
+    }
+    size_t capacity = buffer->capacity ? buffer->capacity : 256;
+    while (capacity - buffer->length < extra) {
+        if (capacity > SIZE_MAX / 2) {
+            return -1;
+        }
+        capacity *= 2;
+    }
+    uint8_t *data = (uint8_t *)realloc(buffer->data, capacity);
+    if (!data) {
+        return -1;
+    }
+    buffer->data = data;
+    buffer->capacity = capacity;
+    return 0;
+}
+
+static int buffer_append(gdsl_byte_buffer_t *buffer, const void *bytes, size_t length) {
+    if (length == 0) {
+        return 0;
+    }
+    if (buffer_reserve(buffer, length) != 0) {
+        return -1;
+    }
+    memcpy(buffer->data + buffer->length, bytes, length);
+    buffer->length += length;
+    return 0;
+}
+
+static int buffer_append_varint(gdsl_byte_buffer_t *buffer, uint64_t value) {
+    uint8_t bytes[10];
+    size_t count = 0;
+    do {
+        uint8_t byte = (uint8_t)(value & 0x7F);
+        value >>= 7;
+        bytes[count++] = value ? (uint8_t)(byte | 0x80) : byte;
+    } while (value);
+    return buffer_append(buffer, bytes, count);
+}
+
+size_t gdsl_varint_read(const uint8_t *cursor, const uint8_t *end, uint64_t *value) {
+    uint64_t result = 0;
+    for (size_t i = 0; i < 10 && cursor + i < end; ++i) {
+        uint8_t byte = cursor[i];
+        if (i == 9 && byte > 1) {
+            return 0;
+        }
+        result |= (uint64_t)(byte & 0x7F) << (7 * i);
+        if (!(byte & 0x80)) {
+            *value = result;
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+static uint64_t load_le(const uint8_t *bytes, size_t width) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < width; ++i) {
+        value |= (uint64_t)bytes[i] << (8 * i);
+    }
+    return value;
+}
+
+static size_t instruction_size(uint8_t opcode) {
+    const gdsl_opcode_metadata_t *meta = &gdsl_opcode_table[opcode];
+    return meta->name && meta->size > 0 ? meta->size : 1;
+}
+
+static int append_operands(gdsl_byte_buffer_t *payload,
+                           const uint8_t *instruction,
+                           size_t size) {
+    size_t width = size - 1;
+    if (width == 0) {
+        return 0;
+    }
+    if (width <= 8) {
+        return buffer_append_varint(payload, load_le(instruction + 1, width));
+    }
+    return buffer_append(payload, instruction + 1, width);
+}
+
+static int flush_block(gdsl_byte_buffer_t *out,
+                       gdsl_byte_buffer_t *payload,
+                       size_t raw_bytes) {
+    if (raw_bytes == 0) {
+        return 0;
+    }
+    if (buffer_append_varint(out, raw_bytes) != 0 ||
+        buffer_append_varint(out, payload->length) != 0 ||
+        buffer_append(out, payload->data, payload->length) != 0) {
+        return -1;
+    }
+    payload->length = 0;
+    return 0;
+}
+
+int gdsl_encode(const uint8_t *stream,
+                size_t length,
+                uint8_t **out_buffer,
+                size_t *out_length) {
+    if (!out_buffer || !out_length || (!stream && length > 0)) {
+        return -1;
+    }
+    *out_buffer = NULL;
+    *out_length = 0;
+
+    gdsl_byte_buffer_t out = {NULL, 0, 0};
+    gdsl_byte_buffer_t payload = {NULL, 0, 0};
+    uint8_t header[GDSL_ENCODE_HEADER_SIZE];
+    memset(header, 0, sizeof(header));
+    if (buffer_append(&out, header, sizeof(header)) != 0) {
+        return -1;
+    }
+
+    size_t pos = 0;
+    size_t block_raw = 0;
+    size_t tail_length = 0;
+    while (pos < length) {
+        uint8_t opcode = stream[pos];
+        size_t size = instruction_size(opcode);
+        if (pos + size > length) {
+            tail_length = length - pos;
+            break;
+        }
+        if (block_raw > 0 && block_raw + size > GDSL_ENCODE_BLOCK_SIZE) {
+            if (flush_block(&out, &payload, block_raw) != 0) {
+                goto fail;
+            }
+            block_raw = 0;
+        }
+
+        size_t count = 1;
+        while (pos + (count + 1) * size <= length &&
+               stream[pos + count * size] == opcode &&
+               block_raw + (count + 1) * size <= GDSL_ENCODE_BLOCK_SIZE) {
+            count++;
+        }
+
+        if (buffer_append(&payload, &opcode, 1) != 0 ||
+            buffer_append_varint(&payload, count) != 0) {
+            goto fail;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            if (append_operands(&payload, stream + pos + i * size, size) != 0) {
+                goto fail;
+            }
+        }
+        pos += count * size;
+        block_raw += count * size;
+    }
+    if (flush_block(&out, &payload, block_raw) != 0 ||
+        buffer_append(&out, stream + length - tail_length, tail_length) != 0) {
+        goto fail;
+    }
+
+    memcpy(out.data, gdsl_encode_magic, 4);
+    out.data[4] = GDSL_ENCODE_VERSION;
+    out.data[5] = (uint8_t)tail_length;
+    for (size_t i = 0; i < 8; ++i) {
+        out.data[8 + i] = (uint8_t)((uint64_t)length >> (8 * i));
+    }
+
+    free(payload.data);
+    *out_buffer = out.data;
+    *out_length = out.length;
+    return 0;
+
+fail:
+    free(payload.data);
+    free(out.data);
+    return -1;
+}
+
+int gdsl_encode_reader_init(gdsl_encode_reader_t *reader,
+                            const uint8_t *encoded,
+                            size_t length) {
+    if (!reader || !encoded || length < GDSL_ENCODE_HEADER_SIZE) {
+        return -1;
+    }
+    if (memcmp(encoded, gdsl_encode_magic, 4) != 0 ||
+        encoded[4] != GDSL_ENCODE_VERSION || encoded[6] != 0 || encoded[7] != 0) {
+        return -1;
+    }
+
+    memset(reader, 0, sizeof(*reader));
+    reader->raw_length = load_le(encoded + 8, 8);
+    reader->tail_length = encoded[5];
+    if (reader->tail_length > reader->raw_length ||
+        reader->tail_length > length - GDSL_ENCODE_HEADER_SIZE) {
+        return -1;
+    }
+    reader->cursor = encoded + GDSL_ENCODE_HEADER_SIZE;
+    reader->end = encoded + length - reader->tail_length;
+    reader->block_end = reader->cursor;
+    reader->raw_remaining = reader->raw_length - reader->tail_length;
+    reader->tail = reader->end;
+    return 0;
+}
+
+int gdsl_encode_reader_next(gdsl_encode_reader_t *reader, gdsl_encode_run_t *run) {
+    while (reader->block_raw_remaining == 0) {
+        if (reader->cursor != reader->block_end) {
+            return -1;
+        }
+        if (reader->raw_remaining == 0) {
+            return reader->cursor == reader->end ? 0 : -1;
+        }
+
+        uint64_t raw_bytes = 0;
+        uint64_t payload_bytes = 0;
+        size_t used = gdsl_varint_read(reader->cursor, reader->end, &raw_bytes);
+        if (used == 0) {
+            return -1;
+        }
+        reader->cursor += used;
+        used = gdsl_varint_read(reader->cursor, reader->end, &payload_bytes);
+        if (used == 0) {
+            return -1;
+        }
+        reader->cursor += used;
+        if (raw_bytes == 0 || raw_bytes > reader->raw_remaining ||
+            payload_bytes > (uint64_t)(reader->end - reader->cursor)) {
+            return -1;
+        }
+        reader->block_end = reader->cursor + payload_bytes;
+        reader->block_raw_remaining = raw_bytes;
+    }
+
+    if (reader->cursor >= reader->block_end) {
+        return -1;
+    }
+    uint8_t opcode = *reader->cursor++;
+    uint64_t count = 0;
+    size_t used = gdsl_varint_read(reader->cursor, reader->block_end, &count);
+    if (used == 0 || count == 0) {
+        return -1;
+    }
+    reader->cursor += used;
+
+    size_t size = instruction_size(opcode);
+    if (count > reader->block_raw_remaining / size) {
+        return -1;
+    }
+
+    const uint8_t *operands = reader->cursor;
+    size_t width = size - 1;
+    if (width > 8) {
+        if (count * width > (uint64_t)(reader->block_end - reader->cursor)) {
+            return -1;
+        }
+        reader->cursor += count * width;
+    } else if (width > 0) {
+        for (uint64_t i = 0; i < count; ++i) {
+            uint64_t value = 0;
+            used = gdsl_varint_read(reader->cursor, reader->block_end, &value);
+            if (used == 0 || (width < 8 && (value >> (8 * width)) != 0)) {
+                return -1;
+            }
+            reader->cursor += used;
+        }
+    }
+
+    run->opcode = opcode;
+    run->count = count;
+    run->operands = operands;
+    run->operand_bytes = (size_t)(reader->cursor - operands);
+
+    reader->block_raw_remaining -= count * size;
+    reader->raw_remaining -= count * size;
+    return 1;
+}
+
+int gdsl_encoded_raw_length(const uint8_t *encoded,
+                            size_t length,
+                            uint64_t *out_length) {
+    gdsl_encode_reader_t reader;
+    if (!out_length || gdsl_encode_reader_init(&reader, encoded, length) != 0) {
+        return -1;
+    }
+    *out_length = reader.raw_length;
+    return 0;
+}
+
+int gdsl_decode(const uint8_t *encoded,
+                size_t length,
+                uint8_t **out_buffer,
+                size_t *out_length) {
+    if (!out_buffer || !out_length) {
+        return -1;
+    }
+    *out_buffer = NULL;
+    *out_length = 0;
+
+    gdsl_encode_reader_t reader;
+    if (gdsl_encode_reader_init(&reader, encoded, length) != 0 ||
+        (uint64_t)(size_t)reader.raw_length != reader.raw_length) {
+        return -1;
+    }
+
+    size_t raw_length = (size_t)reader.raw_length;
+    uint8_t *raw = (uint8_t *)malloc(raw_length ? raw_length : 1);
+    if (!raw) {
+        return -1;
+    }
+
+    size_t pos = 0;
+    gdsl_encode_run_t run;
+    int rc;
+    while ((rc = gdsl_encode_reader_next(&reader, &run)) > 0) {
+        size_t size = instruction_size(run.opcode);
+        size_t width = size - 1;
+        const uint8_t *operand = run.operands;
+        const uint8_t *operand_end = run.operands + run.operand_bytes;
+        for (uint64_t i = 0; i < run.count; ++i) {
+            raw[pos] = run.opcode;
+            if (width > 8) {
+                memcpy(raw + pos + 1, operand, width);
+                operand += width;
+            } else if (width > 0) {
+                uint64_t value = 0;
+                operand += gdsl_varint_read(operand, operand_end, &value);
+                for (size_t b = 0; b < width; ++b) {
+                    raw[pos + 1 + b] = (uint8_t)(value >> (8 * b));
+                }
+            }
+            pos += size;
+        }
+    }
+    if (rc < 0) {
+        free(raw);
+        return -1;
+    }
+    memcpy(raw + pos, reader.tail, reader.tail_length);
+
+    *out_buffer = raw;
+    *out_length = raw_length;
+    return 0;
+}
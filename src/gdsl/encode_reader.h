@@ -0,0 +1,42 @@
+#ifndef GDSL_ENCODE_READER_INTERNAL_H
+#define GDSL_ENCODE_READER_INTERNAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* One run of an encoded stream: count consecutive instances of opcode. Their
+ * operand fields start at operands and span operand_bytes encoded bytes. */
+typedef struct {
+    uint8_t opcode;
+    uint64_t count;
+    const uint8_t *operands;
+    size_t operand_bytes;
+} gdsl_encode_run_t;
+
+typedef struct {
+    const uint8_t *cursor;
+    const uint8_t *end;
+    const uint8_t *block_end;
+    /* Raw bytes the current block still has to account for. */
+    uint64_t block_raw_remaining;
+    /* Raw bytes still expected from blocks (excluding the tail). */
+    uint64_t raw_remaining;
+    uint64_t raw_length;
+    const uint8_t *tail;
+    size_t tail_length;
+} gdsl_encode_reader_t;
+
+/* Validates the header. Returns -1 for malformed input. */
+int gdsl_encode_reader_init(gdsl_encode_reader_t *reader,
+                            const uint8_t *encoded,
+                            size_t length);
+
+/* Returns 1 with the next run, 0 once every block was read (the tail is then
+ * in reader->tail), or -1 for malformed input. */
+int gdsl_encode_reader_next(gdsl_encode_reader_t *reader, gdsl_encode_run_t *run);
+
+/* Reads one LEB128 varint of at most 64 bits; returns the bytes used, or 0
+ * when it is truncated or too long. */
+size_t gdsl_varint_read(const uint8_t *cursor, const uint8_t *end, uint64_t *value);
+
+#endif // GDSL_ENCODE_READER_INTERNAL_H
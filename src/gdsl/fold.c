@@ -0,0 +1,250 @@
+#include "gdsl/fold.h"
+
+#include "fold_eval.h"
+#include "opcodes.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+int gdsl_fold_is_if(uint8_t opcode) {
+    return opcode >= GDSL_OPCODE_IF_EQ && opcode <= GDSL_OPCODE_IF_LT;
+}
+
+/* Register r of the operand (byte r), or -1 past the register file. */
+static int operand_register(uint64_t operand, unsigned byte) {
+    unsigned r = (unsigned)(operand >> (8 * byte)) & 0xFFu;
+    return r < GDSL_FOLD_REGISTERS ? (int)r : -1;
+}
+
+static int register_known(const gdsl_fold_registers_t *registers, int r) {
+    return r >= 0 && ((registers->known >> r) & 1u);
+}
+
+int gdsl_fold_apply(gdsl_fold_registers_t *registers, uint8_t opcode, uint64_t operand) {
+    int dst = operand_register(operand, 0);
+    if (opcode == GDSL_OPCODE_CONST_I32) {
+        if (dst < 0) {
+            return (int)(operand & 0xFF);
+        }
+        registers->known |= 1u << dst;
+        registers->values[dst] = (int32_t)(uint32_t)(operand >> 8);
+        return -1;
+    }
+
+    int a = operand_register(operand, 1);
+    int b = operand_register(operand, 2);
+    int invalid = dst < 0 ? (int)(operand & 0xFF)
+                  : a < 0 ? (int)((operand >> 8) & 0xFF)
+                  : b < 0 ? (int)((operand >> 16) & 0xFF)
+                          : -1;
+    if (dst < 0) {
+        return invalid;
+    }
+    if (!register_known(registers, a) || !register_known(registers, b)) {
+        registers->known &= ~(1u << dst);
+        return invalid;
+    }
+    /* Wrapping 32-bit arithmetic. */
+    uint32_t x = (uint32_t)registers->values[a];
+    uint32_t y = (uint32_t)registers->values[b];
+    uint32_t result = opcode == GDSL_OPCODE_ADD   ? x + y
+                      : opcode == GDSL_OPCODE_SUB ? x - y
+                                                  : x * y;
+    registers->values[dst] = (int32_t)result;
+    registers->known |= 1u << dst;
+    return -1;
+}
+
+int gdsl_fold_condition(const gdsl_fold_registers_t *registers,
+                        uint8_t opcode,
+                        uint64_t operand,
+                        int *out) {
+    int a = operand_register(operand, 0);
+    int b = operand_register(operand, 1);
+    *out = GDSL_FOLD_UNKNOWN;
+    if (a < 0) {
+        return (int)(operand & 0xFF);
+    }
+    if (b < 0) {
+        return (int)((operand >> 8) & 0xFF);
+    }
+    if (!register_known(registers, a) || !register_known(registers, b)) {
+        return -1;
+    }
+    int32_t x = registers->values[a];
+    int32_t y = registers->values[b];
+    int taken = opcode == GDSL_OPCODE_IF_EQ   ? x == y
+                : opcode == GDSL_OPCODE_IF_NE ? x != y
+                : opcode == GDSL_OPCODE_IF_GT ? x > y
+                                              : x < y;
+    *out = taken ? GDSL_FOLD_TRUE : GDSL_FOLD_FALSE;
+    return -1;
+}
+
+void gdsl_fold_join(gdsl_fold_registers_t *registers, const gdsl_fold_registers_t *other) {
+    uint32_t known = registers->known & other->known;
+    for (int r = 0; r < GDSL_FOLD_REGISTERS; ++r) {
+        if (((known >> r) & 1u) && registers->values[r] != other->values[r]) {
+            known &= ~(1u << r);
+        }
+    }
+    registers->known = known;
+}
+
+static uint64_t load_operand(const uint8_t *bytes, size_t width) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < width && i < 8; ++i) {
+        value |= (uint64_t)bytes[i] << (8 * i);
+    }
+    return value;
+}
+
+/*
+ * One pass with a stack of open IFs. Decided IFs lose their IF, ELSE and
+ * ENDIF and their dead arm; dead arms are skipped whole, counting only the
+ * IFs nested in them to find where they end. Anything the verifier would
+ * report about the control flow itself makes the pass give up and copy the
+ * stream, so the report of the pruned stream never loses a diagnostic.
+ */
+typedef struct {
+    int taken;
+    int in_else;
+    gdsl_fold_registers_t entry;
+    gdsl_fold_registers_t then_arm;
+} gdsl_fold_frame_t;
+
+/* Returns 0 with the pruned stream in out, or -1 when it must be copied. */
+static int fold_stream(const uint8_t *stream,
+                       size_t length,
+                       uint8_t *out,
+                       size_t *out_length,
+                       gdsl_fold_stats_t *stats) {
+    gdsl_fold_frame_t frames[GDSL_FOLD_MAX_DEPTH];
+    size_t depth = 0;
+    /* IFs open inside the dead arm, plus one for the arm itself. */
+    uint64_t dead = 0;
+    gdsl_fold_registers_t registers;
+    memset(&registers, 0, sizeof(registers));
+    size_t written = 0;
+
+    size_t pos = 0;
+    while (pos < length) {
+        uint8_t opcode = stream[pos];
+        const gdsl_opcode_metadata_t *meta = &gdsl_opcode_table[opcode];
+        if (!meta->name || meta->size == 0 || meta->size > length - pos) {
+            return -1;
+        }
+        size_t size = meta->size;
+        uint64_t operand = 0;
+        if (meta->flags & GDSL_OPCODE_FLAG_CONTROL) {
+            operand = load_operand(stream + pos + 1, size - 1);
+        }
+        int keep = 1;
+
+        if (dead > 1 || (dead == 1 && opcode != GDSL_OPCODE_ELSE &&
+                         opcode != GDSL_OPCODE_ENDIF)) {
+            if (gdsl_fold_is_if(opcode)) {
+                dead++;
+            } else if (opcode == GDSL_OPCODE_ENDIF) {
+                dead--;
+            }
+            keep = 0;
+        } else if (gdsl_fold_is_if(opcode)) {
+            int taken;
+            if (depth == GDSL_FOLD_MAX_DEPTH ||
+                gdsl_fold_condition(&registers, opcode, operand, &taken) >= 0) {
+                return -1;
+            }
+            gdsl_fold_frame_t *frame = &frames[depth++];
+            frame->taken = taken;
+            frame->in_else = 0;
+            frame->entry = registers;
+            if (taken == GDSL_FOLD_UNKNOWN) {
+                stats->branches_kept++;
+            } else {
+                stats->branches_folded++;
+                keep = 0;
+                dead = taken == GDSL_FOLD_FALSE;
+            }
+        } else if (opcode == GDSL_OPCODE_ELSE) {
+            if (depth == 0 || frames[depth - 1].in_else) {
+                return -1;
+            }
+            gdsl_fold_frame_t *frame = &frames[depth - 1];
+            frame->in_else = 1;
+            if (frame->taken == GDSL_FOLD_UNKNOWN) {
+                frame->then_arm = registers;
+                registers = frame->entry;
+            } else {
+                keep = 0;
+                dead = frame->taken == GDSL_FOLD_TRUE;
+            }
+        } else if (opcode == GDSL_OPCODE_ENDIF) {
+            if (depth == 0) {
+                return -1;
+            }
+            gdsl_fold_frame_t *frame = &frames[--depth];
+            if (frame->taken == GDSL_FOLD_UNKNOWN) {
+                gdsl_fold_join(&registers,
+                               frame->in_else ? &frame->then_arm : &frame->entry);
+            } else {
+                keep = 0;
+                dead = 0;
+            }
+        } else if (meta->flags & GDSL_OPCODE_FLAG_CONTROL) {
+            if (gdsl_fold_apply(&registers, opcode, operand) >= 0) {
+                return -1;
+            }
+        }
+
+        if (keep) {
+            memcpy(out + written, stream + pos, size);
+            written += size;
+        } else {
+            stats->instructions_removed++;
+            stats->bytes_removed += size;
+        }
+        pos += size;
+    }
+
+    if (depth > 0) {
+        return -1;
+    }
+    *out_length = written;
+    return 0;
+}
+
+int gdsl_fold(const uint8_t *stream,
+              size_t length,
+              uint8_t **out_stream,
+              size_t *out_length,
+              gdsl_fold_stats_t *stats) {
+    if (!out_stream || !out_length || (!stream && length > 0)) {
+        return -1;
+    }
+    *out_stream = NULL;
+    *out_length = 0;
+
+    /* Pruning only ever removes bytes. */
+    uint8_t *out = (uint8_t *)malloc(length ? length : 1);
+    if (!out) {
+        return -1;
+    }
+    gdsl_fold_stats_t local;
+    memset(&local, 0, sizeof(local));
+    size_t written = 0;
+    if (fold_stream(stream, length, out, &written, &local) != 0) {
+        if (length > 0) {
+            memcpy(out, stream, length);
+        }
+        written = length;
+        memset(&local, 0, sizeof(local));
+    }
+
+    if (stats) {
+        *stats = local;
+    }
+    *out_stream = out;
+    *out_length = written;
+    return 0;
+}
@@ -0,0 +1,37 @@
+#ifndef GDSL_FOLD_EVAL_INTERNAL_H
+#define GDSL_FOLD_EVAL_INTERNAL_H
+
+#include <stdint.h>
+
+#include "gdsl/fold.h"
+
+/* Abstract register file shared by gdsl_fold and the verifier: bit r of
+ * known is set when register r holds values[r] on every path. */
+typedef struct {
+    uint32_t known;
+    int32_t values[GDSL_FOLD_REGISTERS];
+} gdsl_fold_registers_t;
+
+/* Condition of an IF: decided either way or unknown. */
+#define GDSL_FOLD_FALSE 0
+#define GDSL_FOLD_TRUE 1
+#define GDSL_FOLD_UNKNOWN 2
+
+int gdsl_fold_is_if(uint8_t opcode);
+
+/* Applies CONST_I32, ADD, SUB or MUL; operand is the little-endian operand
+ * value. Returns the first register out of range, or -1 when all are valid
+ * (an out-of-range destination is ignored, other results become unknown). */
+int gdsl_fold_apply(gdsl_fold_registers_t *registers, uint8_t opcode, uint64_t operand);
+
+/* Evaluates an IF_* into *out. Returns like gdsl_fold_apply; the condition
+ * is unknown when a register is out of range. */
+int gdsl_fold_condition(const gdsl_fold_registers_t *registers,
+                        uint8_t opcode,
+                        uint64_t operand,
+                        int *out);
+
+/* Merges the registers of another path into registers. */
+void gdsl_fold_join(gdsl_fold_registers_t *registers, const gdsl_fold_registers_t *other);
+
+#endif // GDSL_FOLD_EVAL_INTERNAL_H
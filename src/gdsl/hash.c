@@ -0,0 +1,104 @@
+#include "hash.h"
+
+#include <string.h>
+
+#define GDSL_HASH_P1 0x9E3779B185EBCA87ull
+#define GDSL_HASH_P2 0xC2B2AE3D27D4EB4Full
+#define GDSL_HASH_P3 0x165667B19E3779F9ull
+
+static uint64_t rotl64(uint64_t x, unsigned r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static uint64_t fmix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xFF51AFD7ED558CCDull;
+    x ^= x >> 33;
+    x *= 0xC4CEB9FE1A85EC53ull;
+    x ^= x >> 33;
+    return x;
+}
+
+static uint64_t load64(const uint8_t *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static void hash_round(uint64_t *a, uint64_t *b, const uint8_t *block) {
+    *a = rotl64(*a + load64(block) * GDSL_HASH_P2, 31) * GDSL_HASH_P1;
+    *b = rotl64(*b + load64(block + 8) * GDSL_HASH_P3, 29) * GDSL_HASH_P2;
+}
+
+static gdsl_hash128_t hash_final(uint64_t a, uint64_t b) {
+    gdsl_hash128_t hash;
+    hash.lo = fmix64(a ^ rotl64(b, 17));
+    hash.hi = fmix64(b ^ rotl64(a, 41));
+    return hash;
+}
+
+gdsl_hash128_t gdsl_hash128(const uint8_t *data, size_t length) {
+    uint64_t a = GDSL_HASH_P1 ^ (uint64_t)length;
+    uint64_t b = GDSL_HASH_P2 + (uint64_t)length;
+
+    size_t offset = 0;
+    for (; offset + 16 <= length; offset += 16) {
+        hash_round(&a, &b, data + offset);
+    }
+
+    uint8_t tail[16] = {0};
+    if (offset < length) {
+        memcpy(tail, data + offset, length - offset);
+        hash_round(&a, &b, tail);
+    }
+
+    return hash_final(a, b);
+}
+
+void gdsl_hash128_stream_init(gdsl_hash128_stream_t *stream) {
+    memset(stream, 0, sizeof(*stream));
+    stream->a = GDSL_HASH_P1;
+    stream->b = GDSL_HASH_P2;
+}
+
+void gdsl_hash128_stream_update(gdsl_hash128_stream_t *stream,
+                                const uint8_t *data,
+                                size_t length) {
+    stream->length += length;
+    if (stream->pending_length > 0 && length > 0) {
+        size_t take = 16 - stream->pending_length;
+        if (take > length) {
+            take = length;
+        }
+        memcpy(stream->pending + stream->pending_length, data, take);
+        stream->pending_length += take;
+        data += take;
+        length -= take;
+        if (stream->pending_length < 16) {
+            return;
+        }
+        hash_round(&stream->a, &stream->b, stream->pending);
+        stream->pending_length = 0;
+    }
+    for (; length >= 16; data += 16, length -= 16) {
+        hash_round(&stream->a, &stream->b, data);
+    }
+    if (length > 0) {
+        memcpy(stream->pending, data, length);
+        stream->pending_length = length;
+    }
+}
+
+gdsl_hash128_t gdsl_hash128_stream_final(gdsl_hash128_stream_t *stream) {
+    uint64_t a = stream->a;
+    uint64_t b = stream->b;
+    if (stream->pending_length > 0) {
+        uint8_t tail[16] = {0};
+        memcpy(tail, stream->pending, stream->pending_length);
+        hash_round(&a, &b, tail);
+    }
+    /* The length is only known here, so it is mixed in last. */
+    a ^= stream->length * GDSL_HASH_P3;
+    b += stream->length;
+    return hash_final(a, b);
+}
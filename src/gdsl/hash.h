@@ -0,0 +1,36 @@
+#ifndef GDSL_HASH_INTERNAL_H
+#define GDSL_HASH_INTERNAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* 128-bit non-cryptographic content hash (two independent 64-bit lanes).
+ * Used to key result caches; it is not a defence against adversarial
+ * collisions. */
+typedef struct {
+    uint64_t lo;
+    uint64_t hi;
+} gdsl_hash128_t;
+
+gdsl_hash128_t gdsl_hash128(const uint8_t *data, size_t length);
+
+/* Incremental form for input that arrives in pieces. The result depends only
+ * on the concatenated bytes, not on how they were split, but it differs from
+ * gdsl_hash128 of the same bytes. */
+typedef struct {
+    uint64_t a;
+    uint64_t b;
+    uint64_t length;
+    uint8_t pending[16];
+    size_t pending_length;
+} gdsl_hash128_stream_t;
+
+void gdsl_hash128_stream_init(gdsl_hash128_stream_t *stream);
+
+void gdsl_hash128_stream_update(gdsl_hash128_stream_t *stream,
+                                const uint8_t *data,
+                                size_t length);
+
+gdsl_hash128_t gdsl_hash128_stream_final(gdsl_hash128_stream_t *stream);
+
+#endif // GDSL_HASH_INTERNAL_H
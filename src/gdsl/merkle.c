@@ -0,0 +1,136 @@
+#include "gdsl/merkle.h"
+
+#include "hash.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static gdsl_merkle_hash_t from_hash128(gdsl_hash128_t hash) {
+    gdsl_merkle_hash_t out;
+    out.lo = hash.lo;
+    out.hi = hash.hi;
+    return out;
+}
+
+static gdsl_merkle_hash_t hash_children(const gdsl_merkle_hash_t *left,
+                                        const gdsl_merkle_hash_t *right) {
+    uint64_t words[4] = {left->lo, left->hi, right->lo, right->hi};
+    uint8_t bytes[sizeof(words)];
+    memcpy(bytes, words, sizeof(bytes));
+    return from_hash128(gdsl_hash128(bytes, sizeof(bytes)));
+}
+
+typedef struct {
+    const uint8_t *heap;
+    size_t length;
+    size_t page_size;
+    gdsl_merkle_hash_t *leaves;
+} gdsl_merkle_leaf_task_t;
+
+static void hash_leaves(void *ctx, size_t begin, size_t end, size_t worker) {
+    (void)worker;
+    gdsl_merkle_leaf_task_t *task = (gdsl_merkle_leaf_task_t *)ctx;
+    for (size_t page = begin; page < end; ++page) {
+        size_t offset = page * task->page_size;
+        size_t size = task->length - offset < task->page_size ? task->length - offset
+                                                              : task->page_size;
+        task->leaves[page] = from_hash128(gdsl_hash128(task->heap + offset, size));
+    }
+}
+
+int gdsl_merkle_build(const uint8_t *heap,
+                      size_t length,
+                      size_t page_size,
+                      gdsl_pool_t *pool,
+                      gdsl_merkle_tree_t *out) {
+    if (!out || (!heap && length > 0)) {
+        return -1;
+    }
+    memset(out, 0, sizeof(*out));
+    if (page_size == 0) {
+        page_size = GDSL_MERKLE_DEFAULT_PAGE_SIZE;
+    }
+
+    /* An empty heap is one empty page. */
+    size_t page_count = length == 0 ? 1 : (length - 1) / page_size + 1;
+    size_t node_count = 0;
+    for (size_t level = page_count; ; level = (level + 1) / 2) {
+        node_count += level;
+        if (level == 1) {
+            break;
+        }
+    }
+    gdsl_merkle_hash_t *nodes = (gdsl_merkle_hash_t *)malloc(node_count * sizeof(*nodes));
+    if (!nodes) {
+        return -1;
+    }
+
+    gdsl_merkle_leaf_task_t task;
+    task.heap = heap;
+    task.length = length;
+    task.page_size = page_size;
+    task.leaves = nodes;
+    if (length == 0) {
+        nodes[0] = from_hash128(gdsl_hash128(NULL, 0));
+    } else if (gdsl_pool_parallel_for(pool, 0, page_count, 64, hash_leaves, &task) != 0) {
+        free(nodes);
+        return -1;
+    }
+
+    size_t level_begin = 0;
+    for (size_t level = page_count; level > 1; level = (level + 1) / 2) {
+        const gdsl_merkle_hash_t *children = nodes + level_begin;
+        gdsl_merkle_hash_t *parents = nodes + level_begin + level;
+        for (size_t i = 0; i < level / 2; ++i) {
+            parents[i] = hash_children(&children[2 * i], &children[2 * i + 1]);
+        }
+        if (level % 2) {
+            parents[level / 2] = children[level - 1];
+        }
+        level_begin += level;
+    }
+
+    out->nodes = nodes;
+    out->node_count = node_count;
+    out->page_count = page_count;
+    out->page_size = page_size;
+    out->length = length;
+    return 0;
+}
+
+void gdsl_merkle_destroy(gdsl_merkle_tree_t *tree) {
+    if (!tree) {
+        return;
+    }
+    free(tree->nodes);
+    memset(tree, 0, sizeof(*tree));
+}
+
+gdsl_merkle_hash_t gdsl_merkle_root(const gdsl_merkle_tree_t *tree) {
+    gdsl_merkle_hash_t root;
+    memset(&root, 0, sizeof(root));
+    if (tree && tree->node_count > 0) {
+        root = tree->nodes[tree->node_count - 1];
+    }
+    return root;
+}
+
+int gdsl_merkle_heap_root(const uint8_t *heap,
+                          size_t length,
+                          size_t page_size,
+                          gdsl_merkle_hash_t *out) {
+    if (!out) {
+        return -1;
+    }
+    gdsl_merkle_tree_t tree;
+    if (gdsl_merkle_build(heap, length, page_size, NULL, &tree) != 0) {
+        return -1;
+    }
+    *out = gdsl_merkle_root(&tree);
+    gdsl_merkle_destroy(&tree);
+    return 0;
+}
+
+int gdsl_merkle_equal(gdsl_merkle_hash_t a, gdsl_merkle_hash_t b) {
+    return a.lo == b.lo && a.hi == b.hi;
+}
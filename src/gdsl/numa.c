@@ -0,0 +1,102 @@
+#define _GNU_SOURCE
+
+#include "numa.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#define GDSL_MPOL_INTERLEAVE 3
+
+/* Parses a sysfs list such as "0-3,8,10-11" into values. */
+static size_t parse_list(const char *path, int *values, size_t max_values) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        return 0;
+    }
+
+    char line[4096];
+    size_t count = 0;
+    if (fgets(line, sizeof(line), file)) {
+        char *cursor = line;
+        while (*cursor && *cursor != '\n') {
+            char *end = NULL;
+            long first = strtol(cursor, &end, 10);
+            if (end == cursor || first < 0) {
+                break;
+            }
+            long last = first;
+            cursor = end;
+            if (*cursor == '-') {
+                last = strtol(cursor + 1, &end, 10);
+                if (end == cursor + 1 || last < first) {
+                    break;
+                }
+                cursor = end;
+            }
+            for (long v = first; v <= last && count < max_values; ++v) {
+                values[count++] = (int)v;
+            }
+            if (*cursor == ',') {
+                cursor++;
+            }
+        }
+    }
+
+    fclose(file);
+    return count;
+}
+
+size_t gdsl_numa_online_nodes(int *nodes, size_t max_nodes) {
+#if defined(__linux__)
+    return parse_list("/sys/devices/system/node/online", nodes, max_nodes);
+#else
+    (void)nodes;
+    (void)max_nodes;
+    return 0;
+#endif
+}
+
+size_t gdsl_numa_node_cpus(int node, int *cpus, size_t max_cpus) {
+#if defined(__linux__)
+    char path[128];
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+    return parse_list(path, cpus, max_cpus);
+#else
+    (void)node;
+    (void)cpus;
+    (void)max_cpus;
+    return 0;
+#endif
+}
+
+int gdsl_numa_interleave(void *addr, size_t length) {
+#if defined(__linux__) && defined(SYS_mbind)
+    int nodes[GDSL_NUMA_MAX_NODES];
+    size_t count = gdsl_numa_online_nodes(nodes, GDSL_NUMA_MAX_NODES);
+    if (count < 2) {
+        return 0;
+    }
+
+    unsigned long mask = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (nodes[i] < (int)(sizeof(mask) * 8)) {
+            mask |= 1ul << nodes[i];
+        }
+    }
+    if (syscall(SYS_mbind, addr, length, GDSL_MPOL_INTERLEAVE, &mask,
+                sizeof(mask) * 8, 0) != 0) {
+        return -1;
+    }
+    return 0;
+#else
+    (void)addr;
+    (void)length;
+    return 0;
+#endif
+}
@@ -0,0 +1,23 @@
+#ifndef GDSL_NUMA_INTERNAL_H
+#define GDSL_NUMA_INTERNAL_H
+
+#include <stddef.h>
+
+/* Internal NUMA topology helpers. Topology comes from sysfs and placement
+ * from the raw mbind syscall, so the library does not depend on libnuma.
+ * Every helper degrades to "one node, no placement" where unsupported. */
+
+#define GDSL_NUMA_MAX_NODES 64
+
+/* Fills nodes with the online node ids in ascending order and returns how
+ * many were written (0 when topology is unavailable). */
+size_t gdsl_numa_online_nodes(int *nodes, size_t max_nodes);
+
+/* Fills cpus with the CPUs of node and returns how many were written. */
+size_t gdsl_numa_node_cpus(int node, int *cpus, size_t max_cpus);
+
+/* Interleaves the pages of [addr, addr + length) across all online nodes.
+ * Must be called before the range is first touched. */
+int gdsl_numa_interleave(void *addr, size_t length);
+
+#endif // GDSL_NUMA_INTERNAL_H
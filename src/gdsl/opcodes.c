@@ -0,0 +1,56 @@
+#include "opcodes.h"
+
+const gdsl_opcode_metadata_t gdsl_opcode_table[256] = {
+    [GDSL_OPCODE_NOP] = {"NOP", 1},
+    [GDSL_OPCODE_BEGIN_STREAM] = {"BEGIN_STREAM", 1},
+    [GDSL_OPCODE_BARRIER] = {"BARRIER", 1},
+    [GDSL_OPCODE_SUBMIT] = {"SUBMIT", 1},
+    [GDSL_OPCODE_FENCE_WAIT] = {"FENCE_WAIT", 1},
+    [GDSL_OPCODE_END_STREAM] = {"END_STREAM", 1},
+    [GDSL_OPCODE_END_PROGRAM] = {"END_PROGRAM", 1},
+    [GDSL_OPCODE_SNAPSHOT_BEGIN] = {"SNAPSHOT_BEGIN", 1},
+    [GDSL_OPCODE_SNAPSHOT_END] = {"SNAPSHOT_END", 1},
+    [GDSL_OPCODE_CHECKPOINT] = {"CHECKPOINT", 1},
+    /* label_id / marker label_id / message id, u32 each. */
+    [GDSL_OPCODE_LABEL] = {"LABEL", 5, GDSL_OPCODE_FLAG_DEBUG},
+    [GDSL_OPCODE_MARKER_PUSH] = {"MARKER_PUSH", 5, GDSL_OPCODE_FLAG_DEBUG},
+    [GDSL_OPCODE_MARKER_POP] = {"MARKER_POP", 1, GDSL_OPCODE_FLAG_DEBUG},
+    [GDSL_OPCODE_LOG] = {"LOG", 5, GDSL_OPCODE_FLAG_DEBUG},
+    /* u8 device id; u32 semaphore id; u8 queue id. */
+    [GDSL_OPCODE_SET_DEVICE] = {"SET_DEVICE", 2, GDSL_OPCODE_FLAG_SYNC},
+    [GDSL_OPCODE_SEMAPHORE_SIGNAL] = {"SEMAPHORE_SIGNAL", 5, GDSL_OPCODE_FLAG_SYNC},
+    [GDSL_OPCODE_SEMAPHORE_WAIT] = {"SEMAPHORE_WAIT", 5, GDSL_OPCODE_FLAG_SYNC},
+    [GDSL_OPCODE_SET_QUEUE] = {"SET_QUEUE", 2, GDSL_OPCODE_FLAG_SYNC},
+    /* u32 buffer id; COPY_BUFFER takes u32 source then u32 destination. */
+    [GDSL_OPCODE_ALLOC_BUFFER] = {"ALLOC_BUFFER", 5, GDSL_OPCODE_FLAG_RESOURCE},
+    [GDSL_OPCODE_FREE_BUFFER] = {"FREE_BUFFER", 5, GDSL_OPCODE_FLAG_RESOURCE},
+    [GDSL_OPCODE_UPLOAD] = {"UPLOAD", 5, GDSL_OPCODE_FLAG_RESOURCE},
+    [GDSL_OPCODE_DOWNLOAD] = {"DOWNLOAD", 5, GDSL_OPCODE_FLAG_RESOURCE},
+    [GDSL_OPCODE_COPY_BUFFER] = {"COPY_BUFFER", 9, GDSL_OPCODE_FLAG_RESOURCE},
+    /* u8 bind point, u8 descriptor-set mask, u8 vertex-binding mask. */
+    [GDSL_OPCODE_PIPE_BIND] = {"PIPE_BIND", 4, GDSL_OPCODE_FLAG_BINDING},
+    /* u8 set or binding, then u32 descriptor or buffer id. */
+    [GDSL_OPCODE_SET_DESCRIPTOR] = {"SET_DESCRIPTOR", 6, GDSL_OPCODE_FLAG_BINDING},
+    [GDSL_OPCODE_BIND_BUFFER] = {"BIND_BUFFER", 6, GDSL_OPCODE_FLAG_BINDING},
+    [GDSL_OPCODE_BEGIN_PASS] = {"BEGIN_PASS", 1, GDSL_OPCODE_FLAG_BINDING},
+    [GDSL_OPCODE_END_PASS] = {"END_PASS", 1, GDSL_OPCODE_FLAG_BINDING},
+    /* u32 first, u32 count; u32 x, y, z groups. */
+    [GDSL_OPCODE_DRAW] = {"DRAW", 9, GDSL_OPCODE_FLAG_BINDING},
+    [GDSL_OPCODE_DRAW_INDEXED] = {"DRAW_INDEXED", 9, GDSL_OPCODE_FLAG_BINDING},
+    [GDSL_OPCODE_DISPATCH] = {"DISPATCH", 13, GDSL_OPCODE_FLAG_BINDING},
+    /* u32 query id. */
+    [GDSL_OPCODE_QUERY_BEGIN] = {"QUERY_BEGIN", 5, GDSL_OPCODE_FLAG_BINDING},
+    [GDSL_OPCODE_QUERY_END] = {"QUERY_END", 5, GDSL_OPCODE_FLAG_BINDING},
+    /* u8 register, i32 value; u8 destination and two u8 sources; two u8
+     * registers compared. */
+    [GDSL_OPCODE_CONST_I32] = {"CONST_I32", 6, GDSL_OPCODE_FLAG_CONTROL},
+    [GDSL_OPCODE_ADD] = {"ADD", 4, GDSL_OPCODE_FLAG_CONTROL},
+    [GDSL_OPCODE_SUB] = {"SUB", 4, GDSL_OPCODE_FLAG_CONTROL},
+    [GDSL_OPCODE_MUL] = {"MUL", 4, GDSL_OPCODE_FLAG_CONTROL},
+    [GDSL_OPCODE_IF_EQ] = {"IF_EQ", 3, GDSL_OPCODE_FLAG_CONTROL},
+    [GDSL_OPCODE_IF_NE] = {"IF_NE", 3, GDSL_OPCODE_FLAG_CONTROL},
+    [GDSL_OPCODE_IF_GT] = {"IF_GT", 3, GDSL_OPCODE_FLAG_CONTROL},
+    [GDSL_OPCODE_IF_LT] = {"IF_LT", 3, GDSL_OPCODE_FLAG_CONTROL},
+    [GDSL_OPCODE_ELSE] = {"ELSE", 1, GDSL_OPCODE_FLAG_CONTROL},
+    [GDSL_OPCODE_ENDIF] = {"ENDIF", 1, GDSL_OPCODE_FLAG_CONTROL},
+};
@@ -0,0 +1,80 @@
+#ifndef GDSL_OPCODES_INTERNAL_H
+#define GDSL_OPCODES_INTERNAL_H
+
+#include <stdint.h>
+
+typedef enum {
+    GDSL_OPCODE_NOP = 0x00,
+    GDSL_OPCODE_BEGIN_STREAM = 0x01,
+    GDSL_OPCODE_BARRIER = 0x02,
+    GDSL_OPCODE_SUBMIT = 0x03,
+    GDSL_OPCODE_FENCE_WAIT = 0x04,
+    GDSL_OPCODE_END_STREAM = 0x05,
+    GDSL_OPCODE_END_PROGRAM = 0x06,
+    GDSL_OPCODE_SNAPSHOT_BEGIN = 0x07,
+    GDSL_OPCODE_SNAPSHOT_END = 0x08,
+    GDSL_OPCODE_CHECKPOINT = 0x09,
+    GDSL_OPCODE_LABEL = 0x0A,
+    GDSL_OPCODE_MARKER_PUSH = 0x0B,
+    GDSL_OPCODE_MARKER_POP = 0x0C,
+    GDSL_OPCODE_LOG = 0x0D,
+    GDSL_OPCODE_SET_DEVICE = 0x0E,
+    GDSL_OPCODE_SEMAPHORE_SIGNAL = 0x0F,
+    GDSL_OPCODE_SEMAPHORE_WAIT = 0x10,
+    GDSL_OPCODE_SET_QUEUE = 0x11,
+    GDSL_OPCODE_ALLOC_BUFFER = 0x12,
+    GDSL_OPCODE_FREE_BUFFER = 0x13,
+    GDSL_OPCODE_UPLOAD = 0x14,
+    GDSL_OPCODE_DOWNLOAD = 0x15,
+    GDSL_OPCODE_COPY_BUFFER = 0x16,
+    GDSL_OPCODE_PIPE_BIND = 0x17,
+    GDSL_OPCODE_SET_DESCRIPTOR = 0x18,
+    GDSL_OPCODE_BIND_BUFFER = 0x19,
+    GDSL_OPCODE_BEGIN_PASS = 0x1A,
+    GDSL_OPCODE_END_PASS = 0x1B,
+    GDSL_OPCODE_DRAW = 0x1C,
+    GDSL_OPCODE_DRAW_INDEXED = 0x1D,
+    GDSL_OPCODE_DISPATCH = 0x1E,
+    GDSL_OPCODE_QUERY_BEGIN = 0x1F,
+    GDSL_OPCODE_QUERY_END = 0x20,
+    GDSL_OPCODE_CONST_I32 = 0x21,
+    GDSL_OPCODE_ADD = 0x22,
+    GDSL_OPCODE_SUB = 0x23,
+    GDSL_OPCODE_MUL = 0x24,
+    GDSL_OPCODE_IF_EQ = 0x25,
+    GDSL_OPCODE_IF_NE = 0x26,
+    GDSL_OPCODE_IF_GT = 0x27,
+    GDSL_OPCODE_IF_LT = 0x28,
+    GDSL_OPCODE_ELSE = 0x29,
+    GDSL_OPCODE_ENDIF = 0x2A
+} gdsl_opcode_t;
+
+/* Debug-only instruction: no rule reads it and it never changes the verifier
+ * state, so it does not take part in the canonical stream hash. */
+#define GDSL_OPCODE_FLAG_DEBUG (1u << 0)
+/* Reads its operand and verifier state beyond gdsl_state_t (the selected
+ * device, semaphore edges). The state-key rules, and everything derived from
+ * them, only see its phase checks. */
+#define GDSL_OPCODE_FLAG_SYNC (1u << 1)
+/* Accesses the buffers named by its operand. Only race detection reads the
+ * operand; otherwise it is a plain phase-checked instruction. */
+#define GDSL_OPCODE_FLAG_RESOURCE (1u << 2)
+/* Reads or updates the bindings and the pass/query nesting of the selected
+ * device, which live outside gdsl_state_t. Like SYNC opcodes, these are
+ * never neutral and codegen refuses them. */
+#define GDSL_OPCODE_FLAG_BINDING (1u << 3)
+/* Register arithmetic and IF/ELSE/ENDIF (gdsl/fold.h): reads the register
+ * file or the branch stack, so it is handled like the binding opcodes. */
+#define GDSL_OPCODE_FLAG_CONTROL (1u << 4)
+
+/* size counts the opcode byte plus its operands; name is NULL for bytes that
+ * are not opcodes. */
+typedef struct {
+    const char *name;
+    uint8_t size;
+    uint8_t flags;
+} gdsl_opcode_metadata_t;
+
+extern const gdsl_opcode_metadata_t gdsl_opcode_table[256];
+
+#endif // GDSL_OPCODES_INTERNAL_H
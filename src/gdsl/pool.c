@@ -0,0 +1,560 @@
+#define _GNU_SOURCE
+
+#include "gdsl/pool.h"
+
+#include "numa.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define GDSL_POOL_DEQUE_CAPACITY 256u
+#define GDSL_POOL_STEAL_ROUNDS 64u
+
+typedef struct gdsl_pool_job gdsl_pool_job_t;
+
+typedef struct {
+    gdsl_pool_job_t *job;
+    size_t begin;
+    size_t end;
+} gdsl_pool_task_t;
+
+struct gdsl_pool_job {
+    gdsl_pool_range_fn fn;
+    void *ctx;
+    size_t grain;
+    size_t remaining;
+    gdsl_pool_task_t *tasks;
+    size_t task_capacity;
+    size_t task_next;
+};
+
+/* Chase-Lev deque (Le et al., "Correct and Efficient Work-Stealing for Weak
+ * Memory Models"), with the seq_cst fences folded into the bottom/top
+ * accesses they order. Fixed capacity: a full deque makes the owner run the
+ * would-be task inline instead of growing. */
+typedef struct {
+    int64_t top;
+    int64_t bottom;
+    gdsl_pool_task_t *slots[GDSL_POOL_DEQUE_CAPACITY];
+} gdsl_pool_deque_t;
+
+typedef struct {
+    gdsl_pool_t *pool;
+    size_t index;
+    uint32_t rng;
+    int cpu;
+    int node;
+    pthread_t thread;
+    /* Task addressed to this worker alone (static partitioning). */
+    gdsl_pool_task_t *mailbox;
+    gdsl_pool_deque_t deque;
+} gdsl_pool_worker_t;
+
+struct gdsl_pool {
+    size_t thread_count;
+    size_t node_count;
+    int numa_aware;
+    gdsl_pool_worker_t *workers;
+    pthread_mutex_t submit_lock;
+    pthread_mutex_t sleep_lock;
+    pthread_cond_t sleep_cond;
+    uint64_t work_epoch;
+    size_t sleepers;
+    int shutdown;
+};
+
+static __thread gdsl_pool_worker_t *tls_worker;
+
+static int deque_push(gdsl_pool_deque_t *deque, gdsl_pool_task_t *task) {
+    int64_t b = __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED);
+    int64_t t = __atomic_load_n(&deque->top, __ATOMIC_ACQUIRE);
+    if (b - t >= (int64_t)GDSL_POOL_DEQUE_CAPACITY) {
+        return -1;
+    }
+    __atomic_store_n(&deque->slots[b & (GDSL_POOL_DEQUE_CAPACITY - 1)], task,
+                     __ATOMIC_RELAXED);
+    __atomic_store_n(&deque->bottom, b + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+static gdsl_pool_task_t *deque_pop(gdsl_pool_deque_t *deque) {
+    int64_t b = __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED) - 1;
+    __atomic_store_n(&deque->bottom, b, __ATOMIC_SEQ_CST);
+    int64_t t = __atomic_load_n(&deque->top, __ATOMIC_SEQ_CST);
+
+    if (t > b) {
+        __atomic_store_n(&deque->bottom, b + 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+
+    gdsl_pool_task_t *task = __atomic_load_n(
+        &deque->slots[b & (GDSL_POOL_DEQUE_CAPACITY - 1)], __ATOMIC_RELAXED);
+    if (t == b) {
+        if (!__atomic_compare_exchange_n(&deque->top, &t, t + 1, 0,
+                                         __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+            task = NULL;
+        }
+        __atomic_store_n(&deque->bottom, b + 1, __ATOMIC_RELAXED);
+    }
+    return task;
+}
+
+static gdsl_pool_task_t *deque_steal(gdsl_pool_deque_t *deque) {
+    int64_t t = __atomic_load_n(&deque->top, __ATOMIC_SEQ_CST);
+    int64_t b = __atomic_load_n(&deque->bottom, __ATOMIC_SEQ_CST);
+    if (t >= b) {
+        return NULL;
+    }
+
+    gdsl_pool_task_t *task = __atomic_load_n(
+        &deque->slots[t & (GDSL_POOL_DEQUE_CAPACITY - 1)], __ATOMIC_RELAXED);
+    if (!__atomic_compare_exchange_n(&deque->top, &t, t + 1, 0,
+                                     __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+        return NULL;
+    }
+    return task;
+}
+
+static uint32_t next_random(gdsl_pool_worker_t *worker) {
+    uint32_t x = worker->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    worker->rng = x;
+    return x;
+}
+
+static void notify_work(gdsl_pool_t *pool) {
+    __atomic_add_fetch(&pool->work_epoch, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&pool->sleepers, __ATOMIC_SEQ_CST) > 0) {
+        pthread_mutex_lock(&pool->sleep_lock);
+        pthread_cond_broadcast(&pool->sleep_cond);
+        pthread_mutex_unlock(&pool->sleep_lock);
+    }
+}
+
+static gdsl_pool_task_t *alloc_task(gdsl_pool_job_t *job,
+                                    size_t begin,
+                                    size_t end) {
+    size_t slot = __atomic_fetch_add(&job->task_next, 1, __ATOMIC_RELAXED);
+    if (slot >= job->task_capacity) {
+        return NULL;
+    }
+    gdsl_pool_task_t *task = &job->tasks[slot];
+    task->job = job;
+    task->begin = begin;
+    task->end = end;
+    return task;
+}
+
+static void run_task(gdsl_pool_worker_t *worker, gdsl_pool_task_t *task) {
+    gdsl_pool_job_t *job = task->job;
+    size_t begin = task->begin;
+    size_t end = task->end;
+
+    /* Lazy binary splitting: publish the upper half for thieves and keep
+     * working on the lower half until the range reaches the grain. */
+    while (end - begin > job->grain) {
+        size_t mid = begin + (end - begin) / 2;
+        gdsl_pool_task_t *half = alloc_task(job, mid, end);
+        if (!half || deque_push(&worker->deque, half) != 0) {
+            break;
+        }
+        notify_work(worker->pool);
+        end = mid;
+    }
+
+    job->fn(job->ctx, begin, end, worker->index);
+    __atomic_sub_fetch(&job->remaining, end - begin, __ATOMIC_RELEASE);
+}
+
+static gdsl_pool_task_t *find_task(gdsl_pool_worker_t *worker) {
+    gdsl_pool_task_t *task = NULL;
+    if (__atomic_load_n(&worker->mailbox, __ATOMIC_RELAXED)) {
+        task = __atomic_exchange_n(&worker->mailbox, NULL, __ATOMIC_ACQUIRE);
+        if (task) {
+            return task;
+        }
+    }
+
+    task = deque_pop(&worker->deque);
+    if (task) {
+        return task;
+    }
+
+    gdsl_pool_t *pool = worker->pool;
+    size_t count = pool->thread_count;
+    if (count < 2) {
+        return NULL;
+    }
+    size_t start = next_random(worker) % count;
+    for (size_t i = 0; i < count; ++i) {
+        size_t victim = (start + i) % count;
+        if (victim == worker->index) {
+            continue;
+        }
+        task = deque_steal(&pool->workers[victim].deque);
+        if (task) {
+            return task;
+        }
+    }
+    return NULL;
+}
+
+/* Helps until every range of job has completed. Tasks run here may belong to
+ * an enclosing job when parallel_for is nested; running them is still
+ * correct and keeps the deques draining. */
+static void help_until_done(gdsl_pool_worker_t *self, gdsl_pool_job_t *job) {
+    while (__atomic_load_n(&job->remaining, __ATOMIC_ACQUIRE) != 0) {
+        gdsl_pool_task_t *task = find_task(self);
+        if (task) {
+            run_task(self, task);
+        } else {
+            sched_yield();
+        }
+    }
+}
+
+static void *worker_main(void *arg) {
+    gdsl_pool_worker_t *worker = (gdsl_pool_worker_t *)arg;
+    gdsl_pool_t *pool = worker->pool;
+    tls_worker = worker;
+
+    for (;;) {
+        uint64_t epoch = __atomic_load_n(&pool->work_epoch, __ATOMIC_SEQ_CST);
+
+        gdsl_pool_task_t *task = NULL;
+        for (unsigned round = 0; round < GDSL_POOL_STEAL_ROUNDS && !task;
+             ++round) {
+            task = find_task(worker);
+        }
+        if (task) {
+            run_task(worker, task);
+            continue;
+        }
+
+        pthread_mutex_lock(&pool->sleep_lock);
+        __atomic_add_fetch(&pool->sleepers, 1, __ATOMIC_SEQ_CST);
+        while (!pool->shutdown &&
+               __atomic_load_n(&pool->work_epoch, __ATOMIC_SEQ_CST) == epoch) {
+            pthread_cond_wait(&pool->sleep_cond, &pool->sleep_lock);
+        }
+        __atomic_sub_fetch(&pool->sleepers, 1, __ATOMIC_SEQ_CST);
+        int stop = pool->shutdown;
+        pthread_mutex_unlock(&pool->sleep_lock);
+        if (stop) {
+            break;
+        }
+    }
+
+    tls_worker = NULL;
+    return NULL;
+}
+
+static size_t online_cpus(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (size_t)n : 1;
+}
+
+static void pin_worker(gdsl_pool_worker_t *worker) {
+#if defined(__linux__)
+    if (worker->cpu < 0 || worker->cpu >= CPU_SETSIZE) {
+        return;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(worker->cpu, &set);
+    pthread_setaffinity_np(worker->thread, sizeof(set), &set);
+#else
+    (void)worker;
+#endif
+}
+
+/* Spreads background workers 1..n-1 evenly over the online nodes, in node
+ * order, so contiguous static partitions map to contiguous node ranges. */
+static void assign_numa_cpus(gdsl_pool_t *pool) {
+    int nodes[GDSL_NUMA_MAX_NODES];
+    size_t node_count = gdsl_numa_online_nodes(nodes, GDSL_NUMA_MAX_NODES);
+    size_t background = pool->thread_count - 1;
+    if (node_count == 0 || background == 0) {
+        return;
+    }
+
+    int cpus[1024];
+    size_t used = 0;
+    for (size_t n = 0; n < node_count; ++n) {
+        size_t first = 1 + n * background / node_count;
+        size_t last = 1 + (n + 1) * background / node_count;
+        size_t cpu_count = gdsl_numa_node_cpus(nodes[n], cpus, 1024);
+        if (first < last) {
+            used++;
+        }
+        for (size_t i = first; i < last; ++i) {
+            pool->workers[i].node = nodes[n];
+            pool->workers[i].cpu =
+                cpu_count ? cpus[(i - first) % cpu_count] : -1;
+        }
+    }
+    pool->node_count = used;
+}
+
+static void assign_explicit_cpus(gdsl_pool_t *pool,
+                                 const gdsl_pool_options_t *options) {
+    for (size_t i = 1; i < pool->thread_count; ++i) {
+        pool->workers[i].cpu =
+            options->cpu_affinity[(i - 1) % options->cpu_affinity_count];
+    }
+
+    int nodes[GDSL_NUMA_MAX_NODES];
+    size_t node_count = gdsl_numa_online_nodes(nodes, GDSL_NUMA_MAX_NODES);
+    int cpus[1024];
+    for (size_t n = 0; n < node_count; ++n) {
+        size_t cpu_count = gdsl_numa_node_cpus(nodes[n], cpus, 1024);
+        int used = 0;
+        for (size_t i = 1; i < pool->thread_count; ++i) {
+            for (size_t c = 0; c < cpu_count; ++c) {
+                if (cpus[c] == pool->workers[i].cpu) {
+                    pool->workers[i].node = nodes[n];
+                    used = 1;
+                }
+            }
+        }
+        pool->node_count += (size_t)used;
+    }
+}
+
+static void assign_cpus(gdsl_pool_t *pool, const gdsl_pool_options_t *options) {
+    if (options && options->cpu_affinity && options->cpu_affinity_count > 0) {
+        assign_explicit_cpus(pool, options);
+        return;
+    }
+    if (pool->numa_aware) {
+        assign_numa_cpus(pool);
+    }
+}
+
+int gdsl_pool_create(const gdsl_pool_options_t *options, gdsl_pool_t **out_pool) {
+    if (!out_pool) {
+        return -1;
+    }
+    *out_pool = NULL;
+
+    size_t thread_count = options ? options->thread_count : 0;
+    if (thread_count == 0) {
+        size_t cpus = online_cpus();
+        size_t reserved = options ? options->reserved_threads : 0;
+        thread_count = cpus > reserved ? cpus - reserved : 1;
+    }
+
+    gdsl_pool_t *pool = (gdsl_pool_t *)calloc(1, sizeof(*pool));
+    if (!pool) {
+        return -1;
+    }
+    pool->workers =
+        (gdsl_pool_worker_t *)calloc(thread_count, sizeof(gdsl_pool_worker_t));
+    if (!pool->workers) {
+        free(pool);
+        return -1;
+    }
+    pool->thread_count = thread_count;
+    pthread_mutex_init(&pool->submit_lock, NULL);
+    pthread_mutex_init(&pool->sleep_lock, NULL);
+    pthread_cond_init(&pool->sleep_cond, NULL);
+
+    for (size_t i = 0; i < thread_count; ++i) {
+        pool->workers[i].pool = pool;
+        pool->workers[i].index = i;
+        pool->workers[i].rng = (uint32_t)(0x9E3779B9u * (i + 1));
+        pool->workers[i].cpu = -1;
+        pool->workers[i].node = -1;
+    }
+    pool->numa_aware = options ? options->numa_aware : 0;
+    assign_cpus(pool, options);
+
+    /* Slot 0 belongs to whichever external thread is currently inside
+     * gdsl_pool_parallel_for; only slots 1..n-1 get background threads. */
+    for (size_t i = 1; i < thread_count; ++i) {
+        if (pthread_create(&pool->workers[i].thread, NULL, worker_main,
+                           &pool->workers[i]) != 0) {
+            pool->thread_count = i;
+            gdsl_pool_destroy(pool);
+            return -1;
+        }
+        pin_worker(&pool->workers[i]);
+    }
+
+    *out_pool = pool;
+    return 0;
+}
+
+void gdsl_pool_destroy(gdsl_pool_t *pool) {
+    if (!pool) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->sleep_lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->sleep_cond);
+    pthread_mutex_unlock(&pool->sleep_lock);
+
+    for (size_t i = 1; i < pool->thread_count; ++i) {
+        pthread_join(pool->workers[i].thread, NULL);
+    }
+
+    pthread_cond_destroy(&pool->sleep_cond);
+    pthread_mutex_destroy(&pool->sleep_lock);
+    pthread_mutex_destroy(&pool->submit_lock);
+    free(pool->workers);
+    free(pool);
+}
+
+size_t gdsl_pool_thread_count(const gdsl_pool_t *pool) {
+    return pool ? pool->thread_count : 1;
+}
+
+int gdsl_pool_worker_node(const gdsl_pool_t *pool, size_t worker) {
+    if (!pool || worker >= pool->thread_count) {
+        return -1;
+    }
+    return pool->workers[worker].node;
+}
+
+size_t gdsl_pool_node_count(const gdsl_pool_t *pool) {
+    return pool ? pool->node_count : 0;
+}
+
+int gdsl_pool_parallel_for(gdsl_pool_t *pool,
+                           size_t begin,
+                           size_t end,
+                           size_t grain,
+                           gdsl_pool_range_fn fn,
+                           void *ctx) {
+    if (!fn || end < begin) {
+        return -1;
+    }
+    if (begin == end) {
+        return 0;
+    }
+    if (grain == 0) {
+        grain = 1;
+    }
+
+    size_t count = end - begin;
+    if (!pool || pool->thread_count < 2 || count <= grain) {
+        gdsl_pool_worker_t *self = tls_worker;
+        size_t worker = (self && pool && self->pool == pool) ? self->index : 0;
+        fn(ctx, begin, end, worker);
+        return 0;
+    }
+
+    gdsl_pool_job_t job;
+    job.fn = fn;
+    job.ctx = ctx;
+    job.grain = grain;
+    job.remaining = count;
+    job.task_next = 0;
+    job.task_capacity = 2 * (count / grain + 1);
+    job.tasks =
+        (gdsl_pool_task_t *)malloc(job.task_capacity * sizeof(gdsl_pool_task_t));
+    if (!job.tasks) {
+        return -1;
+    }
+
+    gdsl_pool_worker_t *outer = tls_worker;
+    gdsl_pool_worker_t *self = outer;
+    int external = !self || self->pool != pool;
+    if (external) {
+        pthread_mutex_lock(&pool->submit_lock);
+        self = &pool->workers[0];
+        tls_worker = self;
+    }
+
+    gdsl_pool_task_t root = {&job, begin, end};
+    run_task(self, &root);
+    help_until_done(self, &job);
+
+    if (external) {
+        tls_worker = outer;
+        pthread_mutex_unlock(&pool->submit_lock);
+    }
+    free(job.tasks);
+    return 0;
+}
+
+int gdsl_pool_parallel_for_static(gdsl_pool_t *pool,
+                                  size_t begin,
+                                  size_t end,
+                                  gdsl_pool_range_fn fn,
+                                  void *ctx) {
+    if (!fn || end < begin) {
+        return -1;
+    }
+    if (begin == end) {
+        return 0;
+    }
+    if (!pool || pool->thread_count < 2) {
+        fn(ctx, begin, end, 0);
+        return 0;
+    }
+
+    gdsl_pool_worker_t *outer = tls_worker;
+    if (outer && outer->pool == pool) {
+        /* Mailboxes are only addressed by external callers, which hold the
+         * submit lock; nested calls use the stealing scheduler instead. */
+        size_t grain = (end - begin) / pool->thread_count + 1;
+        return gdsl_pool_parallel_for(pool, begin, end, grain, fn, ctx);
+    }
+
+    size_t first = pool->numa_aware ? 1 : 0;
+    size_t parts = pool->thread_count - first;
+    size_t count = end - begin;
+
+    gdsl_pool_job_t job;
+    job.fn = fn;
+    job.ctx = ctx;
+    job.grain = SIZE_MAX;
+    job.remaining = count;
+    job.task_capacity = parts;
+    job.task_next = parts;
+    job.tasks = (gdsl_pool_task_t *)malloc(parts * sizeof(gdsl_pool_task_t));
+    if (!job.tasks) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&pool->submit_lock);
+    gdsl_pool_worker_t *self = &pool->workers[0];
+    tls_worker = self;
+
+    gdsl_pool_task_t *own = NULL;
+    size_t share = count / parts;
+    size_t extra = count % parts;
+    for (size_t p = 0; p < parts; ++p) {
+        gdsl_pool_task_t *task = &job.tasks[p];
+        task->job = &job;
+        task->begin = begin + p * share + (p < extra ? p : extra);
+        task->end = task->begin + share + (p < extra ? 1 : 0);
+        if (task->begin == task->end) {
+            continue;
+        }
+        if (first + p == 0) {
+            own = task;
+        } else {
+            __atomic_store_n(&pool->workers[first + p].mailbox, task,
+                             __ATOMIC_RELEASE);
+        }
+    }
+    notify_work(pool);
+
+    if (own) {
+        run_task(self, own);
+    }
+    help_until_done(self, &job);
+
+    tls_worker = outer;
+    pthread_mutex_unlock(&pool->submit_lock);
+    free(job.tasks);
+    return 0;
+}
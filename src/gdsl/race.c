@@ -0,0 +1,355 @@
+#include "race.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define GDSL_RACE_THREAD_KEYS (1u << 16)
+
+/* An epoch is a thread's clock at one access: clock << 8 | thread. Clocks
+ * start at 1, so 0 means "no access". */
+typedef uint64_t gdsl_epoch_t;
+
+struct gdsl_race_resource {
+    uint32_t id;
+    int used;
+    gdsl_epoch_t write;
+    gdsl_epoch_t read;
+    /* Per-thread read clocks while unordered reads are outstanding. */
+    uint32_t *reads;
+};
+
+struct gdsl_race_semaphore {
+    uint32_t id;
+    int used;
+    /* FIFO of signaller clocks not consumed by a wait yet. */
+    uint32_t *pending;
+    size_t head;
+    size_t count;
+    size_t capacity;
+};
+
+static gdsl_epoch_t make_epoch(size_t thread, uint32_t clock) {
+    return (gdsl_epoch_t)clock << 8 | (gdsl_epoch_t)thread;
+}
+
+static size_t epoch_thread(gdsl_epoch_t epoch) {
+    return (size_t)(epoch & 0xFF);
+}
+
+static uint32_t epoch_clock(gdsl_epoch_t epoch) {
+    return (uint32_t)(epoch >> 8);
+}
+
+static uint32_t *thread_clock(gdsl_race_detector_t *detector, size_t thread) {
+    return detector->clocks + thread * GDSL_RACE_MAX_QUEUES;
+}
+
+/* Whether the access at epoch happens before the present of clock. */
+static int happens_before(gdsl_epoch_t epoch, const uint32_t *clock) {
+    return epoch_clock(epoch) <= clock[epoch_thread(epoch)];
+}
+
+static void join_clock(uint32_t *into, const uint32_t *from) {
+    for (size_t i = 0; i < GDSL_RACE_MAX_QUEUES; ++i) {
+        if (from[i] > into[i]) {
+            into[i] = from[i];
+        }
+    }
+}
+
+static size_t hash_id(uint32_t id) {
+    uint64_t x = (uint64_t)id * 0x9E3779B97F4A7C15ull;
+    return (size_t)(x >> 32);
+}
+
+void gdsl_race_release(gdsl_race_detector_t *detector) {
+    if (detector->resources) {
+        for (size_t i = 0; i <= detector->resource_mask; ++i) {
+            free(detector->resources[i].reads);
+        }
+    }
+    if (detector->semaphores) {
+        for (size_t i = 0; i <= detector->semaphore_mask; ++i) {
+            free(detector->semaphores[i].pending);
+        }
+    }
+    free(detector->resources);
+    free(detector->semaphores);
+    free(detector->clocks);
+    free(detector->thread_of);
+    memset(detector, 0, sizeof(*detector));
+}
+
+void gdsl_race_select(gdsl_race_detector_t *detector, uint8_t device, uint8_t queue) {
+    detector->selected = (uint16_t)(device << 8 | queue);
+    detector->current = -1;
+}
+
+/* Thread of the selected queue, created on first use and brought up to date
+ * with the host; -1 when it cannot be tracked. */
+static int current_thread(gdsl_race_detector_t *detector) {
+    if (detector->failed) {
+        return -1;
+    }
+    if (!detector->thread_of) {
+        detector->thread_of = (uint8_t *)calloc(GDSL_RACE_THREAD_KEYS, 1);
+        detector->clocks = (uint32_t *)calloc(
+            GDSL_RACE_MAX_QUEUES * GDSL_RACE_MAX_QUEUES, sizeof(uint32_t));
+        if (!detector->thread_of || !detector->clocks) {
+            detector->failed = 1;
+            return -1;
+        }
+        detector->current = -1;
+    }
+
+    int thread = detector->current;
+    if (thread < 0) {
+        uint8_t slot = detector->thread_of[detector->selected];
+        if (slot == 0) {
+            if (detector->thread_count == GDSL_RACE_MAX_QUEUES) {
+                detector->overflow = 1;
+                return -1;
+            }
+            size_t created = detector->thread_count++;
+            detector->thread_queue[created] = detector->selected;
+            thread_clock(detector, created)[created] = 1;
+            slot = (uint8_t)(created + 1);
+            detector->thread_of[detector->selected] = slot;
+        }
+        thread = slot - 1;
+        detector->current = thread;
+    }
+
+    if (detector->joined_host[thread] != detector->host_version) {
+        join_clock(thread_clock(detector, (size_t)thread), detector->host);
+        detector->joined_host[thread] = detector->host_version;
+    }
+    return thread;
+}
+
+static gdsl_race_semaphore_t *find_semaphore(gdsl_race_detector_t *detector,
+                                             uint32_t id) {
+    if (!detector->semaphores ||
+        (detector->semaphore_count + 1) * 2 > detector->semaphore_mask + 1) {
+        size_t capacity = detector->semaphores ? (detector->semaphore_mask + 1) * 2 : 64;
+        gdsl_race_semaphore_t *table =
+            (gdsl_race_semaphore_t *)calloc(capacity, sizeof(*table));
+        if (!table) {
+            detector->failed = 1;
+            return NULL;
+        }
+        if (detector->semaphores) {
+            for (size_t i = 0; i <= detector->semaphore_mask; ++i) {
+                gdsl_race_semaphore_t *old = &detector->semaphores[i];
+                if (!old->used) {
+                    continue;
+                }
+                size_t j = hash_id(old->id) & (capacity - 1);
+                while (table[j].used) {
+                    j = (j + 1) & (capacity - 1);
+                }
+                table[j] = *old;
+            }
+            free(detector->semaphores);
+        }
+        detector->semaphores = table;
+        detector->semaphore_mask = capacity - 1;
+    }
+
+    size_t i = hash_id(id) & detector->semaphore_mask;
+    while (detector->semaphores[i].used && detector->semaphores[i].id != id) {
+        i = (i + 1) & detector->semaphore_mask;
+    }
+    gdsl_race_semaphore_t *semaphore = &detector->semaphores[i];
+    if (!semaphore->used) {
+        semaphore->used = 1;
+        semaphore->id = id;
+        detector->semaphore_count++;
+    }
+    return semaphore;
+}
+
+void gdsl_race_signal(gdsl_race_detector_t *detector, uint32_t semaphore_id) {
+    int thread = current_thread(detector);
+    if (thread < 0) {
+        return;
+    }
+    gdsl_race_semaphore_t *semaphore = find_semaphore(detector, semaphore_id);
+    if (!semaphore) {
+        return;
+    }
+    if (semaphore->count == semaphore->capacity) {
+        size_t capacity = semaphore->capacity ? semaphore->capacity * 2 : 4;
+        uint32_t *pending = (uint32_t *)malloc(capacity * GDSL_RACE_MAX_QUEUES *
+                                               sizeof(uint32_t));
+        if (!pending) {
+            detector->failed = 1;
+            return;
+        }
+        for (size_t i = 0; i < semaphore->count; ++i) {
+            size_t from = (semaphore->head + i) % semaphore->capacity;
+            memcpy(pending + i * GDSL_RACE_MAX_QUEUES,
+                   semaphore->pending + from * GDSL_RACE_MAX_QUEUES,
+                   GDSL_RACE_MAX_QUEUES * sizeof(uint32_t));
+        }
+        free(semaphore->pending);
+        semaphore->pending = pending;
+        semaphore->capacity = capacity;
+        semaphore->head = 0;
+    }
+
+    uint32_t *clock = thread_clock(detector, (size_t)thread);
+    size_t tail = (semaphore->head + semaphore->count) % semaphore->capacity;
+    memcpy(semaphore->pending + tail * GDSL_RACE_MAX_QUEUES, clock,
+           GDSL_RACE_MAX_QUEUES * sizeof(uint32_t));
+    semaphore->count++;
+    clock[thread]++;
+}
+
+void gdsl_race_wait(gdsl_race_detector_t *detector, uint32_t semaphore_id) {
+    int thread = current_thread(detector);
+    if (thread < 0) {
+        return;
+    }
+    gdsl_race_semaphore_t *semaphore = find_semaphore(detector, semaphore_id);
+    if (!semaphore || semaphore->count == 0) {
+        /* Signalled later in the stream (or never): no edge to take here. */
+        return;
+    }
+    join_clock(thread_clock(detector, (size_t)thread),
+               semaphore->pending + semaphore->head * GDSL_RACE_MAX_QUEUES);
+    semaphore->head = (semaphore->head + 1) % semaphore->capacity;
+    semaphore->count--;
+}
+
+void gdsl_race_host_wait(gdsl_race_detector_t *detector) {
+    int thread = current_thread(detector);
+    if (thread < 0) {
+        return;
+    }
+    uint32_t *clock = thread_clock(detector, (size_t)thread);
+    join_clock(detector->host, clock);
+    detector->host_version++;
+    clock[thread]++;
+}
+
+static gdsl_race_resource_t *find_resource(gdsl_race_detector_t *detector, uint32_t id) {
+    if (!detector->resources ||
+        (detector->resource_count + 1) * 2 > detector->resource_mask + 1) {
+        size_t capacity = detector->resources ? (detector->resource_mask + 1) * 2 : 256;
+        gdsl_race_resource_t *table =
+            (gdsl_race_resource_t *)calloc(capacity, sizeof(*table));
+        if (!table) {
+            detector->failed = 1;
+            return NULL;
+        }
+        if (detector->resources) {
+            for (size_t i = 0; i <= detector->resource_mask; ++i) {
+                gdsl_race_resource_t *old = &detector->resources[i];
+                if (!old->used) {
+                    continue;
+                }
+                size_t j = hash_id(old->id) & (capacity - 1);
+                while (table[j].used) {
+                    j = (j + 1) & (capacity - 1);
+                }
+                table[j] = *old;
+            }
+            free(detector->resources);
+        }
+        detector->resources = table;
+        detector->resource_mask = capacity - 1;
+    }
+
+    size_t i = hash_id(id) & detector->resource_mask;
+    while (detector->resources[i].used && detector->resources[i].id != id) {
+        i = (i + 1) & detector->resource_mask;
+    }
+    gdsl_race_resource_t *resource = &detector->resources[i];
+    if (!resource->used) {
+        resource->used = 1;
+        resource->id = id;
+        detector->resource_count++;
+    }
+    return resource;
+}
+
+static void set_conflict(const gdsl_race_detector_t *detector,
+                         gdsl_race_conflict_t *conflict,
+                         size_t thread,
+                         int write,
+                         size_t other,
+                         int other_write) {
+    conflict->write = write;
+    conflict->queue = detector->thread_queue[thread];
+    conflict->other_write = other_write;
+    conflict->other_queue = detector->thread_queue[other];
+}
+
+int gdsl_race_access(gdsl_race_detector_t *detector,
+                     uint32_t resource_id,
+                     int write,
+                     gdsl_race_conflict_t *conflict) {
+    int current = current_thread(detector);
+    if (current < 0) {
+        return 0;
+    }
+    gdsl_race_resource_t *resource = find_resource(detector, resource_id);
+    if (!resource) {
+        return 0;
+    }
+    size_t thread = (size_t)current;
+    uint32_t *clock = thread_clock(detector, thread);
+    gdsl_epoch_t now = make_epoch(thread, clock[thread]);
+    int race = 0;
+
+    if (!write) {
+        if (!resource->reads && resource->read == now) {
+            return 0;
+        }
+        if (resource->write && !happens_before(resource->write, clock)) {
+            set_conflict(detector, conflict, thread, 0,
+                         epoch_thread(resource->write), 1);
+            race = 1;
+        }
+        if (resource->reads) {
+            resource->reads[thread] = clock[thread];
+        } else if (!resource->read || happens_before(resource->read, clock)) {
+            resource->read = now;
+        } else {
+            /* Unordered reads from two queues: keep one clock per queue. */
+            resource->reads = (uint32_t *)calloc(GDSL_RACE_MAX_QUEUES, sizeof(uint32_t));
+            if (!resource->reads) {
+                detector->failed = 1;
+                return race;
+            }
+            resource->reads[epoch_thread(resource->read)] = epoch_clock(resource->read);
+            resource->reads[thread] = clock[thread];
+        }
+        return race;
+    }
+
+    if (resource->write == now) {
+        return 0;
+    }
+    if (resource->write && !happens_before(resource->write, clock)) {
+        set_conflict(detector, conflict, thread, 1, epoch_thread(resource->write), 1);
+        race = 1;
+    }
+    if (resource->reads) {
+        for (size_t u = 0; u < detector->thread_count && !race; ++u) {
+            if (resource->reads[u] > clock[u]) {
+                set_conflict(detector, conflict, thread, 1, u, 0);
+                race = 1;
+            }
+        }
+        free(resource->reads);
+        resource->reads = NULL;
+    } else if (!race && resource->read && !happens_before(resource->read, clock)) {
+        set_conflict(detector, conflict, thread, 1, epoch_thread(resource->read), 0);
+        race = 1;
+    }
+    resource->read = 0;
+    resource->write = now;
+    return race;
+}
@@ -0,0 +1,76 @@
+#ifndef GDSL_RACE_INTERNAL_H
+#define GDSL_RACE_INTERNAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Cross-queue race detection (FastTrack). Every (device, queue) pair is a
+ * thread with a vector clock; happens-before edges come from semaphore
+ * signal/wait pairs and from host fence waits, which order a queue's work
+ * before everything recorded afterwards. Each resource keeps the epoch of its
+ * last write and of its last read, widened to a read vector only while reads
+ * from several queues are unordered, so the common access is O(1).
+ *
+ * Nothing is allocated until the first call; a zeroed detector is ready.
+ */
+
+#define GDSL_RACE_MAX_QUEUES 64
+
+typedef struct gdsl_race_resource gdsl_race_resource_t;
+typedef struct gdsl_race_semaphore gdsl_race_semaphore_t;
+
+typedef struct {
+    /* Thread of the selected queue, or -1 before the first access. */
+    int current;
+    size_t thread_count;
+    uint16_t thread_queue[GDSL_RACE_MAX_QUEUES];
+    /* (device << 8 | queue) -> thread + 1; 0 when not seen yet. */
+    uint8_t *thread_of;
+    uint16_t selected;
+    /* clocks[t * GDSL_RACE_MAX_QUEUES + u]: what thread t knows of u. */
+    uint32_t *clocks;
+    /* What the host has waited for, and the version each thread last joined. */
+    uint32_t host[GDSL_RACE_MAX_QUEUES];
+    uint64_t host_version;
+    uint64_t joined_host[GDSL_RACE_MAX_QUEUES];
+    gdsl_race_resource_t *resources;
+    size_t resource_mask;
+    size_t resource_count;
+    gdsl_race_semaphore_t *semaphores;
+    size_t semaphore_mask;
+    size_t semaphore_count;
+    /* A queue beyond GDSL_RACE_MAX_QUEUES was selected. */
+    int overflow;
+    int failed;
+} gdsl_race_detector_t;
+
+/* Queues are given as device << 8 | queue. */
+typedef struct {
+    int write;
+    uint16_t queue;
+    /* The earlier access it races with. */
+    int other_write;
+    uint16_t other_queue;
+} gdsl_race_conflict_t;
+
+void gdsl_race_release(gdsl_race_detector_t *detector);
+
+/* Selects the queue later calls act on. */
+void gdsl_race_select(gdsl_race_detector_t *detector, uint8_t device, uint8_t queue);
+
+void gdsl_race_signal(gdsl_race_detector_t *detector, uint32_t semaphore);
+
+void gdsl_race_wait(gdsl_race_detector_t *detector, uint32_t semaphore);
+
+/* The host waited for the selected queue's submitted work. */
+void gdsl_race_host_wait(gdsl_race_detector_t *detector);
+
+/* Records an access by the selected queue. Returns 1 and fills conflict
+ * when it is unordered with an earlier conflicting access. */
+int gdsl_race_access(gdsl_race_detector_t *detector,
+                     uint32_t resource,
+                     int write,
+                     gdsl_race_conflict_t *conflict);
+
+#endif // GDSL_RACE_INTERNAL_H
@@ -0,0 +1,107 @@
+#include "gdsl/replay.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    const uint8_t *stream;
+    size_t length;
+    const gdsl_slice_set_t *slices;
+    const gdsl_replay_options_t *options;
+    gdsl_replay_interval_t *intervals;
+} gdsl_replay_task_t;
+
+/* Base heap with the keyframe diff applied, in a malloc'd buffer. */
+static int materialise_keyframe(const gdsl_replay_options_t *options,
+                                const gdsl_slice_t *slice,
+                                uint8_t **out_heap,
+                                size_t *out_length) {
+    if (slice->diff) {
+        return gdsl_patch(options->base_heap, options->base_heap_length, slice->diff,
+                          out_heap, out_length);
+    }
+    size_t length = options->base_heap_length;
+    uint8_t *heap = (uint8_t *)malloc(length ? length : 1);
+    if (!heap) {
+        return -1;
+    }
+    if (length > 0) {
+        memcpy(heap, options->base_heap, length);
+    }
+    *out_heap = heap;
+    *out_length = length;
+    return 0;
+}
+
+static void replay_interval(const gdsl_replay_task_t *task, size_t i) {
+    const gdsl_replay_options_t *options = task->options;
+    const gdsl_slice_t *slice = &task->slices->slices[i];
+    gdsl_replay_interval_t *interval = &task->intervals[i];
+    memset(interval, 0, sizeof(*interval));
+    interval->status = GDSL_REPLAY_FAILED;
+
+    uint8_t *heap = NULL;
+    size_t heap_length = 0;
+    uint8_t *bytes = NULL;
+    size_t bytes_length = 0;
+    int rc = materialise_keyframe(options, slice, &heap, &heap_length);
+    if (rc == 0) {
+        rc = gdsl_slice_materialise(task->stream, task->length, slice, &bytes,
+                                    &bytes_length);
+    }
+    if (rc == 0) {
+        rc = options->execute(options->ctx, bytes, bytes_length, heap, heap_length);
+    }
+    if (rc == 0) {
+        rc = gdsl_merkle_heap_root(heap, heap_length, options->page_size, &interval->root);
+    }
+    free(bytes);
+    free(heap);
+    if (rc != 0) {
+        memset(&interval->root, 0, sizeof(interval->root));
+        return;
+    }
+
+    /* The interval ends at the CHECKPOINT the next slice starts at. */
+    uint64_t checkpoint = i + 1 < task->slices->count ? task->slices->slices[i + 1].checkpoint
+                                                      : GDSL_SLICE_NONE;
+    if (checkpoint == GDSL_SLICE_NONE || !options->checkpoint_roots ||
+        checkpoint >= options->checkpoint_root_count) {
+        interval->status = GDSL_REPLAY_UNCHECKED;
+    } else if (gdsl_merkle_equal(interval->root, options->checkpoint_roots[checkpoint])) {
+        interval->status = GDSL_REPLAY_CONSISTENT;
+    } else {
+        interval->status = GDSL_REPLAY_DIVERGED;
+    }
+}
+
+static void replay_range(void *ctx, size_t begin, size_t end, size_t worker) {
+    (void)worker;
+    const gdsl_replay_task_t *task = (const gdsl_replay_task_t *)ctx;
+    for (size_t i = begin; i < end; ++i) {
+        replay_interval(task, i);
+    }
+}
+
+int gdsl_replay_intervals(const uint8_t *stream,
+                          size_t length,
+                          const gdsl_slice_set_t *slices,
+                          const gdsl_replay_options_t *options,
+                          gdsl_replay_interval_t *intervals) {
+    if (!slices || !options || !options->execute || !intervals ||
+        (!stream && length > 0) ||
+        (!options->base_heap && options->base_heap_length > 0)) {
+        return -1;
+    }
+    gdsl_replay_task_t task;
+    task.stream = stream;
+    task.length = length;
+    task.slices = slices;
+    task.options = options;
+    task.intervals = intervals;
+    /* Intervals are long and uneven: hand them out one at a time. */
+    if (gdsl_pool_parallel_for(options->pool, 0, slices->count, 1, replay_range, &task) != 0) {
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,695 @@
+#include "gdsl/slice.h"
+
+#include "gdsl/verify.h"
+
+#include "opcodes.h"
+#include "verify_cuts.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    uint8_t *data;
+    size_t length;
+    size_t capacity;
+    int failed;
+} gdsl_slice_bytes_t;
+
+/* Appends one instruction with a little-endian operand. */
+static void emit(gdsl_slice_bytes_t *out, uint8_t opcode, uint64_t operand) {
+    size_t size = gdsl_opcode_table[opcode].size;
+    if (out->length + size > out->capacity) {
+        size_t capacity = out->capacity ? out->capacity * 2 : 64;
+        while (capacity < out->length + size) {
+            capacity *= 2;
+        }
+        uint8_t *data = (uint8_t *)realloc(out->data, capacity);
+        if (!data) {
+            out->failed = 1;
+            return;
+        }
+        out->data = data;
+        out->capacity = capacity;
+    }
+    uint8_t *bytes = out->data + out->length;
+    bytes[0] = opcode;
+    for (size_t i = 1; i < size; ++i) {
+        bytes[i] = i <= 8 ? (uint8_t)(operand >> (8 * (i - 1))) : 0;
+    }
+    out->length += size;
+}
+
+/*
+ * Buffers and semaphores by id, in an open-addressing table. A buffer is
+ * live from ALLOC_BUFFER to FREE_BUFFER; a semaphore keeps the device of
+ * every signal, of which the first `waits` have been consumed.
+ */
+typedef struct {
+    uint32_t id;
+    int used;
+    int live;
+    uint8_t device;
+    uint8_t *signals;
+    size_t signal_count;
+    size_t signal_capacity;
+    uint64_t waits;
+} gdsl_slice_object_t;
+
+typedef struct {
+    gdsl_slice_object_t *entries;
+    size_t mask;
+    size_t count;
+} gdsl_slice_table_t;
+
+static size_t hash_id(uint32_t id) {
+    uint64_t x = (uint64_t)id * 0x9E3779B97F4A7C15ull;
+    return (size_t)(x >> 32);
+}
+
+static gdsl_slice_object_t *find_object(gdsl_slice_table_t *table, uint32_t id) {
+    if (!table->entries || (table->count + 1) * 2 > table->mask + 1) {
+        size_t capacity = table->entries ? (table->mask + 1) * 2 : 64;
+        gdsl_slice_object_t *entries =
+            (gdsl_slice_object_t *)calloc(capacity, sizeof(*entries));
+        if (!entries) {
+            return NULL;
+        }
+        if (table->entries) {
+            for (size_t i = 0; i <= table->mask; ++i) {
+                if (!table->entries[i].used) {
+                    continue;
+                }
+                size_t j = hash_id(table->entries[i].id) & (capacity - 1);
+                while (entries[j].used) {
+                    j = (j + 1) & (capacity - 1);
+                }
+                entries[j] = table->entries[i];
+            }
+            free(table->entries);
+        }
+        table->entries = entries;
+        table->mask = capacity - 1;
+    }
+
+    size_t i = hash_id(id) & table->mask;
+    while (table->entries[i].used && table->entries[i].id != id) {
+        i = (i + 1) & table->mask;
+    }
+    gdsl_slice_object_t *object = &table->entries[i];
+    if (!object->used) {
+        object->used = 1;
+        object->id = id;
+        table->count++;
+    }
+    return object;
+}
+
+static void table_release(gdsl_slice_table_t *table) {
+    if (table->entries) {
+        for (size_t i = 0; i <= table->mask; ++i) {
+            free(table->entries[i].signals);
+        }
+    }
+    free(table->entries);
+    memset(table, 0, sizeof(*table));
+}
+
+/* What is bound on a device since its last BEGIN_STREAM: operands of the
+ * last PIPE_BIND per bind point, SET_DESCRIPTOR per set and BIND_BUFFER per
+ * binding, and the ids of the open queries. */
+#define GDSL_SLICE_QUERY_IDS 8
+
+typedef struct {
+    uint32_t pipelines;
+    uint64_t pipeline[2];
+    uint32_t sets;
+    uint64_t set[8];
+    uint32_t buffers;
+    uint64_t buffer[9];
+    uint32_t query_count;
+    uint32_t query[GDSL_SLICE_QUERY_IDS];
+} gdsl_slice_bindings_t;
+
+/* A prologue re-declaration: a live buffer (signal == 0) or a pending
+ * signal, sorted by device, then buffers before signals, then id. */
+typedef struct {
+    uint8_t device;
+    uint8_t signal;
+    uint32_t id;
+    size_t order;
+} gdsl_slice_declaration_t;
+
+typedef struct {
+    gdsl_slice_table_t buffers;
+    gdsl_slice_table_t semaphores;
+    gdsl_slice_bindings_t bindings[GDSL_VERIFY_CUT_DEVICES];
+    gdsl_slice_declaration_t *declarations;
+    size_t declaration_capacity;
+    gdsl_slice_set_t *set;
+    int failed;
+    int invalid;
+} gdsl_slicer_t;
+
+static void observe_binding(gdsl_slice_bindings_t *bindings, uint8_t opcode, uint64_t operand) {
+    uint8_t slot = (uint8_t)operand;
+    switch (opcode) {
+    case GDSL_OPCODE_BEGIN_STREAM:
+        memset(bindings, 0, sizeof(*bindings));
+        break;
+    case GDSL_OPCODE_PIPE_BIND:
+        if (slot < 2) {
+            bindings->pipelines |= 1u << slot;
+            bindings->pipeline[slot] = operand;
+        }
+        break;
+    case GDSL_OPCODE_SET_DESCRIPTOR:
+        if (slot < 8) {
+            bindings->sets |= 1u << slot;
+            bindings->set[slot] = operand;
+        }
+        break;
+    case GDSL_OPCODE_BIND_BUFFER:
+        if (slot < 9) {
+            bindings->buffers |= 1u << slot;
+            bindings->buffer[slot] = operand;
+        }
+        break;
+    case GDSL_OPCODE_QUERY_BEGIN:
+        if (bindings->query_count < GDSL_SLICE_QUERY_IDS) {
+            bindings->query[bindings->query_count] = (uint32_t)operand;
+        }
+        bindings->query_count++;
+        break;
+    case GDSL_OPCODE_QUERY_END:
+        if (bindings->query_count > 0) {
+            bindings->query_count--;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+static void observe_instruction(void *ctx, uint8_t opcode, uint64_t operand, uint8_t device) {
+    gdsl_slicer_t *slicer = (gdsl_slicer_t *)ctx;
+    gdsl_slice_object_t *object;
+    switch (opcode) {
+    case GDSL_OPCODE_ALLOC_BUFFER:
+    case GDSL_OPCODE_FREE_BUFFER:
+        object = find_object(&slicer->buffers, (uint32_t)operand);
+        if (!object) {
+            slicer->failed = 1;
+            return;
+        }
+        object->live = opcode == GDSL_OPCODE_ALLOC_BUFFER;
+        object->device = device;
+        break;
+    case GDSL_OPCODE_SEMAPHORE_SIGNAL:
+    case GDSL_OPCODE_SEMAPHORE_WAIT:
+        object = find_object(&slicer->semaphores, (uint32_t)operand);
+        if (!object) {
+            slicer->failed = 1;
+            return;
+        }
+        if (opcode == GDSL_OPCODE_SEMAPHORE_WAIT) {
+            object->waits++;
+            return;
+        }
+        if (object->signal_count == object->signal_capacity) {
+            size_t capacity = object->signal_capacity ? object->signal_capacity * 2 : 8;
+            uint8_t *signals = (uint8_t *)realloc(object->signals, capacity);
+            if (!signals) {
+                slicer->failed = 1;
+                return;
+            }
+            object->signals = signals;
+            object->signal_capacity = capacity;
+        }
+        object->signals[object->signal_count++] = device;
+        break;
+    default:
+        observe_binding(&slicer->bindings[device], opcode, operand);
+        break;
+    }
+}
+
+static int compare_declarations(const void *a, const void *b) {
+    const gdsl_slice_declaration_t *x = (const gdsl_slice_declaration_t *)a;
+    const gdsl_slice_declaration_t *y = (const gdsl_slice_declaration_t *)b;
+    if (x->device != y->device) {
+        return x->device < y->device ? -1 : 1;
+    }
+    if (x->signal != y->signal) {
+        return x->signal < y->signal ? -1 : 1;
+    }
+    if (x->id != y->id) {
+        return x->id < y->id ? -1 : 1;
+    }
+    return x->order < y->order ? -1 : (x->order > y->order);
+}
+
+static int add_declaration(gdsl_slicer_t *slicer,
+                           size_t *count,
+                           uint8_t device,
+                           uint8_t signal,
+                           uint32_t id,
+                           size_t order) {
+    if (*count == slicer->declaration_capacity) {
+        size_t capacity = slicer->declaration_capacity ? slicer->declaration_capacity * 2 : 64;
+        gdsl_slice_declaration_t *declarations = (gdsl_slice_declaration_t *)realloc(
+            slicer->declarations, capacity * sizeof(*declarations));
+        if (!declarations) {
+            return -1;
+        }
+        slicer->declarations = declarations;
+        slicer->declaration_capacity = capacity;
+    }
+    gdsl_slice_declaration_t *declaration = &slicer->declarations[(*count)++];
+    declaration->device = device;
+    declaration->signal = signal;
+    declaration->id = id;
+    declaration->order = order;
+    return 0;
+}
+
+/* Live buffers and pending signals at the cut, sorted. Marks the cut invalid
+ * when a wait is still waiting for its signal. Returns the count, or -1. */
+static long collect_declarations(gdsl_slicer_t *slicer) {
+    size_t count = 0;
+    const gdsl_slice_table_t *buffers = &slicer->buffers;
+    for (size_t i = 0; buffers->entries && i <= buffers->mask; ++i) {
+        const gdsl_slice_object_t *buffer = &buffers->entries[i];
+        if (buffer->used && buffer->live &&
+            add_declaration(slicer, &count, buffer->device, 0, buffer->id, 0) != 0) {
+            return -1;
+        }
+    }
+    const gdsl_slice_table_t *semaphores = &slicer->semaphores;
+    for (size_t i = 0; semaphores->entries && i <= semaphores->mask; ++i) {
+        const gdsl_slice_object_t *semaphore = &semaphores->entries[i];
+        if (!semaphore->used) {
+            continue;
+        }
+        if (semaphore->waits > semaphore->signal_count) {
+            slicer->invalid = 1;
+            continue;
+        }
+        for (size_t j = (size_t)semaphore->waits; j < semaphore->signal_count; ++j) {
+            if (add_declaration(slicer, &count, semaphore->signals[j], 1, semaphore->id,
+                                j) != 0) {
+                return -1;
+            }
+        }
+    }
+    if (count > 1) {
+        qsort(slicer->declarations, count, sizeof(*slicer->declarations),
+              compare_declarations);
+    }
+    return (long)count;
+}
+
+static int device_used(const gdsl_verify_cut_t *state, size_t device) {
+    return (state->device_mask[device >> 5] >> (device & 31)) & 1u;
+}
+
+static int multi_device(const gdsl_verify_cut_t *state) {
+    int multi = state->device_mask[0] != 1u;
+    for (size_t i = 1; i < GDSL_VERIFY_CUT_DEVICES / 32; ++i) {
+        multi |= state->device_mask[i] != 0;
+    }
+    return multi;
+}
+
+/* Bindings and scopes of a device that is recording. */
+static void emit_recording(gdsl_slice_bytes_t *out,
+                           const gdsl_verify_device_state_t *device,
+                           const gdsl_slice_bindings_t *bindings) {
+    for (uint32_t point = 0; point < 2; ++point) {
+        if ((bindings->pipelines >> point) & 1u) {
+            emit(out, GDSL_OPCODE_PIPE_BIND, bindings->pipeline[point]);
+        }
+    }
+    for (uint32_t slot = 0; slot < 8; ++slot) {
+        if ((bindings->sets >> slot) & 1u) {
+            emit(out, GDSL_OPCODE_SET_DESCRIPTOR, bindings->set[slot]);
+        }
+    }
+    for (uint32_t slot = 0; slot < 9; ++slot) {
+        if ((bindings->buffers >> slot) & 1u) {
+            emit(out, GDSL_OPCODE_BIND_BUFFER, bindings->buffer[slot]);
+        }
+    }
+    if (device->pass_depth > 0) {
+        emit(out, GDSL_OPCODE_BEGIN_PASS, 0);
+    }
+    for (uint32_t i = 0; i < device->query_depth; ++i) {
+        uint32_t known = bindings->query_count < GDSL_SLICE_QUERY_IDS
+                             ? bindings->query_count
+                             : GDSL_SLICE_QUERY_IDS;
+        emit(out, GDSL_OPCODE_QUERY_BEGIN, i < known ? bindings->query[i] : 0);
+    }
+}
+
+/*
+ * Replays the shortest clean path to every device's state: BEGIN_STREAM
+ * unless the device never began, the re-declarations while it records, then
+ * SUBMIT/FENCE_WAIT/END_STREAM up to its phase. States that only an error
+ * leads to (a snapshot open outside Idle) are approximated.
+ */
+static void emit_prologue(gdsl_slicer_t *slicer,
+                          const gdsl_verify_cut_t *state,
+                          const gdsl_slice_declaration_t *declarations,
+                          size_t declaration_count,
+                          gdsl_slice_bytes_t *out) {
+    int multi = multi_device(state);
+    size_t next = 0;
+    for (size_t d = 0; d < GDSL_VERIFY_CUT_DEVICES; ++d) {
+        if (!device_used(state, d)) {
+            continue;
+        }
+        const gdsl_verify_device_state_t *device = &state->devices[d];
+        if (multi) {
+            emit(out, GDSL_OPCODE_SET_DEVICE, d);
+        }
+        if (device->phase != GDSL_VERIFY_PHASE_BUILD) {
+            emit(out, GDSL_OPCODE_BEGIN_STREAM, 0);
+        }
+        for (; next < declaration_count && declarations[next].device <= d; ++next) {
+            if (device->phase != GDSL_VERIFY_PHASE_BUILD) {
+                emit(out,
+                     declarations[next].signal ? GDSL_OPCODE_SEMAPHORE_SIGNAL
+                                               : GDSL_OPCODE_ALLOC_BUFFER,
+                     declarations[next].id);
+            }
+        }
+        switch (device->phase) {
+        case GDSL_VERIFY_PHASE_RECORD:
+            if (device->device_domain) {
+                emit(out, GDSL_OPCODE_BARRIER, 0);
+            }
+            emit_recording(out, device, &slicer->bindings[d]);
+            break;
+        case GDSL_VERIFY_PHASE_SUBMITTED:
+            emit(out, GDSL_OPCODE_SUBMIT, 0);
+            break;
+        case GDSL_VERIFY_PHASE_IDLE:
+            emit(out, GDSL_OPCODE_SUBMIT, 0);
+            emit(out, GDSL_OPCODE_FENCE_WAIT, 0);
+            if (device->snapshot_active) {
+                emit(out, GDSL_OPCODE_SNAPSHOT_BEGIN, 0);
+            }
+            break;
+        case GDSL_VERIFY_PHASE_FINISHED:
+            emit(out, GDSL_OPCODE_SUBMIT, 0);
+            emit(out, GDSL_OPCODE_FENCE_WAIT, 0);
+            emit(out, GDSL_OPCODE_END_STREAM, 0);
+            break;
+        default:
+            break;
+        }
+    }
+
+    for (uint32_t r = 0; r < GDSL_FOLD_REGISTERS; ++r) {
+        if ((state->registers.known >> r) & 1u) {
+            emit(out, GDSL_OPCODE_CONST_I32,
+                 r | (uint64_t)(uint32_t)state->registers.values[r] << 8);
+        }
+    }
+    for (size_t d = 0; d < GDSL_VERIFY_CUT_DEVICES; ++d) {
+        if (device_used(state, d) && state->queues[d] != 0) {
+            if (multi) {
+                emit(out, GDSL_OPCODE_SET_DEVICE, d);
+            }
+            emit(out, GDSL_OPCODE_SET_QUEUE, state->queues[d]);
+        }
+    }
+    if (multi) {
+        emit(out, GDSL_OPCODE_SET_DEVICE, state->device);
+    }
+}
+
+/* Closes the scopes of every device and takes it to Finished. */
+static void emit_epilogue(const gdsl_verify_cut_t *state, gdsl_slice_bytes_t *out) {
+    int multi = multi_device(state);
+    for (size_t d = 0; d < GDSL_VERIFY_CUT_DEVICES; ++d) {
+        if (!device_used(state, d)) {
+            continue;
+        }
+        const gdsl_verify_device_state_t *device = &state->devices[d];
+        if (multi) {
+            emit(out, GDSL_OPCODE_SET_DEVICE, d);
+        }
+        if (device->phase == GDSL_VERIFY_PHASE_RECORD) {
+            for (uint32_t i = 0; i < device->query_depth; ++i) {
+                emit(out, GDSL_OPCODE_QUERY_END, 0);
+            }
+            if (device->pass_depth > 0) {
+                emit(out, GDSL_OPCODE_END_PASS, 0);
+            }
+        }
+        if (device->snapshot_active) {
+            emit(out, GDSL_OPCODE_SNAPSHOT_END, 0);
+        }
+        switch (device->phase) {
+        case GDSL_VERIFY_PHASE_BUILD:
+            emit(out, GDSL_OPCODE_BEGIN_STREAM, 0);
+            /* fall through */
+        case GDSL_VERIFY_PHASE_RECORD:
+            emit(out, GDSL_OPCODE_SUBMIT, 0);
+            /* fall through */
+        case GDSL_VERIFY_PHASE_SUBMITTED:
+            emit(out, GDSL_OPCODE_FENCE_WAIT, 0);
+            /* fall through */
+        case GDSL_VERIFY_PHASE_IDLE:
+            emit(out, GDSL_OPCODE_END_STREAM, 0);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+static void observe_cut(void *ctx, size_t cut, const gdsl_verify_cut_t *state) {
+    gdsl_slicer_t *slicer = (gdsl_slicer_t *)ctx;
+    if (slicer->failed || slicer->invalid) {
+        return;
+    }
+    if (state->open_branches > 0) {
+        slicer->invalid = 1;
+        return;
+    }
+    long count = collect_declarations(slicer);
+    if (count < 0) {
+        slicer->failed = 1;
+        return;
+    }
+    if (slicer->invalid) {
+        return;
+    }
+
+    gdsl_slice_bytes_t epilogue;
+    gdsl_slice_bytes_t prologue;
+    memset(&epilogue, 0, sizeof(epilogue));
+    memset(&prologue, 0, sizeof(prologue));
+    emit_epilogue(state, &epilogue);
+    emit_prologue(slicer, state, slicer->declarations, (size_t)count, &prologue);
+    slicer->set->slices[cut].epilogue = epilogue.data;
+    slicer->set->slices[cut].epilogue_length = epilogue.length;
+    slicer->set->slices[cut + 1].prologue = prologue.data;
+    slicer->set->slices[cut + 1].prologue_length = prologue.length;
+    if (epilogue.failed || prologue.failed) {
+        slicer->failed = 1;
+    }
+}
+
+void gdsl_slice_set_destroy(gdsl_slice_set_t *set) {
+    if (!set || !set->slices) {
+        return;
+    }
+    for (size_t i = 0; i < set->count; ++i) {
+        free(set->slices[i].prologue);
+        free(set->slices[i].epilogue);
+    }
+    free(set->slices);
+    set->slices = NULL;
+    set->count = 0;
+}
+
+/* Finds the byte offset and CHECKPOINT ordinal of every cut point, and
+ * counts the instructions and SNAPSHOT_BEGINs of the stream. */
+static int locate_cuts(const uint8_t *stream,
+                       size_t length,
+                       const uint64_t *cut_points,
+                       size_t cut_count,
+                       uint64_t *cut_offsets,
+                       gdsl_slice_t *slices,
+                       uint64_t *instruction_count,
+                       size_t *snapshot_count) {
+    size_t next = 0;
+    uint64_t index = 0;
+    uint64_t checkpoints = 0;
+    size_t snapshots = 0;
+    size_t pos = 0;
+    while (pos < length) {
+        uint8_t opcode = stream[pos];
+        const gdsl_opcode_metadata_t *meta = &gdsl_opcode_table[opcode];
+        size_t size = meta->name ? meta->size : 1;
+        if (size == 0 || size > length - pos) {
+            break;
+        }
+        if (next < cut_count && cut_points[next] == index) {
+            if (opcode != GDSL_OPCODE_CHECKPOINT) {
+                return -1;
+            }
+            cut_offsets[next] = pos;
+            slices[next + 1].checkpoint = checkpoints;
+            next++;
+        }
+        checkpoints += opcode == GDSL_OPCODE_CHECKPOINT;
+        snapshots += opcode == GDSL_OPCODE_SNAPSHOT_BEGIN;
+        pos += size;
+        index++;
+    }
+    *instruction_count = index;
+    *snapshot_count = snapshots;
+    return next == cut_count ? 0 : -1;
+}
+
+int gdsl_slice(const uint8_t *stream,
+               size_t length,
+               const uint64_t *cut_points,
+               size_t cut_count,
+               const gdsl_slice_options_t *options,
+               gdsl_slice_set_t *out) {
+    if (!out || (!stream && length > 0) || (!cut_points && cut_count > 0)) {
+        return -1;
+    }
+    out->slices = NULL;
+    out->count = 0;
+    for (size_t i = 1; i < cut_count; ++i) {
+        if (cut_points[i] <= cut_points[i - 1]) {
+            return -1;
+        }
+    }
+
+    gdsl_slice_set_t set;
+    set.count = cut_count + 1;
+    set.slices = (gdsl_slice_t *)calloc(set.count, sizeof(gdsl_slice_t));
+    uint64_t *cut_offsets = (uint64_t *)malloc((cut_count ? cut_count : 1) * sizeof(uint64_t));
+    gdsl_slicer_t *slicer = (gdsl_slicer_t *)calloc(1, sizeof(*slicer));
+    gdsl_verify_report_t *report = (gdsl_verify_report_t *)malloc(sizeof(*report));
+    gdsl_verify_snapshot_t *snapshots = NULL;
+    int rc = -1;
+    if (!set.slices || !cut_offsets || !slicer || !report) {
+        goto out;
+    }
+    for (size_t i = 0; i < set.count; ++i) {
+        set.slices[i].checkpoint = GDSL_SLICE_NONE;
+        set.slices[i].snapshot = GDSL_SLICE_NONE;
+    }
+
+    uint64_t instruction_count;
+    size_t snapshot_count;
+    if (locate_cuts(stream, length, cut_points, cut_count, cut_offsets, set.slices,
+                    &instruction_count, &snapshot_count) != 0) {
+        goto out;
+    }
+    for (size_t i = 0; i < set.count; ++i) {
+        gdsl_slice_t *slice = &set.slices[i];
+        slice->begin_offset = i > 0 ? cut_offsets[i - 1] : 0;
+        slice->end_offset = i < cut_count ? cut_offsets[i] : length;
+        slice->begin_index = i > 0 ? cut_points[i - 1] : 0;
+        slice->end_index = i < cut_count ? cut_points[i] : instruction_count;
+    }
+
+    if (snapshot_count > 0) {
+        snapshots = (gdsl_verify_snapshot_t *)malloc(snapshot_count * sizeof(*snapshots));
+        if (!snapshots) {
+            goto out;
+        }
+    }
+    gdsl_verify_options_t verify_options;
+    memset(&verify_options, 0, sizeof(verify_options));
+    verify_options.snapshots = snapshots;
+    verify_options.snapshot_capacity = snapshot_count;
+
+    slicer->set = &set;
+    gdsl_verify_observer_t observer;
+    observer.ctx = slicer;
+    observer.instruction = observe_instruction;
+    observer.cut = observe_cut;
+    if (gdsl_verify_cuts(stream, length, GDSL_VERIFY_LEVEL_DOMAIN, &verify_options,
+                         cut_offsets, cut_count, &observer, report) != 0 ||
+        slicer->failed || slicer->invalid) {
+        goto out;
+    }
+
+    /* Keyframe of each slice. Regions do not nest, so they end in order. */
+    size_t count = report->snapshot_count < snapshot_count ? (size_t)report->snapshot_count
+                                                           : snapshot_count;
+    size_t region = 0;
+    uint64_t keyframe = GDSL_SLICE_NONE;
+    for (size_t i = 1; i < set.count; ++i) {
+        gdsl_slice_t *slice = &set.slices[i];
+        for (; region < count && snapshots[region].end_index < slice->begin_index; ++region) {
+            if (snapshots[region].flags & GDSL_VERIFY_SNAPSHOT_SAFE) {
+                keyframe = region;
+            }
+        }
+        slice->snapshot = keyframe;
+        if (keyframe != GDSL_SLICE_NONE && options && options->snapshot_diffs &&
+            keyframe < options->snapshot_diff_count) {
+            slice->diff = options->snapshot_diffs[keyframe];
+        }
+    }
+    rc = 0;
+
+out:
+    if (slicer) {
+        table_release(&slicer->buffers);
+        table_release(&slicer->semaphores);
+        free(slicer->declarations);
+    }
+    free(snapshots);
+    free(report);
+    free(slicer);
+    free(cut_offsets);
+    if (rc == 0) {
+        *out = set;
+    } else {
+        gdsl_slice_set_destroy(&set);
+    }
+    return rc;
+}
+
+int gdsl_slice_materialise(const uint8_t *stream,
+                           size_t length,
+                           const gdsl_slice_t *slice,
+                           uint8_t **out_stream,
+                           size_t *out_length) {
+    if (!slice || !out_stream || !out_length || (!stream && length > 0) ||
+        slice->begin_offset > slice->end_offset || slice->end_offset > length) {
+        return -1;
+    }
+    size_t body = (size_t)(slice->end_offset - slice->begin_offset);
+    size_t total = slice->prologue_length + body + slice->epilogue_length;
+    uint8_t *bytes = (uint8_t *)malloc(total ? total : 1);
+    if (!bytes) {
+        return -1;
+    }
+    size_t pos = 0;
+    if (slice->prologue_length > 0) {
+        memcpy(bytes, slice->prologue, slice->prologue_length);
+        pos += slice->prologue_length;
+    }
+    if (body > 0) {
+        memcpy(bytes + pos, stream + slice->begin_offset, body);
+        pos += body;
+    }
+    if (slice->epilogue_length > 0) {
+        memcpy(bytes + pos, slice->epilogue, slice->epilogue_length);
+    }
+    *out_stream = bytes;
+    *out_length = total;
+    return 0;
+}
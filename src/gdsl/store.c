@@ -0,0 +1,511 @@
+#define _GNU_SOURCE
+
+#include "gdsl/store.h"
+
+#include "hash.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define GDSL_STORE_MAGIC 0x57534447u /* "GDSW" */
+#define GDSL_STORE_VERSION 1u
+#define GDSL_STORE_SCAN_CHUNK ((size_t)64 << 10)
+
+/* On-disk record: this header, chunk_count chunk entries, then the payload.
+ * The checksum covers all three with the checksum fields zeroed. */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t checkpoint;
+    uint64_t target_length;
+    uint64_t payload_length;
+    uint64_t chunk_count;
+    uint32_t page_size;
+    uint32_t flags;
+    uint32_t diff_version;
+    uint32_t reserved;
+    uint64_t checksum_lo;
+    uint64_t checksum_hi;
+} gdsl_store_record_t;
+
+typedef struct {
+    uint64_t page_index;
+    uint64_t length;
+    uint64_t data_offset;
+    uint64_t reference;
+} gdsl_store_chunk_t;
+
+struct gdsl_store {
+    int fd;
+    gdsl_store_options_t options;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    /* Records appended since the last batch was taken, starting at file
+     * offset pending_offset. A commit leader swaps this with the batch
+     * buffer and writes the batch without holding the lock. */
+    uint8_t *pending;
+    size_t pending_length;
+    size_t pending_capacity;
+    uint64_t pending_offset;
+    uint8_t *batch;
+    size_t batch_capacity;
+    int flushing;
+    int failed;
+    uint64_t durable_end;
+    size_t durable_count;
+    uint64_t commit_count;
+    /* Start offsets of every appended record. */
+    uint64_t *offsets;
+    size_t count;
+    size_t offsets_capacity;
+};
+
+static void record_head(const gdsl_diff_result_t *diff,
+                        uint64_t checkpoint,
+                        gdsl_store_record_t *head) {
+    memset(head, 0, sizeof(*head));
+    head->magic = GDSL_STORE_MAGIC;
+    head->version = GDSL_STORE_VERSION;
+    head->checkpoint = checkpoint;
+    head->target_length = diff->header.target_length;
+    head->payload_length = diff->payload_length;
+    head->chunk_count = diff->chunk_count;
+    head->page_size = diff->header.page_size;
+    head->flags = diff->header.flags;
+    head->diff_version = diff->header.version;
+}
+
+static void encode_chunk(const gdsl_diff_chunk_t *chunk, gdsl_store_chunk_t *out) {
+    out->page_index = chunk->page_index;
+    out->length = chunk->length;
+    out->data_offset = chunk->data_offset;
+    out->reference = chunk->reference;
+}
+
+static void hash_head(gdsl_hash128_stream_t *stream, const gdsl_store_record_t *head) {
+    gdsl_store_record_t zeroed = *head;
+    zeroed.checksum_lo = 0;
+    zeroed.checksum_hi = 0;
+    gdsl_hash128_stream_init(stream);
+    gdsl_hash128_stream_update(stream, (const uint8_t *)&zeroed, sizeof(zeroed));
+}
+
+static int body_length(const gdsl_store_record_t *head, uint64_t *out) {
+    if (head->chunk_count > UINT64_MAX / sizeof(gdsl_store_chunk_t)) {
+        return -1;
+    }
+    uint64_t chunks = head->chunk_count * sizeof(gdsl_store_chunk_t);
+    if (head->payload_length > UINT64_MAX - chunks) {
+        return -1;
+    }
+    *out = chunks + head->payload_length;
+    return 0;
+}
+
+static int read_all(int fd, void *buffer, size_t length, uint64_t offset) {
+    uint8_t *bytes = (uint8_t *)buffer;
+    while (length > 0) {
+        ssize_t n = pread(fd, bytes, length, (off_t)offset);
+        if (n <= 0) {
+            return -1;
+        }
+        bytes += n;
+        length -= (size_t)n;
+        offset += (uint64_t)n;
+    }
+    return 0;
+}
+
+static int write_all(int fd, const uint8_t *bytes, size_t length, uint64_t offset) {
+    while (length > 0) {
+        ssize_t n = pwrite(fd, bytes, length, (off_t)offset);
+        if (n <= 0) {
+            return -1;
+        }
+        bytes += n;
+        length -= (size_t)n;
+        offset += (uint64_t)n;
+    }
+    return 0;
+}
+
+static int push_offset(gdsl_store_t *store, uint64_t offset) {
+    if (store->count == store->offsets_capacity) {
+        size_t capacity = store->offsets_capacity ? store->offsets_capacity * 2 : 64;
+        uint64_t *offsets = (uint64_t *)realloc(store->offsets, capacity * sizeof(uint64_t));
+        if (!offsets) {
+            return -1;
+        }
+        store->offsets = offsets;
+        store->offsets_capacity = capacity;
+    }
+    store->offsets[store->count++] = offset;
+    return 0;
+}
+
+/* Validates the record at offset against the file end and its checksum.
+ * Returns its total length, or 0 when it is torn or corrupt. */
+static uint64_t scan_record(int fd, uint64_t offset, uint64_t file_size, uint8_t *scratch) {
+    gdsl_store_record_t head;
+    uint64_t body = 0;
+    if (file_size - offset < sizeof(head) || read_all(fd, &head, sizeof(head), offset) != 0 ||
+        head.magic != GDSL_STORE_MAGIC || head.version != GDSL_STORE_VERSION ||
+        body_length(&head, &body) != 0 || body > file_size - offset - sizeof(head)) {
+        return 0;
+    }
+    gdsl_hash128_stream_t stream;
+    hash_head(&stream, &head);
+    uint64_t position = offset + sizeof(head);
+    uint64_t remaining = body;
+    while (remaining > 0) {
+        size_t piece = remaining < GDSL_STORE_SCAN_CHUNK ? (size_t)remaining
+                                                         : GDSL_STORE_SCAN_CHUNK;
+        if (read_all(fd, scratch, piece, position) != 0) {
+            return 0;
+        }
+        gdsl_hash128_stream_update(&stream, scratch, piece);
+        position += piece;
+        remaining -= piece;
+    }
+    gdsl_hash128_t sum = gdsl_hash128_stream_final(&stream);
+    if (sum.lo != head.checksum_lo || sum.hi != head.checksum_hi) {
+        return 0;
+    }
+    return sizeof(head) + body;
+}
+
+static int recover(gdsl_store_t *store, gdsl_store_recovery_t *out_recovery) {
+    struct stat st;
+    if (fstat(store->fd, &st) != 0) {
+        return -1;
+    }
+    uint64_t file_size = (uint64_t)st.st_size;
+    uint8_t *scratch = (uint8_t *)malloc(GDSL_STORE_SCAN_CHUNK);
+    if (!scratch) {
+        return -1;
+    }
+    uint64_t offset = 0;
+    int rc = 0;
+    for (;;) {
+        uint64_t length = scan_record(store->fd, offset, file_size, scratch);
+        if (length == 0) {
+            break;
+        }
+        if (push_offset(store, offset) != 0) {
+            rc = -1;
+            break;
+        }
+        offset += length;
+    }
+    free(scratch);
+    if (rc != 0) {
+        return -1;
+    }
+
+    /* Drop the torn tail so new records follow the last valid one. */
+    if (offset < file_size &&
+        (ftruncate(store->fd, (off_t)offset) != 0 || fdatasync(store->fd) != 0)) {
+        return -1;
+    }
+    store->durable_end = offset;
+    store->durable_count = store->count;
+    store->pending_offset = offset;
+    if (out_recovery) {
+        out_recovery->record_count = store->count;
+        out_recovery->valid_bytes = offset;
+        out_recovery->truncated_bytes = file_size - offset;
+    }
+    return 0;
+}
+
+/* Makes the log's directory entry durable, for a newly created file. */
+static int sync_parent(const char *path) {
+    const char *slash = strrchr(path, '/');
+    char *dir = NULL;
+    if (!slash) {
+        dir = strdup(".");
+    } else if (slash == path) {
+        dir = strdup("/");
+    } else {
+        dir = strndup(path, (size_t)(slash - path));
+    }
+    if (!dir) {
+        return -1;
+    }
+    int fd = open(dir, O_RDONLY | O_DIRECTORY);
+    free(dir);
+    if (fd < 0) {
+        return -1;
+    }
+    int rc = fsync(fd);
+    close(fd);
+    return rc;
+}
+
+int gdsl_store_open(const char *path,
+                    const gdsl_store_options_t *options,
+                    gdsl_store_t **out_store,
+                    gdsl_store_recovery_t *out_recovery) {
+    if (!path || !out_store) {
+        return -1;
+    }
+    *out_store = NULL;
+    if (out_recovery) {
+        memset(out_recovery, 0, sizeof(*out_recovery));
+    }
+
+    gdsl_store_t *store = (gdsl_store_t *)calloc(1, sizeof(*store));
+    if (!store) {
+        return -1;
+    }
+    if (options) {
+        store->options = *options;
+    }
+    int created = access(path, F_OK) != 0;
+    store->fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (store->fd < 0) {
+        free(store);
+        return -1;
+    }
+    if ((created && sync_parent(path) != 0) || recover(store, out_recovery) != 0) {
+        close(store->fd);
+        free(store->offsets);
+        free(store);
+        return -1;
+    }
+    pthread_mutex_init(&store->lock, NULL);
+    pthread_cond_init(&store->cond, NULL);
+    *out_store = store;
+    return 0;
+}
+
+/* Called with the lock held. Either waits for the commit in flight or leads
+ * the next one, until byte end of the log is durable. */
+static int commit_until(gdsl_store_t *store, uint64_t end) {
+    while (!store->failed && store->durable_end < end) {
+        if (store->flushing) {
+            pthread_cond_wait(&store->cond, &store->lock);
+            continue;
+        }
+        store->flushing = 1;
+        if (store->options.group_delay_us > 0) {
+            struct timespec delay;
+            delay.tv_sec = store->options.group_delay_us / 1000000u;
+            delay.tv_nsec = (long)(store->options.group_delay_us % 1000000u) * 1000L;
+            pthread_mutex_unlock(&store->lock);
+            nanosleep(&delay, NULL);
+            pthread_mutex_lock(&store->lock);
+        }
+
+        /* Take every record appended so far; later writers fill the other
+         * buffer and join the next batch. */
+        uint8_t *batch = store->pending;
+        size_t batch_length = store->pending_length;
+        size_t batch_capacity = store->pending_capacity;
+        uint64_t batch_offset = store->pending_offset;
+        size_t batch_records = store->count;
+        store->pending = store->batch;
+        store->pending_capacity = store->batch_capacity;
+        store->pending_length = 0;
+        store->pending_offset = batch_offset + batch_length;
+        store->batch = batch;
+        store->batch_capacity = batch_capacity;
+        pthread_mutex_unlock(&store->lock);
+
+        int rc = write_all(store->fd, batch, batch_length, batch_offset);
+        if (rc == 0) {
+            rc = fdatasync(store->fd);
+        }
+
+        pthread_mutex_lock(&store->lock);
+        if (rc != 0) {
+            store->failed = 1;
+        } else {
+            store->durable_end = batch_offset + batch_length;
+            store->durable_count = batch_records;
+            store->commit_count++;
+        }
+        store->flushing = 0;
+        pthread_cond_broadcast(&store->cond);
+    }
+    return store->durable_end >= end ? 0 : -1;
+}
+
+int gdsl_store_append(gdsl_store_t *store,
+                      uint64_t checkpoint,
+                      const gdsl_diff_result_t *diff,
+                      size_t *out_index) {
+    if (!store || !diff || (diff->chunk_count > 0 && !diff->chunks) ||
+        (diff->payload_length > 0 && !diff->payload)) {
+        return -1;
+    }
+
+    /* Checksum outside the lock; only the copy into the log is serialised. */
+    gdsl_store_record_t head;
+    record_head(diff, checkpoint, &head);
+    uint64_t body = 0;
+    if (body_length(&head, &body) != 0 || body > SIZE_MAX - sizeof(head)) {
+        return -1;
+    }
+    size_t record_length = sizeof(head) + (size_t)body;
+    gdsl_hash128_stream_t stream;
+    hash_head(&stream, &head);
+    for (size_t i = 0; i < diff->chunk_count; ++i) {
+        gdsl_store_chunk_t chunk;
+        encode_chunk(&diff->chunks[i], &chunk);
+        gdsl_hash128_stream_update(&stream, (const uint8_t *)&chunk, sizeof(chunk));
+    }
+    gdsl_hash128_stream_update(&stream, diff->payload, diff->payload_length);
+    gdsl_hash128_t sum = gdsl_hash128_stream_final(&stream);
+    head.checksum_lo = sum.lo;
+    head.checksum_hi = sum.hi;
+
+    pthread_mutex_lock(&store->lock);
+    if (store->failed || record_length > SIZE_MAX - store->pending_length) {
+        pthread_mutex_unlock(&store->lock);
+        return -1;
+    }
+    size_t needed = store->pending_length + record_length;
+    if (needed > store->pending_capacity) {
+        size_t capacity = store->pending_capacity ? store->pending_capacity : 64u << 10;
+        while (capacity < needed) {
+            capacity = capacity > SIZE_MAX / 2 ? needed : capacity * 2;
+        }
+        uint8_t *pending = (uint8_t *)realloc(store->pending, capacity);
+        if (!pending) {
+            pthread_mutex_unlock(&store->lock);
+            return -1;
+        }
+        store->pending = pending;
+        store->pending_capacity = capacity;
+    }
+    uint64_t offset = store->pending_offset + store->pending_length;
+    if (push_offset(store, offset) != 0) {
+        pthread_mutex_unlock(&store->lock);
+        return -1;
+    }
+    size_t index = store->count - 1;
+    uint8_t *cursor = store->pending + store->pending_length;
+    memcpy(cursor, &head, sizeof(head));
+    cursor += sizeof(head);
+    for (size_t i = 0; i < diff->chunk_count; ++i) {
+        gdsl_store_chunk_t chunk;
+        encode_chunk(&diff->chunks[i], &chunk);
+        memcpy(cursor, &chunk, sizeof(chunk));
+        cursor += sizeof(chunk);
+    }
+    if (diff->payload_length > 0) {
+        memcpy(cursor, diff->payload, diff->payload_length);
+    }
+    store->pending_length = needed;
+
+    int rc = commit_until(store, offset + record_length);
+    pthread_mutex_unlock(&store->lock);
+    if (rc == 0 && out_index) {
+        *out_index = index;
+    }
+    return rc;
+}
+
+int gdsl_store_read(gdsl_store_t *store,
+                    size_t index,
+                    uint64_t *out_checkpoint,
+                    gdsl_diff_result_t *out) {
+    if (!store || !out) {
+        return -1;
+    }
+    memset(out, 0, sizeof(*out));
+
+    pthread_mutex_lock(&store->lock);
+    int durable = index < store->durable_count;
+    uint64_t offset = durable ? store->offsets[index] : 0;
+    pthread_mutex_unlock(&store->lock);
+
+    gdsl_store_record_t head;
+    uint64_t body = 0;
+    if (!durable || read_all(store->fd, &head, sizeof(head), offset) != 0 ||
+        head.magic != GDSL_STORE_MAGIC || body_length(&head, &body) != 0 ||
+        body > SIZE_MAX) {
+        return -1;
+    }
+    size_t chunk_bytes = (size_t)head.chunk_count * sizeof(gdsl_store_chunk_t);
+    gdsl_store_chunk_t *chunks = (gdsl_store_chunk_t *)malloc(chunk_bytes ? chunk_bytes : 1);
+    out->chunks = (gdsl_diff_chunk_t *)malloc(
+        (head.chunk_count ? (size_t)head.chunk_count : 1) * sizeof(gdsl_diff_chunk_t));
+    out->payload = (uint8_t *)malloc(head.payload_length ? (size_t)head.payload_length : 1);
+    out->payload_storage = GDSL_DIFF_STORAGE_HEAP;
+    int rc = -1;
+    if (!chunks || !out->chunks || !out->payload ||
+        read_all(store->fd, chunks, chunk_bytes, offset + sizeof(head)) != 0 ||
+        read_all(store->fd, out->payload, (size_t)head.payload_length,
+                 offset + sizeof(head) + chunk_bytes) != 0) {
+        goto cleanup;
+    }
+
+    gdsl_hash128_stream_t stream;
+    hash_head(&stream, &head);
+    gdsl_hash128_stream_update(&stream, (const uint8_t *)chunks, chunk_bytes);
+    gdsl_hash128_stream_update(&stream, out->payload, (size_t)head.payload_length);
+    gdsl_hash128_t sum = gdsl_hash128_stream_final(&stream);
+    if (sum.lo != head.checksum_lo || sum.hi != head.checksum_hi) {
+        goto cleanup;
+    }
+
+    for (size_t i = 0; i < head.chunk_count; ++i) {
+        out->chunks[i].page_index = (size_t)chunks[i].page_index;
+        out->chunks[i].length = (size_t)chunks[i].length;
+        out->chunks[i].data_offset = (size_t)chunks[i].data_offset;
+        out->chunks[i].reference = (size_t)chunks[i].reference;
+    }
+    out->header.version = head.diff_version;
+    out->header.page_size = head.page_size;
+    out->header.flags = head.flags;
+    out->header.chunk_count = (uint32_t)head.chunk_count;
+    out->header.target_length = head.target_length;
+    out->chunk_count = (size_t)head.chunk_count;
+    out->payload_length = (size_t)head.payload_length;
+    if (out_checkpoint) {
+        *out_checkpoint = head.checkpoint;
+    }
+    rc = 0;
+
+cleanup:
+    free(chunks);
+    if (rc != 0) {
+        gdsl_diff_result_destroy(out);
+    }
+    return rc;
+}
+
+void gdsl_store_stats(gdsl_store_t *store, gdsl_store_stats_t *out) {
+    if (!out) {
+        return;
+    }
+    memset(out, 0, sizeof(*out));
+    if (!store) {
+        return;
+    }
+    pthread_mutex_lock(&store->lock);
+    out->record_count = store->durable_count;
+    out->commit_count = store->commit_count;
+    out->durable_bytes = store->durable_end;
+    pthread_mutex_unlock(&store->lock);
+}
+
+void gdsl_store_close(gdsl_store_t *store) {
+    if (!store) {
+        return;
+    }
+    close(store->fd);
+    pthread_cond_destroy(&store->cond);
+    pthread_mutex_destroy(&store->lock);
+    free(store->pending);
+    free(store->batch);
+    free(store->offsets);
+    free(store);
+}
@@ -1,11 +1,33 @@
+#define _GNU_SOURCE
+#define _FILE_OFFSET_BITS 64
+
 #include "gdsl/verify.h"
 
+#include "encode_reader.h"
+#include "fold_eval.h"
+#include "opcodes.h"
+#include "race.h"
+#include "verify_cuts.h"
+#include "verify_rules.h"
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <pthread.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #define ARRAY_SIZE(x) (sizeof(x) / sizeof((x)[0]))
 
+/* Values match gdsl_verify_phase_t. */
 typedef enum {
     GDSL_PHASE_BUILD = 0,
     GDSL_PHASE_RECORD,
@@ -19,43 +41,15 @@ typedef enum {
     GDSL_DOMAIN_DEVICE = 1
 } gdsl_domain_t;
 
-typedef enum {
-    GDSL_OPCODE_NOP = 0x00,
-    GDSL_OPCODE_BEGIN_STREAM = 0x01,
-    GDSL_OPCODE_BARRIER = 0x02,
-    GDSL_OPCODE_SUBMIT = 0x03,
-    GDSL_OPCODE_FENCE_WAIT = 0x04,
-    GDSL_OPCODE_END_STREAM = 0x05,
-    GDSL_OPCODE_END_PROGRAM = 0x06,
-    GDSL_OPCODE_SNAPSHOT_BEGIN = 0x07,
-    GDSL_OPCODE_SNAPSHOT_END = 0x08,
-    GDSL_OPCODE_CHECKPOINT = 0x09
-} gdsl_opcode_t;
-
-typedef struct {
-    const char *name;
-    uint8_t size;
-} gdsl_opcode_metadata_t;
-
-static const gdsl_opcode_metadata_t gdsl_opcode_table[256] = {
-    [GDSL_OPCODE_NOP] = {"NOP", 1},
-    [GDSL_OPCODE_BEGIN_STREAM] = {"BEGIN_STREAM", 1},
-    [GDSL_OPCODE_BARRIER] = {"BARRIER", 1},
-    [GDSL_OPCODE_SUBMIT] = {"SUBMIT", 1},
-    [GDSL_OPCODE_FENCE_WAIT] = {"FENCE_WAIT", 1},
-    [GDSL_OPCODE_END_STREAM] = {"END_STREAM", 1},
-    [GDSL_OPCODE_END_PROGRAM] = {"END_PROGRAM", 1},
-    [GDSL_OPCODE_SNAPSHOT_BEGIN] = {"SNAPSHOT_BEGIN", 1},
-    [GDSL_OPCODE_SNAPSHOT_END] = {"SNAPSHOT_END", 1},
-    [GDSL_OPCODE_CHECKPOINT] = {"CHECKPOINT", 1},
-};
-
 typedef struct {
     gdsl_phase_t phase;
     gdsl_domain_t domain;
     int snapshot_active;
 } gdsl_state_t;
 
+/* SET_DEVICE takes a u8 device id. */
+#define GDSL_MAX_DEVICES 256
+
 static void gdsl_state_reset(gdsl_state_t *state) {
     state->phase = GDSL_PHASE_BUILD;
     state->domain = GDSL_DOMAIN_HOST;
@@ -63,24 +57,51 @@ static void gdsl_state_reset(gdsl_state_t *state) {
 }
 
 static void add_diagnostic(gdsl_verify_report_t *report,
-                           size_t instruction_index,
+                           uint64_t instruction_index,
+                           uint64_t byte_offset,
                            gdsl_verify_severity_t severity,
                            const char *fmt,
                            ...) {
-    if (!report || report->diagnostic_count >= GDSL_VERIFY_MAX_DIAGNOSTICS) {
+    if (!report) {
         return;
     }
 
-    gdsl_verify_diagnostic_t *diag =
-        &report->diagnostics[report->diagnostic_count++];
-    diag->instruction_index = instruction_index;
-    diag->severity = severity;
-
+    char message[GDSL_VERIFY_MAX_MESSAGE];
     va_list args;
     va_start(args, fmt);
-    vsnprintf(diag->message, GDSL_VERIFY_MAX_MESSAGE, fmt, args);
+    vsnprintf(message, sizeof(message), fmt, args);
     va_end(args);
 
+    gdsl_verify_diagnostic_t *diag = NULL;
+    if (report->flags & GDSL_VERIFY_REPORT_AGGREGATED) {
+        for (size_t i = 0; i < report->diagnostic_count; ++i) {
+            gdsl_verify_diagnostic_t *existing = &report->diagnostics[i];
+            if (existing->severity == severity &&
+                strcmp(existing->message, message) == 0) {
+                diag = existing;
+                break;
+            }
+        }
+    }
+
+    /* Counts cover every diagnostic, including those that no longer fit, so
+     * success never depends on the buffer size. */
+    if (diag) {
+        diag->occurrence_count++;
+        diag->last_instruction_index = instruction_index;
+    } else if (report->diagnostic_count < GDSL_VERIFY_MAX_DIAGNOSTICS) {
+        diag = &report->diagnostics[report->diagnostic_count++];
+        diag->instruction_index = instruction_index;
+        diag->byte_offset = byte_offset;
+        diag->severity = severity;
+        memcpy(diag->message, message, strlen(message) + 1);
+        diag->occurrence_count = 1;
+        diag->last_instruction_index = instruction_index;
+    } else {
+        report->dropped_diagnostic_count++;
+        report->flags |= GDSL_VERIFY_REPORT_DIAGNOSTICS_TRUNCATED;
+    }
+
     if (severity == GDSL_VERIFY_SEVERITY_ERROR) {
         report->error_count++;
     } else if (severity == GDSL_VERIFY_SEVERITY_WARNING) {
@@ -91,188 +112,2128 @@ static void add_diagnostic(gdsl_verify_report_t *report,
 }
 
 static void report_transition_error(gdsl_verify_report_t *report,
-                                    size_t index,
+                                    uint64_t index,
+                                    uint64_t byte_offset,
                                     const char *op,
                                     const char *expected) {
-    add_diagnostic(report, index, GDSL_VERIFY_SEVERITY_ERROR,
+    add_diagnostic(report, index, byte_offset, GDSL_VERIFY_SEVERITY_ERROR,
                    "%s not allowed in %s phase", op, expected);
 }
 
-int gdsl_verify(const uint8_t *stream,
-                size_t length,
-                gdsl_verify_level_t level,
-                gdsl_verify_report_t *report) {
-    if (!report) {
-        return -1;
+/* Applies one well-formed instruction to state (rules of section 3). */
+static void verify_step(gdsl_state_t *state,
+                        gdsl_verify_level_t level,
+                        uint8_t opcode,
+                        const gdsl_opcode_metadata_t *meta,
+                        uint64_t instruction_index,
+                        uint64_t offset,
+                        gdsl_verify_report_t *report) {
+    switch (opcode) {
+    case GDSL_OPCODE_BEGIN_STREAM:
+        if (level >= GDSL_VERIFY_LEVEL_PHASE) {
+            if (state->snapshot_active) {
+                add_diagnostic(report, instruction_index, offset,
+                               GDSL_VERIFY_SEVERITY_ERROR,
+                               "cannot BEGIN_STREAM while snapshot is active");
+            }
+            if (state->phase != GDSL_PHASE_BUILD &&
+                state->phase != GDSL_PHASE_IDLE) {
+                report_transition_error(report, instruction_index, offset,
+                                        meta->name,
+                                        state->phase == GDSL_PHASE_RECORD
+                                            ? "Record"
+                                            : "Idle");
+            }
+        }
+        state->phase = GDSL_PHASE_RECORD;
+        break;
+    case GDSL_OPCODE_BARRIER:
+        if (level >= GDSL_VERIFY_LEVEL_PHASE &&
+            state->phase != GDSL_PHASE_RECORD) {
+            report_transition_error(report, instruction_index, offset,
+                                    meta->name, "Record");
+        }
+        if (level >= GDSL_VERIFY_LEVEL_DOMAIN &&
+            state->domain != GDSL_DOMAIN_DEVICE) {
+            add_diagnostic(report, instruction_index, offset,
+                           GDSL_VERIFY_SEVERITY_WARNING,
+                           "BARRIER issued outside device domain; assuming implicit promotion");
+            state->domain = GDSL_DOMAIN_DEVICE;
+        }
+        break;
+    case GDSL_OPCODE_SUBMIT:
+        if (level >= GDSL_VERIFY_LEVEL_PHASE) {
+            if (state->phase != GDSL_PHASE_RECORD) {
+                report_transition_error(report, instruction_index, offset,
+                                        meta->name, "Record");
+            }
+            if (state->snapshot_active) {
+                add_diagnostic(report, instruction_index, offset,
+                               GDSL_VERIFY_SEVERITY_ERROR,
+                               "cannot SUBMIT inside a snapshot");
+            }
+        }
+        state->phase = GDSL_PHASE_SUBMITTED;
+        state->domain = GDSL_DOMAIN_DEVICE;
+        break;
+    case GDSL_OPCODE_FENCE_WAIT:
+        if (level >= GDSL_VERIFY_LEVEL_PHASE &&
+            state->phase != GDSL_PHASE_SUBMITTED) {
+            report_transition_error(report, instruction_index, offset,
+                                    meta->name, "Submitted");
+        }
+        state->phase = GDSL_PHASE_IDLE;
+        state->domain = GDSL_DOMAIN_HOST;
+        break;
+    case GDSL_OPCODE_END_STREAM:
+        if (level >= GDSL_VERIFY_LEVEL_PHASE &&
+            state->phase != GDSL_PHASE_IDLE &&
+            state->phase != GDSL_PHASE_RECORD) {
+            report_transition_error(report, instruction_index, offset,
+                                    meta->name, "Idle");
+        }
+        if (state->phase == GDSL_PHASE_RECORD && level >= GDSL_VERIFY_LEVEL_PHASE) {
+            add_diagnostic(report, instruction_index, offset,
+                           GDSL_VERIFY_SEVERITY_WARNING,
+                           "END_STREAM while GPU work still pending; assuming idle transition");
+        }
+        state->phase = GDSL_PHASE_FINISHED;
+        break;
+    case GDSL_OPCODE_END_PROGRAM:
+        if (level >= GDSL_VERIFY_LEVEL_PHASE &&
+            state->phase != GDSL_PHASE_FINISHED) {
+            report_transition_error(report, instruction_index, offset,
+                                    meta->name, "Finished");
+        }
+        break;
+    case GDSL_OPCODE_SNAPSHOT_BEGIN:
+        if (level >= GDSL_VERIFY_LEVEL_DOMAIN) {
+            if (state->snapshot_active) {
+                add_diagnostic(report, instruction_index, offset,
+                               GDSL_VERIFY_SEVERITY_ERROR,
+                               "nested SNAPSHOT_BEGIN not allowed");
+            }
+            if (state->phase != GDSL_PHASE_IDLE) {
+                report_transition_error(report, instruction_index, offset,
+                                        meta->name, "Idle");
+            }
+            if (state->domain != GDSL_DOMAIN_HOST) {
+                add_diagnostic(report, instruction_index, offset,
+                               GDSL_VERIFY_SEVERITY_ERROR,
+                               "snapshots require host domain but current domain is device");
+            }
+        }
+        state->snapshot_active = 1;
+        break;
+    case GDSL_OPCODE_SNAPSHOT_END:
+        if (level >= GDSL_VERIFY_LEVEL_DOMAIN && !state->snapshot_active) {
+            add_diagnostic(report, instruction_index, offset,
+                           GDSL_VERIFY_SEVERITY_ERROR,
+                           "SNAPSHOT_END without SNAPSHOT_BEGIN");
+        }
+        state->snapshot_active = 0;
+        break;
+    case GDSL_OPCODE_CHECKPOINT:
+        if (level >= GDSL_VERIFY_LEVEL_DOMAIN &&
+            state->phase != GDSL_PHASE_IDLE) {
+            report_transition_error(report, instruction_index, offset,
+                                    meta->name, "Idle");
+        }
+        break;
+    case GDSL_OPCODE_SEMAPHORE_SIGNAL:
+    case GDSL_OPCODE_SEMAPHORE_WAIT:
+        /* Recorded into the selected device's next submission. */
+        if (level >= GDSL_VERIFY_LEVEL_PHASE &&
+            state->phase != GDSL_PHASE_RECORD) {
+            report_transition_error(report, instruction_index, offset,
+                                    meta->name, "Record");
+        }
+        break;
+    case GDSL_OPCODE_ALLOC_BUFFER:
+    case GDSL_OPCODE_FREE_BUFFER:
+        if (level >= GDSL_VERIFY_LEVEL_PHASE &&
+            state->phase != GDSL_PHASE_IDLE &&
+            state->phase != GDSL_PHASE_RECORD) {
+            report_transition_error(report, instruction_index, offset,
+                                    meta->name, "Idle");
+        }
+        break;
+    case GDSL_OPCODE_UPLOAD:
+    case GDSL_OPCODE_DOWNLOAD:
+    case GDSL_OPCODE_COPY_BUFFER:
+    case GDSL_OPCODE_PIPE_BIND:
+    case GDSL_OPCODE_SET_DESCRIPTOR:
+    case GDSL_OPCODE_BIND_BUFFER:
+    case GDSL_OPCODE_BEGIN_PASS:
+    case GDSL_OPCODE_END_PASS:
+    case GDSL_OPCODE_DRAW:
+    case GDSL_OPCODE_DRAW_INDEXED:
+    case GDSL_OPCODE_DISPATCH:
+    case GDSL_OPCODE_QUERY_BEGIN:
+    case GDSL_OPCODE_QUERY_END:
+        if (level >= GDSL_VERIFY_LEVEL_PHASE &&
+            state->phase != GDSL_PHASE_RECORD) {
+            report_transition_error(report, instruction_index, offset,
+                                    meta->name, "Record");
+        }
+        break;
+    default:
+        break;
     }
+}
 
-    memset(report, 0, sizeof(*report));
-    report->success = 0;
+/*
+ * Run skipping. An opcode is neutral for a (level, state) pair when stepping
+ * it changes neither the state nor the report beyond instruction_count; a run
+ * of neutral opcodes can then be consumed in one step. The sets are derived
+ * once by probing verify_step on every reachable state, so they always agree
+ * with the rules above. A rule that starts reading anything outside
+ * gdsl_state_t must keep its opcode out of the sets explicitly, as the
+ * binding and control opcodes do.
+ */
+#define GDSL_STATE_KEYS GDSL_VERIFY_STATE_KEYS
+#define GDSL_NEUTRAL_VECTOR_VALUES 8
 
-    if (!stream && length > 0) {
-        add_diagnostic(report, 0, GDSL_VERIFY_SEVERITY_ERROR,
-                       "null stream pointer with non-zero length");
-        return 0;
-    }
+typedef struct {
+    uint32_t mask[8];
+    uint8_t values[GDSL_NEUTRAL_VECTOR_VALUES];
+    size_t value_count;
+} gdsl_neutral_set_t;
 
-    gdsl_state_t state;
-    gdsl_state_reset(&state);
+static gdsl_neutral_set_t gdsl_neutral_sets[GDSL_VERIFY_LEVEL_DOMAIN + 1]
+                                           [GDSL_STATE_KEYS];
+static pthread_once_t gdsl_neutral_once = PTHREAD_ONCE_INIT;
 
-    size_t offset = 0;
-    size_t instruction_index = 0;
+static size_t state_key(const gdsl_state_t *state) {
+    return (size_t)state->phase * 4 + (size_t)state->domain * 2 +
+           (state->snapshot_active ? 1 : 0);
+}
 
-    while (offset < length) {
-        uint8_t opcode = stream[offset];
-        const gdsl_opcode_metadata_t *meta = &gdsl_opcode_table[opcode];
+static void state_from_key(size_t key, gdsl_state_t *state) {
+    state->phase = (gdsl_phase_t)(key / 4);
+    state->domain = (gdsl_domain_t)((key / 2) % 2);
+    state->snapshot_active = (int)(key % 2);
+}
 
-        if (!meta->name) {
-            add_diagnostic(report, instruction_index,
-                           GDSL_VERIFY_SEVERITY_ERROR,
-                           "unknown opcode 0x%02x", opcode);
-            offset += 1;
-            instruction_index++;
-            continue;
-        }
+static int neutral_contains(const gdsl_neutral_set_t *set, uint8_t opcode) {
+    return (set->mask[opcode >> 5] >> (opcode & 31)) & 1u;
+}
 
-        if (meta->size == 0 || offset + meta->size > length) {
-            add_diagnostic(report, instruction_index,
-                           GDSL_VERIFY_SEVERITY_ERROR,
-                           "truncated instruction for %s", meta->name);
-            break;
-        }
+static void build_neutral_sets(void) {
+    static gdsl_verify_report_t scratch;
 
-        report->instruction_count++;
+    for (int level = GDSL_VERIFY_LEVEL_SYNTAX; level <= GDSL_VERIFY_LEVEL_DOMAIN;
+         ++level) {
+        for (size_t key = 0; key < GDSL_STATE_KEYS; ++key) {
+            gdsl_neutral_set_t *set = &gdsl_neutral_sets[level][key];
+            for (unsigned opcode = 0; opcode < 256; ++opcode) {
+                const gdsl_opcode_metadata_t *meta = &gdsl_opcode_table[opcode];
+                if (!meta->name || meta->size != 1 ||
+                    (meta->flags &
+                     (GDSL_OPCODE_FLAG_BINDING | GDSL_OPCODE_FLAG_CONTROL))) {
+                    continue;
+                }
 
-        switch (opcode) {
-        case GDSL_OPCODE_BEGIN_STREAM:
-            if (level >= GDSL_VERIFY_LEVEL_PHASE) {
-                if (state.snapshot_active) {
-                    add_diagnostic(report, instruction_index,
-                                   GDSL_VERIFY_SEVERITY_ERROR,
-                                   "cannot BEGIN_STREAM while snapshot is active");
+                gdsl_state_t before;
+                state_from_key(key, &before);
+                gdsl_state_t after = before;
+
+                memset(&scratch, 0, sizeof(scratch));
+                verify_step(&after, (gdsl_verify_level_t)level, (uint8_t)opcode,
+                            meta, 0, 0, &scratch);
+                if (scratch.error_count || scratch.warning_count ||
+                    scratch.info_count || scratch.dropped_diagnostic_count ||
+                    memcmp(&before, &after, sizeof(before)) != 0) {
+                    continue;
                 }
-                if (state.phase != GDSL_PHASE_BUILD &&
-                    state.phase != GDSL_PHASE_IDLE) {
-                    report_transition_error(report, instruction_index,
-                                            meta->name,
-                                            state.phase == GDSL_PHASE_RECORD
-                                                ? "Record"
-                                                : "Idle");
+
+                set->mask[opcode >> 5] |= 1u << (opcode & 31);
+                if (set->value_count < GDSL_NEUTRAL_VECTOR_VALUES) {
+                    set->values[set->value_count] = (uint8_t)opcode;
                 }
+                set->value_count++;
             }
-            state.phase = GDSL_PHASE_RECORD;
-            break;
-        case GDSL_OPCODE_BARRIER:
-            if (level >= GDSL_VERIFY_LEVEL_PHASE &&
-                state.phase != GDSL_PHASE_RECORD) {
-                report_transition_error(report, instruction_index,
-                                        meta->name, "Record");
-            }
-            if (level >= GDSL_VERIFY_LEVEL_DOMAIN &&
-                state.domain != GDSL_DOMAIN_DEVICE) {
-                add_diagnostic(report, instruction_index,
-                               GDSL_VERIFY_SEVERITY_WARNING,
-                               "BARRIER issued outside device domain; assuming implicit promotion");
-                state.domain = GDSL_DOMAIN_DEVICE;
+        }
+    }
+}
+
+/* Length of the run of opcodes in set at the start of bytes (at least 1 when
+ * bytes[0] is in set). */
+static size_t neutral_run_length(const gdsl_neutral_set_t *set,
+                                 const uint8_t *bytes,
+                                 size_t length) {
+    size_t run = 0;
+#if defined(__SSE2__)
+    if (set->value_count <= GDSL_NEUTRAL_VECTOR_VALUES) {
+        __m128i needles[GDSL_NEUTRAL_VECTOR_VALUES];
+        for (size_t i = 0; i < set->value_count; ++i) {
+            needles[i] = _mm_set1_epi8((char)set->values[i]);
+        }
+        while (run + 16 <= length) {
+            __m128i chunk = _mm_loadu_si128((const __m128i *)(bytes + run));
+            __m128i hit = _mm_cmpeq_epi8(chunk, needles[0]);
+            for (size_t i = 1; i < set->value_count; ++i) {
+                hit = _mm_or_si128(hit, _mm_cmpeq_epi8(chunk, needles[i]));
             }
-            break;
-        case GDSL_OPCODE_SUBMIT:
-            if (level >= GDSL_VERIFY_LEVEL_PHASE) {
-                if (state.phase != GDSL_PHASE_RECORD) {
-                    report_transition_error(report, instruction_index,
-                                            meta->name, "Record");
-                }
-                if (state.snapshot_active) {
-                    add_diagnostic(report, instruction_index,
-                                   GDSL_VERIFY_SEVERITY_ERROR,
-                                   "cannot SUBMIT inside a snapshot");
-                }
+            unsigned miss = ~(unsigned)_mm_movemask_epi8(hit) & 0xFFFFu;
+            if (miss) {
+                return run + (size_t)__builtin_ctz(miss);
             }
-            state.phase = GDSL_PHASE_SUBMITTED;
-            state.domain = GDSL_DOMAIN_DEVICE;
-            break;
-        case GDSL_OPCODE_FENCE_WAIT:
-            if (level >= GDSL_VERIFY_LEVEL_PHASE &&
-                state.phase != GDSL_PHASE_SUBMITTED) {
-                report_transition_error(report, instruction_index,
-                                        meta->name, "Submitted");
+            run += 16;
+        }
+    }
+#endif
+    while (run < length && neutral_contains(set, bytes[run])) {
+        run++;
+    }
+    return run;
+}
+
+/* Buffer ids ever allocated, with whether each is live. Open addressing;
+ * entries are never removed, FREE_BUFFER only clears live. */
+typedef struct {
+    uint32_t id;
+    uint8_t used;
+    uint8_t live;
+} gdsl_live_buffer_t;
+
+typedef struct {
+    gdsl_live_buffer_t *entries;
+    size_t capacity;
+    size_t count;
+    int failed;
+} gdsl_live_buffers_t;
+
+static gdsl_live_buffer_t *live_buffers_slot(gdsl_live_buffer_t *entries,
+                                             size_t capacity,
+                                             uint32_t id) {
+    size_t slot = (size_t)(id * 0x9e3779b1u) & (capacity - 1);
+    while (entries[slot].used && entries[slot].id != id) {
+        slot = (slot + 1) & (capacity - 1);
+    }
+    return &entries[slot];
+}
+
+static void live_buffers_set(gdsl_live_buffers_t *set, uint32_t id, int live) {
+    if (set->failed) {
+        return;
+    }
+    if (2 * (set->count + 1) > set->capacity) {
+        size_t capacity = set->capacity ? 2 * set->capacity : 64;
+        gdsl_live_buffer_t *entries =
+            (gdsl_live_buffer_t *)calloc(capacity, sizeof(gdsl_live_buffer_t));
+        if (!entries) {
+            set->failed = 1;
+            return;
+        }
+        for (size_t i = 0; i < set->capacity; ++i) {
+            if (set->entries[i].used) {
+                *live_buffers_slot(entries, capacity, set->entries[i].id) = set->entries[i];
             }
-            state.phase = GDSL_PHASE_IDLE;
-            state.domain = GDSL_DOMAIN_HOST;
+        }
+        free(set->entries);
+        set->entries = entries;
+        set->capacity = capacity;
+    }
+    gdsl_live_buffer_t *entry = live_buffers_slot(set->entries, set->capacity, id);
+    if (!entry->used) {
+        entry->used = 1;
+        entry->id = id;
+        set->count++;
+    }
+    entry->live = (uint8_t)live;
+}
+
+static int compare_ids(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+typedef struct {
+    gdsl_verify_snapshot_t *out;
+    size_t capacity;
+    gdsl_verify_snapshot_t open;
+    uint64_t errors_at_begin;
+    int is_open;
+    /* Live-buffer capture, with snapshot_resources set. */
+    uint32_t *resources;
+    size_t resource_capacity;
+    size_t resource_used;
+    gdsl_live_buffers_t live;
+} gdsl_snapshot_index_t;
+
+/* Stores the buffers live at SNAPSHOT_BEGIN for the region being opened. */
+static void snapshot_capture_resources(gdsl_snapshot_index_t *index,
+                                       const gdsl_verify_report_t *report) {
+    gdsl_verify_snapshot_t *region = &index->open;
+    region->resource_offset = index->resource_used;
+    if (report->snapshot_count >= index->capacity) {
+        return;
+    }
+    if (index->live.failed) {
+        region->flags |= GDSL_VERIFY_SNAPSHOT_RESOURCES_TRUNCATED;
+        return;
+    }
+    uint32_t *ids = index->resources + index->resource_used;
+    size_t stored = 0;
+    for (size_t i = 0; i < index->live.capacity; ++i) {
+        const gdsl_live_buffer_t *entry = &index->live.entries[i];
+        if (!entry->used || !entry->live) {
+            continue;
+        }
+        if (index->resource_used + stored == index->resource_capacity) {
+            region->flags |= GDSL_VERIFY_SNAPSHOT_RESOURCES_TRUNCATED;
             break;
-        case GDSL_OPCODE_END_STREAM:
-            if (level >= GDSL_VERIFY_LEVEL_PHASE &&
-                state.phase != GDSL_PHASE_IDLE &&
-                state.phase != GDSL_PHASE_RECORD) {
-                report_transition_error(report, instruction_index,
-                                        meta->name, "Idle");
+        }
+        ids[stored++] = entry->id;
+    }
+    qsort(ids, stored, sizeof(uint32_t), compare_ids);
+    region->resource_count = stored;
+    index->resource_used += stored;
+}
+
+static void snapshot_close(gdsl_snapshot_index_t *index,
+                           gdsl_verify_report_t *report,
+                           uint64_t end_index,
+                           uint64_t end_offset,
+                           int terminated) {
+    gdsl_verify_snapshot_t *region = &index->open;
+    region->end_index = end_index;
+    region->end_offset = end_offset;
+    region->error_count = report->error_count - index->errors_at_begin;
+    if (!terminated) {
+        region->flags |= GDSL_VERIFY_SNAPSHOT_UNTERMINATED;
+    } else if (region->error_count == 0) {
+        region->flags |= GDSL_VERIFY_SNAPSHOT_SAFE;
+    }
+
+    if (report->snapshot_count < index->capacity) {
+        index->out[report->snapshot_count] = *region;
+    } else {
+        report->flags |= GDSL_VERIFY_REPORT_SNAPSHOTS_TRUNCATED;
+    }
+    report->snapshot_count++;
+    index->is_open = 0;
+}
+
+/*
+ * Cross-device synchronisation. Every SEMAPHORE_SIGNAL/WAIT is logged with
+ * the device it was recorded for, and the log is joined once the whole stream
+ * is known: the k-th wait on a semaphore consumes its k-th signal, which
+ * happens before it. A wait that no signal can release is a deadlock.
+ */
+typedef struct {
+    uint64_t instruction_index;
+    uint64_t byte_offset;
+    uint32_t semaphore;
+    uint8_t device;
+    uint8_t wait;
+} gdsl_sync_event_t;
+
+typedef struct {
+    gdsl_sync_event_t *events;
+    size_t count;
+    size_t capacity;
+    int failed;
+} gdsl_sync_log_t;
+
+static void sync_log_append(gdsl_sync_log_t *log, const gdsl_sync_event_t *event) {
+    if (log->count == log->capacity) {
+        size_t capacity = log->capacity ? log->capacity * 2 : 64;
+        gdsl_sync_event_t *events = (gdsl_sync_event_t *)realloc(
+            log->events, capacity * sizeof(gdsl_sync_event_t));
+        if (!events) {
+            log->failed = 1;
+            return;
+        }
+        log->events = events;
+        log->capacity = capacity;
+    }
+    log->events[log->count++] = *event;
+}
+
+static void sync_log_release(gdsl_sync_log_t *log) {
+    free(log->events);
+    memset(log, 0, sizeof(*log));
+}
+
+typedef struct {
+    uint32_t semaphore;
+    size_t event;
+} gdsl_sync_key_t;
+
+static int compare_sync_keys(const void *a, const void *b) {
+    const gdsl_sync_key_t *x = (const gdsl_sync_key_t *)a;
+    const gdsl_sync_key_t *y = (const gdsl_sync_key_t *)b;
+    if (x->semaphore != y->semaphore) {
+        return x->semaphore < y->semaphore ? -1 : 1;
+    }
+    return x->event < y->event ? -1 : (x->event > y->event);
+}
+
+/* Joins a log in stream order. Returns -1 when out of memory. */
+static int sync_join(const gdsl_sync_log_t *log, gdsl_verify_report_t *report) {
+    size_t count = log->count;
+    if (count == 0) {
+        return 0;
+    }
+    const gdsl_sync_event_t *events = log->events;
+    gdsl_sync_key_t *keys = (gdsl_sync_key_t *)malloc(count * sizeof(*keys));
+    size_t *partner = (size_t *)malloc(count * sizeof(*partner));
+    size_t *order = (size_t *)malloc(count * sizeof(*order));
+    uint8_t *done = (uint8_t *)calloc(count, 1);
+    size_t *device_begin = (size_t *)calloc(GDSL_MAX_DEVICES + 1, sizeof(size_t));
+    size_t *cursor = (size_t *)malloc(GDSL_MAX_DEVICES * sizeof(size_t));
+    int rc = -1;
+    if (!keys || !partner || !order || !done || !device_begin || !cursor) {
+        goto out;
+    }
+
+    /* Pair the k-th wait on each semaphore with its k-th signal. */
+    for (size_t i = 0; i < count; ++i) {
+        keys[i].semaphore = events[i].semaphore;
+        keys[i].event = i;
+        partner[i] = SIZE_MAX;
+    }
+    qsort(keys, count, sizeof(*keys), compare_sync_keys);
+    for (size_t group = 0; group < count;) {
+        size_t end = group;
+        while (end < count && keys[end].semaphore == keys[group].semaphore) {
+            end++;
+        }
+        size_t signal = group;
+        for (size_t i = group; i < end; ++i) {
+            size_t wait = keys[i].event;
+            if (!events[wait].wait) {
+                continue;
             }
-            if (state.phase == GDSL_PHASE_RECORD && level >= GDSL_VERIFY_LEVEL_PHASE) {
-                add_diagnostic(report, instruction_index,
-                               GDSL_VERIFY_SEVERITY_WARNING,
-                               "END_STREAM while GPU work still pending; assuming idle transition");
+            while (signal < end && events[keys[signal].event].wait) {
+                signal++;
             }
-            state.phase = GDSL_PHASE_FINISHED;
-            break;
-        case GDSL_OPCODE_END_PROGRAM:
-            if (level >= GDSL_VERIFY_LEVEL_PHASE &&
-                state.phase != GDSL_PHASE_FINISHED) {
-                report_transition_error(report, instruction_index,
-                                        meta->name, "Finished");
+            if (signal == end) {
+                break;
             }
-            break;
-        case GDSL_OPCODE_SNAPSHOT_BEGIN:
-            if (level >= GDSL_VERIFY_LEVEL_DOMAIN) {
-                if (state.snapshot_active) {
-                    add_diagnostic(report, instruction_index,
-                                   GDSL_VERIFY_SEVERITY_ERROR,
-                                   "nested SNAPSHOT_BEGIN not allowed");
-                }
-                if (state.phase != GDSL_PHASE_IDLE) {
-                    report_transition_error(report, instruction_index,
-                                            meta->name, "Idle");
-                }
-                if (state.domain != GDSL_DOMAIN_HOST) {
-                    add_diagnostic(report, instruction_index,
-                                   GDSL_VERIFY_SEVERITY_ERROR,
-                                   "snapshots require host domain but current domain is device");
+            partner[wait] = keys[signal].event;
+            partner[keys[signal].event] = wait;
+            signal++;
+        }
+        group = end;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        if (partner[i] != SIZE_MAX) {
+            continue;
+        }
+        if (events[i].wait) {
+            add_diagnostic(report, events[i].instruction_index,
+                           events[i].byte_offset, GDSL_VERIFY_SEVERITY_ERROR,
+                           "SEMAPHORE_WAIT on semaphore %u is never signalled",
+                           (unsigned)events[i].semaphore);
+        } else {
+            add_diagnostic(report, events[i].instruction_index,
+                           events[i].byte_offset, GDSL_VERIFY_SEVERITY_WARNING,
+                           "SEMAPHORE_SIGNAL on semaphore %u is never waited on",
+                           (unsigned)events[i].semaphore);
+        }
+    }
+
+    /* Run every device's events in program order; a wait proceeds once its
+     * signal has run. Whatever is left blocked is a cycle of waits. */
+    for (size_t i = 0; i < count; ++i) {
+        device_begin[events[i].device + 1]++;
+    }
+    for (size_t d = 0; d < GDSL_MAX_DEVICES; ++d) {
+        device_begin[d + 1] += device_begin[d];
+        cursor[d] = device_begin[d];
+    }
+    for (size_t i = 0; i < count; ++i) {
+        order[cursor[events[i].device]++] = i;
+    }
+    for (size_t d = 0; d < GDSL_MAX_DEVICES; ++d) {
+        cursor[d] = device_begin[d];
+    }
+    int progress = 1;
+    while (progress) {
+        progress = 0;
+        for (size_t d = 0; d < GDSL_MAX_DEVICES; ++d) {
+            while (cursor[d] < device_begin[d + 1]) {
+                size_t e = order[cursor[d]];
+                if (events[e].wait && partner[e] != SIZE_MAX && !done[partner[e]]) {
+                    break;
                 }
+                done[e] = 1;
+                cursor[d]++;
+                progress = 1;
             }
-            state.snapshot_active = 1;
-            break;
-        case GDSL_OPCODE_SNAPSHOT_END:
-            if (level >= GDSL_VERIFY_LEVEL_DOMAIN && !state.snapshot_active) {
-                add_diagnostic(report, instruction_index,
-                               GDSL_VERIFY_SEVERITY_ERROR,
-                               "SNAPSHOT_END without SNAPSHOT_BEGIN");
-            }
-            state.snapshot_active = 0;
-            break;
-        case GDSL_OPCODE_CHECKPOINT:
-            if (level >= GDSL_VERIFY_LEVEL_DOMAIN &&
-                state.phase != GDSL_PHASE_IDLE) {
-                report_transition_error(report, instruction_index,
-                                        meta->name, "Idle");
-            }
+        }
+    }
+    for (size_t d = 0; d < GDSL_MAX_DEVICES; ++d) {
+        if (cursor[d] < device_begin[d + 1]) {
+            const gdsl_sync_event_t *blocked = &events[order[cursor[d]]];
+            add_diagnostic(report, blocked->instruction_index,
+                           blocked->byte_offset, GDSL_VERIFY_SEVERITY_ERROR,
+                           "SEMAPHORE_WAIT on semaphore %u deadlocks device %u",
+                           (unsigned)blocked->semaphore, (unsigned)d);
+        }
+    }
+    rc = 0;
+
+out:
+    free(cursor);
+    free(device_begin);
+    free(done);
+    free(order);
+    free(partner);
+    free(keys);
+    return rc;
+}
+
+/*
+ * Draw/dispatch validation. What is bound on a device is one bitset; every
+ * PIPE_BIND precomputes the bits each kind of draw needs (and the bits it
+ * must not see), so a draw costs a single mask test. Which binding is
+ * missing is only worked out once the test fails. Render passes and queries
+ * are tracked as nesting counters. Bindings belong to the command buffer, so
+ * BEGIN_STREAM clears them.
+ */
+#define GDSL_BIND_GRAPHICS_PIPELINE (1u << 0)
+#define GDSL_BIND_COMPUTE_PIPELINE (1u << 1)
+#define GDSL_BIND_PASS (1u << 2)
+#define GDSL_BIND_INDEX_BUFFER (1u << 3)
+#define GDSL_BIND_SETS_SHIFT 8
+#define GDSL_BIND_VERTEX_SHIFT 16
+
+/* PIPE_BIND bind points; BIND_BUFFER binding 8 is the index buffer, 0-7 are
+ * vertex bindings. */
+#define GDSL_BIND_POINT_GRAPHICS 0
+#define GDSL_BIND_POINT_COMPUTE 1
+#define GDSL_BIND_INDEX_BINDING 8
+
+enum {
+    GDSL_DRAW_KIND_DRAW = 0,
+    GDSL_DRAW_KIND_INDEXED,
+    GDSL_DRAW_KIND_DISPATCH,
+    GDSL_DRAW_KINDS
+};
+
+typedef struct {
+    uint32_t bound;
+    uint32_t need[GDSL_DRAW_KINDS];
+    uint32_t forbid[GDSL_DRAW_KINDS];
+    uint8_t graphics_layout[2];
+    uint8_t compute_sets;
+    uint32_t pass_depth;
+    uint32_t query_depth;
+} gdsl_bindings_t;
+
+static void bindings_update_needs(gdsl_bindings_t *bindings) {
+    uint32_t graphics = GDSL_BIND_GRAPHICS_PIPELINE | GDSL_BIND_PASS |
+                        (uint32_t)bindings->graphics_layout[0] << GDSL_BIND_SETS_SHIFT |
+                        (uint32_t)bindings->graphics_layout[1] << GDSL_BIND_VERTEX_SHIFT;
+    bindings->need[GDSL_DRAW_KIND_DRAW] = graphics;
+    bindings->need[GDSL_DRAW_KIND_INDEXED] = graphics | GDSL_BIND_INDEX_BUFFER;
+    bindings->need[GDSL_DRAW_KIND_DISPATCH] =
+        GDSL_BIND_COMPUTE_PIPELINE |
+        (uint32_t)bindings->compute_sets << GDSL_BIND_SETS_SHIFT;
+    bindings->forbid[GDSL_DRAW_KIND_DISPATCH] = GDSL_BIND_PASS;
+}
+
+static void bindings_reset(gdsl_bindings_t *bindings) {
+    memset(bindings, 0, sizeof(*bindings));
+    bindings_update_needs(bindings);
+}
+
+static void report_missing_binding(gdsl_verify_report_t *report,
+                                   uint64_t index,
+                                   uint64_t offset,
+                                   const char *op,
+                                   uint32_t missing,
+                                   uint32_t present) {
+    if (present & GDSL_BIND_PASS) {
+        add_diagnostic(report, index, offset, GDSL_VERIFY_SEVERITY_ERROR,
+                       "%s inside a render pass", op);
+    } else if (missing & GDSL_BIND_GRAPHICS_PIPELINE) {
+        add_diagnostic(report, index, offset, GDSL_VERIFY_SEVERITY_ERROR,
+                       "%s without a bound graphics pipeline", op);
+    } else if (missing & GDSL_BIND_COMPUTE_PIPELINE) {
+        add_diagnostic(report, index, offset, GDSL_VERIFY_SEVERITY_ERROR,
+                       "%s without a bound compute pipeline", op);
+    } else if (missing & GDSL_BIND_PASS) {
+        add_diagnostic(report, index, offset, GDSL_VERIFY_SEVERITY_ERROR,
+                       "%s outside a render pass", op);
+    } else if (missing & (0xFFu << GDSL_BIND_SETS_SHIFT)) {
+        add_diagnostic(report, index, offset, GDSL_VERIFY_SEVERITY_ERROR,
+                       "%s without descriptor set %u bound", op,
+                       (unsigned)__builtin_ctz(missing >> GDSL_BIND_SETS_SHIFT));
+    } else if (missing & (0xFFu << GDSL_BIND_VERTEX_SHIFT)) {
+        add_diagnostic(report, index, offset, GDSL_VERIFY_SEVERITY_ERROR,
+                       "%s without vertex buffer binding %u bound", op,
+                       (unsigned)__builtin_ctz(missing >> GDSL_BIND_VERTEX_SHIFT));
+    } else {
+        add_diagnostic(report, index, offset, GDSL_VERIFY_SEVERITY_ERROR,
+                       "%s without a bound index buffer", op);
+    }
+}
+
+static void check_draw(const gdsl_bindings_t *bindings,
+                       int kind,
+                       const char *op,
+                       uint64_t index,
+                       uint64_t offset,
+                       gdsl_verify_report_t *report) {
+    uint32_t need = bindings->need[kind];
+    uint32_t forbid = bindings->forbid[kind];
+    if (__builtin_expect(((bindings->bound & need) ^ need) |
+                             (bindings->bound & forbid),
+                         0)) {
+        report_missing_binding(report, index, offset, op,
+                               need & ~bindings->bound, bindings->bound & forbid);
+    }
+}
+
+/* Pass and query scopes must close before the work is submitted. */
+static void check_open_scopes(const gdsl_bindings_t *bindings,
+                              const char *op,
+                              uint64_t index,
+                              uint64_t offset,
+                              gdsl_verify_report_t *report) {
+    if (bindings->pass_depth > 0) {
+        add_diagnostic(report, index, offset, GDSL_VERIFY_SEVERITY_ERROR,
+                       "%s inside a render pass", op);
+    }
+    if (bindings->query_depth > 0) {
+        add_diagnostic(report, index, offset, GDSL_VERIFY_SEVERITY_ERROR,
+                       "%s with %u active queries", op, bindings->query_depth);
+    }
+}
+
+/* Binding rules (GDSL_OPCODE_FLAG_BINDING) at PHASE level and above; the
+ * phase checks of the same opcodes are in verify_step. */
+static void bindings_step(gdsl_bindings_t *bindings,
+                          uint8_t opcode,
+                          const gdsl_opcode_metadata_t *meta,
+                          uint64_t operand,
+                          uint64_t index,
+                          uint64_t offset,
+                          gdsl_verify_report_t *report) {
+    uint8_t slot = (uint8_t)operand;
+    switch (opcode) {
+    case GDSL_OPCODE_DRAW:
+        check_draw(bindings, GDSL_DRAW_KIND_DRAW, meta->name, index, offset, report);
+        break;
+    case GDSL_OPCODE_DRAW_INDEXED:
+        check_draw(bindings, GDSL_DRAW_KIND_INDEXED, meta->name, index, offset, report);
+        break;
+    case GDSL_OPCODE_DISPATCH:
+        check_draw(bindings, GDSL_DRAW_KIND_DISPATCH, meta->name, index, offset, report);
+        break;
+    case GDSL_OPCODE_PIPE_BIND:
+        if (slot == GDSL_BIND_POINT_GRAPHICS) {
+            bindings->bound |= GDSL_BIND_GRAPHICS_PIPELINE;
+            bindings->graphics_layout[0] = (uint8_t)(operand >> 8);
+            bindings->graphics_layout[1] = (uint8_t)(operand >> 16);
+        } else if (slot == GDSL_BIND_POINT_COMPUTE) {
+            bindings->bound |= GDSL_BIND_COMPUTE_PIPELINE;
+            bindings->compute_sets = (uint8_t)(operand >> 8);
+        } else {
+            add_diagnostic(report, index, offset, GDSL_VERIFY_SEVERITY_ERROR,
+                           "PIPE_BIND with unknown bind point %u", (unsigned)slot);
+        }
+        bindings_update_needs(bindings);
+        break;
+    case GDSL_OPCODE_SET_DESCRIPTOR:
+        if (slot < 8) {
+            bindings->bound |= 1u << (GDSL_BIND_SETS_SHIFT + slot);
+        } else {
+            add_diagnostic(report, index, offset, GDSL_VERIFY_SEVERITY_ERROR,
+                           "SET_DESCRIPTOR set %u out of range", (unsigned)slot);
+        }
+        break;
+    case GDSL_OPCODE_BIND_BUFFER:
+        if (slot < 8) {
+            bindings->bound |= 1u << (GDSL_BIND_VERTEX_SHIFT + slot);
+        } else if (slot == GDSL_BIND_INDEX_BINDING) {
+            bindings->bound |= GDSL_BIND_INDEX_BUFFER;
+        } else {
+            add_diagnostic(report, index, offset, GDSL_VERIFY_SEVERITY_ERROR,
+                           "BIND_BUFFER binding %u out of range", (unsigned)slot);
+        }
+        break;
+    case GDSL_OPCODE_BEGIN_PASS:
+        if (bindings->pass_depth > 0) {
+            add_diagnostic(report, index, offset, GDSL_VERIFY_SEVERITY_ERROR,
+                           "nested BEGIN_PASS not allowed");
+        }
+        bindings->pass_depth++;
+        bindings->bound |= GDSL_BIND_PASS;
+        break;
+    case GDSL_OPCODE_END_PASS:
+        if (bindings->pass_depth == 0) {
+            add_diagnostic(report, index, offset, GDSL_VERIFY_SEVERITY_ERROR,
+                           "END_PASS without BEGIN_PASS");
             break;
-        default:
+        }
+        if (--bindings->pass_depth == 0) {
+            bindings->bound &= ~GDSL_BIND_PASS;
+        }
+        break;
+    case GDSL_OPCODE_QUERY_BEGIN:
+        bindings->query_depth++;
+        break;
+    case GDSL_OPCODE_QUERY_END:
+        if (bindings->query_depth == 0) {
+            add_diagnostic(report, index, offset, GDSL_VERIFY_SEVERITY_ERROR,
+                           "QUERY_END without QUERY_BEGIN");
             break;
         }
+        bindings->query_depth--;
+        break;
+    default:
+        break;
+    }
+}
+
+/*
+ * Control flow (gdsl/fold.h). An IF whose condition folds to a constant has
+ * its dead arm skipped; otherwise both arms start from the state at the IF
+ * and must leave the same Γ and pass/query nesting, after which bindings and
+ * registers keep only what both arms agree on.
+ */
+typedef struct {
+    uint64_t index;
+    uint8_t device;
+    int taken;
+    int in_else;
+    /* An arm changed the selected device, so the arms are not joined. */
+    int diverged;
+    gdsl_state_t entry_state;
+    gdsl_bindings_t entry_bindings;
+    gdsl_fold_registers_t entry_registers;
+    gdsl_state_t then_state;
+    gdsl_bindings_t then_bindings;
+    gdsl_fold_registers_t then_registers;
+} gdsl_branch_t;
+
+/* Saved state of a device that is not selected. */
+typedef struct {
+    gdsl_state_t state;
+    gdsl_bindings_t bindings;
+    /* Queue selected on the device (GDSL_VERIFY_DETECT_RACES). */
+    uint8_t queue;
+} gdsl_device_t;
+
+/*
+ * Resumable verifier. A stream can be fed in consecutive chunks (for example
+ * mmap windows of a file); offsets and instruction indices are absolute and
+ * 64-bit, so they stay exact past the address-space limit of the host.
+ */
+typedef struct {
+    gdsl_verify_level_t level;
+    size_t level_index;
+    gdsl_verify_report_t *report;
+    /* Γ, bindings and queue of the selected device; the others wait in
+     * device_zero or, for devices other than 0, in devices[], which is only
+     * allocated once a stream selects one. */
+    gdsl_state_t state;
+    gdsl_bindings_t bindings;
+    uint8_t queue;
+    uint8_t device;
+    uint32_t device_mask[GDSL_MAX_DEVICES / 32];
+    gdsl_device_t device_zero;
+    gdsl_device_t *devices;
+    int devices_failed;
+    gdsl_sync_log_t sync;
+    int detect_races;
+    gdsl_race_detector_t races;
+    int races_truncated;
+    /* Registers, open IFs (deeper ones only counted) and the nesting of the
+     * dead arm being skipped, 0 outside one. */
+    gdsl_fold_registers_t registers;
+    gdsl_branch_t branches[GDSL_FOLD_MAX_DEPTH];
+    size_t branch_depth;
+    uint64_t branch_overflow;
+    uint64_t dead;
+    gdsl_snapshot_index_t snapshots;
+    int index_snapshots;
+    /* gdsl_verify_cuts only. */
+    const gdsl_verify_observer_t *observer;
+    uint64_t max_errors;
+    int stop_when_full;
+    /* Byte offset and index of the next instruction. */
+    uint64_t offset;
+    uint64_t instruction_index;
+    int stopped;
+} gdsl_verifier_t;
+
+static int limits_reached(const gdsl_verifier_t *verifier) {
+    const gdsl_verify_report_t *report = verifier->report;
+    if (verifier->max_errors > 0 &&
+        report->error_count >= verifier->max_errors) {
+        return 1;
+    }
+    return verifier->stop_when_full &&
+           report->diagnostic_count >= GDSL_VERIFY_MAX_DIAGNOSTICS;
+}
+
+static void verifier_init(gdsl_verifier_t *verifier,
+                          gdsl_verify_level_t level,
+                          const gdsl_verify_options_t *options,
+                          gdsl_verify_report_t *report) {
+    memset(verifier, 0, sizeof(*verifier));
+    verifier->level = level;
+    /* Levels outside the enum behave like the nearest defined one. */
+    verifier->level_index = level <= GDSL_VERIFY_LEVEL_SYNTAX   ? 0
+                            : level >= GDSL_VERIFY_LEVEL_DOMAIN ? 2
+                                                                : 1;
+    verifier->report = report;
+    gdsl_state_reset(&verifier->state);
+    bindings_reset(&verifier->bindings);
+    verifier->device_mask[0] = 1u;
+
+    verifier->max_errors = options ? options->max_errors : 0;
+    if (options && (options->flags & GDSL_VERIFY_FAIL_FAST)) {
+        verifier->max_errors = 1;
+    }
+    if (options && (options->flags & GDSL_VERIFY_STOP_WHEN_FULL)) {
+        verifier->stop_when_full = 1;
+    }
+    if (options && (options->flags & GDSL_VERIFY_DETECT_RACES) &&
+        level >= GDSL_VERIFY_LEVEL_DOMAIN) {
+        verifier->detect_races = 1;
+    }
+    if (options && options->snapshots && level >= GDSL_VERIFY_LEVEL_DOMAIN) {
+        verifier->index_snapshots = 1;
+        verifier->snapshots.out = options->snapshots;
+        verifier->snapshots.capacity = options->snapshot_capacity;
+        verifier->snapshots.resources = options->snapshot_resources;
+        verifier->snapshots.resource_capacity =
+            options->snapshot_resources ? options->snapshot_resource_capacity : 0;
+    }
 
-        offset += meta->size;
-        instruction_index++;
+    memset(report, 0, sizeof(*report));
+    report->success = 0;
+    if (options && (options->flags & GDSL_VERIFY_AGGREGATE)) {
+        report->flags |= GDSL_VERIFY_REPORT_AGGREGATED;
     }
 
-    if (state.snapshot_active) {
-        add_diagnostic(report, instruction_index, GDSL_VERIFY_SEVERITY_ERROR,
-                       "unterminated snapshot region");
+    pthread_once(&gdsl_neutral_once, build_neutral_sets);
+}
+
+/* Sets GDSL_VERIFY_REPORT_STOPPED_EARLY once an early-exit limit is hit. */
+static int verifier_check_limits(gdsl_verifier_t *verifier) {
+    if ((verifier->max_errors > 0 || verifier->stop_when_full) &&
+        limits_reached(verifier)) {
+        verifier->report->flags |= GDSL_VERIFY_REPORT_STOPPED_EARLY;
+        verifier->report->stop_index = verifier->instruction_index;
+        verifier->stopped = 1;
     }
+    return verifier->stopped;
+}
+
+static void verifier_advance(gdsl_verifier_t *verifier,
+                             uint64_t instructions,
+                             uint64_t bytes) {
+    verifier->offset += bytes;
+    verifier->instruction_index += instructions;
+}
+
+static void verifier_unknown(gdsl_verifier_t *verifier, uint8_t opcode) {
+    add_diagnostic(verifier->report, verifier->instruction_index,
+                   verifier->offset, GDSL_VERIFY_SEVERITY_ERROR,
+                   "unknown opcode 0x%02x", opcode);
+    verifier_advance(verifier, 1, 1);
+}
+
+static int device_used(const uint32_t *mask, size_t device) {
+    return (mask[device >> 5] >> (device & 31)) & 1u;
+}
 
-    if (state.phase != GDSL_PHASE_FINISHED) {
-        add_diagnostic(report, instruction_index, GDSL_VERIFY_SEVERITY_ERROR,
-                       "stream did not reach END_STREAM/END_PROGRAM");
+/* Next used device at or after from, GDSL_MAX_DEVICES when there is none. */
+static size_t next_device(const uint32_t *mask, size_t from) {
+    while (from < GDSL_MAX_DEVICES) {
+        uint32_t bits = mask[from >> 5] >> (from & 31);
+        if (bits) {
+            return from + (size_t)__builtin_ctz(bits);
+        }
+        from = (from | 31) + 1;
     }
+    return GDSL_MAX_DEVICES;
+}
 
-    report->success = (report->error_count == 0);
+/* Allocates the saved state of devices 1 and up. Returns -1 when out of
+ * memory; verification then finishes with -1. */
+static int verifier_reserve_devices(gdsl_verifier_t *verifier) {
+    if (!verifier->devices) {
+        verifier->devices = (gdsl_device_t *)malloc(GDSL_MAX_DEVICES * sizeof(gdsl_device_t));
+        if (!verifier->devices) {
+            verifier->devices_failed = 1;
+            return -1;
+        }
+    }
     return 0;
 }
+
+/* Saved state of a device other than the selected one. */
+static gdsl_device_t *verifier_saved_device(gdsl_verifier_t *verifier, size_t device) {
+    return device == 0 ? &verifier->device_zero : &verifier->devices[device];
+}
+
+static const gdsl_state_t *verifier_device_state(const gdsl_verifier_t *verifier,
+                                                 size_t device) {
+    if (device == verifier->device) {
+        return &verifier->state;
+    }
+    return device == 0 ? &verifier->device_zero.state : &verifier->devices[device].state;
+}
+
+static void verifier_select_device(gdsl_verifier_t *verifier, uint8_t device) {
+    if (device == verifier->device) {
+        return;
+    }
+    if (verifier_reserve_devices(verifier) != 0) {
+        return;
+    }
+    gdsl_device_t *saved = verifier_saved_device(verifier, verifier->device);
+    saved->state = verifier->state;
+    saved->bindings = verifier->bindings;
+    saved->queue = verifier->queue;
+    if (device_used(verifier->device_mask, device)) {
+        saved = verifier_saved_device(verifier, device);
+        verifier->state = saved->state;
+        verifier->bindings = saved->bindings;
+        verifier->queue = saved->queue;
+    } else {
+        gdsl_state_reset(&verifier->state);
+        bindings_reset(&verifier->bindings);
+        verifier->queue = 0;
+        verifier->device_mask[device >> 5] |= 1u << (device & 31);
+    }
+    verifier->device = device;
+}
+
+/* SET_DEVICE, SET_QUEUE and the semaphore log (GDSL_OPCODE_FLAG_SYNC). */
+static void verifier_sync(gdsl_verifier_t *verifier, uint8_t opcode, uint64_t operand) {
+    if (opcode == GDSL_OPCODE_SET_DEVICE || opcode == GDSL_OPCODE_SET_QUEUE) {
+        if (opcode == GDSL_OPCODE_SET_DEVICE) {
+            verifier_select_device(verifier, (uint8_t)operand);
+        } else {
+            verifier->queue = (uint8_t)operand;
+        }
+        if (verifier->detect_races) {
+            gdsl_race_select(&verifier->races, verifier->device, verifier->queue);
+        }
+        return;
+    }
+    if (verifier->level < GDSL_VERIFY_LEVEL_PHASE) {
+        return;
+    }
+    if (verifier->detect_races) {
+        if (opcode == GDSL_OPCODE_SEMAPHORE_WAIT) {
+            gdsl_race_wait(&verifier->races, (uint32_t)operand);
+        } else {
+            gdsl_race_signal(&verifier->races, (uint32_t)operand);
+        }
+    }
+    gdsl_sync_event_t event;
+    event.instruction_index = verifier->instruction_index;
+    event.byte_offset = verifier->offset;
+    event.semaphore = (uint32_t)operand;
+    event.device = verifier->device;
+    event.wait = opcode == GDSL_OPCODE_SEMAPHORE_WAIT;
+    sync_log_append(&verifier->sync, &event);
+}
+
+static void report_race(gdsl_verifier_t *verifier,
+                        uint32_t resource,
+                        const gdsl_race_conflict_t *conflict) {
+    add_diagnostic(verifier->report, verifier->instruction_index, verifier->offset,
+                   GDSL_VERIFY_SEVERITY_ERROR,
+                   "resource %u: %s on device %u queue %u races with %s on device %u queue %u",
+                   resource, conflict->write ? "write" : "read",
+                   (unsigned)(conflict->queue >> 8), (unsigned)(conflict->queue & 0xFF),
+                   conflict->other_write ? "write" : "read",
+                   (unsigned)(conflict->other_queue >> 8),
+                   (unsigned)(conflict->other_queue & 0xFF));
+}
+
+static void verifier_access(gdsl_verifier_t *verifier, uint32_t resource, int write) {
+    gdsl_race_conflict_t conflict;
+    if (gdsl_race_access(&verifier->races, resource, write, &conflict)) {
+        report_race(verifier, resource, &conflict);
+    }
+}
+
+/* Race detection for buffer accesses (GDSL_OPCODE_FLAG_RESOURCE) and host
+ * fence waits. */
+static void verifier_races(gdsl_verifier_t *verifier, uint8_t opcode, uint64_t operand) {
+    gdsl_race_detector_t *races = &verifier->races;
+    switch (opcode) {
+    case GDSL_OPCODE_FENCE_WAIT:
+        gdsl_race_host_wait(races);
+        break;
+    case GDSL_OPCODE_DOWNLOAD:
+        verifier_access(verifier, (uint32_t)operand, 0);
+        break;
+    case GDSL_OPCODE_COPY_BUFFER:
+        verifier_access(verifier, (uint32_t)operand, 0);
+        verifier_access(verifier, (uint32_t)(operand >> 32), 1);
+        break;
+    default:
+        verifier_access(verifier, (uint32_t)operand, 1);
+        break;
+    }
+    if (races->overflow && !verifier->races_truncated) {
+        add_diagnostic(verifier->report, verifier->instruction_index,
+                       verifier->offset, GDSL_VERIFY_SEVERITY_WARNING,
+                       "race detection covers the first %u queues only",
+                       (unsigned)GDSL_RACE_MAX_QUEUES);
+        verifier->races_truncated = 1;
+    }
+}
+
+static void report_register(gdsl_verifier_t *verifier, int reg) {
+    if (reg >= 0) {
+        add_diagnostic(verifier->report, verifier->instruction_index,
+                       verifier->offset, GDSL_VERIFY_SEVERITY_ERROR,
+                       "register %d out of range", reg);
+    }
+}
+
+/* Merges the arm that just ended with the other one (its end state, or the
+ * entry state when there is no ELSE). */
+static void verifier_join_arms(gdsl_verifier_t *verifier, const gdsl_branch_t *branch) {
+    const gdsl_state_t *other = branch->in_else ? &branch->then_state : &branch->entry_state;
+    const gdsl_bindings_t *other_bindings =
+        branch->in_else ? &branch->then_bindings : &branch->entry_bindings;
+    gdsl_state_t *state = &verifier->state;
+    gdsl_bindings_t *bindings = &verifier->bindings;
+
+    if (state->phase != other->phase || state->domain != other->domain ||
+        state->snapshot_active != other->snapshot_active ||
+        bindings->pass_depth != other_bindings->pass_depth ||
+        bindings->query_depth != other_bindings->query_depth) {
+        add_diagnostic(verifier->report, verifier->instruction_index,
+                       verifier->offset, GDSL_VERIFY_SEVERITY_ERROR,
+                       "arms of the IF at instruction %" PRIu64
+                       " end in different states",
+                       branch->index);
+    }
+    bindings->bound &= other_bindings->bound;
+    for (int kind = 0; kind < GDSL_DRAW_KINDS; ++kind) {
+        bindings->need[kind] |= other_bindings->need[kind];
+        bindings->forbid[kind] |= other_bindings->forbid[kind];
+    }
+    gdsl_fold_join(&verifier->registers,
+                   branch->in_else ? &branch->then_registers : &branch->entry_registers);
+}
+
+static int verifier_check_device(gdsl_verifier_t *verifier, gdsl_branch_t *branch) {
+    if (!branch->diverged && verifier->device != branch->device) {
+        add_diagnostic(verifier->report, verifier->instruction_index,
+                       verifier->offset, GDSL_VERIFY_SEVERITY_ERROR,
+                       "arms of the IF at instruction %" PRIu64
+                       " must end on device %u",
+                       branch->index, (unsigned)branch->device);
+        branch->diverged = 1;
+    }
+    return !branch->diverged;
+}
+
+/* Register arithmetic and IF/ELSE/ENDIF (GDSL_OPCODE_FLAG_CONTROL). */
+static void verifier_control(gdsl_verifier_t *verifier, uint8_t opcode, uint64_t operand) {
+    gdsl_verify_report_t *report = verifier->report;
+
+    if (gdsl_fold_is_if(opcode)) {
+        if (verifier->branch_depth == GDSL_FOLD_MAX_DEPTH) {
+            add_diagnostic(report, verifier->instruction_index, verifier->offset,
+                           GDSL_VERIFY_SEVERITY_ERROR, "IF nesting deeper than %u",
+                           (unsigned)GDSL_FOLD_MAX_DEPTH);
+            verifier->branch_overflow++;
+            return;
+        }
+        int taken;
+        report_register(verifier, gdsl_fold_condition(&verifier->registers, opcode,
+                                                      operand, &taken));
+        gdsl_branch_t *branch = &verifier->branches[verifier->branch_depth++];
+        branch->index = verifier->instruction_index;
+        branch->device = verifier->device;
+        branch->taken = taken;
+        branch->in_else = 0;
+        branch->diverged = 0;
+        branch->entry_state = verifier->state;
+        branch->entry_bindings = verifier->bindings;
+        branch->entry_registers = verifier->registers;
+        verifier->dead = taken == GDSL_FOLD_FALSE;
+        return;
+    }
+
+    if (opcode == GDSL_OPCODE_ELSE || opcode == GDSL_OPCODE_ENDIF) {
+        if (verifier->branch_overflow > 0) {
+            verifier->branch_overflow -= opcode == GDSL_OPCODE_ENDIF;
+            return;
+        }
+        if (verifier->branch_depth == 0) {
+            add_diagnostic(report, verifier->instruction_index, verifier->offset,
+                           GDSL_VERIFY_SEVERITY_ERROR, "%s without IF",
+                           gdsl_opcode_table[opcode].name);
+            return;
+        }
+        gdsl_branch_t *branch = &verifier->branches[verifier->branch_depth - 1];
+        if (opcode == GDSL_OPCODE_ELSE) {
+            if (branch->in_else) {
+                add_diagnostic(report, verifier->instruction_index, verifier->offset,
+                               GDSL_VERIFY_SEVERITY_ERROR, "duplicate ELSE");
+                return;
+            }
+            if (branch->taken != GDSL_FOLD_UNKNOWN) {
+                verifier->dead = branch->taken == GDSL_FOLD_TRUE;
+            } else if (verifier_check_device(verifier, branch)) {
+                branch->then_state = verifier->state;
+                branch->then_bindings = verifier->bindings;
+                branch->then_registers = verifier->registers;
+                verifier->state = branch->entry_state;
+                verifier->bindings = branch->entry_bindings;
+                verifier->registers = branch->entry_registers;
+            }
+            branch->in_else = 1;
+            return;
+        }
+        verifier->branch_depth--;
+        verifier->dead = 0;
+        if (branch->taken == GDSL_FOLD_UNKNOWN && verifier_check_device(verifier, branch)) {
+            verifier_join_arms(verifier, branch);
+        }
+        return;
+    }
+
+    report_register(verifier, gdsl_fold_apply(&verifier->registers, opcode, operand));
+}
+
+/* Inside a dead arm: whether opcode is the ELSE or ENDIF that ends it, which
+ * verifier_control then handles. IFs nested in the arm are only counted. */
+static int verifier_dead_arm_ends(gdsl_verifier_t *verifier, uint8_t opcode) {
+    if (gdsl_fold_is_if(opcode)) {
+        verifier->dead++;
+    } else if (opcode == GDSL_OPCODE_ELSE) {
+        return verifier->dead == 1;
+    } else if (opcode == GDSL_OPCODE_ENDIF) {
+        if (verifier->dead == 1) {
+            return 1;
+        }
+        verifier->dead--;
+    }
+    return 0;
+}
+
+/* Whether the verifier needs the operand of an instruction decoded. */
+static int reads_operand(const gdsl_opcode_metadata_t *meta) {
+    return (meta->flags & (GDSL_OPCODE_FLAG_SYNC | GDSL_OPCODE_FLAG_RESOURCE |
+                           GDSL_OPCODE_FLAG_BINDING | GDSL_OPCODE_FLAG_CONTROL)) != 0;
+}
+
+static uint64_t load_operand(const uint8_t *bytes, size_t width) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < width && i < 8; ++i) {
+        value |= (uint64_t)bytes[i] << (8 * i);
+    }
+    return value;
+}
+
+static const gdsl_neutral_set_t *verifier_neutral(const gdsl_verifier_t *verifier) {
+    return &gdsl_neutral_sets[verifier->level_index][state_key(&verifier->state)];
+}
+
+/* Applies one well-formed instruction, including the snapshot index. operand
+ * is the little-endian operand value (only read for sync, resource,
+ * binding and control opcodes). Inside a dead arm only the instruction
+ * count moves. */
+static void verifier_apply(gdsl_verifier_t *verifier,
+                           uint8_t opcode,
+                           const gdsl_opcode_metadata_t *meta,
+                           uint64_t operand) {
+    gdsl_verify_report_t *report = verifier->report;
+    gdsl_state_t *state = &verifier->state;
+    gdsl_snapshot_index_t *snapshots = &verifier->snapshots;
+    uint64_t offset = verifier->offset;
+    uint64_t instruction_index = verifier->instruction_index;
+
+    if (verifier->dead && !verifier_dead_arm_ends(verifier, opcode)) {
+        report->instruction_count++;
+        verifier_advance(verifier, 1, meta->size);
+        return;
+    }
+    if (verifier->observer) {
+        verifier->observer->instruction(verifier->observer->ctx, opcode, operand,
+                                        verifier->device);
+    }
+
+    if (verifier->index_snapshots && opcode == GDSL_OPCODE_SNAPSHOT_BEGIN &&
+        !snapshots->is_open) {
+        gdsl_verify_snapshot_t *region = &snapshots->open;
+        memset(region, 0, sizeof(*region));
+        region->begin_index = instruction_index;
+        region->begin_offset = offset;
+        region->entry_phase = (gdsl_verify_phase_t)state->phase;
+        region->entry_device_domain = state->domain == GDSL_DOMAIN_DEVICE;
+        snapshots->errors_at_begin = report->error_count;
+        snapshots->is_open = 1;
+        if (snapshots->resources) {
+            snapshot_capture_resources(snapshots, report);
+        }
+    }
+
+    report->instruction_count++;
+    verify_step(state, verifier->level, opcode, meta, instruction_index, offset,
+                report);
+    if (verifier->level >= GDSL_VERIFY_LEVEL_PHASE) {
+        if (meta->flags & GDSL_OPCODE_FLAG_CONTROL) {
+            verifier_control(verifier, opcode, operand);
+        } else if (meta->flags & GDSL_OPCODE_FLAG_BINDING) {
+            bindings_step(&verifier->bindings, opcode, meta, operand,
+                          instruction_index, offset, report);
+        } else if (opcode == GDSL_OPCODE_BEGIN_STREAM) {
+            bindings_reset(&verifier->bindings);
+        } else if (opcode == GDSL_OPCODE_SUBMIT || opcode == GDSL_OPCODE_END_STREAM) {
+            check_open_scopes(&verifier->bindings, meta->name, instruction_index,
+                              offset, report);
+        }
+    }
+    if (meta->flags & GDSL_OPCODE_FLAG_SYNC) {
+        verifier_sync(verifier, opcode, operand);
+    }
+    if (snapshots->resources &&
+        (opcode == GDSL_OPCODE_ALLOC_BUFFER || opcode == GDSL_OPCODE_FREE_BUFFER)) {
+        live_buffers_set(&snapshots->live, (uint32_t)operand,
+                         opcode == GDSL_OPCODE_ALLOC_BUFFER);
+    }
+    if (verifier->detect_races &&
+        ((meta->flags & GDSL_OPCODE_FLAG_RESOURCE) ||
+         opcode == GDSL_OPCODE_FENCE_WAIT)) {
+        verifier_races(verifier, opcode, operand);
+    }
+
+    if (snapshots->is_open && opcode == GDSL_OPCODE_SNAPSHOT_END) {
+        snapshot_close(snapshots, report, instruction_index, offset, 1);
+    }
+
+    verifier_advance(verifier, 1, meta->size);
+}
+
+/* A draw or dispatch changes nothing, so once one passes its checks every
+ * draw of the same kind straight after it passes as well. */
+static int is_draw(uint8_t opcode) {
+    return opcode == GDSL_OPCODE_DRAW || opcode == GDSL_OPCODE_DRAW_INDEXED ||
+           opcode == GDSL_OPCODE_DISPATCH;
+}
+
+static uint64_t report_diagnostic_total(const gdsl_verify_report_t *report) {
+    return report->error_count + report->warning_count + report->info_count;
+}
+
+/* Number of complete size-byte instructions with opcode at the start of
+ * bytes. */
+static size_t repeat_run_length(const uint8_t *bytes,
+                                size_t length,
+                                uint8_t opcode,
+                                size_t size) {
+    size_t run = 0;
+    for (size_t pos = 0; pos + size <= length && bytes[pos] == opcode; pos += size) {
+        run++;
+    }
+    return run;
+}
+
+/* Verifies the instructions of bytes, which continue the stream at
+ * verifier->offset. Unless final is set, an instruction cut off by the end of
+ * the chunk is left for the next one. Returns the bytes consumed. */
+static size_t verifier_feed(gdsl_verifier_t *verifier,
+                            const uint8_t *bytes,
+                            size_t length,
+                            int final) {
+    size_t pos = 0;
+
+    while (pos < length && !verifier_check_limits(verifier)) {
+        uint8_t opcode = bytes[pos];
+        const gdsl_opcode_metadata_t *meta = &gdsl_opcode_table[opcode];
+
+        if (!meta->name) {
+            verifier_unknown(verifier, opcode);
+            pos += 1;
+            continue;
+        }
+
+        if (meta->size == 0 || pos + meta->size > length) {
+            if (!final && meta->size != 0) {
+                break;
+            }
+            add_diagnostic(verifier->report, verifier->instruction_index,
+                           verifier->offset, GDSL_VERIFY_SEVERITY_ERROR,
+                           "truncated instruction for %s", meta->name);
+            verifier->stopped = 1;
+            break;
+        }
+
+        const gdsl_neutral_set_t *neutral = verifier_neutral(verifier);
+        if (neutral_contains(neutral, opcode)) {
+            size_t run = neutral_run_length(neutral, bytes + pos, length - pos);
+            verifier->report->instruction_count += run;
+            verifier_advance(verifier, run, run);
+            pos += run;
+            continue;
+        }
+
+        uint64_t operand = 0;
+        if (reads_operand(meta)) {
+            operand = load_operand(bytes + pos + 1, (size_t)meta->size - 1);
+        }
+        uint64_t diagnostics = report_diagnostic_total(verifier->report);
+        verifier_apply(verifier, opcode, meta, operand);
+        pos += meta->size;
+        if (is_draw(opcode) &&
+            report_diagnostic_total(verifier->report) == diagnostics) {
+            size_t run = repeat_run_length(bytes + pos, length - pos, opcode,
+                                           meta->size);
+            verifier->report->instruction_count += run;
+            verifier_advance(verifier, run, (uint64_t)run * meta->size);
+            pos += run * meta->size;
+        }
+    }
+
+    return pos;
+}
+
+/* Applies a run of count consecutive instances of opcode without
+ * materialising them: once the state makes the opcode neutral, the rest of
+ * the run is consumed in one step. Operand fields are only decoded for sync,
+ * resource, binding and control opcodes. */
+static void verifier_run(gdsl_verifier_t *verifier, const gdsl_encode_run_t *run) {
+    uint8_t opcode = run->opcode;
+    uint64_t count = run->count;
+    const gdsl_opcode_metadata_t *meta = &gdsl_opcode_table[opcode];
+    const uint8_t *operand = run->operands;
+    const uint8_t *operand_end = run->operands + run->operand_bytes;
+
+    while (count > 0 && !verifier_check_limits(verifier)) {
+        if (!meta->name) {
+            verifier_unknown(verifier, opcode);
+            count--;
+            continue;
+        }
+        if (neutral_contains(verifier_neutral(verifier), opcode)) {
+            verifier->report->instruction_count += count;
+            verifier_advance(verifier, count, count * meta->size);
+            return;
+        }
+        uint64_t value = 0;
+        if (reads_operand(meta)) {
+            size_t width = (size_t)meta->size - 1;
+            if (width > 8) {
+                value = load_operand(operand, width);
+                operand += width;
+            } else if (width > 0) {
+                operand += gdsl_varint_read(operand, operand_end, &value);
+            }
+        }
+        uint64_t diagnostics = report_diagnostic_total(verifier->report);
+        verifier_apply(verifier, opcode, meta, value);
+        count--;
+        if (is_draw(opcode) &&
+            report_diagnostic_total(verifier->report) == diagnostics) {
+            verifier->report->instruction_count += count;
+            verifier_advance(verifier, count, count * meta->size);
+            return;
+        }
+    }
+}
+
+/* End-of-stream rules. device prefixes the messages of multi-device streams
+ * ("" otherwise). */
+static void check_unterminated_snapshot(const gdsl_state_t *state,
+                                        const char *device,
+                                        uint64_t index,
+                                        uint64_t offset,
+                                        gdsl_verify_report_t *report) {
+    if (state->snapshot_active) {
+        add_diagnostic(report, index, offset, GDSL_VERIFY_SEVERITY_ERROR,
+                       "%sunterminated snapshot region", device);
+    }
+}
+
+static void check_finished(const gdsl_state_t *state,
+                           const char *device,
+                           uint64_t index,
+                           uint64_t offset,
+                           gdsl_verify_report_t *report) {
+    if (state->phase != GDSL_PHASE_FINISHED) {
+        add_diagnostic(report, index, offset, GDSL_VERIFY_SEVERITY_ERROR,
+                       "%sstream did not reach END_STREAM/END_PROGRAM", device);
+    }
+}
+
+static void verifier_release(gdsl_verifier_t *verifier) {
+    sync_log_release(&verifier->sync);
+    gdsl_race_release(&verifier->races);
+    free(verifier->snapshots.live.entries);
+    verifier->snapshots.live.entries = NULL;
+    free(verifier->devices);
+    verifier->devices = NULL;
+}
+
+/* Returns -1 when the semaphore log or the device states could not be kept
+ * (out of memory). */
+static int verifier_finish(gdsl_verifier_t *verifier) {
+    gdsl_verify_report_t *report = verifier->report;
+    uint64_t index = verifier->instruction_index;
+    uint64_t offset = verifier->offset;
+
+    if (report->flags & GDSL_VERIFY_REPORT_STOPPED_EARLY) {
+        if (verifier->snapshots.is_open) {
+            snapshot_close(&verifier->snapshots, report, index, offset, 0);
+        }
+        verifier_release(verifier);
+        return 0;
+    }
+
+    if (verifier->branch_depth > 0) {
+        add_diagnostic(report, index, offset, GDSL_VERIFY_SEVERITY_ERROR,
+                       "IF at instruction %" PRIu64 " has no ENDIF",
+                       verifier->branches[0].index);
+    }
+
+    const uint32_t *mask = verifier->device_mask;
+    int multi_device = next_device(mask, 1) < GDSL_MAX_DEVICES;
+    char prefix[16] = "";
+    for (size_t d = next_device(mask, 0); d < GDSL_MAX_DEVICES; d = next_device(mask, d + 1)) {
+        if (multi_device) {
+            snprintf(prefix, sizeof(prefix), "device %u: ", (unsigned)d);
+        }
+        check_unterminated_snapshot(verifier_device_state(verifier, d), prefix, index,
+                                    offset, report);
+    }
+    if (verifier->snapshots.is_open) {
+        snapshot_close(&verifier->snapshots, report, index, offset, 0);
+    }
+    for (size_t d = next_device(mask, 0); d < GDSL_MAX_DEVICES; d = next_device(mask, d + 1)) {
+        if (multi_device) {
+            snprintf(prefix, sizeof(prefix), "device %u: ", (unsigned)d);
+        }
+        check_finished(verifier_device_state(verifier, d), prefix, index, offset, report);
+    }
+
+    int rc = verifier->sync.failed || verifier->races.failed || verifier->devices_failed
+                 ? -1
+                 : sync_join(&verifier->sync, report);
+    verifier_release(verifier);
+
+    report->success = (report->error_count == 0 && rc == 0);
+    return rc;
+}
+
+size_t gdsl_verify_rules_initial(void) {
+    gdsl_state_t state;
+    gdsl_state_reset(&state);
+    return state_key(&state);
+}
+
+size_t gdsl_verify_rules_step(gdsl_verify_level_t level,
+                              size_t key,
+                              uint8_t opcode,
+                              gdsl_verify_report_t *report) {
+    gdsl_state_t state;
+    state_from_key(key, &state);
+    verify_step(&state, level, opcode, &gdsl_opcode_table[opcode], 0, 0, report);
+    return state_key(&state);
+}
+
+void gdsl_verify_rules_finish(size_t key, gdsl_verify_report_t *report) {
+    gdsl_state_t state;
+    state_from_key(key, &state);
+    check_unterminated_snapshot(&state, "", 0, 0, report);
+    check_finished(&state, "", 0, 0, report);
+}
+
+/*
+ * Per-device passes. With a pool, a stream that addresses several devices is
+ * split at its SET_DEVICE instructions and every device's sub-stream is
+ * verified by its own pass. The passes never look at each other: the
+ * diagnostics are merged in stream order and the semaphore logs joined
+ * afterwards, so the report is identical to the serial one. Early-exit
+ * limits, aggregation and the snapshot index need the serial order and keep
+ * the single pass.
+ */
+typedef struct {
+    uint64_t offset;
+    uint64_t length;
+    uint64_t index;
+    uint8_t device;
+} gdsl_device_segment_t;
+
+typedef struct {
+    gdsl_device_segment_t *segments;
+    size_t count;
+    size_t capacity;
+    uint32_t device_mask[GDSL_MAX_DEVICES / 32];
+    /* Device selected at the end, SET_DEVICE count and where the serial pass
+     * would stop. */
+    uint8_t last_device;
+    uint64_t host_instructions;
+    uint64_t end_index;
+    uint64_t end_offset;
+    /* Registers and IFs span devices, so such streams stay serial. */
+    int has_control;
+} gdsl_device_split_t;
+
+typedef struct {
+    uint8_t device;
+    const gdsl_device_segment_t *segments;
+    size_t segment_count;
+    gdsl_verifier_t verifier;
+    gdsl_verify_report_t report;
+} gdsl_device_pass_t;
+
+typedef struct {
+    const uint8_t *stream;
+    gdsl_verify_level_t level;
+    gdsl_device_pass_t *passes;
+} gdsl_device_passes_t;
+
+static int split_append(gdsl_device_split_t *split,
+                        uint8_t device,
+                        uint64_t begin,
+                        uint64_t end,
+                        uint64_t index) {
+    if (begin == end) {
+        return 0;
+    }
+    if (split->count == split->capacity) {
+        size_t capacity = split->capacity ? split->capacity * 2 : 16;
+        gdsl_device_segment_t *segments = (gdsl_device_segment_t *)realloc(
+            split->segments, capacity * sizeof(gdsl_device_segment_t));
+        if (!segments) {
+            return -1;
+        }
+        split->segments = segments;
+        split->capacity = capacity;
+    }
+    gdsl_device_segment_t *segment = &split->segments[split->count++];
+    segment->offset = begin;
+    segment->length = end - begin;
+    segment->index = index;
+    segment->device = device;
+    return 0;
+}
+
+/* Cuts stream into per-device segments; SET_DEVICE itself stays with the
+ * host. */
+static int split_devices(const uint8_t *stream, size_t length, gdsl_device_split_t *split) {
+    memset(split, 0, sizeof(*split));
+    split->device_mask[0] = 1u;
+
+    uint8_t device = 0;
+    size_t begin = 0;
+    uint64_t begin_index = 0;
+    uint64_t index = 0;
+    size_t pos = 0;
+    while (pos < length) {
+        const gdsl_opcode_metadata_t *meta = &gdsl_opcode_table[stream[pos]];
+        if (!meta->name) {
+            pos++;
+            index++;
+            continue;
+        }
+        if (meta->size == 0 || meta->size > length - pos) {
+            break;
+        }
+        if (meta->flags & GDSL_OPCODE_FLAG_CONTROL) {
+            split->has_control = 1;
+        }
+        if (stream[pos] == GDSL_OPCODE_SET_DEVICE) {
+            if (split_append(split, device, begin, pos, begin_index) != 0) {
+                return -1;
+            }
+            device = stream[pos + 1];
+            split->device_mask[device >> 5] |= 1u << (device & 31);
+            split->host_instructions++;
+            begin = pos + meta->size;
+            begin_index = index + 1;
+        }
+        pos += meta->size;
+        index++;
+    }
+    split->end_index = index;
+    split->end_offset = pos;
+    split->last_device = device;
+    return split_append(split, device, begin, length, begin_index);
+}
+
+static void verify_device_range(void *ctx, size_t begin, size_t end, size_t worker) {
+    const gdsl_device_passes_t *passes = (const gdsl_device_passes_t *)ctx;
+    (void)worker;
+
+    for (size_t i = begin; i < end; ++i) {
+        gdsl_device_pass_t *pass = &passes->passes[i];
+        gdsl_verifier_t *verifier = &pass->verifier;
+        verifier_init(verifier, passes->level, NULL, &pass->report);
+        verifier->device = pass->device;
+        for (size_t s = 0; s < pass->segment_count && !verifier->stopped; ++s) {
+            const gdsl_device_segment_t *segment = &pass->segments[s];
+            verifier->offset = segment->offset;
+            verifier->instruction_index = segment->index;
+            verifier_feed(verifier, passes->stream + segment->offset,
+                          (size_t)segment->length, 1);
+        }
+    }
+}
+
+static int compare_sync_events(const void *a, const void *b) {
+    const gdsl_sync_event_t *x = (const gdsl_sync_event_t *)a;
+    const gdsl_sync_event_t *y = (const gdsl_sync_event_t *)b;
+    return x->instruction_index < y->instruction_index
+               ? -1
+               : (x->instruction_index > y->instruction_index);
+}
+
+/* Merges the passes into verifier (initialised for the whole stream). */
+static int join_device_passes(gdsl_verifier_t *verifier,
+                              const gdsl_device_split_t *split,
+                              gdsl_device_pass_t *passes,
+                              size_t pass_count) {
+    gdsl_verify_report_t *report = verifier->report;
+    size_t *next = (size_t *)calloc(pass_count, sizeof(size_t));
+    if (!next || verifier_reserve_devices(verifier) != 0) {
+        free(next);
+        return -1;
+    }
+
+    report->instruction_count = split->host_instructions;
+    uint64_t total_diagnostics = 0;
+    size_t events = 0;
+    for (size_t p = 0; p < pass_count; ++p) {
+        const gdsl_verify_report_t *part = &passes[p].report;
+        report->instruction_count += part->instruction_count;
+        report->error_count += part->error_count;
+        report->warning_count += part->warning_count;
+        report->info_count += part->info_count;
+        total_diagnostics += part->diagnostic_count + part->dropped_diagnostic_count;
+        events += passes[p].verifier.sync.count;
+        verifier_saved_device(verifier, passes[p].device)->state = passes[p].verifier.state;
+        if (passes[p].verifier.sync.failed) {
+            verifier->sync.failed = 1;
+        }
+    }
+
+    /* Every pass keeps its earliest diagnostics, so the earliest overall are
+     * among them. */
+    while (report->diagnostic_count < GDSL_VERIFY_MAX_DIAGNOSTICS) {
+        size_t best = pass_count;
+        for (size_t p = 0; p < pass_count; ++p) {
+            const gdsl_verify_report_t *part = &passes[p].report;
+            if (next[p] < part->diagnostic_count &&
+                (best == pass_count ||
+                 part->diagnostics[next[p]].instruction_index <
+                     passes[best].report.diagnostics[next[best]].instruction_index)) {
+                best = p;
+            }
+        }
+        if (best == pass_count) {
+            break;
+        }
+        report->diagnostics[report->diagnostic_count++] =
+            passes[best].report.diagnostics[next[best]++];
+    }
+    report->dropped_diagnostic_count = total_diagnostics - report->diagnostic_count;
+    if (report->dropped_diagnostic_count > 0) {
+        report->flags |= GDSL_VERIFY_REPORT_DIAGNOSTICS_TRUNCATED;
+    }
+    free(next);
+
+    memcpy(verifier->device_mask, split->device_mask, sizeof(split->device_mask));
+    verifier->device = split->last_device;
+    verifier->state = verifier_saved_device(verifier, split->last_device)->state;
+    verifier->instruction_index = split->end_index;
+    verifier->offset = split->end_offset;
+
+    if (events > 0 && !verifier->sync.failed) {
+        gdsl_sync_log_t *log = &verifier->sync;
+        log->events = (gdsl_sync_event_t *)malloc(events * sizeof(gdsl_sync_event_t));
+        if (!log->events) {
+            return -1;
+        }
+        log->capacity = events;
+        for (size_t p = 0; p < pass_count; ++p) {
+            const gdsl_sync_log_t *part = &passes[p].verifier.sync;
+            if (part->count == 0) {
+                continue;
+            }
+            memcpy(log->events + log->count, part->events,
+                   part->count * sizeof(gdsl_sync_event_t));
+            log->count += part->count;
+        }
+        qsort(log->events, log->count, sizeof(gdsl_sync_event_t), compare_sync_events);
+    }
+    return 0;
+}
+
+/* Returns 1 when the stream was verified by per-device passes, 0 when it
+ * addresses a single device (nothing to split) and -1 on failure. */
+static int verify_device_passes(const uint8_t *stream,
+                                size_t length,
+                                gdsl_verify_level_t level,
+                                const gdsl_verify_options_t *options,
+                                gdsl_verify_report_t *report) {
+    gdsl_device_split_t split;
+    if (split_devices(stream, length, &split) != 0) {
+        free(split.segments);
+        return -1;
+    }
+
+    size_t pass_count = 0;
+    size_t per_device[GDSL_MAX_DEVICES] = {0};
+    for (size_t d = 0; d < GDSL_MAX_DEVICES; ++d) {
+        pass_count += device_used(split.device_mask, d);
+    }
+    if (pass_count < 2 || split.has_control) {
+        free(split.segments);
+        return 0;
+    }
+
+    /* Group the segments by device, keeping stream order within each. */
+    gdsl_device_segment_t *grouped = (gdsl_device_segment_t *)malloc(
+        (split.count ? split.count : 1) * sizeof(gdsl_device_segment_t));
+    gdsl_device_pass_t *passes =
+        (gdsl_device_pass_t *)calloc(pass_count, sizeof(gdsl_device_pass_t));
+    gdsl_verifier_t *verifier = (gdsl_verifier_t *)malloc(sizeof(gdsl_verifier_t));
+    int rc = -1;
+    if (!grouped || !passes || !verifier) {
+        goto out;
+    }
+    for (size_t i = 0; i < split.count; ++i) {
+        per_device[split.segments[i].device]++;
+    }
+    size_t first = 0;
+    size_t p = 0;
+    size_t slot_of[GDSL_MAX_DEVICES];
+    for (size_t d = 0; d < GDSL_MAX_DEVICES; ++d) {
+        if (!device_used(split.device_mask, d)) {
+            continue;
+        }
+        passes[p].device = (uint8_t)d;
+        passes[p].segments = grouped + first;
+        slot_of[d] = first;
+        first += per_device[d];
+        p++;
+    }
+    for (size_t i = 0; i < split.count; ++i) {
+        grouped[slot_of[split.segments[i].device]++] = split.segments[i];
+    }
+    for (p = 0; p < pass_count; ++p) {
+        passes[p].segment_count = per_device[passes[p].device];
+    }
+
+    gdsl_device_passes_t ctx = {stream, level, passes};
+    if (gdsl_pool_parallel_for(options->pool, 0, pass_count, 1,
+                               verify_device_range, &ctx) != 0) {
+        goto out;
+    }
+
+    verifier_init(verifier, level, options, report);
+    if (join_device_passes(verifier, &split, passes, pass_count) != 0) {
+        verifier_release(verifier);
+        goto out;
+    }
+    rc = verifier_finish(verifier) == 0 ? 1 : -1;
+
+out:
+    if (passes) {
+        for (p = 0; p < pass_count; ++p) {
+            verifier_release(&passes[p].verifier);
+        }
+    }
+    free(verifier);
+    free(passes);
+    free(grouped);
+    free(split.segments);
+    return rc;
+}
+
+int gdsl_verify(const uint8_t *stream,
+                size_t length,
+                gdsl_verify_level_t level,
+                gdsl_verify_report_t *report) {
+    return gdsl_verify_ex(stream, length, level, NULL, report);
+}
+
+int gdsl_verify_ex(const uint8_t *stream,
+                   size_t length,
+                   gdsl_verify_level_t level,
+                   const gdsl_verify_options_t *options,
+                   gdsl_verify_report_t *report) {
+    if (!report) {
+        return -1;
+    }
+
+    gdsl_verifier_t verifier;
+    verifier_init(&verifier, level, options, report);
+
+    if (!stream && length > 0) {
+        add_diagnostic(report, 0, 0, GDSL_VERIFY_SEVERITY_ERROR,
+                       "null stream pointer with non-zero length");
+        return 0;
+    }
+
+    if (options && options->pool && options->max_errors == 0 && !options->snapshots &&
+        !(options->flags & (GDSL_VERIFY_FAIL_FAST | GDSL_VERIFY_STOP_WHEN_FULL |
+                            GDSL_VERIFY_AGGREGATE | GDSL_VERIFY_DETECT_RACES))) {
+        int rc = verify_device_passes(stream, length, level, options, report);
+        if (rc != 0) {
+            return rc < 0 ? -1 : 0;
+        }
+    }
+
+    verifier_feed(&verifier, stream, length, 1);
+    return verifier_finish(&verifier);
+}
+
+static void verifier_capture(const gdsl_verifier_t *verifier, gdsl_verify_cut_t *cut) {
+    memset(cut, 0, sizeof(*cut));
+    cut->instruction_index = verifier->instruction_index;
+    cut->byte_offset = verifier->offset;
+    memcpy(cut->device_mask, verifier->device_mask, sizeof(cut->device_mask));
+    const uint32_t *mask = verifier->device_mask;
+    for (size_t d = next_device(mask, 0); d < GDSL_MAX_DEVICES; d = next_device(mask, d + 1)) {
+        int selected = d == verifier->device;
+        const gdsl_device_t *saved =
+            d == 0 ? &verifier->device_zero : &verifier->devices[d];
+        const gdsl_state_t *state = selected ? &verifier->state : &saved->state;
+        const gdsl_bindings_t *bindings = selected ? &verifier->bindings : &saved->bindings;
+        cut->queues[d] = selected ? verifier->queue : saved->queue;
+        gdsl_verify_device_state_t *out = &cut->devices[d];
+        out->phase = (gdsl_verify_phase_t)state->phase;
+        out->device_domain = state->domain == GDSL_DOMAIN_DEVICE;
+        out->snapshot_active = state->snapshot_active;
+        out->pass_depth = bindings->pass_depth;
+        out->query_depth = bindings->query_depth;
+    }
+    cut->device = verifier->device;
+    cut->registers = verifier->registers;
+    cut->open_branches = verifier->branch_depth + verifier->branch_overflow;
+}
+
+int gdsl_verify_cuts(const uint8_t *stream,
+                     size_t length,
+                     gdsl_verify_level_t level,
+                     const gdsl_verify_options_t *options,
+                     const uint64_t *cut_offsets,
+                     size_t cut_count,
+                     const gdsl_verify_observer_t *observer,
+                     gdsl_verify_report_t *report) {
+    if (!report || !observer || (!stream && length > 0) || (!cut_offsets && cut_count > 0)) {
+        return -1;
+    }
+    gdsl_verify_cut_t *cut = (gdsl_verify_cut_t *)malloc(sizeof(*cut));
+    if (!cut) {
+        return -1;
+    }
+
+    gdsl_verifier_t verifier;
+    verifier_init(&verifier, level, options, report);
+    verifier.observer = observer;
+    size_t reached = 0;
+    for (size_t k = 0; k < cut_count; ++k) {
+        uint64_t target = cut_offsets[k];
+        if (target < verifier.offset || target > length) {
+            break;
+        }
+        verifier_feed(&verifier, stream + verifier.offset,
+                      (size_t)(target - verifier.offset), 0);
+        if (verifier.offset != target) {
+            break;
+        }
+        verifier_capture(&verifier, cut);
+        observer->cut(observer->ctx, k, cut);
+        reached++;
+    }
+    free(cut);
+    if (reached < cut_count) {
+        verifier_release(&verifier);
+        return -1;
+    }
+
+    verifier_feed(&verifier, stream + verifier.offset, length - (size_t)verifier.offset, 1);
+    return verifier_finish(&verifier);
+}
+
+int gdsl_verify_encoded(const uint8_t *encoded,
+                        size_t length,
+                        gdsl_verify_level_t level,
+                        const gdsl_verify_options_t *options,
+                        gdsl_verify_report_t *report) {
+    if (!report) {
+        return -1;
+    }
+
+    gdsl_encode_reader_t reader;
+    if (gdsl_encode_reader_init(&reader, encoded, length) != 0) {
+        return -1;
+    }
+
+    gdsl_verifier_t verifier;
+    verifier_init(&verifier, level, options, report);
+
+    gdsl_encode_run_t run;
+    int rc = 0;
+    while (!verifier.stopped && (rc = gdsl_encode_reader_next(&reader, &run)) > 0) {
+        verifier_run(&verifier, &run);
+    }
+    if (!verifier.stopped) {
+        if (rc < 0) {
+            verifier_release(&verifier);
+            return -1;
+        }
+        verifier_feed(&verifier, reader.tail, reader.tail_length, 1);
+    }
+
+    return verifier_finish(&verifier);
+}
+
+/* Bytes verified between releases of the pages behind the cursor. */
+#define GDSL_VERIFY_FILE_SLICE ((size_t)4 << 20)
+
+int gdsl_verify_file(const char *path,
+                     gdsl_verify_level_t level,
+                     const gdsl_verify_options_t *options,
+                     gdsl_verify_report_t *report) {
+    if (!path || !report) {
+        return -1;
+    }
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < 0) {
+        close(fd);
+        return -1;
+    }
+    uint64_t size = (uint64_t)info.st_size;
+
+    long page_size = sysconf(_SC_PAGESIZE);
+    size_t page = page_size > 0 ? (size_t)page_size : 4096;
+    size_t window = options && options->window_size ? options->window_size
+                                                    : GDSL_VERIFY_DEFAULT_WINDOW;
+    /* Two pages guarantee that a window starting at the page holding the
+     * cursor always covers the next whole instruction. */
+    window = (window + page - 1) / page * page;
+    if (window < 2 * page) {
+        window = 2 * page;
+    }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    gdsl_verifier_t verifier;
+    verifier_init(&verifier, level, options, report);
+
+    int rc = 0;
+    while (verifier.offset < size && !verifier.stopped) {
+        uint64_t start = verifier.offset / page * page;
+        uint64_t remaining = size - start;
+        size_t map_length = remaining < window ? (size_t)remaining : window;
+        int final = (start + map_length == size);
+
+        uint8_t *base = (uint8_t *)mmap(NULL, map_length, PROT_READ,
+                                        MAP_PRIVATE, fd, (off_t)start);
+        if (base == MAP_FAILED) {
+            rc = -1;
+            break;
+        }
+        madvise(base, map_length, MADV_SEQUENTIAL);
+
+        size_t pos = (size_t)(verifier.offset - start);
+        size_t released = 0;
+        while (pos < map_length && !verifier.stopped) {
+            size_t slice = map_length - pos;
+            if (slice > GDSL_VERIFY_FILE_SLICE) {
+                slice = GDSL_VERIFY_FILE_SLICE;
+            }
+            size_t used = verifier_feed(&verifier, base + pos, slice,
+                                        final && pos + slice == map_length);
+            pos += used;
+
+            size_t behind = pos / page * page;
+            if (behind > released) {
+                madvise(base + released, behind - released, MADV_DONTNEED);
+                released = behind;
+            }
+            if (used == 0) {
+                /* The next instruction crosses the end of the window. */
+                break;
+            }
+        }
+
+        munmap(base, map_length);
+    }
+
+    close(fd);
+    if (rc != 0) {
+        verifier_release(&verifier);
+        return rc;
+    }
+    return verifier_finish(&verifier);
+}
+
+const gdsl_verify_snapshot_t *gdsl_verify_find_snapshot(
+    const gdsl_verify_snapshot_t *snapshots,
+    size_t count,
+    uint64_t instruction_index) {
+    if (!snapshots) {
+        return NULL;
+    }
+
+    /* Last region that begins at or before instruction_index. */
+    size_t lo = 0;
+    size_t hi = count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (snapshots[mid].begin_index <= instruction_index) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo == 0 || snapshots[lo - 1].end_index < instruction_index) {
+        return NULL;
+    }
+    return &snapshots[lo - 1];
+}
+
+typedef struct {
+    const gdsl_verify_batch_item_t *items;
+    gdsl_verify_level_t level;
+} gdsl_verify_batch_ctx_t;
+
+static void verify_batch_range(void *ctx, size_t begin, size_t end, size_t worker) {
+    const gdsl_verify_batch_ctx_t *batch = (const gdsl_verify_batch_ctx_t *)ctx;
+    (void)worker;
+
+    for (size_t i = begin; i < end; ++i) {
+        const gdsl_verify_batch_item_t *item = &batch->items[i];
+        gdsl_verify(item->stream, item->length, batch->level, item->report);
+    }
+}
+
+int gdsl_verify_batch(const gdsl_verify_batch_item_t *items,
+                      size_t count,
+                      gdsl_verify_level_t level,
+                      gdsl_pool_t *pool) {
+    if (!items && count > 0) {
+        return -1;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        if (!items[i].report) {
+            return -1;
+        }
+    }
+
+    gdsl_verify_batch_ctx_t batch = {items, level};
+    return gdsl_pool_parallel_for(pool, 0, count, 1, verify_batch_range, &batch);
+}
@@ -0,0 +1,61 @@
+#ifndef GDSL_VERIFY_CUTS_INTERNAL_H
+#define GDSL_VERIFY_CUTS_INTERNAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "fold_eval.h"
+#include "gdsl/verify.h"
+
+/*
+ * The verifier's state at chosen points of a stream, for tools that rebuild
+ * it (gdsl_slice). The stream is verified once; the observer sees every
+ * instruction the verifier applies outside dead arms, and the state just
+ * before each cut.
+ */
+
+#define GDSL_VERIFY_CUT_DEVICES 256
+
+typedef struct {
+    gdsl_verify_phase_t phase;
+    int device_domain;
+    int snapshot_active;
+    uint32_t pass_depth;
+    uint32_t query_depth;
+} gdsl_verify_device_state_t;
+
+typedef struct {
+    uint64_t instruction_index;
+    uint64_t byte_offset;
+    /* Devices addressed so far (device 0 always). */
+    uint32_t device_mask[GDSL_VERIFY_CUT_DEVICES / 32];
+    gdsl_verify_device_state_t devices[GDSL_VERIFY_CUT_DEVICES];
+    uint8_t queues[GDSL_VERIFY_CUT_DEVICES];
+    uint8_t device;
+    gdsl_fold_registers_t registers;
+    /* IFs without their ENDIF yet, including ones nested too deep. */
+    uint64_t open_branches;
+} gdsl_verify_cut_t;
+
+typedef struct {
+    void *ctx;
+    /* An instruction on the selected device; operand as in verify.c (only
+     * decoded for sync, resource, binding and control opcodes). */
+    void (*instruction)(void *ctx, uint8_t opcode, uint64_t operand, uint8_t device);
+    /* The state before the instruction at cut_offsets[cut]. */
+    void (*cut)(void *ctx, size_t cut, const gdsl_verify_cut_t *state);
+} gdsl_verify_observer_t;
+
+/* gdsl_verify_ex with an observer. cut_offsets must be increasing
+ * instruction boundaries; returns -1 when one is not reached (bad offset or
+ * an early-exit limit) or the report could not be completed. */
+int gdsl_verify_cuts(const uint8_t *stream,
+                     size_t length,
+                     gdsl_verify_level_t level,
+                     const gdsl_verify_options_t *options,
+                     const uint64_t *cut_offsets,
+                     size_t cut_count,
+                     const gdsl_verify_observer_t *observer,
+                     gdsl_verify_report_t *report);
+
+#endif // GDSL_VERIFY_CUTS_INTERNAL_H
@@ -0,0 +1,29 @@
+#ifndef GDSL_VERIFY_RULES_INTERNAL_H
+#define GDSL_VERIFY_RULES_INTERNAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "gdsl/verify.h"
+
+/*
+ * The verifier's rules as a finite transition function over state keys
+ * (phase x domain x snapshot flag). Used by tools that derive tables from the
+ * rules instead of restating them.
+ */
+
+#define GDSL_VERIFY_STATE_KEYS 20
+
+size_t gdsl_verify_rules_initial(void);
+
+/* Applies a known opcode in state key at level: returns the next key and
+ * appends the diagnostics the instruction raises to report. */
+size_t gdsl_verify_rules_step(gdsl_verify_level_t level,
+                              size_t key,
+                              uint8_t opcode,
+                              gdsl_verify_report_t *report);
+
+/* Appends the end-of-stream diagnostics for a stream that ends in key. */
+void gdsl_verify_rules_finish(size_t key, gdsl_verify_report_t *report);
+
+#endif // GDSL_VERIFY_RULES_INTERNAL_H
@@ -0,0 +1,686 @@
+#define _GNU_SOURCE
+
+#include "gdsl/verifyd.h"
+
+#include "hash.h"
+
+#include <fcntl.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#define GDSL_VERIFYD_MAGIC 0x44565347u /* "GSVD" */
+#define GDSL_VERIFYD_VERSION 1u
+#define GDSL_VERIFYD_ALIGN 64u
+#define GDSL_VERIFYD_DEFAULT_CACHE 4096u
+#define GDSL_VERIFYD_DEFAULT_SPIN 20000u
+#define GDSL_VERIFYD_CLIENT_SPIN 20000u
+#define GDSL_VERIFYD_MAX_BATCH 64u
+#define GDSL_VERIFYD_WAIT_NS 50000000L
+
+enum {
+    GDSL_VERIFYD_SLOT_FREE = 0,
+    GDSL_VERIFYD_SLOT_CLAIMED = 1,
+    GDSL_VERIFYD_SLOT_SUBMITTED = 2,
+    GDSL_VERIFYD_SLOT_DONE = 3,
+    /* Taken by the server; the client can no longer withdraw it. */
+    GDSL_VERIFYD_SLOT_RUNNING = 4,
+    /* Given up by its client on stop. The ring entry is still queued; the
+     * server frees the slot when it pops it. */
+    GDSL_VERIFYD_SLOT_WITHDRAWN = 5
+};
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slot_count;
+    uint32_t slot_data_size;
+    uint64_t slot_stride;
+    uint64_t cells_offset;
+    uint64_t slots_offset;
+    uint32_t stop;
+    uint32_t next_claim;
+    /* Polls a client makes before sleeping; set by the server, 0 on
+     * single-CPU hosts where spinning only delays the server. */
+    uint32_t client_spin;
+    uint8_t pad0[GDSL_VERIFYD_ALIGN - 52];
+    /* Producer side of the ring, on its own cache line. */
+    uint64_t enqueue_pos;
+    uint8_t pad1[GDSL_VERIFYD_ALIGN - 8];
+    /* Consumer side: ring head plus the server's doorbell futex. */
+    uint64_t dequeue_pos;
+    uint32_t doorbell;
+    uint32_t server_sleeping;
+    uint8_t pad2[GDSL_VERIFYD_ALIGN - 16];
+} gdsl_verifyd_header_t;
+
+/* Vyukov bounded queue cell. */
+typedef struct {
+    uint64_t sequence;
+    uint64_t slot;
+} gdsl_verifyd_cell_t;
+
+typedef struct {
+    uint32_t state;
+    uint32_t client_waiting;
+    uint32_t level;
+    uint32_t reserved;
+    uint64_t length;
+    gdsl_verifyd_report_t report;
+} gdsl_verifyd_slot_header_t;
+
+typedef struct {
+    gdsl_hash128_t hash;
+    uint64_t length;
+    uint32_t level;
+    uint32_t valid;
+    gdsl_verifyd_report_t report;
+} gdsl_verifyd_cache_entry_t;
+
+struct gdsl_verifyd_server {
+    gdsl_verifyd_header_t *header;
+    gdsl_pool_t *pool;
+    uint32_t spin_iterations;
+    gdsl_verifyd_cache_entry_t *cache;
+    size_t cache_mask;
+    gdsl_verify_report_t *scratch;
+    /* One slot_data_size copy per pool worker. */
+    uint8_t *copies;
+};
+
+typedef struct {
+    uint32_t slot;
+    gdsl_hash128_t hash;
+    int hit;
+    /* Read once from the slot; the client can still write the shared copy. */
+    uint64_t length;
+    uint32_t level;
+    gdsl_verifyd_report_t report;
+} gdsl_verifyd_job_t;
+
+typedef struct {
+    gdsl_verifyd_server_t *server;
+    gdsl_verifyd_job_t *jobs;
+} gdsl_verifyd_batch_t;
+
+static size_t align_up(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+static uint32_t round_pow2(uint32_t value) {
+    uint32_t result = 1;
+    while (result < value && result < (1u << 31)) {
+        result <<= 1;
+    }
+    return result;
+}
+
+static void cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+/* Process-shared futex helpers; other platforms fall back to short sleeps. */
+static void futex_wait(uint32_t *word, uint32_t expected) {
+#if defined(__linux__)
+    struct timespec timeout = {0, GDSL_VERIFYD_WAIT_NS};
+    syscall(SYS_futex, word, FUTEX_WAIT, expected, &timeout, NULL, 0);
+#else
+    (void)word;
+    (void)expected;
+    struct timespec pause = {0, 100000L};
+    nanosleep(&pause, NULL);
+#endif
+}
+
+static void futex_wake(uint32_t *word) {
+#if defined(__linux__)
+    syscall(SYS_futex, word, FUTEX_WAKE, 1, NULL, NULL, 0);
+#else
+    (void)word;
+#endif
+}
+
+static gdsl_verifyd_cell_t *region_cells(gdsl_verifyd_header_t *header) {
+    return (gdsl_verifyd_cell_t *)((uint8_t *)header + header->cells_offset);
+}
+
+static gdsl_verifyd_slot_header_t *region_slot(gdsl_verifyd_header_t *header,
+                                               uint32_t slot) {
+    return (gdsl_verifyd_slot_header_t *)((uint8_t *)header +
+                                          header->slots_offset +
+                                          slot * header->slot_stride);
+}
+
+static uint8_t *slot_data(gdsl_verifyd_slot_header_t *slot) {
+    return (uint8_t *)slot +
+           align_up(sizeof(gdsl_verifyd_slot_header_t), GDSL_VERIFYD_ALIGN);
+}
+
+static gdsl_verifyd_header_t *checked_header(void *region) {
+    gdsl_verifyd_header_t *header = (gdsl_verifyd_header_t *)region;
+    if (!header || header->magic != GDSL_VERIFYD_MAGIC ||
+        header->version != GDSL_VERIFYD_VERSION) {
+        return NULL;
+    }
+    return header;
+}
+
+size_t gdsl_verifyd_region_size(uint32_t slot_count, uint32_t slot_data_size) {
+    if (slot_count == 0) {
+        return 0;
+    }
+    size_t slots = round_pow2(slot_count);
+    size_t stride = align_up(sizeof(gdsl_verifyd_slot_header_t), GDSL_VERIFYD_ALIGN) +
+                    align_up(slot_data_size, GDSL_VERIFYD_ALIGN);
+    size_t cells = align_up(slots * sizeof(gdsl_verifyd_cell_t), GDSL_VERIFYD_ALIGN);
+    return sizeof(gdsl_verifyd_header_t) + cells + slots * stride;
+}
+
+int gdsl_verifyd_region_init(void *region,
+                             size_t region_size,
+                             uint32_t slot_count,
+                             uint32_t slot_data_size) {
+    size_t needed = gdsl_verifyd_region_size(slot_count, slot_data_size);
+    if (!region || needed == 0 || region_size < needed) {
+        return -1;
+    }
+
+    memset(region, 0, needed);
+    gdsl_verifyd_header_t *header = (gdsl_verifyd_header_t *)region;
+    uint32_t slots = round_pow2(slot_count);
+    header->slot_count = slots;
+    header->slot_data_size = slot_data_size;
+    header->slot_stride =
+        align_up(sizeof(gdsl_verifyd_slot_header_t), GDSL_VERIFYD_ALIGN) +
+        align_up(slot_data_size, GDSL_VERIFYD_ALIGN);
+    header->cells_offset = sizeof(gdsl_verifyd_header_t);
+    header->slots_offset = header->cells_offset +
+                           align_up(slots * sizeof(gdsl_verifyd_cell_t),
+                                    GDSL_VERIFYD_ALIGN);
+
+    gdsl_verifyd_cell_t *cells = region_cells(header);
+    for (uint32_t i = 0; i < slots; ++i) {
+        cells[i].sequence = i;
+    }
+
+    header->version = GDSL_VERIFYD_VERSION;
+    __atomic_store_n(&header->magic, GDSL_VERIFYD_MAGIC, __ATOMIC_RELEASE);
+    return 0;
+}
+
+int gdsl_verifyd_map(const char *name,
+                     int create,
+                     uint32_t slot_count,
+                     uint32_t slot_data_size,
+                     void **out_region,
+                     size_t *out_size) {
+    if (!name || !out_region || !out_size) {
+        return -1;
+    }
+    *out_region = NULL;
+    *out_size = 0;
+
+    int fd = shm_open(name, O_RDWR | (create ? O_CREAT : 0), 0600);
+    if (fd < 0) {
+        return -1;
+    }
+
+    size_t size = 0;
+    if (create) {
+        size = gdsl_verifyd_region_size(slot_count, slot_data_size);
+        if (size == 0 || ftruncate(fd, (off_t)size) != 0) {
+            close(fd);
+            return -1;
+        }
+    } else {
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(gdsl_verifyd_header_t)) {
+            close(fd);
+            return -1;
+        }
+        size = (size_t)st.st_size;
+    }
+
+    void *region = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (region == MAP_FAILED) {
+        return -1;
+    }
+
+    if (create) {
+        if (gdsl_verifyd_region_init(region, size, slot_count, slot_data_size) != 0) {
+            munmap(region, size);
+            return -1;
+        }
+    } else {
+        gdsl_verifyd_header_t *header = checked_header(region);
+        if (!header ||
+            gdsl_verifyd_region_size(header->slot_count, header->slot_data_size) >
+                size) {
+            munmap(region, size);
+            return -1;
+        }
+    }
+
+    *out_region = region;
+    *out_size = size;
+    return 0;
+}
+
+void gdsl_verifyd_unmap(void *region, size_t region_size) {
+    if (region && region_size > 0) {
+        munmap(region, region_size);
+    }
+}
+
+static int ring_push(gdsl_verifyd_header_t *header, uint32_t slot) {
+    gdsl_verifyd_cell_t *cells = region_cells(header);
+    uint64_t mask = header->slot_count - 1;
+    uint64_t pos = __atomic_load_n(&header->enqueue_pos, __ATOMIC_RELAXED);
+
+    for (;;) {
+        gdsl_verifyd_cell_t *cell = &cells[pos & mask];
+        uint64_t seq = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+        int64_t diff = (int64_t)(seq - pos);
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&header->enqueue_pos, &pos, pos + 1, 1,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                cell->slot = slot;
+                __atomic_store_n(&cell->sequence, pos + 1, __ATOMIC_RELEASE);
+                return 0;
+            }
+        } else if (diff < 0) {
+            return -1;
+        } else {
+            pos = __atomic_load_n(&header->enqueue_pos, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+/* Single consumer: only the server dequeues. */
+static int ring_pop(gdsl_verifyd_header_t *header, uint32_t *slot) {
+    gdsl_verifyd_cell_t *cells = region_cells(header);
+    uint64_t mask = header->slot_count - 1;
+    uint64_t pos = header->dequeue_pos;
+    gdsl_verifyd_cell_t *cell = &cells[pos & mask];
+    uint64_t seq = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+    if (seq != pos + 1) {
+        return -1;
+    }
+    *slot = (uint32_t)cell->slot;
+    __atomic_store_n(&header->dequeue_pos, pos + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&cell->sequence, pos + mask + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+static int ring_empty(gdsl_verifyd_header_t *header) {
+    gdsl_verifyd_cell_t *cells = region_cells(header);
+    uint64_t pos = header->dequeue_pos;
+    gdsl_verifyd_cell_t *cell = &cells[pos & (header->slot_count - 1)];
+    return __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE) != pos + 1;
+}
+
+/* ---- server ---- */
+
+int gdsl_verifyd_server_create(void *region,
+                               const gdsl_verifyd_server_options_t *options,
+                               gdsl_verifyd_server_t **out_server) {
+    if (!out_server) {
+        return -1;
+    }
+    *out_server = NULL;
+
+    gdsl_verifyd_header_t *header = checked_header(region);
+    if (!header) {
+        return -1;
+    }
+
+    gdsl_verifyd_server_t *server =
+        (gdsl_verifyd_server_t *)calloc(1, sizeof(*server));
+    if (!server) {
+        return -1;
+    }
+
+    size_t entries = GDSL_VERIFYD_DEFAULT_CACHE;
+    if (options && options->cache_entries > 0) {
+        entries = round_pow2(options->cache_entries > (1u << 30)
+                                 ? (1u << 30)
+                                 : (uint32_t)options->cache_entries);
+    }
+    server->header = header;
+    server->pool = options ? options->pool : NULL;
+    int multi_cpu = sysconf(_SC_NPROCESSORS_ONLN) > 1;
+    server->spin_iterations = (options && options->spin_iterations)
+                                  ? options->spin_iterations
+                                  : (multi_cpu ? GDSL_VERIFYD_DEFAULT_SPIN : 0);
+    __atomic_store_n(&header->client_spin,
+                     multi_cpu ? GDSL_VERIFYD_CLIENT_SPIN : 0, __ATOMIC_RELAXED);
+    server->cache_mask = entries - 1;
+    server->cache = (gdsl_verifyd_cache_entry_t *)calloc(
+        entries, sizeof(gdsl_verifyd_cache_entry_t));
+    size_t workers = gdsl_pool_thread_count(server->pool);
+    server->scratch = (gdsl_verify_report_t *)malloc(workers * sizeof(gdsl_verify_report_t));
+    server->copies = (uint8_t *)malloc(workers * (size_t)header->slot_data_size + 1);
+    if (!server->cache || !server->scratch || !server->copies) {
+        gdsl_verifyd_server_destroy(server);
+        return -1;
+    }
+
+    *out_server = server;
+    return 0;
+}
+
+void gdsl_verifyd_server_destroy(gdsl_verifyd_server_t *server) {
+    if (!server) {
+        return;
+    }
+    free(server->cache);
+    free(server->scratch);
+    free(server->copies);
+    free(server);
+}
+
+static void compact_report(const gdsl_verify_report_t *full,
+                           gdsl_verifyd_report_t *out) {
+    memset(out, 0, sizeof(*out));
+    out->success = full->success;
+    out->instruction_count = full->instruction_count;
+    out->error_count = full->error_count;
+    out->warning_count = full->warning_count;
+    out->info_count = full->info_count;
+    out->diagnostic_count = full->diagnostic_count;
+    for (size_t i = 0; i < full->diagnostic_count; ++i) {
+        const gdsl_verify_diagnostic_t *diag = &full->diagnostics[i];
+        if (diag->severity == GDSL_VERIFY_SEVERITY_ERROR) {
+            out->first_error_index = diag->instruction_index;
+            strncpy(out->first_error, diag->message, GDSL_VERIFYD_MESSAGE - 1);
+            break;
+        }
+    }
+}
+
+static gdsl_verifyd_cache_entry_t *cache_lookup(gdsl_verifyd_server_t *server,
+                                                gdsl_hash128_t hash,
+                                                uint64_t length,
+                                                uint32_t level) {
+    gdsl_verifyd_cache_entry_t *entry =
+        &server->cache[(hash.lo ^ level) & server->cache_mask];
+    if (entry->valid && entry->hash.lo == hash.lo && entry->hash.hi == hash.hi &&
+        entry->length == length && entry->level == level) {
+        return entry;
+    }
+    return NULL;
+}
+
+static void serve_range(void *ctx, size_t begin, size_t end, size_t worker) {
+    gdsl_verifyd_batch_t *batch = (gdsl_verifyd_batch_t *)ctx;
+    gdsl_verifyd_server_t *server = batch->server;
+    size_t capacity = server->header->slot_data_size;
+
+    for (size_t i = begin; i < end; ++i) {
+        gdsl_verifyd_job_t *job = &batch->jobs[i];
+        gdsl_verifyd_slot_header_t *slot = region_slot(server->header, job->slot);
+        gdsl_verifyd_report_t *report = &job->report;
+        job->length = __atomic_load_n(&slot->length, __ATOMIC_RELAXED);
+        job->level = __atomic_load_n(&slot->level, __ATOMIC_RELAXED);
+
+        if (job->length > capacity || job->level > GDSL_VERIFY_LEVEL_DOMAIN) {
+            memset(report, 0, sizeof(*report));
+            report->error_count = 1;
+            strncpy(report->first_error, "invalid submission",
+                    GDSL_VERIFYD_MESSAGE - 1);
+            job->hit = 1;
+            continue;
+        }
+
+        /* Hash and verify a private copy: a client that keeps writing its
+         * slot must not get a verdict cached under another stream's hash. */
+        uint8_t *data = server->copies + worker * capacity;
+        size_t length = (size_t)job->length;
+        if (length > 0) {
+            memcpy(data, slot_data(slot), length);
+        }
+        job->hash = gdsl_hash128(data, length);
+        /* The cache is only written between batches, so concurrent lookups
+         * from pool workers are safe. */
+        gdsl_verifyd_cache_entry_t *entry =
+            cache_lookup(server, job->hash, job->length, job->level);
+        if (entry) {
+            *report = entry->report;
+            report->flags |= GDSL_VERIFYD_REPORT_CACHED;
+            job->hit = 1;
+            continue;
+        }
+
+        gdsl_verify_report_t *full = &server->scratch[worker];
+        gdsl_verify(data, length, (gdsl_verify_level_t)job->level, full);
+        compact_report(full, report);
+        job->hit = 0;
+    }
+}
+
+size_t gdsl_verifyd_server_poll(gdsl_verifyd_server_t *server) {
+    if (!server) {
+        return 0;
+    }
+    gdsl_verifyd_header_t *header = server->header;
+
+    gdsl_verifyd_job_t jobs[GDSL_VERIFYD_MAX_BATCH];
+    size_t count = 0;
+    uint32_t slot = 0;
+    while (count < GDSL_VERIFYD_MAX_BATCH && ring_pop(header, &slot) == 0) {
+        if (slot >= header->slot_count) {
+            continue;
+        }
+        /* A client that gave up on stop left its slot withdrawn. Popping
+         * its ring entry is what frees the slot, so a slot is never queued
+         * twice. */
+        uint32_t *state = &region_slot(header, slot)->state;
+        uint32_t expected = GDSL_VERIFYD_SLOT_SUBMITTED;
+        if (!__atomic_compare_exchange_n(state, &expected, GDSL_VERIFYD_SLOT_RUNNING, 0,
+                                         __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+            if (expected == GDSL_VERIFYD_SLOT_WITHDRAWN) {
+                __atomic_store_n(state, GDSL_VERIFYD_SLOT_FREE, __ATOMIC_RELEASE);
+            }
+            continue;
+        }
+        jobs[count].slot = slot;
+        jobs[count].hit = 0;
+        count++;
+    }
+    if (count == 0) {
+        return 0;
+    }
+
+    gdsl_verifyd_batch_t batch = {server, jobs};
+    gdsl_pool_parallel_for(server->pool, 0, count, 1, serve_range, &batch);
+
+    for (size_t i = 0; i < count; ++i) {
+        gdsl_verifyd_slot_header_t *entry_slot = region_slot(header, jobs[i].slot);
+        if (!jobs[i].hit) {
+            gdsl_verifyd_cache_entry_t *entry =
+                &server->cache[(jobs[i].hash.lo ^ jobs[i].level) & server->cache_mask];
+            entry->hash = jobs[i].hash;
+            entry->length = jobs[i].length;
+            entry->level = jobs[i].level;
+            entry->report = jobs[i].report;
+            entry->valid = 1;
+        }
+        entry_slot->report = jobs[i].report;
+
+        __atomic_store_n(&entry_slot->state, GDSL_VERIFYD_SLOT_DONE,
+                         __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&entry_slot->client_waiting, __ATOMIC_SEQ_CST)) {
+            futex_wake(&entry_slot->state);
+        }
+    }
+    return count;
+}
+
+int gdsl_verifyd_server_run(gdsl_verifyd_server_t *server) {
+    if (!server) {
+        return -1;
+    }
+    gdsl_verifyd_header_t *header = server->header;
+
+    while (!__atomic_load_n(&header->stop, __ATOMIC_ACQUIRE)) {
+        if (gdsl_verifyd_server_poll(server) > 0) {
+            continue;
+        }
+
+        uint32_t spins = 0;
+        while (ring_empty(header) && spins < server->spin_iterations) {
+            cpu_relax();
+            spins++;
+        }
+        if (!ring_empty(header)) {
+            continue;
+        }
+
+        uint32_t seen = __atomic_load_n(&header->doorbell, __ATOMIC_SEQ_CST);
+        __atomic_store_n(&header->server_sleeping, 1, __ATOMIC_SEQ_CST);
+        if (ring_empty(header) && !__atomic_load_n(&header->stop, __ATOMIC_ACQUIRE)) {
+            futex_wait(&header->doorbell, seen);
+        }
+        __atomic_store_n(&header->server_sleeping, 0, __ATOMIC_SEQ_CST);
+    }
+    return 0;
+}
+
+void gdsl_verifyd_request_stop(void *region) {
+    gdsl_verifyd_header_t *header = checked_header(region);
+    if (!header) {
+        return;
+    }
+    __atomic_store_n(&header->stop, 1, __ATOMIC_RELEASE);
+    __atomic_add_fetch(&header->doorbell, 1, __ATOMIC_SEQ_CST);
+    futex_wake(&header->doorbell);
+}
+
+/* ---- client ---- */
+
+int gdsl_verifyd_acquire(void *region, size_t length, gdsl_verifyd_slot_t *out) {
+    gdsl_verifyd_header_t *header = checked_header(region);
+    if (!header || !out || length > header->slot_data_size) {
+        return -1;
+    }
+
+    uint32_t count = header->slot_count;
+    for (;;) {
+        if (__atomic_load_n(&header->stop, __ATOMIC_ACQUIRE)) {
+            return -1;
+        }
+        uint32_t start = __atomic_fetch_add(&header->next_claim, 1, __ATOMIC_RELAXED);
+        for (uint32_t i = 0; i < count; ++i) {
+            uint32_t index = (start + i) & (count - 1);
+            gdsl_verifyd_slot_header_t *slot = region_slot(header, index);
+            uint32_t expected = GDSL_VERIFYD_SLOT_FREE;
+            if (__atomic_compare_exchange_n(&slot->state, &expected,
+                                            GDSL_VERIFYD_SLOT_CLAIMED, 0,
+                                            __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+                out->region = region;
+                out->slot = index;
+                out->data = slot_data(slot);
+                out->capacity = header->slot_data_size;
+                return 0;
+            }
+        }
+        sched_yield();
+    }
+}
+
+int gdsl_verifyd_submit(gdsl_verifyd_slot_t *handle,
+                        size_t length,
+                        gdsl_verify_level_t level,
+                        gdsl_verifyd_report_t *report) {
+    if (!handle || !report) {
+        return -1;
+    }
+    gdsl_verifyd_header_t *header = checked_header(handle->region);
+    if (!header || handle->slot >= header->slot_count) {
+        return -1;
+    }
+    gdsl_verifyd_slot_header_t *slot = region_slot(header, handle->slot);
+    if (length > handle->capacity) {
+        __atomic_store_n(&slot->state, GDSL_VERIFYD_SLOT_FREE, __ATOMIC_RELEASE);
+        return -1;
+    }
+
+    slot->length = length;
+    slot->level = (uint32_t)level;
+    slot->client_waiting = 0;
+    __atomic_store_n(&slot->state, GDSL_VERIFYD_SLOT_SUBMITTED, __ATOMIC_RELEASE);
+
+    /* A slot is queued at most once: a withdrawn slot only becomes free
+     * again when the server pops its entry. The ring has slot_count cells,
+     * so it cannot fill. */
+    if (ring_push(header, handle->slot) != 0) {
+        __atomic_store_n(&slot->state, GDSL_VERIFYD_SLOT_FREE, __ATOMIC_RELEASE);
+        return -1;
+    }
+    __atomic_add_fetch(&header->doorbell, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&header->server_sleeping, __ATOMIC_SEQ_CST)) {
+        futex_wake(&header->doorbell);
+    }
+
+    uint32_t spin_limit = __atomic_load_n(&header->client_spin, __ATOMIC_RELAXED);
+    uint32_t spins = 0;
+    while (__atomic_load_n(&slot->state, __ATOMIC_ACQUIRE) !=
+           GDSL_VERIFYD_SLOT_DONE) {
+        if (spins < spin_limit) {
+            cpu_relax();
+            spins++;
+            continue;
+        }
+        if (__atomic_load_n(&header->stop, __ATOMIC_ACQUIRE)) {
+            /* Withdraw the submission unless the server has already taken
+             * it; a taken slot is finished and its report consumed below.
+             * The server frees a withdrawn slot when it pops the entry. */
+            uint32_t expected = GDSL_VERIFYD_SLOT_SUBMITTED;
+            if (__atomic_compare_exchange_n(&slot->state, &expected,
+                                            GDSL_VERIFYD_SLOT_WITHDRAWN, 0,
+                                            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                return -1;
+            }
+        }
+        __atomic_store_n(&slot->client_waiting, 1, __ATOMIC_SEQ_CST);
+        uint32_t state = __atomic_load_n(&slot->state, __ATOMIC_SEQ_CST);
+        if (state == GDSL_VERIFYD_SLOT_SUBMITTED || state == GDSL_VERIFYD_SLOT_RUNNING) {
+            futex_wait(&slot->state, state);
+        }
+    }
+
+    *report = slot->report;
+    __atomic_store_n(&slot->state, GDSL_VERIFYD_SLOT_FREE, __ATOMIC_RELEASE);
+    return 0;
+}
+
+int gdsl_verifyd_verify(void *region,
+                        const uint8_t *stream,
+                        size_t length,
+                        gdsl_verify_level_t level,
+                        gdsl_verifyd_report_t *report) {
+    if ((!stream && length > 0) || !report) {
+        return -1;
+    }
+
+    gdsl_verifyd_slot_t slot;
+    if (gdsl_verifyd_acquire(region, length, &slot) != 0) {
+        return -1;
+    }
+    if (length > 0) {
+        memcpy(slot.data, stream, length);
+    }
+    return gdsl_verifyd_submit(&slot, length, level, report);
+}
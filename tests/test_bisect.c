@@ -0,0 +1,127 @@
+#include "gdsl/bisect.h"
+#include "gdsl/merkle.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    size_t divergent;
+    size_t probes;
+} probe_ctx_t;
+
+static int agree_before(void *ctx, size_t checkpoint) {
+    probe_ctx_t *probe = (probe_ctx_t *)ctx;
+    probe->probes++;
+    return checkpoint < probe->divergent;
+}
+
+static int failing_probe(void *ctx, size_t checkpoint) {
+    (void)ctx;
+    (void)checkpoint;
+    return -1;
+}
+
+static size_t ceil_log2(size_t n) {
+    size_t bits = 0;
+    while (((size_t)1 << bits) < n) {
+        bits++;
+    }
+    return bits;
+}
+
+static void test_bisect_checkpoints(void) {
+    for (size_t count = 0; count <= 70; ++count) {
+        for (size_t divergent = 0; divergent <= count; ++divergent) {
+            probe_ctx_t ctx = {divergent, 0};
+            size_t checkpoint = 0;
+            size_t probes = 0;
+            assert(gdsl_bisect_search(count, agree_before, &ctx, &checkpoint, &probes) == 0);
+            assert(checkpoint == (divergent == count ? GDSL_BISECT_NONE : divergent));
+            assert(probes == ctx.probes);
+            assert(probes <= ceil_log2(count + 1));
+        }
+    }
+    size_t checkpoint;
+    assert(gdsl_bisect_search(8, failing_probe, NULL, &checkpoint, NULL) == -1);
+    assert(gdsl_bisect_search(8, NULL, NULL, &checkpoint, NULL) == -1);
+
+    /* Recorded roots: the runs split at checkpoint 6 and stay apart. */
+    gdsl_merkle_hash_t a[10];
+    gdsl_merkle_hash_t b[10];
+    for (size_t i = 0; i < 10; ++i) {
+        a[i].lo = i * 11;
+        a[i].hi = i;
+        b[i] = a[i];
+        if (i >= 6) {
+            b[i].hi ^= 0x80;
+        }
+    }
+    assert(gdsl_bisect_checkpoints(a, b, 10, &checkpoint) == 0);
+    assert(checkpoint == 6);
+    assert(gdsl_bisect_checkpoints(a, a, 10, &checkpoint) == 0);
+    assert(checkpoint == GDSL_BISECT_NONE);
+    assert(gdsl_bisect_checkpoints(NULL, b, 10, &checkpoint) == -1);
+}
+
+static void test_bisect_pages(void) {
+    /* 13 pages, the last one short, so the tree has carried nodes. */
+    const size_t length = 12 * 4096 + 300;
+    uint8_t *heap_a = (uint8_t *)malloc(length);
+    uint8_t *heap_b = (uint8_t *)malloc(length);
+    for (size_t i = 0; i < length; ++i) {
+        heap_a[i] = (uint8_t)(i * 13 + 1);
+    }
+    memcpy(heap_b, heap_a, length);
+    heap_b[0] ^= 1;
+    heap_b[7 * 4096 + 4095] ^= 1;
+    heap_b[12 * 4096 + 299] ^= 1;
+
+    gdsl_merkle_tree_t a;
+    gdsl_merkle_tree_t b;
+    assert(gdsl_merkle_build(heap_a, length, 0, NULL, &a) == 0);
+    assert(gdsl_merkle_build(heap_b, length, 0, NULL, &b) == 0);
+    size_t pages[16];
+    size_t count = 0;
+    assert(gdsl_bisect_pages(&a, &b, pages, 16, &count) == 0);
+    assert(count == 3);
+    assert(pages[0] == 0 && pages[1] == 7 && pages[2] == 12);
+
+    /* Counting only, and too small an output. */
+    assert(gdsl_bisect_pages(&a, &b, NULL, 0, &count) == 0);
+    assert(count == 3);
+    assert(gdsl_bisect_pages(&a, &b, pages, 2, &count) == -1);
+    assert(count == 3);
+    assert(gdsl_bisect_pages(&a, &a, pages, 16, &count) == 0);
+    assert(count == 0);
+    gdsl_merkle_destroy(&b);
+
+    /* A heap that grew: the new pages differ as well. */
+    uint8_t *longer = (uint8_t *)malloc(length + 2 * 4096);
+    memcpy(longer, heap_a, length);
+    memset(longer + length, 0, 2 * 4096);
+    longer[3 * 4096] ^= 1;
+    assert(gdsl_merkle_build(longer, length + 2 * 4096, 0, NULL, &b) == 0);
+    assert(gdsl_bisect_pages(&a, &b, pages, 16, &count) == 0);
+    assert(count == 4);
+    assert(pages[0] == 3 && pages[1] == 12 && pages[2] == 13 && pages[3] == 14);
+    gdsl_merkle_destroy(&b);
+
+    /* Trees of different page sizes cannot be compared. */
+    assert(gdsl_merkle_build(heap_b, length, 1024, NULL, &b) == 0);
+    assert(gdsl_bisect_pages(&a, &b, pages, 16, &count) == -1);
+    gdsl_merkle_destroy(&b);
+
+    gdsl_merkle_destroy(&a);
+    free(longer);
+    free(heap_b);
+    free(heap_a);
+}
+
+int main(void) {
+    test_bisect_checkpoints();
+    test_bisect_pages();
+    puts("All bisect tests completed.");
+    return 0;
+}
@@ -0,0 +1,100 @@
+#include "gdsl/codegen.h"
+#include "gdsl/verify.h"
+
+#include "loader_verify.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Opcodes the build-time generated loader verifier was specialised to. */
+static const uint8_t loader_opcodes[] = {0x00, 0x01, 0x02, 0x03, 0x04,
+                                         0x05, 0x06, 0x07, 0x08};
+
+static void compare(const uint8_t *stream, size_t length) {
+    static gdsl_verify_report_t report;
+    loader_verify_result_t result;
+
+    int rc = gdsl_verify(stream, length, GDSL_VERIFY_LEVEL_DOMAIN, &report);
+    assert(rc == 0);
+    rc = loader_verify(stream, length, &result);
+    assert(rc == 0);
+
+    assert(result.success == report.success);
+    assert(result.instruction_count == report.instruction_count);
+    assert(result.error_count == report.error_count);
+    assert(result.warning_count == report.warning_count);
+    if (report.error_count > 0) {
+        const gdsl_verify_diagnostic_t *first = NULL;
+        for (size_t i = 0; i < report.diagnostic_count; ++i) {
+            if (report.diagnostics[i].severity == GDSL_VERIFY_SEVERITY_ERROR) {
+                first = &report.diagnostics[i];
+                break;
+            }
+        }
+        assert(first);
+        assert(result.first_error_index == first->instruction_index);
+        assert(result.first_error);
+    }
+}
+
+static void test_generated_matches_library(void) {
+    const uint8_t good[] = {0x01, 0x02, 0x03, 0x04, 0x07, 0x08, 0x05, 0x06};
+    compare(good, sizeof(good));
+
+    loader_verify_result_t result;
+    assert(loader_verify(good, sizeof(good), &result) == 0);
+    assert(result.success);
+    assert(loader_verify(NULL, 1, &result) == -1);
+
+    /* Random streams over the subset plus one byte outside it. */
+    uint32_t seed = 7;
+    uint8_t stream[48];
+    for (int round = 0; round < 20000; ++round) {
+        size_t length = (size_t)(round % (int)sizeof(stream));
+        for (size_t i = 0; i < length; ++i) {
+            seed = seed * 1664525u + 1013904223u;
+            unsigned pick = (seed >> 24) % (sizeof(loader_opcodes) + 1);
+            stream[i] = pick < sizeof(loader_opcodes) ? loader_opcodes[pick] : 0xFF;
+        }
+        compare(stream, length);
+    }
+}
+
+static void test_generator_rejects_bad_input(void) {
+    FILE *sink = tmpfile();
+    assert(sink);
+
+    uint8_t opcodes[] = {0x01, 0xFF};
+    gdsl_codegen_options_t options;
+    memset(&options, 0, sizeof(options));
+    options.level = GDSL_VERIFY_LEVEL_PHASE;
+    options.opcodes = opcodes;
+    options.opcode_count = 2;
+    options.prefix = "tiny";
+    assert(gdsl_codegen_verifier(&options, sink, NULL) == -1); /* 0xFF */
+    opcodes[1] = (uint8_t)gdsl_codegen_opcode("SEMAPHORE_WAIT");
+    assert(gdsl_codegen_verifier(&options, sink, NULL) == -1); /* needs more than a table */
+    opcodes[1] = (uint8_t)gdsl_codegen_opcode("DRAW");
+    assert(gdsl_codegen_verifier(&options, sink, NULL) == -1);
+
+    options.opcode_count = 1;
+    options.prefix = "1bad";
+    assert(gdsl_codegen_verifier(&options, sink, NULL) == -1);
+
+    options.prefix = "tiny";
+    assert(gdsl_codegen_verifier(&options, sink, NULL) == 0);
+    assert(ftell(sink) > 0);
+
+    assert(gdsl_codegen_opcode("SNAPSHOT_BEGIN") == 0x07);
+    assert(gdsl_codegen_opcode("DRAW_EVERYTHING") == -1);
+    fclose(sink);
+}
+
+int main(void) {
+    test_generated_matches_library();
+    test_generator_rejects_bad_input();
+    puts("All codegen tests completed.");
+    return 0;
+}
@@ -0,0 +1,121 @@
+#include "gdsl/gdsl.hpp"
+
+#include <array>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <memory_resource>
+#include <ranges>
+#include <vector>
+
+static void test_cpp_diff_roundtrip() {
+    std::vector<std::uint8_t> base(4096 * 8 + 100);
+    for (std::size_t i = 0; i < base.size(); ++i) {
+        base[i] = static_cast<std::uint8_t>(i * 7);
+    }
+    std::vector<std::uint8_t> target = base;
+    target[4096 * 3 + 5] ^= 1;
+    target[target.size() - 1] ^= 1;
+
+    gdsl::diff d;
+    assert(gdsl::make_diff(base, target, d) == 0);
+    assert(d.target_length() == target.size());
+    assert(d.raw_chunks().size() == 2);
+    assert(!d.has_references());
+
+    /* The view hands out payload bytes in place. */
+    std::size_t seen = 0;
+    for (gdsl::chunk_ref chunk : d.chunks()) {
+        assert(chunk.data.data() >= d.payload().data());
+        assert(std::memcmp(chunk.data.data(), target.data() + chunk.page_index() * 4096,
+                           chunk.data.size()) == 0);
+        seen++;
+    }
+    assert(seen == 2);
+    assert(std::ranges::distance(d.chunks()) == 2);
+    assert(d.chunks()[1].page_index() == 8);
+
+    /* Moving transfers the storage without copying it. */
+    const std::uint8_t *payload = d.payload().data();
+    gdsl::diff moved = std::move(d);
+    assert(moved.payload().data() == payload);
+    assert(d.payload().empty() && d.raw_chunks().empty());
+
+    gdsl::patched out;
+    assert(gdsl::patch(base, moved, out) == 0);
+    assert(out.size() == target.size());
+    assert(std::memcmp(out.span().data(), target.data(), target.size()) == 0);
+    gdsl::patched taken = std::move(out);
+    assert(taken.size() == target.size() && out.size() == 0);
+
+    gdsl_diff_stat_t stat;
+    assert(gdsl::diff_stat(base, target, stat) == 0);
+    assert(stat.chunk_count == 2 && stat.payload_bytes == moved.payload().size());
+
+    /* Adopting a C result leaves nothing behind to destroy twice. */
+    gdsl_diff_result_t raw;
+    assert(gdsl_diff(base.data(), base.size(), target.data(), target.size(), &raw) == 0);
+    const std::uint8_t *raw_payload = raw.payload;
+    gdsl::diff adopted(std::move(raw));
+    assert(adopted.payload().data() == raw_payload);
+    assert(adopted.raw_chunks().size() == 2);
+    assert(raw.payload == nullptr && raw.chunks == nullptr && raw.chunk_count == 0);
+    gdsl_diff_result_destroy(&raw);
+}
+
+static void test_cpp_multi_reference() {
+    std::vector<std::uint8_t> older(4096 * 4, 0x11);
+    std::vector<std::uint8_t> previous(4096 * 4, 0x22);
+    std::vector<std::uint8_t> target = older;
+    std::array<gdsl_diff_reference_t, 2> references = {gdsl::reference(previous),
+                                                       gdsl::reference(older)};
+    gdsl::diff d;
+    assert(gdsl::make_diff(references, target, d) == 0);
+    assert(d.has_references());
+    assert(d.payload().empty());
+    for (gdsl::chunk_ref chunk : d.chunks()) {
+        assert(chunk.reference() != 0 && chunk.data.empty());
+    }
+    gdsl::patched out;
+    assert(gdsl::patch(references, d, out) == 0);
+    assert(std::memcmp(out.span().data(), target.data(), target.size()) == 0);
+    assert(gdsl::patch(previous, d, out) == -1);
+}
+
+static void test_cpp_verify_report() {
+    /* Reports come from the caller's arena. */
+    std::array<std::byte, 2 * sizeof(gdsl_verify_report_t)> arena;
+    std::pmr::monotonic_buffer_resource resource(arena.data(), arena.size(),
+                                                 std::pmr::null_memory_resource());
+    gdsl::verify_report report(&resource);
+
+    const std::uint8_t good[] = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06};
+    assert(gdsl::verify(gdsl::bytes(good), GDSL_VERIFY_LEVEL_DOMAIN, report) == 0);
+    assert(report.success());
+    assert(report.instruction_count() == 6);
+
+    std::string_view bad("\x01\x03\x05", 3);
+    gdsl::verify_report failed(&resource);
+    assert(gdsl::verify(bad, GDSL_VERIFY_LEVEL_DOMAIN, failed) == 0);
+    assert(!failed.success());
+    std::size_t errors = 0;
+    for (const gdsl_verify_diagnostic_t &diagnostic :
+         failed.diagnostics(GDSL_VERIFY_SEVERITY_ERROR)) {
+        assert(!gdsl::message(diagnostic).empty());
+        errors++;
+    }
+    assert(errors > 0 && errors <= failed.diagnostics().size());
+
+    const gdsl_verify_report_t *raw = failed.get();
+    gdsl::verify_report kept = std::move(failed);
+    assert(kept.get() == raw);
+    assert(!kept.success());
+}
+
+int main() {
+    test_cpp_diff_roundtrip();
+    test_cpp_multi_reference();
+    test_cpp_verify_report();
+    std::puts("All C++ layer tests completed.");
+    return 0;
+}
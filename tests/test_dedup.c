@@ -0,0 +1,225 @@
+#include "gdsl/dedup.h"
+#include "gdsl/verify.h"
+
+#include "dedup_scan.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static uint32_t next_random(uint32_t *seed) {
+    *seed = *seed * 1103515245u + 12345u;
+    return *seed >> 16;
+}
+
+static int same_hash(const gdsl_stream_hash_t *a, const gdsl_stream_hash_t *b) {
+    return a->lo == b->lo && a->hi == b->hi;
+}
+
+/* Random one-byte opcodes (and the odd unknown byte) with debug instructions
+ * sprinkled in; plain receives the same stream without them. Some one-byte
+ * opcodes sit between the debug opcodes in value, where the vector scan has
+ * to reject them. */
+static size_t build_decorated(uint32_t *seed,
+                              size_t instructions,
+                              uint8_t *decorated,
+                              uint8_t *plain,
+                              size_t *plain_length) {
+    size_t n = 0;
+    size_t p = 0;
+    for (size_t i = 0; i < instructions; ++i) {
+        uint32_t pick = next_random(seed) % 20;
+        if (pick >= 16) {
+            static const uint8_t between[] = {0x1A, 0x1B, 0x29, 0x2A};
+            decorated[n++] = between[pick - 16];
+            plain[p++] = between[pick - 16];
+        } else if (pick < 10) {
+            decorated[n++] = (uint8_t)pick;
+            plain[p++] = (uint8_t)pick;
+        } else if (pick == 10) {
+            decorated[n++] = 0xFF;
+            plain[p++] = 0xFF;
+        } else if (pick == 11) {
+            decorated[n++] = 0x0C; /* MARKER_POP */
+        } else {
+            /* LABEL, MARKER_PUSH or LOG; operands may look like opcodes. */
+            static const uint8_t wide[] = {0x0A, 0x0B, 0x0D, 0x0A};
+            decorated[n++] = wide[pick - 12];
+            for (int b = 0; b < 4; ++b) {
+                decorated[n++] = (uint8_t)next_random(seed);
+            }
+        }
+    }
+    *plain_length = p;
+    return n;
+}
+
+static void test_canonical_hash(void) {
+    const uint8_t plain[] = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06};
+    const uint8_t labelled[] = {0x0A, 0x01, 0x00, 0x00, 0x00, /* LABEL 1 */
+                                0x01, 0x02,
+                                0x0B, 0x02, 0x00, 0x00, 0x00, /* MARKER_PUSH 2 */
+                                0x03, 0x04, 0x0C,             /* MARKER_POP */
+                                0x0D, 0x07, 0x00, 0x00, 0x00, /* LOG 7 */
+                                0x05, 0x06};
+    gdsl_stream_hash_t a;
+    gdsl_stream_hash_t b;
+    assert(gdsl_stream_hash(plain, sizeof(plain), &a) == 0);
+    assert(gdsl_stream_hash(labelled, sizeof(labelled), &b) == 0);
+    assert(same_hash(&a, &b));
+
+    /* Real instructions still count. */
+    const uint8_t reordered[] = {0x01, 0x03, 0x02, 0x04, 0x05, 0x06};
+    assert(gdsl_stream_hash(reordered, sizeof(reordered), &b) == 0);
+    assert(!same_hash(&a, &b));
+    assert(gdsl_stream_hash(plain, sizeof(plain) - 1, &b) == 0);
+    assert(!same_hash(&a, &b));
+
+    /* A debug instruction cut off by the end of the stream is kept. */
+    const uint8_t truncated[] = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x0A, 0x01};
+    assert(gdsl_stream_hash(truncated, sizeof(truncated), &b) == 0);
+    assert(!same_hash(&a, &b));
+
+    assert(gdsl_stream_hash(NULL, 0, &b) == 0);
+    assert(gdsl_stream_hash(NULL, 1, &b) == -1);
+}
+
+static void test_decorated_streams_match(void) {
+    enum { INSTRUCTIONS = 3000 };
+    uint8_t *decorated = (uint8_t *)malloc(INSTRUCTIONS * 5);
+    uint8_t *plain = (uint8_t *)malloc(INSTRUCTIONS);
+    assert(decorated && plain);
+    static gdsl_verify_report_t decorated_report;
+    static gdsl_verify_report_t plain_report;
+
+#if defined(__SSE2__)
+    /* The shipped opcode table must keep the sixteen-byte scan. */
+    assert(gdsl_stream_scan_vectorized());
+#endif
+
+    uint32_t seed = 4242;
+    for (int round = 0; round < 200; ++round) {
+        size_t instructions = 1 + next_random(&seed) % INSTRUCTIONS;
+        size_t plain_length = 0;
+        size_t length = build_decorated(&seed, instructions, decorated, plain,
+                                        &plain_length);
+
+        gdsl_stream_hash_t a;
+        gdsl_stream_hash_t b;
+        assert(gdsl_stream_hash(decorated, length, &a) == 0);
+        assert(gdsl_stream_hash(plain, plain_length, &b) == 0);
+        assert(same_hash(&a, &b));
+
+        /* Equal canonical hashes must mean equal verdicts. */
+        for (int level = GDSL_VERIFY_LEVEL_SYNTAX; level <= GDSL_VERIFY_LEVEL_DOMAIN;
+             ++level) {
+            gdsl_verify(decorated, length, (gdsl_verify_level_t)level,
+                        &decorated_report);
+            gdsl_verify(plain, plain_length, (gdsl_verify_level_t)level,
+                        &plain_report);
+            assert(decorated_report.success == plain_report.success);
+            assert(decorated_report.error_count == plain_report.error_count);
+            assert(decorated_report.warning_count == plain_report.warning_count);
+            assert(decorated_report.info_count == plain_report.info_count);
+        }
+    }
+
+    free(plain);
+    free(decorated);
+}
+
+static void test_index_pipeline(void) {
+    gdsl_dedup_index_t *index = NULL;
+    assert(gdsl_dedup_index_create(0, &index) == 0);
+
+    const uint8_t upload[] = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06};
+    const uint8_t renamed[] = {0x0A, 0x09, 0x00, 0x00, 0x00,
+                               0x01, 0x02, 0x03, 0x04, 0x05, 0x06};
+
+    gdsl_dedup_entry_t entry;
+    assert(gdsl_dedup_admit(index, upload, sizeof(upload), 100, &entry) == 0);
+    assert(entry.stream_id == 100);
+    assert(entry.diff_base_id == GDSL_DEDUP_NONE);
+    assert(entry.verified_levels == 0);
+
+    gdsl_dedup_certificate_t certificate;
+    assert(gdsl_dedup_verify(index, &entry.hash, upload, sizeof(upload),
+                             GDSL_VERIFY_LEVEL_DOMAIN, &certificate) == 0);
+    assert(certificate.success);
+    assert(gdsl_dedup_set_diff_base(index, &entry.hash, 7) == 0);
+
+    /* The same recording under another label is a duplicate: nothing to
+     * store, verify or diff. The stream pointer is not even read. */
+    gdsl_dedup_entry_t duplicate;
+    assert(gdsl_dedup_admit(index, renamed, sizeof(renamed), 101, &duplicate) == 1);
+    assert(duplicate.stream_id == 100);
+    assert(duplicate.diff_base_id == 7);
+    assert(duplicate.verified_levels == (1u << GDSL_VERIFY_LEVEL_DOMAIN));
+    memset(&certificate, 0, sizeof(certificate));
+    assert(gdsl_dedup_verify(index, &duplicate.hash, NULL, 0,
+                             GDSL_VERIFY_LEVEL_DOMAIN, &certificate) == 1);
+    assert(certificate.success);
+
+    /* Other levels are certified separately. */
+    assert(gdsl_dedup_verify(index, &duplicate.hash, renamed, sizeof(renamed),
+                             GDSL_VERIFY_LEVEL_PHASE, &certificate) == 0);
+    assert(gdsl_dedup_lookup(index, &duplicate.hash, &entry) == 1);
+    assert(entry.verified_levels == ((1u << GDSL_VERIFY_LEVEL_DOMAIN) |
+                                     (1u << GDSL_VERIFY_LEVEL_PHASE)));
+
+    /* A failing stream keeps its failing certificate. */
+    const uint8_t broken[] = {0x03, 0x05};
+    assert(gdsl_dedup_admit(index, broken, sizeof(broken), 102, &entry) == 0);
+    assert(gdsl_dedup_verify(index, &entry.hash, broken, sizeof(broken),
+                             GDSL_VERIFY_LEVEL_PHASE, &certificate) == 0);
+    assert(!certificate.success);
+    assert(certificate.error_count > 0);
+    assert(gdsl_dedup_verify(index, &entry.hash, NULL, 0,
+                             GDSL_VERIFY_LEVEL_PHASE, &certificate) == 1);
+    assert(!certificate.success);
+
+    gdsl_stream_hash_t unknown = {1, 2};
+    assert(gdsl_dedup_lookup(index, &unknown, &entry) == 0);
+    assert(gdsl_dedup_set_diff_base(index, &unknown, 1) == -1);
+    assert(gdsl_dedup_index_count(index) == 2);
+
+    gdsl_dedup_index_destroy(index);
+}
+
+/* Distinct streams made of bytes that are not opcodes, so nothing is
+ * stripped. */
+static void build_distinct(uint32_t i, uint8_t stream[8]) {
+    memset(stream, 0x00, 8);
+    stream[0] = (uint8_t)(0x80 + (i & 0x7F));
+    stream[1] = (uint8_t)(0x80 + ((i >> 7) & 0x7F));
+}
+
+static void test_index_growth(void) {
+    gdsl_dedup_index_t *index = NULL;
+    assert(gdsl_dedup_index_create(2, &index) == 0);
+
+    uint8_t stream[8];
+    for (uint32_t i = 0; i < 5000; ++i) {
+        build_distinct(i, stream);
+        assert(gdsl_dedup_admit(index, stream, sizeof(stream), i, NULL) == 0);
+    }
+    assert(gdsl_dedup_index_count(index) == 5000);
+    for (uint32_t i = 0; i < 5000; ++i) {
+        build_distinct(i, stream);
+        gdsl_dedup_entry_t entry;
+        assert(gdsl_dedup_admit(index, stream, sizeof(stream), 9999, &entry) == 1);
+        assert(entry.stream_id == i);
+    }
+
+    gdsl_dedup_index_destroy(index);
+}
+
+int main(void) {
+    test_canonical_hash();
+    test_decorated_streams_match();
+    test_index_pipeline();
+    test_index_growth();
+    puts("All dedup tests completed.");
+    return 0;
+}
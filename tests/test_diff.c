@@ -4,6 +4,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 static void fill_pattern(uint8_t *buffer, size_t length, uint8_t seed) {
     for (size_t i = 0; i < length; ++i) {
@@ -85,9 +86,395 @@ static void test_diff_handles_shrinking(void) {
     free(target);
 }
 
+static void test_diff_with_pool_matches_serial(void) {
+    const size_t base_length = 4096 * 300 + 123;
+    const size_t target_length = 4096 * 310 + 7;
+
+    uint8_t *base = (uint8_t *)malloc(base_length);
+    uint8_t *target = (uint8_t *)malloc(target_length);
+    assert(base && target);
+
+    fill_pattern(base, base_length, 5);
+    memcpy(target, base, base_length);
+    memset(target + base_length, 0, target_length - base_length);
+    for (size_t page = 0; page < 310; page += 7) {
+        target[page * 4096 + 11] ^= 0x5a;
+    }
+
+    gdsl_pool_options_t pool_options;
+    memset(&pool_options, 0, sizeof(pool_options));
+    pool_options.thread_count = 4;
+    gdsl_pool_t *pool = NULL;
+    int rc = gdsl_pool_create(&pool_options, &pool);
+    assert(rc == 0);
+
+    gdsl_diff_options_t options;
+    memset(&options, 0, sizeof(options));
+    options.pool = pool;
+
+    gdsl_diff_result_t serial;
+    gdsl_diff_result_t parallel;
+    rc = gdsl_diff(base, base_length, target, target_length, &serial);
+    assert(rc == 0);
+    rc = gdsl_diff_ex(base, base_length, target, target_length, &options,
+                      &parallel);
+    assert(rc == 0);
+    assert(serial.chunk_count == parallel.chunk_count);
+    assert(serial.payload_length == parallel.payload_length);
+    assert(memcmp(serial.chunks, parallel.chunks,
+                  serial.chunk_count * sizeof(gdsl_diff_chunk_t)) == 0);
+    assert(memcmp(serial.payload, parallel.payload, serial.payload_length) == 0);
+
+    uint8_t *patched = NULL;
+    size_t patched_length = 0;
+    rc = gdsl_patch_ex(base, base_length, &parallel, &options, &patched,
+                       &patched_length);
+    assert(rc == 0);
+    assert(patched_length == target_length);
+    assert(memcmp(patched, target, target_length) == 0);
+
+    free(patched);
+    gdsl_diff_result_destroy(&serial);
+    gdsl_diff_result_destroy(&parallel);
+    gdsl_pool_destroy(pool);
+    free(base);
+    free(target);
+}
+
+static void test_diff_numa_placement_roundtrip(void) {
+    const size_t length = 4096 * 200;
+
+    uint8_t *base = (uint8_t *)malloc(length);
+    uint8_t *target = (uint8_t *)malloc(length);
+    assert(base && target);
+    fill_pattern(base, length, 3);
+    memcpy(target, base, length);
+    for (size_t page = 0; page < 200; page += 3) {
+        target[page * 4096 + 100] ^= 0xff;
+    }
+
+    gdsl_pool_options_t pool_options;
+    memset(&pool_options, 0, sizeof(pool_options));
+    pool_options.thread_count = 3;
+    pool_options.numa_aware = 1;
+    gdsl_pool_t *pool = NULL;
+    int rc = gdsl_pool_create(&pool_options, &pool);
+    assert(rc == 0);
+
+    const gdsl_numa_policy_t policies[] = {GDSL_NUMA_FIRST_TOUCH,
+                                           GDSL_NUMA_INTERLEAVE};
+    for (size_t p = 0; p < sizeof(policies) / sizeof(policies[0]); ++p) {
+        gdsl_diff_options_t options;
+        memset(&options, 0, sizeof(options));
+        options.pool = pool;
+        options.memory.numa_policy = policies[p];
+
+        gdsl_diff_result_t diff;
+        rc = gdsl_diff_ex(base, length, target, length, &options, &diff);
+        assert(rc == 0);
+        assert(diff.payload_storage == GDSL_DIFF_STORAGE_MAPPED);
+        assert(diff.chunk_count == 67);
+
+        uint8_t *patched = NULL;
+        size_t patched_length = 0;
+        rc = gdsl_patch_ex(base, length, &diff, &options, &patched,
+                           &patched_length);
+        assert(rc == 0);
+        assert(patched_length == length);
+        assert(memcmp(patched, target, length) == 0);
+
+        gdsl_buffer_free(patched, patched_length);
+        gdsl_diff_result_destroy(&diff);
+    }
+
+    gdsl_pool_destroy(pool);
+    free(base);
+    free(target);
+}
+
+static void test_patch_into_huge_page_buffer(void) {
+    const size_t length = GDSL_BUFFER_HUGE_PAGE_SIZE + 4096 * 3 + 17;
+
+    uint8_t *base = (uint8_t *)malloc(length);
+    uint8_t *target = (uint8_t *)malloc(length);
+    assert(base && target);
+    fill_pattern(base, length, 11);
+    memcpy(target, base, length);
+    target[0] ^= 1;
+    target[length - 1] ^= 1;
+
+    gdsl_diff_options_t options;
+    memset(&options, 0, sizeof(options));
+    options.memory.flags = GDSL_BUFFER_HUGE_PAGES | GDSL_BUFFER_POPULATE |
+                           GDSL_BUFFER_SEQUENTIAL;
+
+    gdsl_diff_result_t diff;
+    int rc = gdsl_diff_ex(base, length, target, length, &options, &diff);
+    assert(rc == 0);
+    assert(diff.chunk_count == 2);
+    assert(diff.payload_storage == GDSL_DIFF_STORAGE_MAPPED);
+
+    uint8_t *patched = NULL;
+    size_t patched_length = 0;
+    rc = gdsl_patch_ex(base, length, &diff, &options, &patched, &patched_length);
+    assert(rc == 0);
+    assert(((uintptr_t)patched % GDSL_BUFFER_HUGE_PAGE_SIZE) == 0);
+    assert(memcmp(patched, target, length) == 0);
+
+    gdsl_buffer_free(patched, patched_length);
+    gdsl_diff_result_destroy(&diff);
+    free(base);
+    free(target);
+}
+
+static void test_streaming_copies_roundtrip(void) {
+    /* Odd lengths exercise the unaligned head and tail of the kernels. */
+    const size_t base_length = 4096 * 9 + 3;
+    const size_t target_length = 4096 * 12 + 1001;
+
+    uint8_t *base = (uint8_t *)malloc(base_length);
+    uint8_t *target = (uint8_t *)malloc(target_length);
+    assert(base && target);
+    fill_pattern(base, base_length, 21);
+    fill_pattern(target, target_length, 22);
+    memcpy(target + 4096, base + 4096, 4096);
+
+    gdsl_diff_options_t options;
+    memset(&options, 0, sizeof(options));
+    options.streaming_threshold = 1;
+
+    gdsl_diff_result_t diff;
+    int rc = gdsl_diff_ex(base, base_length, target, target_length, &options,
+                          &diff);
+    assert(rc == 0);
+    assert(diff.chunk_count == 12);
+
+    uint8_t *patched = NULL;
+    size_t patched_length = 0;
+    rc = gdsl_patch_ex(base, base_length, &diff, &options, &patched,
+                       &patched_length);
+    assert(rc == 0);
+    assert(patched_length == target_length);
+    assert(memcmp(patched, target, target_length) == 0);
+
+    free(patched);
+    gdsl_diff_result_destroy(&diff);
+    free(base);
+    free(target);
+}
+
+/* Unlike fill_pattern, no two pages come out equal. */
+static void fill_random(uint8_t *buffer, size_t length, uint32_t seed) {
+    uint32_t state = seed * 2654435761u + 1u;
+    for (size_t i = 0; i < length; ++i) {
+        state = state * 1664525u + 1013904223u;
+        buffer[i] = (uint8_t)(state >> 24);
+    }
+}
+
+static void test_diff_multi_reference(void) {
+    /* Ping-pong: the target repeats the snapshot two checkpoints back, except
+     * for one fresh page, one page moved from the previous snapshot and a
+     * short last page. */
+    const size_t pages = 150;
+    const size_t length = pages * 4096 + 100;
+    uint8_t *older = (uint8_t *)malloc(length);
+    uint8_t *previous = (uint8_t *)malloc(length);
+    uint8_t *target = (uint8_t *)malloc(length);
+    assert(older && previous && target);
+    fill_random(older, length, 3);
+    fill_random(previous, length, 77);
+    memcpy(target, older, length);
+    fill_random(target + 40 * 4096, 4096, 200);
+    memcpy(target + 90 * 4096, previous + 12 * 4096, 4096);
+    target[length - 1] ^= 0x11;
+
+    gdsl_diff_reference_t references[2];
+    references[0].data = previous;
+    references[0].length = length;
+    references[1].data = older;
+    references[1].length = length;
+
+    gdsl_diff_result_t single;
+    gdsl_diff_result_t multi;
+    int rc = gdsl_diff(previous, length, target, length, &single);
+    assert(rc == 0);
+    rc = gdsl_diff_multi(references, 2, target, length, NULL, &multi);
+    assert(rc == 0);
+    assert(multi.chunk_count == single.chunk_count);
+    assert(multi.header.flags & GDSL_DIFF_FLAG_REFERENCES);
+    assert(single.header.flags == 0);
+    assert(multi.payload_length == 4096 + 100);
+    assert(single.payload_length == length);
+
+    const gdsl_diff_chunk_t *fresh = &multi.chunks[40];
+    assert(fresh->page_index == 40 && fresh->reference == 0);
+    const gdsl_diff_chunk_t *moved = &multi.chunks[90];
+    assert(moved->reference == 1 && moved->data_offset == 12 * 4096);
+    const gdsl_diff_chunk_t *cyclic = &multi.chunks[7];
+    assert(cyclic->reference == 2 && cyclic->data_offset == 7 * 4096);
+    assert(multi.chunks[pages].reference == 0);
+
+    uint8_t *patched = NULL;
+    size_t patched_length = 0;
+    rc = gdsl_patch_multi(references, 2, &multi, NULL, &patched, &patched_length);
+    assert(rc == 0);
+    assert(patched_length == length);
+    assert(memcmp(patched, target, length) == 0);
+    free(patched);
+
+    /* Referencing chunks need the references they were made with. */
+    rc = gdsl_patch(previous, length, &multi, &patched, &patched_length);
+    assert(rc == -1);
+    rc = gdsl_patch_multi(references, 1, &multi, NULL, &patched, &patched_length);
+    assert(rc == -1);
+
+    /* Pooled scans pick the same references. */
+    gdsl_pool_options_t pool_options;
+    memset(&pool_options, 0, sizeof(pool_options));
+    pool_options.thread_count = 4;
+    gdsl_pool_t *pool = NULL;
+    rc = gdsl_pool_create(&pool_options, &pool);
+    assert(rc == 0);
+    gdsl_diff_options_t options;
+    memset(&options, 0, sizeof(options));
+    options.pool = pool;
+    gdsl_diff_result_t parallel;
+    rc = gdsl_diff_multi(references, 2, target, length, &options, &parallel);
+    assert(rc == 0);
+    assert(parallel.chunk_count == multi.chunk_count);
+    assert(memcmp(parallel.chunks, multi.chunks,
+                  multi.chunk_count * sizeof(gdsl_diff_chunk_t)) == 0);
+    assert(memcmp(parallel.payload, multi.payload, multi.payload_length) == 0);
+
+    gdsl_diff_result_destroy(&parallel);
+    gdsl_pool_destroy(pool);
+    gdsl_diff_result_destroy(&single);
+    gdsl_diff_result_destroy(&multi);
+    free(older);
+    free(previous);
+    free(target);
+}
+
+static void test_diff_spills_over_budget(void) {
+    const size_t length = 4096 * 40 + 17;
+    uint8_t *target = (uint8_t *)malloc(length);
+    assert(target);
+    fill_random(target, length, 11);
+
+    gdsl_diff_options_t options;
+    memset(&options, 0, sizeof(options));
+    options.memory_budget = 64 * 1024;
+
+    gdsl_diff_result_t diff;
+    int rc = gdsl_diff_ex(NULL, 0, target, length, &options, &diff);
+    assert(rc == 0);
+    assert(diff.payload_storage == GDSL_DIFF_STORAGE_FILE);
+    assert(diff.payload_fd >= 0);
+    assert(diff.payload_length == length);
+    assert(memcmp(diff.payload, target, length) == 0);
+    assert((size_t)lseek(diff.payload_fd, 0, SEEK_END) == length);
+
+    uint8_t *patched = NULL;
+    size_t patched_length = 0;
+    rc = gdsl_patch(NULL, 0, &diff, &patched, &patched_length);
+    assert(rc == 0);
+    assert(patched_length == length);
+    assert(memcmp(patched, target, length) == 0);
+    free(patched);
+    gdsl_diff_result_destroy(&diff);
+
+    /* Payloads within the budget stay in memory. */
+    options.memory_budget = length;
+    rc = gdsl_diff_ex(NULL, 0, target, length, &options, &diff);
+    assert(rc == 0);
+    assert(diff.payload_storage == GDSL_DIFF_STORAGE_HEAP);
+    gdsl_diff_result_destroy(&diff);
+
+    options.memory_budget = 1;
+    options.spill_directory = "/nonexistent/gdsl";
+    rc = gdsl_diff_ex(NULL, 0, target, length, &options, &diff);
+    assert(rc == -1);
+
+    free(target);
+}
+
+static void test_diff_stat_and_estimate(void) {
+    const size_t pages = 1000;
+    const size_t length = pages * 4096 + 10;
+    uint8_t *base = (uint8_t *)malloc(length);
+    uint8_t *target = (uint8_t *)malloc(length + 4096);
+    assert(base && target);
+    fill_random(base, length, 21);
+    memcpy(target, base, length);
+    /* Every fourth page changes, plus the short last page. */
+    for (size_t page = 0; page < pages; page += 4) {
+        target[page * 4096 + 100] ^= 1;
+    }
+    target[length - 1] ^= 1;
+
+    gdsl_diff_result_t diff;
+    assert(gdsl_diff(base, length, target, length, &diff) == 0);
+    gdsl_diff_stat_t stat;
+    assert(gdsl_diff_stat(base, length, target, length, 0, &stat) == 0);
+    assert(stat.chunk_count == diff.chunk_count);
+    assert(stat.payload_bytes == diff.payload_length);
+    assert(stat.pages_scanned == pages + 1 && stat.total_pages == pages + 1);
+    assert(!stat.over_budget);
+    gdsl_diff_result_destroy(&diff);
+
+    /* A budget stops the scan at the first page that exceeds it. */
+    assert(gdsl_diff_stat(base, length, target, length, 3 * 4096, &stat) == 0);
+    assert(stat.over_budget);
+    assert(stat.chunk_count == 4 && stat.payload_bytes == 4 * 4096);
+    assert(stat.pages_scanned == 13);
+
+    /* Growth past the base is compared against zeros, as in gdsl_diff. */
+    memset(target + length, 0, 4096);
+    target[length + 4090] = 1;
+    assert(gdsl_diff_stat(base, length, target, length + 4096, 0, &stat) == 0);
+    assert(stat.chunk_count == 252);
+
+    gdsl_diff_estimate_options_t options;
+    memset(&options, 0, sizeof(options));
+    options.sample_fraction = 0.1;
+    options.seed = 7;
+    gdsl_diff_estimate_t estimate;
+    assert(gdsl_diff_estimate(base, length, target, length, &options, &estimate) == 0);
+    assert(estimate.total_pages == pages + 1);
+    assert(estimate.sampled_pages == 101);
+    assert(estimate.ratio_low <= estimate.change_ratio);
+    assert(estimate.change_ratio <= estimate.ratio_high);
+    assert(estimate.ratio_low < 0.25 && estimate.ratio_high > 0.25);
+    assert(estimate.ratio_low > 0.1 && estimate.ratio_high < 0.45);
+
+    /* Sampling every page is exact. */
+    options.sample_fraction = 1.0;
+    assert(gdsl_diff_estimate(base, length, target, length, &options, &estimate) == 0);
+    assert(estimate.changed_samples == 251);
+    assert(estimate.ratio_low == estimate.change_ratio);
+    assert(estimate.ratio_high == estimate.change_ratio);
+
+    assert(gdsl_diff_estimate(base, length, base, length, NULL, &estimate) == 0);
+    assert(estimate.change_ratio == 0.0 && estimate.estimated_payload_bytes == 0);
+    assert(estimate.ratio_high > 0.0);
+    options.sample_fraction = 1.5;
+    assert(gdsl_diff_estimate(base, length, target, length, &options, &estimate) == -1);
+
+    free(base);
+    free(target);
+}
+
 int main(void) {
     test_diff_roundtrip();
     test_diff_handles_shrinking();
+    test_diff_with_pool_matches_serial();
+    test_diff_numa_placement_roundtrip();
+    test_patch_into_huge_page_buffer();
+    test_streaming_copies_roundtrip();
+    test_diff_multi_reference();
+    test_diff_spills_over_budget();
+    test_diff_stat_and_estimate();
     puts("All diff tests completed.");
     return 0;
 }
@@ -0,0 +1,137 @@
+#include "gdsl/encode.h"
+#include "gdsl/verify.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void check_round_trip(const uint8_t *stream, size_t length) {
+    uint8_t *encoded = NULL;
+    size_t encoded_length = 0;
+    int rc = gdsl_encode(stream, length, &encoded, &encoded_length);
+    assert(rc == 0);
+
+    uint64_t raw_length = 0;
+    assert(gdsl_encoded_raw_length(encoded, encoded_length, &raw_length) == 0);
+    assert(raw_length == length);
+
+    uint8_t *decoded = NULL;
+    size_t decoded_length = 0;
+    rc = gdsl_decode(encoded, encoded_length, &decoded, &decoded_length);
+    assert(rc == 0);
+    assert(decoded_length == length);
+    assert(length == 0 || memcmp(decoded, stream, length) == 0);
+
+    free(decoded);
+    free(encoded);
+}
+
+static void test_round_trip(void) {
+    check_round_trip(NULL, 0);
+
+    const uint8_t small[] = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06};
+    check_round_trip(small, sizeof(small));
+
+    /* Arbitrary bytes, including ones that are not opcodes. */
+    uint8_t noise[5000];
+    uint32_t seed = 12345;
+    for (size_t i = 0; i < sizeof(noise); ++i) {
+        seed = seed * 1103515245u + 12345u;
+        noise[i] = (uint8_t)(seed >> 16);
+    }
+    check_round_trip(noise, sizeof(noise));
+}
+
+/* A recorder-style stream: one stream per frame, each padded with long runs. */
+static uint8_t *build_frames(size_t frames, size_t padding, size_t *out_length) {
+    size_t length = frames * (padding * 2 + 6) + 2;
+    uint8_t *stream = (uint8_t *)malloc(length);
+    assert(stream);
+    size_t n = 0;
+    for (size_t f = 0; f < frames; ++f) {
+        stream[n++] = 0x01;
+        memset(stream + n, 0x00, padding);
+        n += padding;
+        stream[n++] = 0x02;
+        stream[n++] = 0x03;
+        stream[n++] = 0x04;
+        stream[n++] = 0x07;
+        memset(stream + n, 0x09, padding);
+        n += padding;
+        stream[n++] = 0x08;
+    }
+    stream[n++] = 0x05;
+    stream[n++] = 0x06;
+    assert(n == length);
+    *out_length = length;
+    return stream;
+}
+
+static void expect_same_report(const uint8_t *stream,
+                               size_t length,
+                               const uint8_t *encoded,
+                               size_t encoded_length,
+                               gdsl_verify_level_t level,
+                               const gdsl_verify_options_t *options) {
+    static gdsl_verify_report_t raw;
+    static gdsl_verify_report_t packed;
+    int rc = gdsl_verify_ex(stream, length, level, options, &raw);
+    assert(rc == 0);
+    rc = gdsl_verify_encoded(encoded, encoded_length, level, options, &packed);
+    assert(rc == 0);
+    assert(memcmp(&raw, &packed, sizeof(raw)) == 0);
+}
+
+static void test_verify_encoded_matches_raw(void) {
+    size_t length = 0;
+    uint8_t *stream = build_frames(200, 5000, &length);
+
+    uint8_t *encoded = NULL;
+    size_t encoded_length = 0;
+    int rc = gdsl_encode(stream, length, &encoded, &encoded_length);
+    assert(rc == 0);
+    printf("encode: %zu raw bytes -> %zu encoded\n", length, encoded_length);
+    assert(encoded_length * 50 < length);
+
+    gdsl_verify_options_t options;
+    memset(&options, 0, sizeof(options));
+    expect_same_report(stream, length, encoded, encoded_length,
+                       GDSL_VERIFY_LEVEL_DOMAIN, &options);
+    expect_same_report(stream, length, encoded, encoded_length,
+                       GDSL_VERIFY_LEVEL_SYNTAX, &options);
+
+    /* CHECKPOINT runs inside Record are errors one by one. */
+    stream[3] = 0x09;
+    stream[4] = 0x09;
+    stream[10] = 0xEE;
+    free(encoded);
+    rc = gdsl_encode(stream, length, &encoded, &encoded_length);
+    assert(rc == 0);
+    expect_same_report(stream, length, encoded, encoded_length,
+                       GDSL_VERIFY_LEVEL_DOMAIN, &options);
+    options.flags = GDSL_VERIFY_AGGREGATE;
+    expect_same_report(stream, length, encoded, encoded_length,
+                       GDSL_VERIFY_LEVEL_DOMAIN, &options);
+    options.flags = GDSL_VERIFY_FAIL_FAST;
+    expect_same_report(stream, length, encoded, encoded_length,
+                       GDSL_VERIFY_LEVEL_DOMAIN, &options);
+
+    /* Corrupt framing is rejected rather than misread. */
+    static gdsl_verify_report_t report;
+    encoded[GDSL_ENCODE_HEADER_SIZE] ^= 0x40;
+    assert(gdsl_verify_encoded(encoded, encoded_length, GDSL_VERIFY_LEVEL_DOMAIN,
+                               NULL, &report) == -1);
+    assert(gdsl_verify_encoded(encoded, 8, GDSL_VERIFY_LEVEL_DOMAIN, NULL,
+                               &report) == -1);
+
+    free(encoded);
+    free(stream);
+}
+
+int main(void) {
+    test_round_trip();
+    test_verify_encoded_matches_raw();
+    puts("All encode tests completed.");
+    return 0;
+}
@@ -0,0 +1,274 @@
+#include "gdsl/fold.h"
+#include "gdsl/verify.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static uint32_t next_random(uint32_t *seed) {
+    *seed = *seed * 1103515245u + 12345u;
+    return *seed >> 16;
+}
+
+static int has_diagnostic(const gdsl_verify_report_t *report, const char *text) {
+    for (size_t i = 0; i < report->diagnostic_count; ++i) {
+        if (strstr(report->diagnostics[i].message, text)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void check_fold(const uint8_t *stream,
+                       size_t length,
+                       const uint8_t *expected,
+                       size_t expected_length,
+                       gdsl_fold_stats_t *stats) {
+    uint8_t *pruned = NULL;
+    size_t pruned_length = 0;
+    assert(gdsl_fold(stream, length, &pruned, &pruned_length, stats) == 0);
+    assert(pruned_length == expected_length);
+    assert(expected_length == 0 || memcmp(pruned, expected, expected_length) == 0);
+    free(pruned);
+}
+
+static void test_fold_branches(void) {
+    gdsl_fold_stats_t stats;
+
+    /* r0 = 2, r1 = 3, r2 = r0 * r1 + r0 = 8: IF_GT r2 r1 keeps the then-arm. */
+    const uint8_t taken[] = {
+        0x21, 0x00, 0x02, 0x00, 0x00, 0x00, /* CONST_I32 r0, 2 */
+        0x21, 0x01, 0x03, 0x00, 0x00, 0x00, /* CONST_I32 r1, 3 */
+        0x24, 0x02, 0x00, 0x01,             /* MUL r2, r0, r1 */
+        0x22, 0x02, 0x02, 0x00,             /* ADD r2, r2, r0 */
+        0x01,
+        0x27, 0x02, 0x01,                   /* IF_GT r2, r1 */
+        0x02,
+        0x29,                               /* ELSE */
+        0x05, 0x03,
+        0x2A,                               /* ENDIF */
+        0x03, 0x04, 0x05};
+    const uint8_t taken_pruned[] = {
+        0x21, 0x00, 0x02, 0x00, 0x00, 0x00, 0x21, 0x01, 0x03, 0x00, 0x00, 0x00,
+        0x24, 0x02, 0x00, 0x01, 0x22, 0x02, 0x02, 0x00,
+        0x01, 0x02, 0x03, 0x04, 0x05};
+    check_fold(taken, sizeof(taken), taken_pruned, sizeof(taken_pruned), &stats);
+    assert(stats.branches_folded == 1);
+    assert(stats.branches_kept == 0);
+    assert(stats.instructions_removed == 5);
+    assert(stats.bytes_removed == sizeof(taken) - sizeof(taken_pruned));
+
+    /* Not taken, with an IF nested in the dead arm and a signed compare:
+     * r0 = 0 - 1 = -1 is not greater than r1 = 0. */
+    const uint8_t skipped[] = {
+        0x21, 0x00, 0x01, 0x00, 0x00, 0x00,
+        0x21, 0x01, 0x00, 0x00, 0x00, 0x00,
+        0x23, 0x00, 0x01, 0x00,             /* SUB r0, r1, r0 */
+        0x27, 0x00, 0x01,                   /* IF_GT r0, r1 */
+        0x25, 0x05, 0x06, 0x05, 0x29, 0x05, 0x2A,
+        0x29,
+        0x01, 0x03, 0x04, 0x05,
+        0x2A};
+    const uint8_t skipped_pruned[] = {
+        0x21, 0x00, 0x01, 0x00, 0x00, 0x00, 0x21, 0x01, 0x00, 0x00, 0x00, 0x00,
+        0x23, 0x00, 0x01, 0x00,
+        0x01, 0x03, 0x04, 0x05};
+    check_fold(skipped, sizeof(skipped), skipped_pruned, sizeof(skipped_pruned),
+               &stats);
+    assert(stats.branches_folded == 1);
+
+    /* r5 is never assigned: the IF stays, and r3 is only known after it
+     * when both arms agree. */
+    const uint8_t unknown[] = {
+        0x01,
+        0x26, 0x05, 0x00,                   /* IF_NE r5, r0 */
+        0x21, 0x03, 0x07, 0x00, 0x00, 0x00, 0x21, 0x04, 0x01, 0x00, 0x00, 0x00,
+        0x29,
+        0x21, 0x03, 0x07, 0x00, 0x00, 0x00, 0x21, 0x04, 0x02, 0x00, 0x00, 0x00,
+        0x2A,
+        0x21, 0x06, 0x07, 0x00, 0x00, 0x00,
+        0x25, 0x03, 0x06,                   /* IF_EQ r3, r6: folds */
+        0x03,
+        0x2A,
+        0x25, 0x04, 0x06,                   /* IF_EQ r4, r6: stays */
+        0x04,
+        0x2A,
+        0x04, 0x05};
+    uint8_t unknown_pruned[sizeof(unknown)];
+    size_t n = 0;
+    memcpy(unknown_pruned, unknown, 36);
+    n = 36;
+    unknown_pruned[n++] = 0x03;
+    memcpy(unknown_pruned + n, unknown + 41, sizeof(unknown) - 41);
+    n += sizeof(unknown) - 41;
+    check_fold(unknown, sizeof(unknown), unknown_pruned, n, &stats);
+    assert(stats.branches_folded == 1);
+    assert(stats.branches_kept == 2);
+
+    /* Invalid structure or registers: copied as is. */
+    const uint8_t stray[] = {0x21, 0x00, 0x00, 0x00, 0x00, 0x00,
+                             0x25, 0x00, 0x00, 0x01, 0x2A, 0x2A};
+    check_fold(stray, sizeof(stray), stray, sizeof(stray), &stats);
+    assert(stats.branches_folded == 0);
+    const uint8_t bad_register[] = {0x21, 0x00, 0x00, 0x00, 0x00, 0x00,
+                                    0x25, 0x00, 0x00, 0x22, 0x40, 0x00, 0x00, 0x2A};
+    check_fold(bad_register, sizeof(bad_register), bad_register,
+               sizeof(bad_register), NULL);
+    const uint8_t truncated[] = {0x21, 0x00, 0x00, 0x00, 0x00, 0x00,
+                                 0x25, 0x00, 0x00, 0x2A, 0x21, 0x00};
+    check_fold(truncated, sizeof(truncated), truncated, sizeof(truncated), NULL);
+    check_fold(NULL, 0, NULL, 0, NULL);
+}
+
+static void test_verify_branches(void) {
+    static gdsl_verify_report_t report;
+
+    /* The dead arm would submit twice; it is never verified. */
+    const uint8_t dead_arm[] = {
+        0x21, 0x00, 0x01, 0x00, 0x00, 0x00,
+        0x01,
+        0x25, 0x00, 0x01,                   /* IF_EQ r0, r1: r1 unknown */
+        0x2A,
+        0x21, 0x01, 0x02, 0x00, 0x00, 0x00,
+        0x25, 0x00, 0x01,                   /* IF_EQ r0, r1: 1 != 2 */
+        0x03, 0x03, 0x1C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x2A,
+        0x03, 0x04, 0x05};
+    assert(gdsl_verify(dead_arm, sizeof(dead_arm), GDSL_VERIFY_LEVEL_DOMAIN, &report) == 0);
+    assert(report.success);
+    assert(report.instruction_count == 13);
+    /* Syntax only: no folding, nothing to report either. */
+    assert(gdsl_verify(dead_arm, sizeof(dead_arm), GDSL_VERIFY_LEVEL_SYNTAX, &report) == 0);
+    assert(report.success);
+
+    /* Both arms of an unknown IF are verified from the same state. */
+    const uint8_t both[] = {
+        0x01,
+        0x25, 0x05, 0x06,
+        0x03, 0x04,                         /* then: submit and wait */
+        0x29,
+        0x02,                               /* else: still recording */
+        0x2A,
+        0x03, 0x04, 0x05};
+    assert(gdsl_verify(both, sizeof(both), GDSL_VERIFY_LEVEL_PHASE, &report) == 0);
+    assert(!report.success);
+    assert(has_diagnostic(&report, "arms of the IF at instruction 1 end in different states"));
+
+    const uint8_t agreeing[] = {
+        0x01, 0x25, 0x05, 0x06, 0x00, 0x29, 0x00, 0x00, 0x2A, 0x03, 0x04, 0x05};
+    assert(gdsl_verify(agreeing, sizeof(agreeing), GDSL_VERIFY_LEVEL_DOMAIN, &report) == 0);
+    assert(report.success);
+
+    /* Structure and register errors. */
+    const uint8_t broken[] = {
+        0x29, 0x2A,
+        0x21, 0x10, 0x00, 0x00, 0x00, 0x00,
+        0x25, 0x00, 0x00, 0x29, 0x29, 0x2A,
+        0x01, 0x25, 0x01, 0x01, 0x03, 0x04, 0x05};
+    assert(gdsl_verify(broken, sizeof(broken), GDSL_VERIFY_LEVEL_PHASE, &report) == 0);
+    assert(report.error_count == 5);
+    assert(has_diagnostic(&report, "ELSE without IF"));
+    assert(has_diagnostic(&report, "ENDIF without IF"));
+    assert(has_diagnostic(&report, "register 16 out of range"));
+    assert(has_diagnostic(&report, "duplicate ELSE"));
+    assert(has_diagnostic(&report, "IF at instruction 8 has no ENDIF"));
+
+    uint8_t deep[2 + 40 * 3 + 40 + 3];
+    size_t n = 0;
+    deep[n++] = 0x01;
+    for (int i = 0; i < 40; ++i) {
+        deep[n++] = 0x25;
+        deep[n++] = 0x05;
+        deep[n++] = 0x06;
+    }
+    for (int i = 0; i < 40; ++i) {
+        deep[n++] = 0x2A;
+    }
+    deep[n++] = 0x03;
+    deep[n++] = 0x04;
+    deep[n++] = 0x05;
+    assert(gdsl_verify(deep, n, GDSL_VERIFY_LEVEL_PHASE, &report) == 0);
+    assert(report.error_count == 8);
+    assert(has_diagnostic(&report, "IF nesting deeper than 32"));
+}
+
+/* Random nested blocks of phase, draw and register instructions. */
+static size_t build_block(uint32_t *seed, uint8_t *out, size_t pos, int depth) {
+    static const uint8_t plain[] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x1A, 0x1B};
+    int items = 1 + (int)(next_random(seed) % 6);
+    for (int i = 0; i < items; ++i) {
+        uint32_t pick = next_random(seed) % 10;
+        if (pick < 4) {
+            out[pos++] = plain[next_random(seed) % sizeof(plain)];
+        } else if (pick < 6) {
+            const uint8_t op[] = {0x21, (uint8_t)(next_random(seed) % 4),
+                                  (uint8_t)(next_random(seed) % 3), 0, 0, 0};
+            memcpy(out + pos, op, sizeof(op));
+            pos += sizeof(op);
+        } else if (pick < 7) {
+            out[pos++] = (uint8_t)(0x22 + next_random(seed) % 3);
+            for (int r = 0; r < 3; ++r) {
+                out[pos++] = (uint8_t)(next_random(seed) % 5);
+            }
+        } else if (depth < 4) {
+            out[pos++] = (uint8_t)(0x25 + next_random(seed) % 4);
+            out[pos++] = (uint8_t)(next_random(seed) % 5);
+            out[pos++] = (uint8_t)(next_random(seed) % 5);
+            pos = build_block(seed, out, pos, depth + 1);
+            if (next_random(seed) % 2) {
+                out[pos++] = 0x29;
+                pos = build_block(seed, out, pos, depth + 1);
+            }
+            out[pos++] = 0x2A;
+        }
+    }
+    return pos;
+}
+
+static void test_pruned_streams_verify_alike(void) {
+    static uint8_t stream[1 << 16];
+    static gdsl_verify_report_t original;
+    static gdsl_verify_report_t folded;
+    uint32_t seed = 77;
+    uint64_t removed = 0;
+
+    for (int round = 0; round < 300; ++round) {
+        size_t length = build_block(&seed, stream, 0, 0);
+        uint8_t *pruned = NULL;
+        size_t pruned_length = 0;
+        gdsl_fold_stats_t stats;
+        assert(gdsl_fold(stream, length, &pruned, &pruned_length, &stats) == 0);
+        assert(pruned_length == length - stats.bytes_removed);
+        removed += stats.instructions_removed;
+
+        for (int level = GDSL_VERIFY_LEVEL_PHASE; level <= GDSL_VERIFY_LEVEL_DOMAIN;
+             ++level) {
+            gdsl_verify(stream, length, (gdsl_verify_level_t)level, &original);
+            gdsl_verify(pruned, pruned_length, (gdsl_verify_level_t)level, &folded);
+            assert(original.success == folded.success);
+            assert(original.error_count == folded.error_count);
+            assert(original.warning_count == folded.warning_count);
+            assert(original.info_count == folded.info_count);
+        }
+
+        /* Folding is idempotent. */
+        uint8_t *again = NULL;
+        size_t again_length = 0;
+        assert(gdsl_fold(pruned, pruned_length, &again, &again_length, &stats) == 0);
+        assert(again_length == pruned_length);
+        assert(pruned_length == 0 || memcmp(again, pruned, pruned_length) == 0);
+        assert(stats.branches_folded == 0);
+        free(again);
+        free(pruned);
+    }
+    assert(removed > 0);
+}
+
+int main(void) {
+    test_fold_branches();
+    test_verify_branches();
+    test_pruned_streams_verify_alike();
+    puts("All fold tests completed.");
+    return 0;
+}
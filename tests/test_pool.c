@@ -0,0 +1,149 @@
+#include "gdsl/pool.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    unsigned *hits;
+    size_t thread_count;
+    gdsl_pool_t *pool;
+} visit_ctx_t;
+
+static void mark_range(void *ctx, size_t begin, size_t end, size_t worker) {
+    visit_ctx_t *visit = (visit_ctx_t *)ctx;
+    assert(worker < visit->thread_count);
+    for (size_t i = begin; i < end; ++i) {
+        __atomic_add_fetch(&visit->hits[i], 1, __ATOMIC_RELAXED);
+    }
+}
+
+static void test_parallel_for_covers_range(void) {
+    gdsl_pool_options_t options;
+    memset(&options, 0, sizeof(options));
+    options.thread_count = 4;
+
+    gdsl_pool_t *pool = NULL;
+    int rc = gdsl_pool_create(&options, &pool);
+    assert(rc == 0);
+    assert(gdsl_pool_thread_count(pool) == 4);
+
+    const size_t count = 100000;
+    unsigned *hits = (unsigned *)calloc(count, sizeof(unsigned));
+    assert(hits);
+
+    visit_ctx_t visit = {hits, 4, pool};
+    for (int round = 0; round < 8; ++round) {
+        rc = gdsl_pool_parallel_for(pool, 0, count, 64, mark_range, &visit);
+        assert(rc == 0);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        assert(hits[i] == 8);
+    }
+    printf("pool: %zu items x 8 rounds on %zu threads\n",
+           count, gdsl_pool_thread_count(pool));
+
+    free(hits);
+    gdsl_pool_destroy(pool);
+}
+
+static void nested_range(void *ctx, size_t begin, size_t end, size_t worker) {
+    visit_ctx_t *visit = (visit_ctx_t *)ctx;
+    (void)worker;
+    for (size_t i = begin; i < end; ++i) {
+        visit_ctx_t inner = {visit->hits + i * 100, visit->thread_count,
+                             visit->pool};
+        int rc = gdsl_pool_parallel_for(visit->pool, 0, 100, 8, mark_range,
+                                        &inner);
+        assert(rc == 0);
+    }
+}
+
+static void test_nested_parallel_for(void) {
+    gdsl_pool_options_t options;
+    memset(&options, 0, sizeof(options));
+    options.thread_count = 3;
+
+    gdsl_pool_t *pool = NULL;
+    int rc = gdsl_pool_create(&options, &pool);
+    assert(rc == 0);
+
+    unsigned *hits = (unsigned *)calloc(64 * 100, sizeof(unsigned));
+    assert(hits);
+
+    visit_ctx_t visit = {hits, 3, pool};
+    rc = gdsl_pool_parallel_for(pool, 0, 64, 1, nested_range, &visit);
+    assert(rc == 0);
+    for (size_t i = 0; i < 64 * 100; ++i) {
+        assert(hits[i] == 1);
+    }
+
+    free(hits);
+    gdsl_pool_destroy(pool);
+}
+
+static void test_null_pool_runs_serially(void) {
+    unsigned hits[16];
+    memset(hits, 0, sizeof(hits));
+
+    visit_ctx_t visit = {hits, 1, NULL};
+    int rc = gdsl_pool_parallel_for(NULL, 0, 16, 4, mark_range, &visit);
+    assert(rc == 0);
+    for (size_t i = 0; i < 16; ++i) {
+        assert(hits[i] == 1);
+    }
+    assert(gdsl_pool_thread_count(NULL) == 1);
+    assert(gdsl_pool_parallel_for(NULL, 4, 2, 1, mark_range, &visit) != 0);
+}
+
+typedef struct {
+    size_t owner[64];
+} owner_ctx_t;
+
+static void record_owner(void *ctx, size_t begin, size_t end, size_t worker) {
+    owner_ctx_t *owners = (owner_ctx_t *)ctx;
+    for (size_t i = begin; i < end; ++i) {
+        owners->owner[i] = worker;
+    }
+}
+
+static void test_static_partitions_are_stable(void) {
+    gdsl_pool_options_t options;
+    memset(&options, 0, sizeof(options));
+    options.thread_count = 4;
+    options.numa_aware = 1;
+
+    gdsl_pool_t *pool = NULL;
+    int rc = gdsl_pool_create(&options, &pool);
+    assert(rc == 0);
+    assert(gdsl_pool_worker_node(pool, 0) == -1);
+    printf("pool: numa nodes=%zu worker1 node=%d\n",
+           gdsl_pool_node_count(pool), gdsl_pool_worker_node(pool, 1));
+
+    /* NUMA-aware pools partition over the three pinned workers only. */
+    owner_ctx_t first;
+    owner_ctx_t second;
+    rc = gdsl_pool_parallel_for_static(pool, 0, 64, record_owner, &first);
+    assert(rc == 0);
+    rc = gdsl_pool_parallel_for_static(pool, 0, 64, record_owner, &second);
+    assert(rc == 0);
+    for (size_t i = 0; i < 64; ++i) {
+        assert(first.owner[i] == second.owner[i]);
+        assert(first.owner[i] >= 1 && first.owner[i] <= 3);
+        if (i > 0) {
+            assert(first.owner[i] >= first.owner[i - 1]);
+        }
+    }
+
+    gdsl_pool_destroy(pool);
+}
+
+int main(void) {
+    test_parallel_for_covers_range();
+    test_nested_parallel_for();
+    test_null_pool_runs_serially();
+    test_static_partitions_are_stable();
+    puts("All pool tests completed.");
+    return 0;
+}
@@ -0,0 +1,222 @@
+#include "gdsl/diff.h"
+#include "gdsl/merkle.h"
+#include "gdsl/pool.h"
+#include "gdsl/replay.h"
+#include "gdsl/slice.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum { FRAMES = 12, HEAP_LENGTH = 3 * 4096 + 100 };
+
+static size_t instruction_size(uint8_t opcode) {
+    switch (opcode) {
+    case 0x0E:
+    case 0x11:
+        return 2;
+    case 0x0F:
+    case 0x10:
+    case 0x12:
+    case 0x13:
+    case 0x14:
+    case 0x15:
+        return 5;
+    case 0x21:
+        return 6;
+    default:
+        return 1;
+    }
+}
+
+/* Toy executor: UPLOAD k folds k into one heap byte, so the heap depends on
+ * the order of the uploads. A recording run also keeps the root at every
+ * CHECKPOINT and the diff against the base at every SNAPSHOT_END. */
+typedef struct {
+    const uint8_t *base;
+    gdsl_merkle_hash_t roots[FRAMES];
+    size_t root_count;
+    gdsl_diff_result_t diffs[FRAMES];
+    size_t diff_count;
+    int record;
+    uint32_t fail_upload;
+} toy_executor_t;
+
+static int toy_execute(void *ctx,
+                       const uint8_t *stream,
+                       size_t length,
+                       uint8_t *heap,
+                       size_t heap_length) {
+    toy_executor_t *executor = (toy_executor_t *)ctx;
+    for (size_t pos = 0; pos < length; pos += instruction_size(stream[pos])) {
+        uint8_t opcode = stream[pos];
+        if (opcode == 0x14) {
+            uint32_t k;
+            memcpy(&k, stream + pos + 1, sizeof(k));
+            if (executor->fail_upload && k == executor->fail_upload) {
+                return -1;
+            }
+            size_t at = ((size_t)k * 4099u) % heap_length;
+            heap[at] = (uint8_t)(heap[at] * 31u + k);
+        } else if (executor->record && opcode == 0x09) {
+            assert(gdsl_merkle_heap_root(heap, heap_length, 0,
+                                         &executor->roots[executor->root_count++]) == 0);
+        } else if (executor->record && opcode == 0x08) {
+            assert(gdsl_diff(executor->base, heap_length, heap, heap_length,
+                             &executor->diffs[executor->diff_count++]) == 0);
+        }
+    }
+    return 0;
+}
+
+static void test_merkle_trees(void) {
+    uint8_t *heap = (uint8_t *)calloc(5 * 4096, 1);
+    gdsl_merkle_tree_t tree;
+    assert(gdsl_merkle_build(heap, 5 * 4096, 0, NULL, &tree) == 0);
+    assert(tree.page_count == 5);
+    assert(tree.node_count == 5 + 3 + 2 + 1);
+    gdsl_merkle_hash_t root = gdsl_merkle_root(&tree);
+    gdsl_merkle_destroy(&tree);
+
+    gdsl_merkle_hash_t again;
+    assert(gdsl_merkle_heap_root(heap, 5 * 4096, 0, &again) == 0);
+    assert(gdsl_merkle_equal(root, again));
+    heap[4 * 4096 + 17] = 1;
+    assert(gdsl_merkle_heap_root(heap, 5 * 4096, 0, &again) == 0);
+    assert(!gdsl_merkle_equal(root, again));
+
+    /* A pool gives the same tree. */
+    gdsl_pool_options_t pool_options;
+    memset(&pool_options, 0, sizeof(pool_options));
+    pool_options.thread_count = 4;
+    gdsl_pool_t *pool = NULL;
+    assert(gdsl_pool_create(&pool_options, &pool) == 0);
+    assert(gdsl_merkle_build(heap, 5 * 4096, 0, pool, &tree) == 0);
+    assert(gdsl_merkle_equal(gdsl_merkle_root(&tree), again));
+    gdsl_merkle_destroy(&tree);
+    gdsl_pool_destroy(pool);
+
+    assert(gdsl_merkle_build(NULL, 0, 0, NULL, &tree) == 0);
+    assert(tree.page_count == 1 && tree.node_count == 1);
+    gdsl_merkle_destroy(&tree);
+    free(heap);
+}
+
+static void test_replay_intervals(void) {
+    /* Each frame uploads twice, then snapshots and checkpoints. */
+    uint8_t stream[FRAMES * 19 + 2];
+    uint64_t cuts[FRAMES];
+    size_t length = 0;
+    uint64_t index = 0;
+    for (uint32_t frame = 0; frame < FRAMES; ++frame) {
+        const uint8_t head[] = {0x01, 0x14, 0, 0, 0, 0, 0x14, 0, 0, 0, 0,
+                                0x03, 0x04, 0x07, 0x08};
+        memcpy(stream + length, head, sizeof(head));
+        uint32_t a = 3 * frame + 1;
+        uint32_t b = 5 * frame + 2;
+        memcpy(stream + length + 2, &a, sizeof(a));
+        memcpy(stream + length + 7, &b, sizeof(b));
+        length += sizeof(head);
+        index += 7;
+        cuts[frame] = index++;
+        stream[length++] = 0x09;
+    }
+    stream[length++] = 0x05;
+    stream[length++] = 0x06;
+
+    uint8_t *base = (uint8_t *)malloc(HEAP_LENGTH);
+    for (size_t i = 0; i < HEAP_LENGTH; ++i) {
+        base[i] = (uint8_t)(i * 7);
+    }
+
+    /* The sequential run records the checkpoint roots and keyframe diffs. */
+    toy_executor_t *executor = (toy_executor_t *)calloc(1, sizeof(*executor));
+    executor->base = base;
+    executor->record = 1;
+    uint8_t *heap = (uint8_t *)malloc(HEAP_LENGTH);
+    memcpy(heap, base, HEAP_LENGTH);
+    assert(toy_execute(executor, stream, length, heap, HEAP_LENGTH) == 0);
+    assert(executor->root_count == FRAMES && executor->diff_count == FRAMES);
+    gdsl_merkle_hash_t final_root;
+    assert(gdsl_merkle_heap_root(heap, HEAP_LENGTH, 0, &final_root) == 0);
+    executor->record = 0;
+
+    const gdsl_diff_result_t *diffs[FRAMES];
+    for (size_t i = 0; i < FRAMES; ++i) {
+        diffs[i] = &executor->diffs[i];
+    }
+    gdsl_slice_options_t slice_options;
+    memset(&slice_options, 0, sizeof(slice_options));
+    slice_options.snapshot_diffs = diffs;
+    slice_options.snapshot_diff_count = FRAMES;
+    gdsl_slice_set_t slices;
+    assert(gdsl_slice(stream, length, cuts, FRAMES, &slice_options, &slices) == 0);
+
+    gdsl_pool_options_t pool_options;
+    memset(&pool_options, 0, sizeof(pool_options));
+    pool_options.thread_count = 4;
+    gdsl_pool_t *pool = NULL;
+    assert(gdsl_pool_create(&pool_options, &pool) == 0);
+
+    gdsl_replay_options_t options;
+    memset(&options, 0, sizeof(options));
+    options.base_heap = base;
+    options.base_heap_length = HEAP_LENGTH;
+    options.checkpoint_roots = executor->roots;
+    options.checkpoint_root_count = FRAMES;
+    options.execute = toy_execute;
+    options.ctx = executor;
+    options.pool = pool;
+
+    gdsl_replay_interval_t intervals[FRAMES + 1];
+    assert(gdsl_replay_intervals(stream, length, &slices, &options, intervals) == 0);
+    for (size_t i = 0; i < FRAMES; ++i) {
+        assert(intervals[i].status == GDSL_REPLAY_CONSISTENT);
+    }
+    assert(intervals[FRAMES].status == GDSL_REPLAY_UNCHECKED);
+    assert(gdsl_merkle_equal(intervals[FRAMES].root, final_root));
+
+    /* A wrong recorded root and a failing executor show up per interval. */
+    gdsl_merkle_hash_t roots[FRAMES];
+    memcpy(roots, executor->roots, sizeof(roots));
+    roots[4].lo ^= 1;
+    options.checkpoint_roots = roots;
+    executor->fail_upload = 3 * 8 + 1;
+    assert(gdsl_replay_intervals(stream, length, &slices, &options, intervals) == 0);
+    for (size_t i = 0; i < FRAMES; ++i) {
+        gdsl_replay_status_t expected = i == 4   ? GDSL_REPLAY_DIVERGED
+                                        : i == 8 ? GDSL_REPLAY_FAILED
+                                                 : GDSL_REPLAY_CONSISTENT;
+        assert(intervals[i].status == expected);
+    }
+
+    /* Serially, without recorded roots. */
+    executor->fail_upload = 0;
+    options.pool = NULL;
+    options.checkpoint_roots = NULL;
+    assert(gdsl_replay_intervals(stream, length, &slices, &options, intervals) == 0);
+    for (size_t i = 0; i <= FRAMES; ++i) {
+        assert(intervals[i].status == GDSL_REPLAY_UNCHECKED);
+    }
+    assert(gdsl_merkle_equal(intervals[FRAMES].root, final_root));
+
+    options.execute = NULL;
+    assert(gdsl_replay_intervals(stream, length, &slices, &options, intervals) == -1);
+
+    gdsl_pool_destroy(pool);
+    gdsl_slice_set_destroy(&slices);
+    for (size_t i = 0; i < FRAMES; ++i) {
+        gdsl_diff_result_destroy(&executor->diffs[i]);
+    }
+    free(executor);
+    free(heap);
+    free(base);
+}
+
+int main(void) {
+    test_merkle_trees();
+    test_replay_intervals();
+    puts("All replay tests completed.");
+    return 0;
+}
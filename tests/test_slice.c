@@ -0,0 +1,267 @@
+#include "gdsl/slice.h"
+#include "gdsl/verify.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Appends opcode with an operand_bytes little-endian operand. */
+static void put(uint8_t *stream, size_t *length, uint8_t opcode, uint64_t operand,
+                size_t operand_bytes) {
+    stream[(*length)++] = opcode;
+    for (size_t i = 0; i < operand_bytes; ++i) {
+        stream[(*length)++] = (uint8_t)(operand >> (8 * i));
+    }
+}
+
+static void verify_clean(const uint8_t *stream, size_t length) {
+    gdsl_verify_report_t report;
+    assert(gdsl_verify(stream, length, GDSL_VERIFY_LEVEL_DOMAIN, &report) == 0);
+    if (report.error_count != 0) {
+        for (size_t i = 0; i < report.diagnostic_count; ++i) {
+            printf("  %s\n", report.diagnostics[i].message);
+        }
+    }
+    assert(report.success);
+    assert(report.error_count == 0);
+}
+
+/* Every slice of set verifies without errors on its own, and the slices
+ * cover the stream. */
+static void check_slices(const uint8_t *stream, size_t length, const gdsl_slice_set_t *set) {
+    uint64_t offset = 0;
+    for (size_t i = 0; i < set->count; ++i) {
+        const gdsl_slice_t *slice = &set->slices[i];
+        assert(slice->begin_offset == offset);
+        offset = slice->end_offset;
+        assert((i == 0) == (slice->prologue_length == 0));
+        assert((i + 1 == set->count) == (slice->epilogue_length == 0));
+
+        uint8_t *bytes = NULL;
+        size_t bytes_length = 0;
+        assert(gdsl_slice_materialise(stream, length, slice, &bytes, &bytes_length) == 0);
+        assert(bytes_length == slice->prologue_length +
+                                   (slice->end_offset - slice->begin_offset) +
+                                   slice->epilogue_length);
+        verify_clean(bytes, bytes_length);
+        free(bytes);
+    }
+    assert(offset == length);
+}
+
+static void test_slice_prologues(void) {
+    uint8_t stream[128];
+    size_t length = 0;
+    put(stream, &length, 0x01, 0, 0);          /* BEGIN_STREAM */
+    put(stream, &length, 0x12, 7, 4);          /* ALLOC_BUFFER 7 */
+    put(stream, &length, 0x12, 9, 4);          /* ALLOC_BUFFER 9 */
+    put(stream, &length, 0x03, 0, 0);          /* SUBMIT */
+    put(stream, &length, 0x04, 0, 0);          /* FENCE_WAIT */
+    put(stream, &length, 0x07, 0, 0);          /* SNAPSHOT_BEGIN */
+    put(stream, &length, 0x08, 0, 0);          /* SNAPSHOT_END */
+    put(stream, &length, 0x09, 0, 0);          /* CHECKPOINT (7) */
+    put(stream, &length, 0x21, 5u << 8, 5);    /* CONST_I32 r0, 5 */
+    put(stream, &length, 0x01, 0, 0);
+    put(stream, &length, 0x13, 9, 4);          /* FREE_BUFFER 9 */
+    put(stream, &length, 0x14, 7, 4);          /* UPLOAD 7 */
+    put(stream, &length, 0x0F, 3, 4);          /* SEMAPHORE_SIGNAL 3 */
+    put(stream, &length, 0x03, 0, 0);
+    put(stream, &length, 0x04, 0, 0);
+    put(stream, &length, 0x09, 0, 0);          /* CHECKPOINT (15) */
+    put(stream, &length, 0x01, 0, 0);
+    put(stream, &length, 0x10, 3, 4);          /* SEMAPHORE_WAIT 3 */
+    put(stream, &length, 0x25, 0, 2);          /* IF_EQ r0, r0 */
+    put(stream, &length, 0x15, 7, 4);          /* DOWNLOAD 7 */
+    put(stream, &length, 0x29, 0, 0);          /* ELSE */
+    put(stream, &length, 0x13, 7, 4);          /* FREE_BUFFER 7 (dead) */
+    put(stream, &length, 0x2A, 0, 0);          /* ENDIF */
+    put(stream, &length, 0x03, 0, 0);
+    put(stream, &length, 0x04, 0, 0);
+    put(stream, &length, 0x05, 0, 0);          /* END_STREAM */
+    put(stream, &length, 0x06, 0, 0);          /* END_PROGRAM */
+    assert(length <= sizeof(stream));
+    verify_clean(stream, length);
+
+    gdsl_diff_result_t diff;
+    memset(&diff, 0, sizeof(diff));
+    const gdsl_diff_result_t *diffs[] = {&diff};
+    gdsl_slice_options_t options;
+    memset(&options, 0, sizeof(options));
+    options.snapshot_diffs = diffs;
+    options.snapshot_diff_count = 1;
+
+    const uint64_t cuts[] = {7, 15};
+    gdsl_slice_set_t set;
+    assert(gdsl_slice(stream, length, cuts, 2, &options, &set) == 0);
+    assert(set.count == 3);
+    check_slices(stream, length, &set);
+
+    assert(set.slices[0].checkpoint == GDSL_SLICE_NONE);
+    assert(set.slices[0].snapshot == GDSL_SLICE_NONE);
+    assert(set.slices[0].diff == NULL);
+    assert(set.slices[1].begin_index == 7 && set.slices[1].end_index == 15);
+    assert(set.slices[1].checkpoint == 0);
+    assert(set.slices[2].checkpoint == 1);
+    assert(set.slices[2].end_index == 27);
+    for (size_t i = 1; i < 3; ++i) {
+        assert(set.slices[i].snapshot == 0);
+        assert(set.slices[i].diff == &diff);
+    }
+
+    /* Both buffers are live at the first cut; only buffer 7, the pending
+     * signal and r0 at the second. */
+    const uint8_t first[] = {0x01, 0x12, 7, 0, 0, 0, 0x12, 9, 0, 0, 0, 0x03, 0x04};
+    assert(set.slices[1].prologue_length == sizeof(first));
+    assert(memcmp(set.slices[1].prologue, first, sizeof(first)) == 0);
+    const uint8_t second[] = {0x01, 0x12, 7, 0, 0, 0, 0x0F, 3, 0, 0, 0, 0x03, 0x04,
+                              0x21, 0, 5, 0, 0, 0};
+    assert(set.slices[2].prologue_length == sizeof(second));
+    assert(memcmp(set.slices[2].prologue, second, sizeof(second)) == 0);
+    const uint8_t epilogue[] = {0x05};
+    assert(set.slices[0].epilogue_length == sizeof(epilogue));
+    assert(memcmp(set.slices[0].epilogue, epilogue, sizeof(epilogue)) == 0);
+    gdsl_slice_set_destroy(&set);
+
+    /* No cuts: one slice, the stream itself. */
+    assert(gdsl_slice(stream, length, NULL, 0, NULL, &set) == 0);
+    assert(set.count == 1);
+    check_slices(stream, length, &set);
+    gdsl_slice_set_destroy(&set);
+
+    /* Not a CHECKPOINT, not increasing, past the end. */
+    const uint64_t not_checkpoint[] = {8};
+    assert(gdsl_slice(stream, length, not_checkpoint, 1, NULL, &set) == -1);
+    const uint64_t decreasing[] = {15, 7};
+    assert(gdsl_slice(stream, length, decreasing, 2, NULL, &set) == -1);
+    const uint64_t past_end[] = {7, 40};
+    assert(gdsl_slice(stream, length, past_end, 2, NULL, &set) == -1);
+    assert(set.slices == NULL && set.count == 0);
+}
+
+static void test_slice_devices(void) {
+    /* Device 1 is recording a render pass on queue 2 when device 0 reaches
+     * its checkpoint; device 0 waits on a semaphore device 1 signals later. */
+    uint8_t stream[128];
+    size_t length = 0;
+    put(stream, &length, 0x0E, 1, 1);                  /* SET_DEVICE 1 */
+    put(stream, &length, 0x11, 2, 1);                  /* SET_QUEUE 2 */
+    put(stream, &length, 0x01, 0, 0);
+    put(stream, &length, 0x17, 0 | 1u << 8 | 1u << 16, 3); /* PIPE_BIND graphics */
+    put(stream, &length, 0x18, 0 | 40u << 8, 5);       /* SET_DESCRIPTOR 0, 40 */
+    put(stream, &length, 0x19, 0 | 41u << 8, 5);       /* BIND_BUFFER 0, 41 */
+    put(stream, &length, 0x1A, 0, 0);                  /* BEGIN_PASS */
+    put(stream, &length, 0x1F, 12, 4);                 /* QUERY_BEGIN 12 */
+    put(stream, &length, 0x0E, 0, 1);
+    put(stream, &length, 0x01, 0, 0);
+    put(stream, &length, 0x03, 0, 0);
+    put(stream, &length, 0x04, 0, 0);
+    put(stream, &length, 0x09, 0, 0);                  /* CHECKPOINT (12) */
+    put(stream, &length, 0x0E, 1, 1);
+    put(stream, &length, 0x1C, 3, 8);                  /* DRAW */
+    put(stream, &length, 0x20, 12, 4);                 /* QUERY_END */
+    put(stream, &length, 0x1B, 0, 0);                  /* END_PASS */
+    put(stream, &length, 0x0F, 5, 4);                  /* SEMAPHORE_SIGNAL 5 */
+    put(stream, &length, 0x03, 0, 0);
+    put(stream, &length, 0x04, 0, 0);
+    put(stream, &length, 0x05, 0, 0);
+    put(stream, &length, 0x0E, 0, 1);
+    put(stream, &length, 0x01, 0, 0);
+    put(stream, &length, 0x10, 5, 4);                  /* SEMAPHORE_WAIT 5 */
+    put(stream, &length, 0x03, 0, 0);
+    put(stream, &length, 0x04, 0, 0);
+    put(stream, &length, 0x09, 0, 0);                  /* CHECKPOINT (26) */
+    put(stream, &length, 0x05, 0, 0);
+    assert(length <= sizeof(stream));
+    verify_clean(stream, length);
+
+    const uint64_t cuts[] = {12, 26};
+    gdsl_slice_set_t set;
+    assert(gdsl_slice(stream, length, cuts, 2, NULL, &set) == 0);
+    assert(set.count == 3);
+    check_slices(stream, length, &set);
+    assert(set.slices[1].snapshot == GDSL_SLICE_NONE);
+    assert(set.slices[1].diff == NULL);
+    gdsl_slice_set_destroy(&set);
+
+    /* A wait cut off from the signal recorded after it. */
+    length = 0;
+    put(stream, &length, 0x01, 0, 0);
+    put(stream, &length, 0x10, 5, 4);                  /* SEMAPHORE_WAIT 5 */
+    put(stream, &length, 0x03, 0, 0);
+    put(stream, &length, 0x04, 0, 0);
+    put(stream, &length, 0x09, 0, 0);                  /* CHECKPOINT (4) */
+    put(stream, &length, 0x0E, 1, 1);
+    put(stream, &length, 0x01, 0, 0);
+    put(stream, &length, 0x0F, 5, 4);
+    put(stream, &length, 0x03, 0, 0);
+    put(stream, &length, 0x04, 0, 0);
+    put(stream, &length, 0x05, 0, 0);
+    put(stream, &length, 0x0E, 0, 1);
+    put(stream, &length, 0x05, 0, 0);
+    verify_clean(stream, length);
+    const uint64_t early[] = {4};
+    assert(gdsl_slice(stream, length, early, 1, NULL, &set) == -1);
+
+    /* A cut inside an IF. */
+    length = 0;
+    put(stream, &length, 0x01, 0, 0);
+    put(stream, &length, 0x03, 0, 0);
+    put(stream, &length, 0x04, 0, 0);
+    put(stream, &length, 0x25, 0x0100, 2);             /* IF_EQ r0, r1 */
+    put(stream, &length, 0x09, 0, 0);                  /* CHECKPOINT (4) */
+    put(stream, &length, 0x2A, 0, 0);
+    put(stream, &length, 0x05, 0, 0);
+    verify_clean(stream, length);
+    const uint64_t inside[] = {4};
+    assert(gdsl_slice(stream, length, inside, 1, NULL, &set) == -1);
+}
+
+/* Frames that allocate, free and signal across a checkpoint each, cut at
+ * every checkpoint. */
+static void test_slice_every_checkpoint(void) {
+    enum { FRAMES = 40 };
+    uint8_t *stream = (uint8_t *)malloc(FRAMES * 40 + 8);
+    uint64_t cuts[FRAMES];
+    size_t length = 0;
+    uint64_t index = 0;
+    for (uint32_t frame = 0; frame < FRAMES; ++frame) {
+        put(stream, &length, 0x01, 0, 0);
+        if (frame > 0) {
+            put(stream, &length, 0x10, frame - 1, 4);  /* wait for the last frame */
+            index++;
+        }
+        put(stream, &length, 0x12, 100 + frame, 4);
+        if (frame >= 2) {
+            put(stream, &length, 0x13, 100 + frame - 2, 4);
+            index++;
+        }
+        put(stream, &length, 0x0F, frame, 4);
+        put(stream, &length, 0x03, 0, 0);
+        put(stream, &length, 0x04, 0, 0);
+        index += 5;
+        cuts[frame] = index;
+        put(stream, &length, 0x09, 0, 0);
+        index++;
+    }
+    put(stream, &length, 0x05, 0, 0);
+    verify_clean(stream, length);
+
+    gdsl_slice_set_t set;
+    assert(gdsl_slice(stream, length, cuts, FRAMES, NULL, &set) == 0);
+    assert(set.count == FRAMES + 1);
+    for (size_t i = 1; i < set.count; ++i) {
+        assert(set.slices[i].checkpoint == i - 1);
+    }
+    check_slices(stream, length, &set);
+    gdsl_slice_set_destroy(&set);
+    free(stream);
+}
+
+int main(void) {
+    test_slice_prologues();
+    test_slice_devices();
+    test_slice_every_checkpoint();
+    puts("All slice tests completed.");
+    return 0;
+}
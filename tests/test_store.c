@@ -0,0 +1,225 @@
+#include "gdsl/store.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static void make_path(char *path, size_t size) {
+    snprintf(path, size, "/tmp/gdsl_store_test_%ld.wal", (long)getpid());
+    unlink(path);
+}
+
+/* A diff of target against a zero base, with seed-dependent contents. */
+static void make_diff(uint32_t seed, size_t pages, gdsl_diff_result_t *out) {
+    size_t length = pages * 4096 + seed % 100;
+    uint8_t *target = (uint8_t *)calloc(length, 1);
+    assert(target);
+    for (size_t i = seed % 7; i < length; i += 5) {
+        target[i] = (uint8_t)(seed + i);
+    }
+    assert(gdsl_diff(NULL, 0, target, length, out) == 0);
+    free(target);
+}
+
+static void assert_same_diff(const gdsl_diff_result_t *a, const gdsl_diff_result_t *b) {
+    assert(a->chunk_count == b->chunk_count);
+    assert(a->payload_length == b->payload_length);
+    assert(a->header.target_length == b->header.target_length);
+    assert(a->header.page_size == b->header.page_size);
+    assert(a->header.flags == b->header.flags);
+    for (size_t i = 0; i < a->chunk_count; ++i) {
+        assert(a->chunks[i].page_index == b->chunks[i].page_index);
+        assert(a->chunks[i].length == b->chunks[i].length);
+        assert(a->chunks[i].data_offset == b->chunks[i].data_offset);
+        assert(a->chunks[i].reference == b->chunks[i].reference);
+    }
+    assert(memcmp(a->payload, b->payload, a->payload_length) == 0);
+}
+
+static void test_store_roundtrip(void) {
+    char path[64];
+    make_path(path, sizeof(path));
+
+    gdsl_store_t *store = NULL;
+    gdsl_store_recovery_t recovery;
+    assert(gdsl_store_open(path, NULL, &store, &recovery) == 0);
+    assert(recovery.record_count == 0 && recovery.truncated_bytes == 0);
+
+    gdsl_diff_result_t diffs[5];
+    for (uint32_t i = 0; i < 5; ++i) {
+        make_diff(i + 1, i + 1, &diffs[i]);
+        size_t index = 99;
+        assert(gdsl_store_append(store, 100 + i, &diffs[i], &index) == 0);
+        assert(index == i);
+    }
+    gdsl_store_stats_t stats;
+    gdsl_store_stats(store, &stats);
+    assert(stats.record_count == 5);
+    assert(stats.commit_count == 5);
+    gdsl_store_close(store);
+
+    assert(gdsl_store_open(path, NULL, &store, &recovery) == 0);
+    assert(recovery.record_count == 5 && recovery.truncated_bytes == 0);
+    for (size_t i = 0; i < 5; ++i) {
+        gdsl_diff_result_t read;
+        uint64_t checkpoint = 0;
+        assert(gdsl_store_read(store, i, &checkpoint, &read) == 0);
+        assert(checkpoint == 100 + i);
+        assert_same_diff(&diffs[i], &read);
+        gdsl_diff_result_destroy(&read);
+    }
+    gdsl_diff_result_t missing;
+    assert(gdsl_store_read(store, 5, NULL, &missing) == -1);
+
+    /* Appends continue after the recovered records. */
+    size_t index = 0;
+    assert(gdsl_store_append(store, 200, &diffs[0], &index) == 0);
+    assert(index == 5);
+    gdsl_store_close(store);
+
+    for (size_t i = 0; i < 5; ++i) {
+        gdsl_diff_result_destroy(&diffs[i]);
+    }
+    unlink(path);
+}
+
+static void test_store_truncates_torn_tail(void) {
+    char path[64];
+    make_path(path, sizeof(path));
+
+    gdsl_store_t *store = NULL;
+    assert(gdsl_store_open(path, NULL, &store, NULL) == 0);
+    gdsl_diff_result_t diff;
+    make_diff(9, 3, &diff);
+    for (uint64_t i = 0; i < 3; ++i) {
+        assert(gdsl_store_append(store, i, &diff, NULL) == 0);
+    }
+    gdsl_store_stats_t stats;
+    gdsl_store_stats(store, &stats);
+    uint64_t full = stats.durable_bytes;
+    uint64_t record = full / 3;
+    gdsl_store_close(store);
+
+    /* A crash halfway through the third record. */
+    assert(truncate(path, (off_t)(full - record / 2)) == 0);
+    gdsl_store_recovery_t recovery;
+    assert(gdsl_store_open(path, NULL, &store, &recovery) == 0);
+    assert(recovery.record_count == 2);
+    assert(recovery.valid_bytes == 2 * record);
+    assert(recovery.truncated_bytes == record - record / 2);
+    assert(gdsl_store_append(store, 2, &diff, NULL) == 0);
+    gdsl_store_close(store);
+
+    /* A flipped payload byte fails the checksum of the last record. */
+    FILE *file = fopen(path, "r+b");
+    assert(file);
+    assert(fseek(file, (long)(full - 10), SEEK_SET) == 0);
+    int byte = fgetc(file);
+    assert(fseek(file, (long)(full - 10), SEEK_SET) == 0);
+    fputc(byte ^ 0x40, file);
+    fclose(file);
+    assert(gdsl_store_open(path, NULL, &store, &recovery) == 0);
+    assert(recovery.record_count == 2);
+    assert(recovery.truncated_bytes == record);
+    gdsl_diff_result_t read;
+    assert(gdsl_store_read(store, 1, NULL, &read) == 0);
+    assert_same_diff(&diff, &read);
+    gdsl_diff_result_destroy(&read);
+    gdsl_store_close(store);
+
+    /* Garbage that is not a record at all. */
+    file = fopen(path, "ab");
+    assert(file);
+    fputs("not a record", file);
+    fclose(file);
+    assert(gdsl_store_open(path, NULL, &store, &recovery) == 0);
+    assert(recovery.record_count == 2 && recovery.truncated_bytes == 12);
+    gdsl_store_close(store);
+
+    gdsl_diff_result_destroy(&diff);
+    unlink(path);
+}
+
+#define STORE_WRITERS 4
+#define STORE_APPENDS 40
+
+typedef struct {
+    gdsl_store_t *store;
+    uint32_t writer;
+} store_writer_t;
+
+static void *append_many(void *arg) {
+    store_writer_t *writer = (store_writer_t *)arg;
+    for (uint32_t i = 0; i < STORE_APPENDS; ++i) {
+        gdsl_diff_result_t diff;
+        make_diff(writer->writer * 1000 + i, 1, &diff);
+        assert(gdsl_store_append(writer->store, writer->writer * 1000 + i, &diff, NULL) == 0);
+        gdsl_diff_result_destroy(&diff);
+    }
+    return NULL;
+}
+
+static void test_store_group_commit(void) {
+    char path[64];
+    make_path(path, sizeof(path));
+
+    gdsl_store_options_t options;
+    memset(&options, 0, sizeof(options));
+    options.group_delay_us = 200;
+    gdsl_store_t *store = NULL;
+    assert(gdsl_store_open(path, &options, &store, NULL) == 0);
+
+    pthread_t threads[STORE_WRITERS];
+    store_writer_t writers[STORE_WRITERS];
+    for (uint32_t i = 0; i < STORE_WRITERS; ++i) {
+        writers[i].store = store;
+        writers[i].writer = i;
+        assert(pthread_create(&threads[i], NULL, append_many, &writers[i]) == 0);
+    }
+    for (uint32_t i = 0; i < STORE_WRITERS; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+    gdsl_store_stats_t stats;
+    gdsl_store_stats(store, &stats);
+    assert(stats.record_count == STORE_WRITERS * STORE_APPENDS);
+    assert(stats.commit_count >= 1 && stats.commit_count <= stats.record_count);
+    printf("%zu records in %llu group commits\n", stats.record_count,
+           (unsigned long long)stats.commit_count);
+    gdsl_store_close(store);
+
+    /* Every record survives reopening and is one of the appended diffs. */
+    gdsl_store_recovery_t recovery;
+    assert(gdsl_store_open(path, NULL, &store, &recovery) == 0);
+    assert(recovery.record_count == STORE_WRITERS * STORE_APPENDS);
+    int seen[STORE_WRITERS][STORE_APPENDS];
+    memset(seen, 0, sizeof(seen));
+    for (size_t i = 0; i < recovery.record_count; ++i) {
+        gdsl_diff_result_t read;
+        uint64_t checkpoint = 0;
+        assert(gdsl_store_read(store, i, &checkpoint, &read) == 0);
+        gdsl_diff_result_t expected;
+        make_diff((uint32_t)checkpoint, 1, &expected);
+        assert_same_diff(&expected, &read);
+        seen[checkpoint / 1000][checkpoint % 1000]++;
+        gdsl_diff_result_destroy(&expected);
+        gdsl_diff_result_destroy(&read);
+    }
+    for (size_t w = 0; w < STORE_WRITERS; ++w) {
+        for (size_t i = 0; i < STORE_APPENDS; ++i) {
+            assert(seen[w][i] == 1);
+        }
+    }
+    gdsl_store_close(store);
+    unlink(path);
+}
+
+int main(void) {
+    test_store_roundtrip();
+    test_store_truncates_torn_tail();
+    test_store_group_commit();
+    puts("All store tests completed.");
+    return 0;
+}
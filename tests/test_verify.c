@@ -1,11 +1,17 @@
 #include "gdsl/verify.h"
+#include "gdsl/diagnostics.h"
+#include "gdsl/encode.h"
 
 #include <assert.h>
+#include <inttypes.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 static void print_report(const char *label, const gdsl_verify_report_t *report) {
-    printf("%s: success=%d errors=%zu warnings=%zu infos=%zu\n",
+    printf("%s: success=%d errors=%" PRIu64 " warnings=%" PRIu64
+           " infos=%" PRIu64 "\n",
            label,
            report->success,
            report->error_count,
@@ -13,7 +19,7 @@ static void print_report(const char *label, const gdsl_verify_report_t *report)
            report->info_count);
     for (size_t i = 0; i < report->diagnostic_count; ++i) {
         const gdsl_verify_diagnostic_t *diag = &report->diagnostics[i];
-        printf("  [%zu] severity=%d %s\n",
+        printf("  [%" PRIu64 "] severity=%d %s\n",
                diag->instruction_index,
                (int)diag->severity,
                diag->message);
@@ -91,11 +97,805 @@ static void test_snapshot_constraints(void) {
     assert(report.error_count >= 1);
 }
 
+static void test_batch_matches_single(void) {
+    const uint8_t good[] = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06};
+    const uint8_t bad[] = {0x03, 0x04, 0x05, 0x06};
+
+    gdsl_pool_options_t pool_options;
+    memset(&pool_options, 0, sizeof(pool_options));
+    pool_options.thread_count = 3;
+    gdsl_pool_t *pool = NULL;
+    int rc = gdsl_pool_create(&pool_options, &pool);
+    assert(rc == 0);
+
+    enum { BATCH = 16 };
+    static gdsl_verify_report_t reports[BATCH];
+    gdsl_verify_batch_item_t items[BATCH];
+    for (size_t i = 0; i < BATCH; ++i) {
+        items[i].stream = (i % 2) ? bad : good;
+        items[i].length = (i % 2) ? sizeof(bad) : sizeof(good);
+        items[i].report = &reports[i];
+    }
+
+    rc = gdsl_verify_batch(items, BATCH, GDSL_VERIFY_LEVEL_DOMAIN, pool);
+    assert(rc == 0);
+
+    gdsl_verify_report_t single;
+    for (size_t i = 0; i < BATCH; ++i) {
+        rc = gdsl_verify(items[i].stream, items[i].length,
+                         GDSL_VERIFY_LEVEL_DOMAIN, &single);
+        assert(rc == 0);
+        assert(memcmp(&single, &reports[i], sizeof(single)) == 0);
+        assert(reports[i].success == !(i % 2));
+    }
+
+    gdsl_pool_destroy(pool);
+}
+
+static void test_early_exit_limits(void) {
+    const size_t length = 1u << 20;
+    uint8_t *stream = (uint8_t *)malloc(length);
+    assert(stream);
+    memset(stream, 0xFF, length); /* every byte is an unknown opcode */
+
+    static gdsl_verify_report_t report;
+    int rc = gdsl_verify(stream, 100, GDSL_VERIFY_LEVEL_SYNTAX, &report);
+    assert(rc == 0);
+    assert(!report.success);
+    assert(report.error_count == 101); /* plus the missing END_STREAM */
+    assert(report.diagnostic_count == GDSL_VERIFY_MAX_DIAGNOSTICS);
+    assert(report.dropped_diagnostic_count == 101 - GDSL_VERIFY_MAX_DIAGNOSTICS);
+    assert(report.flags & GDSL_VERIFY_REPORT_DIAGNOSTICS_TRUNCATED);
+    assert(!(report.flags & GDSL_VERIFY_REPORT_STOPPED_EARLY));
+
+    gdsl_verify_options_t options;
+    memset(&options, 0, sizeof(options));
+    options.flags = GDSL_VERIFY_FAIL_FAST;
+    rc = gdsl_verify_ex(stream, length, GDSL_VERIFY_LEVEL_DOMAIN, &options,
+                        &report);
+    assert(rc == 0);
+    assert(!report.success);
+    assert(report.error_count == 1);
+    assert(report.flags & GDSL_VERIFY_REPORT_STOPPED_EARLY);
+    assert(report.stop_index == 1);
+
+    options.flags = 0;
+    options.max_errors = 3;
+    rc = gdsl_verify_ex(stream, length, GDSL_VERIFY_LEVEL_DOMAIN, &options,
+                        &report);
+    assert(rc == 0);
+    assert(report.error_count == 3);
+    assert(report.stop_index == 3);
+
+    options.flags = GDSL_VERIFY_STOP_WHEN_FULL;
+    options.max_errors = 0;
+    rc = gdsl_verify_ex(stream, length, GDSL_VERIFY_LEVEL_DOMAIN, &options,
+                        &report);
+    assert(rc == 0);
+    assert(report.diagnostic_count == GDSL_VERIFY_MAX_DIAGNOSTICS);
+    assert(report.dropped_diagnostic_count == 0);
+    assert(report.stop_index == GDSL_VERIFY_MAX_DIAGNOSTICS);
+
+    /* Limits that are never hit leave a clean stream's report unchanged. */
+    const uint8_t good[] = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06};
+    options.flags = GDSL_VERIFY_FAIL_FAST;
+    rc = gdsl_verify_ex(good, sizeof(good), GDSL_VERIFY_LEVEL_DOMAIN, &options,
+                        &report);
+    assert(rc == 0);
+    assert(report.success);
+    assert(report.flags == 0);
+
+    free(stream);
+}
+
+/* Builds BEGIN, pad, BARRIER, SUBMIT, pad, FENCE_WAIT, pad, END_STREAM,
+ * END_PROGRAM where each pad alternates runs of NOP and filler. */
+static size_t build_padded(uint8_t *stream, size_t pad, uint8_t filler) {
+    size_t n = 0;
+    stream[n++] = 0x01;
+    for (int section = 0; section < 3; ++section) {
+        for (size_t i = 0; i < pad; ++i) {
+            stream[n++] = ((i / 7) % 2) ? filler : 0x00;
+        }
+        if (section == 0) {
+            stream[n++] = 0x02;
+            stream[n++] = 0x03;
+        } else if (section == 1) {
+            stream[n++] = 0x04;
+        }
+    }
+    stream[n++] = 0x05;
+    stream[n++] = 0x06;
+    return n;
+}
+
+static void test_neutral_runs(void) {
+    const size_t pad = 1003;
+    uint8_t *stream = (uint8_t *)malloc(3 * pad + 8);
+    assert(stream);
+    static gdsl_verify_report_t report;
+
+    size_t length = build_padded(stream, pad, 0x00);
+    int rc = gdsl_verify(stream, length, GDSL_VERIFY_LEVEL_DOMAIN, &report);
+    assert(rc == 0);
+    assert(report.success);
+    assert(report.instruction_count == length);
+
+    /* CHECKPOINT is only neutral in Idle at DOMAIN level; elsewhere every one
+     * must still be reported. */
+    length = build_padded(stream, pad, 0x09);
+    size_t checkpoints = 0;
+    for (size_t i = 0; i < pad; ++i) {
+        checkpoints += ((i / 7) % 2) ? 1 : 0;
+    }
+    rc = gdsl_verify(stream, length, GDSL_VERIFY_LEVEL_DOMAIN, &report);
+    assert(rc == 0);
+    assert(!report.success);
+    assert(report.instruction_count == length);
+    assert(report.error_count == 2 * checkpoints); /* Record and Submitted */
+    assert(report.diagnostics[0].instruction_index == 8);
+
+    rc = gdsl_verify(stream, length, GDSL_VERIFY_LEVEL_PHASE, &report);
+    assert(rc == 0);
+    assert(report.success);
+    assert(report.instruction_count == length);
+
+    /* A run that ends in an unknown opcode stops exactly there. */
+    length = build_padded(stream, pad, 0x00);
+    stream[100] = 0xFF;
+    rc = gdsl_verify(stream, length, GDSL_VERIFY_LEVEL_DOMAIN, &report);
+    assert(rc == 0);
+    assert(report.error_count == 1);
+    assert(report.diagnostics[0].instruction_index == 100);
+    assert(report.instruction_count == length - 1);
+
+    free(stream);
+}
+
+static void test_snapshot_index(void) {
+    const uint8_t stream[] = {
+        0x01, 0x02, 0x03, 0x04, /* BEGIN_STREAM .. FENCE_WAIT */
+        0x07, 0x09, 0x08,       /* 4: safe region */
+        0x00,
+        0x01,                   /* BEGIN_STREAM */
+        0x07, 0x08,             /* 9: region entered in Record */
+        0x02, 0x03, 0x04,
+        0x07,                   /* 14: never closed */
+        0x05, 0x06
+    };
+
+    gdsl_verify_snapshot_t regions[4];
+    gdsl_verify_options_t options;
+    memset(&options, 0, sizeof(options));
+    options.snapshots = regions;
+    options.snapshot_capacity = 4;
+
+    static gdsl_verify_report_t report;
+    int rc = gdsl_verify_ex(stream, sizeof(stream), GDSL_VERIFY_LEVEL_DOMAIN,
+                            &options, &report);
+    assert(rc == 0);
+    assert(!report.success);
+    assert(report.snapshot_count == 3);
+
+    assert(regions[0].begin_index == 4 && regions[0].end_index == 6);
+    assert(regions[0].flags == GDSL_VERIFY_SNAPSHOT_SAFE);
+    assert(regions[0].entry_phase == GDSL_VERIFY_PHASE_IDLE);
+    assert(!regions[0].entry_device_domain);
+
+    assert(regions[1].begin_index == 9 && regions[1].end_index == 10);
+    assert(regions[1].flags == 0);
+    assert(regions[1].error_count == 1);
+    assert(regions[1].entry_phase == GDSL_VERIFY_PHASE_RECORD);
+
+    assert(regions[2].begin_index == 14);
+    assert(regions[2].end_index == sizeof(stream));
+    assert(regions[2].end_offset == sizeof(stream));
+    assert(regions[2].flags == GDSL_VERIFY_SNAPSHOT_UNTERMINATED);
+
+    assert(gdsl_verify_find_snapshot(regions, 3, 5) == &regions[0]);
+    assert(gdsl_verify_find_snapshot(regions, 3, 7) == NULL);
+    assert(gdsl_verify_find_snapshot(regions, 3, 9) == &regions[1]);
+    assert(gdsl_verify_find_snapshot(regions, 3, 16) == &regions[2]);
+    assert(gdsl_verify_find_snapshot(regions, 3, 0) == NULL);
+
+    options.snapshot_capacity = 1;
+    rc = gdsl_verify_ex(stream, sizeof(stream), GDSL_VERIFY_LEVEL_DOMAIN,
+                        &options, &report);
+    assert(rc == 0);
+    assert(report.snapshot_count == 3);
+    assert(report.flags & GDSL_VERIFY_REPORT_SNAPSHOTS_TRUNCATED);
+
+    /* Snapshot rules only exist at DOMAIN level. */
+    rc = gdsl_verify_ex(stream, sizeof(stream), GDSL_VERIFY_LEVEL_PHASE,
+                        &options, &report);
+    assert(rc == 0);
+    assert(report.snapshot_count == 0);
+}
+
+static void test_snapshot_resources(void) {
+    const uint8_t stream[] = {
+        0x01,
+        0x12, 7, 0, 0, 0,       /* ALLOC_BUFFER 7 */
+        0x12, 3, 0, 0, 0,       /* ALLOC_BUFFER 3 */
+        0x03, 0x04,
+        0x07, 0x08,             /* 5: captures {3, 7} */
+        0x01,
+        0x13, 7, 0, 0, 0,       /* FREE_BUFFER 7 */
+        0x12, 9, 0, 0, 0,       /* ALLOC_BUFFER 9 */
+        0x03, 0x04,
+        0x07, 0x08,             /* 12: captures {3, 9} */
+        0x07, 0x08,             /* 14: out of resource storage */
+        0x05, 0x06
+    };
+
+    gdsl_verify_snapshot_t regions[4];
+    uint32_t resources[5];
+    gdsl_verify_options_t options;
+    memset(&options, 0, sizeof(options));
+    options.snapshots = regions;
+    options.snapshot_capacity = 4;
+    options.snapshot_resources = resources;
+    options.snapshot_resource_capacity = 5;
+
+    static gdsl_verify_report_t report;
+    int rc = gdsl_verify_ex(stream, sizeof(stream), GDSL_VERIFY_LEVEL_DOMAIN,
+                            &options, &report);
+    assert(rc == 0);
+    assert(report.success);
+    assert(report.snapshot_count == 3);
+
+    assert(regions[0].resource_offset == 0 && regions[0].resource_count == 2);
+    assert(resources[0] == 3 && resources[1] == 7);
+    assert(regions[1].resource_offset == 2 && regions[1].resource_count == 2);
+    assert(resources[2] == 3 && resources[3] == 9);
+    assert(regions[2].resource_offset == 4 && regions[2].resource_count == 1);
+    assert(regions[2].flags & GDSL_VERIFY_SNAPSHOT_RESOURCES_TRUNCATED);
+    assert(!(regions[1].flags & GDSL_VERIFY_SNAPSHOT_RESOURCES_TRUNCATED));
+
+    /* A failing instruction leads back to the buffers its region captured. */
+    const gdsl_verify_snapshot_t *region = gdsl_verify_find_snapshot(regions, 3, 13);
+    assert(region == &regions[1]);
+    assert(resources[region->resource_offset + 1] == 9);
+    assert(gdsl_verify_find_snapshot(regions, 3, 8) == NULL);
+
+    /* Without resource storage the ranges stay empty. */
+    options.snapshot_resources = NULL;
+    rc = gdsl_verify_ex(stream, sizeof(stream), GDSL_VERIFY_LEVEL_DOMAIN,
+                        &options, &report);
+    assert(rc == 0);
+    assert(regions[0].resource_count == 0 && regions[1].resource_count == 0);
+}
+
+static void test_aggregated_diagnostics(void) {
+    uint8_t stream[1000];
+    memset(stream, 0xFF, sizeof(stream));
+
+    gdsl_verify_options_t options;
+    memset(&options, 0, sizeof(options));
+    options.flags = GDSL_VERIFY_AGGREGATE;
+
+    static gdsl_verify_report_t report;
+    int rc = gdsl_verify_ex(stream, sizeof(stream), GDSL_VERIFY_LEVEL_SYNTAX,
+                            &options, &report);
+    assert(rc == 0);
+    assert(report.flags & GDSL_VERIFY_REPORT_AGGREGATED);
+    assert(report.error_count == 1001);
+    assert(report.diagnostic_count == 2);
+    assert(report.diagnostics[0].occurrence_count == 1000);
+    assert(report.diagnostics[0].instruction_index == 0);
+    assert(report.diagnostics[0].last_instruction_index == 999);
+    assert(report.diagnostics[1].occurrence_count == 1);
+    assert(report.dropped_diagnostic_count == 0);
+}
+
+typedef struct {
+    gdsl_diag_collector_t *collector;
+} flood_ctx_t;
+
+static void flood_range(void *ctx, size_t begin, size_t end, size_t worker) {
+    flood_ctx_t *flood = (flood_ctx_t *)ctx;
+    for (size_t i = begin; i < end; ++i) {
+        char message[64];
+        gdsl_diag_collector_add(flood->collector, worker, i,
+                                GDSL_VERIFY_SEVERITY_WARNING,
+                                "BARRIER issued outside device domain");
+        if (i % 97 == 0) {
+            snprintf(message, sizeof(message), "error class %zu", i % 5);
+            gdsl_diag_collector_add(flood->collector, worker, i,
+                                    GDSL_VERIFY_SEVERITY_ERROR, message);
+        }
+    }
+}
+
+static void test_collector_is_deterministic(void) {
+    static gdsl_verify_report_t reference;
+    static gdsl_verify_report_t merged;
+    const size_t thread_counts[] = {1, 2, 4};
+
+    for (size_t t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]); ++t) {
+        gdsl_pool_options_t pool_options;
+        memset(&pool_options, 0, sizeof(pool_options));
+        pool_options.thread_count = thread_counts[t];
+        gdsl_pool_t *pool = NULL;
+        int rc = gdsl_pool_create(&pool_options, &pool);
+        assert(rc == 0);
+
+        gdsl_diag_collector_t *collector = NULL;
+        rc = gdsl_diag_collector_create(gdsl_pool_thread_count(pool), &collector);
+        assert(rc == 0);
+        flood_ctx_t flood = {collector};
+        rc = gdsl_pool_parallel_for(pool, 0, 10000, 16, flood_range, &flood);
+        assert(rc == 0);
+
+        rc = gdsl_diag_collector_merge(collector, t == 0 ? &reference : &merged);
+        assert(rc == 0);
+        if (t > 0) {
+            assert(memcmp(&reference, &merged, sizeof(merged)) == 0);
+        }
+
+        gdsl_diag_collector_destroy(collector);
+        gdsl_pool_destroy(pool);
+    }
+
+    assert(reference.warning_count == 10000);
+    assert(reference.error_count == (10000 + 96) / 97);
+    assert(reference.diagnostic_count == 6);
+    assert(reference.diagnostics[0].severity == GDSL_VERIFY_SEVERITY_ERROR);
+    assert(reference.diagnostics[0].instruction_index == 0);
+    assert(reference.diagnostics[1].occurrence_count == 10000);
+    assert(reference.diagnostics[1].last_instruction_index == 9999);
+    for (size_t i = 1; i < reference.diagnostic_count; ++i) {
+        assert(reference.diagnostics[i - 1].instruction_index <=
+               reference.diagnostics[i].instruction_index);
+    }
+
+    /* Segment reports fold into the same entries with shifted indices. */
+    gdsl_diag_collector_t *collector = NULL;
+    int rc = gdsl_diag_collector_create(1, &collector);
+    assert(rc == 0);
+    const uint8_t segment[] = {0xFF, 0xFF};
+    static gdsl_verify_report_t part;
+    gdsl_verify(segment, sizeof(segment), GDSL_VERIFY_LEVEL_SYNTAX, &part);
+    gdsl_diag_collector_add_report(collector, 0, &part, 0, 0);
+    gdsl_diag_collector_add_report(collector, 0, &part, 100, 100);
+    rc = gdsl_diag_collector_merge(collector, &merged);
+    assert(rc == 0);
+    assert(merged.error_count == 6);
+    assert(merged.diagnostic_count == 2); /* unknown opcode, no END_STREAM */
+    assert(merged.diagnostics[0].occurrence_count == 4);
+    assert(merged.diagnostics[0].last_instruction_index == 101);
+    assert(merged.diagnostics[1].instruction_index == 2);
+    assert(merged.diagnostics[1].last_instruction_index == 102);
+    gdsl_diag_collector_destroy(collector);
+}
+
+static void test_verify_file_windows(void) {
+    const size_t length = (3u << 20) + 12345;
+    uint8_t *stream = (uint8_t *)calloc(length, 1); /* NOP padding */
+    assert(stream);
+    stream[0] = 0x01;
+    stream[4095] = 0xFF; /* last byte of the first page */
+    stream[4096] = 0x02;
+    stream[8191] = 0x03;
+    stream[8192] = 0x04;
+    stream[1u << 20] = 0x07;
+    stream[(2u << 20) + 1] = 0x08;
+    stream[length - 3] = 0xFE;
+    stream[length - 2] = 0x05;
+    stream[length - 1] = 0x06;
+
+    char path[] = "/tmp/gdsl_verify_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    FILE *file = fdopen(fd, "wb");
+    assert(file);
+    assert(fwrite(stream, 1, length, file) == length);
+    fclose(file);
+
+    gdsl_verify_snapshot_t regions[2];
+    gdsl_verify_options_t options;
+    memset(&options, 0, sizeof(options));
+    options.snapshots = regions;
+    options.snapshot_capacity = 2;
+
+    static gdsl_verify_report_t expected;
+    static gdsl_verify_report_t windowed;
+    int rc = gdsl_verify_ex(stream, length, GDSL_VERIFY_LEVEL_DOMAIN, &options,
+                            &expected);
+    assert(rc == 0);
+    assert(expected.error_count == 2);
+    assert(expected.warning_count == 1); /* BARRIER outside device domain */
+    assert(expected.diagnostics[0].byte_offset == 4095);
+    assert(expected.diagnostics[2].byte_offset == length - 3);
+    assert(expected.snapshot_count == 1);
+
+    const size_t windows[] = {0, 1, 8192, 65536 + 7};
+    for (size_t i = 0; i < sizeof(windows) / sizeof(windows[0]); ++i) {
+        options.window_size = windows[i];
+        rc = gdsl_verify_file(path, GDSL_VERIFY_LEVEL_DOMAIN, &options,
+                              &windowed);
+        assert(rc == 0);
+        assert(memcmp(&expected, &windowed, sizeof(windowed)) == 0);
+        assert(regions[0].begin_offset == (1u << 20));
+    }
+
+    assert(gdsl_verify_file("/nonexistent/gdsl", GDSL_VERIFY_LEVEL_SYNTAX,
+                            NULL, &windowed) == -1);
+
+    unlink(path);
+    free(stream);
+}
+
+static int has_diagnostic(const gdsl_verify_report_t *report, const char *text) {
+    for (size_t i = 0; i < report->diagnostic_count; ++i) {
+        if (strstr(report->diagnostics[i].message, text)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void test_multi_device_sync(void) {
+    static gdsl_verify_report_t report;
+
+    /* Device 1 waits for semaphore 7, signalled by device 0. */
+    const uint8_t synced[] = {
+        0x01, 0x0F, 0x07, 0x00, 0x00, 0x00, 0x03, 0x04, /* dev 0: signal 7 */
+        0x0E, 0x01,                                     /* SET_DEVICE 1 */
+        0x01, 0x10, 0x07, 0x00, 0x00, 0x00, 0x03, 0x04, 0x05, /* wait 7 */
+        0x0E, 0x00, 0x05, 0x06};
+    assert(gdsl_verify(synced, sizeof(synced), GDSL_VERIFY_LEVEL_DOMAIN, &report) == 0);
+    print_report("multi_device", &report);
+    assert(report.success);
+    assert(report.instruction_count == 13);
+
+    /* Each device waits for the other's signal first. */
+    const uint8_t cycle[] = {
+        0x01, 0x10, 0x01, 0x00, 0x00, 0x00, 0x0F, 0x02, 0x00, 0x00, 0x00,
+        0x03, 0x04, 0x05,
+        0x0E, 0x01,
+        0x01, 0x10, 0x02, 0x00, 0x00, 0x00, 0x0F, 0x01, 0x00, 0x00, 0x00,
+        0x03, 0x04, 0x05};
+    assert(gdsl_verify(cycle, sizeof(cycle), GDSL_VERIFY_LEVEL_PHASE, &report) == 0);
+    print_report("multi_device_deadlock", &report);
+    assert(!report.success);
+    assert(report.error_count == 2);
+    assert(report.diagnostics[0].byte_offset == 1);
+    assert(report.diagnostics[1].byte_offset == 17);
+    assert(has_diagnostic(&report, "deadlocks device 1"));
+
+    /* Unpaired operations; semaphores work on a single device too. */
+    const uint8_t unpaired[] = {
+        0x01, 0x10, 0x03, 0x00, 0x00, 0x00, 0x0F, 0x04, 0x00, 0x00, 0x00,
+        0x03, 0x04, 0x05, 0x06};
+    assert(gdsl_verify(unpaired, sizeof(unpaired), GDSL_VERIFY_LEVEL_PHASE,
+                       &report) == 0);
+    assert(report.error_count == 1 && report.warning_count == 1);
+    assert(has_diagnostic(&report, "semaphore 3 is never signalled"));
+    assert(has_diagnostic(&report, "semaphore 4 is never waited on"));
+
+    /* Semaphore operations are recorded, and every selected device must
+     * finish. */
+    const uint8_t unfinished[] = {
+        0x10, 0x05, 0x00, 0x00, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05,
+        0x0E, 0x02, 0x01};
+    assert(gdsl_verify(unfinished, sizeof(unfinished), GDSL_VERIFY_LEVEL_PHASE,
+                       &report) == 0);
+    print_report("multi_device_unfinished", &report);
+    assert(has_diagnostic(&report, "SEMAPHORE_WAIT not allowed in Record phase"));
+    assert(has_diagnostic(&report, "device 2: stream did not reach"));
+    assert(!has_diagnostic(&report, "device 0: stream did not reach"));
+}
+
+/* Random multi-device streams: per-device passes on a pool must reproduce
+ * the serial report exactly. */
+static void test_device_passes_match_serial(void) {
+    gdsl_pool_options_t pool_options;
+    memset(&pool_options, 0, sizeof(pool_options));
+    pool_options.thread_count = 3;
+    gdsl_pool_t *pool = NULL;
+    assert(gdsl_pool_create(&pool_options, &pool) == 0);
+
+    enum { MAX_LENGTH = 4096 };
+    static uint8_t stream[MAX_LENGTH];
+    static gdsl_verify_report_t serial;
+    static gdsl_verify_report_t parallel;
+    gdsl_verify_options_t options;
+    memset(&options, 0, sizeof(options));
+    options.pool = pool;
+
+    uint32_t seed = 99;
+    for (int round = 0; round < 300; ++round) {
+        seed = seed * 1103515245u + 12345u;
+        size_t target = 16 + (seed >> 16) % (MAX_LENGTH - 16);
+        size_t length = 0;
+        while (length + 5 <= target) {
+            seed = seed * 1103515245u + 12345u;
+            uint32_t pick = (seed >> 16) % 24;
+            uint32_t operand = (seed >> 8) % 4;
+            if (pick < 9) {
+                stream[length++] = (uint8_t)(1 + pick);
+            } else if (pick < 12) {
+                stream[length++] = 0x0E;
+                stream[length++] = (uint8_t)operand;
+            } else if (pick < 16) {
+                stream[length++] = pick < 14 ? 0x0F : 0x10;
+                memcpy(stream + length, &operand, 4);
+                length += 4;
+            } else if (pick == 16) {
+                stream[length++] = 0xFF;
+            } else {
+                stream[length++] = (uint8_t)(1 + pick % 6);
+            }
+        }
+        if (round % 7 == 0) {
+            stream[length++] = 0x0F; /* truncated */
+        }
+
+        for (int level = GDSL_VERIFY_LEVEL_SYNTAX; level <= GDSL_VERIFY_LEVEL_DOMAIN;
+             ++level) {
+            assert(gdsl_verify(stream, length, (gdsl_verify_level_t)level,
+                               &serial) == 0);
+            assert(gdsl_verify_ex(stream, length, (gdsl_verify_level_t)level,
+                                  &options, &parallel) == 0);
+            assert(memcmp(&serial, &parallel, sizeof(serial)) == 0);
+        }
+    }
+
+    gdsl_pool_destroy(pool);
+}
+
+static void verify_races(const uint8_t *stream, size_t length, gdsl_verify_report_t *report) {
+    gdsl_verify_options_t options;
+    memset(&options, 0, sizeof(options));
+    options.flags = GDSL_VERIFY_DETECT_RACES;
+    assert(gdsl_verify_ex(stream, length, GDSL_VERIFY_LEVEL_DOMAIN, &options, report) == 0);
+}
+
+static void test_race_detection(void) {
+    static gdsl_verify_report_t report;
+
+    /* Queue 1 reads buffer 1 while queue 0 may still be writing it. */
+    const uint8_t racy[] = {
+        0x01, 0x11, 0x00, 0x14, 0x01, 0x00, 0x00, 0x00, /* q0: UPLOAD 1 */
+        0x11, 0x01, 0x15, 0x01, 0x00, 0x00, 0x00,       /* q1: DOWNLOAD 1 */
+        0x03, 0x04, 0x05};
+    verify_races(racy, sizeof(racy), &report);
+    print_report("race", &report);
+    assert(!report.success);
+    assert(report.error_count == 1);
+    assert(report.diagnostics[0].byte_offset == 10);
+    assert(has_diagnostic(&report,
+                          "resource 1: read on device 0 queue 1 races with write "
+                          "on device 0 queue 0"));
+
+    /* Off by default. */
+    assert(gdsl_verify(racy, sizeof(racy), GDSL_VERIFY_LEVEL_DOMAIN, &report) == 0);
+    assert(report.success);
+
+    /* The encoded form decodes the operands the same way. */
+    uint8_t *encoded = NULL;
+    size_t encoded_length = 0;
+    assert(gdsl_encode(racy, sizeof(racy), &encoded, &encoded_length) == 0);
+    gdsl_verify_options_t options;
+    memset(&options, 0, sizeof(options));
+    options.flags = GDSL_VERIFY_DETECT_RACES;
+    static gdsl_verify_report_t encoded_report;
+    assert(gdsl_verify_encoded(encoded, encoded_length, GDSL_VERIFY_LEVEL_DOMAIN,
+                               &options, &encoded_report) == 0);
+    assert(encoded_report.error_count == 1);
+    assert(strcmp(encoded_report.diagnostics[0].message,
+                  "resource 1: read on device 0 queue 1 races with write on device 0 queue 0") == 0);
+    free(encoded);
+
+    /* A semaphore orders the upload before the download. */
+    const uint8_t signalled[] = {
+        0x01, 0x11, 0x00, 0x14, 0x01, 0x00, 0x00, 0x00,
+        0x0F, 0x05, 0x00, 0x00, 0x00,                   /* q0: signal 5 */
+        0x11, 0x01, 0x10, 0x05, 0x00, 0x00, 0x00,       /* q1: wait 5 */
+        0x15, 0x01, 0x00, 0x00, 0x00, 0x03, 0x04, 0x05};
+    verify_races(signalled, sizeof(signalled), &report);
+    print_report("race_signalled", &report);
+    assert(report.success);
+
+    /* So does a host fence wait on queue 0. */
+    const uint8_t fenced[] = {
+        0x01, 0x11, 0x00, 0x14, 0x01, 0x00, 0x00, 0x00, 0x03, 0x04,
+        0x01, 0x11, 0x01, 0x15, 0x01, 0x00, 0x00, 0x00, 0x03, 0x04, 0x05};
+    verify_races(fenced, sizeof(fenced), &report);
+    assert(report.success);
+
+    /* Concurrent reads are fine; a write after both must be ordered after
+     * each of them, and COPY_BUFFER writes its destination. */
+    const uint8_t reads[] = {
+        0x01, 0x11, 0x00, 0x15, 0x04, 0x00, 0x00, 0x00, /* q0: DOWNLOAD 4 */
+        0x11, 0x01, 0x15, 0x04, 0x00, 0x00, 0x00,       /* q1: DOWNLOAD 4 */
+        0x11, 0x00, 0x14, 0x04, 0x00, 0x00, 0x00,       /* q0: UPLOAD 4 */
+        0x11, 0x02, 0x16, 0x03, 0x00, 0x00, 0x00,       /* q2: COPY 3 -> 4 */
+        0x04, 0x00, 0x00, 0x00,
+        0x03, 0x04, 0x05};
+    verify_races(reads, sizeof(reads), &report);
+    print_report("race_reads", &report);
+    assert(report.error_count == 2);
+    assert(has_diagnostic(&report, "resource 4: write on device 0 queue 0 races with "
+                                   "read on device 0 queue 1"));
+    assert(has_diagnostic(&report, "resource 4: write on device 0 queue 2 races with "
+                                   "write on device 0 queue 0"));
+
+    /* Queues of different devices are distinct. */
+    const uint8_t devices[] = {
+        0x01, 0x12, 0x09, 0x00, 0x00, 0x00, 0x03, 0x04, 0x05, /* dev 0: ALLOC 9 */
+        0x0E, 0x01, 0x01, 0x13, 0x09, 0x00, 0x00, 0x00,       /* dev 1: FREE 9 */
+        0x03, 0x04, 0x05};
+    verify_races(devices, sizeof(devices), &report);
+    assert(report.success);
+    const uint8_t unordered_devices[] = {
+        0x01, 0x12, 0x09, 0x00, 0x00, 0x00, 0x03,
+        0x0E, 0x01, 0x01, 0x13, 0x09, 0x00, 0x00, 0x00, 0x03, 0x04, 0x05,
+        0x0E, 0x00, 0x04, 0x05};
+    verify_races(unordered_devices, sizeof(unordered_devices), &report);
+    assert(report.error_count == 1);
+    assert(has_diagnostic(&report, "resource 9: write on device 1 queue 0 races with "
+                                   "write on device 0 queue 0"));
+
+    /* A single queue never races with itself. */
+    const uint8_t single[] = {
+        0x01, 0x14, 0x01, 0x00, 0x00, 0x00, 0x15, 0x01, 0x00, 0x00, 0x00,
+        0x16, 0x01, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00,
+        0x03, 0x04, 0x05};
+    verify_races(single, sizeof(single), &report);
+    assert(report.success);
+
+    /* Past GDSL_RACE_MAX_QUEUES queues the rest go unchecked, with a warning. */
+    uint8_t many[1 + 70 * 7 + 3];
+    size_t n = 0;
+    many[n++] = 0x01;
+    for (uint8_t q = 0; q < 70; ++q) {
+        const uint8_t access[] = {0x11, q, 0x14, q, 0x00, 0x00, 0x00};
+        memcpy(many + n, access, sizeof(access));
+        n += sizeof(access);
+    }
+    many[n++] = 0x03;
+    many[n++] = 0x04;
+    many[n++] = 0x05;
+    verify_races(many, n, &report);
+    assert(report.error_count == 0);
+    assert(report.warning_count == 1);
+    assert(has_diagnostic(&report, "race detection covers the first 64 queues only"));
+}
+
+static void test_draw_validation(void) {
+    static gdsl_verify_report_t report;
+
+    /* Graphics pipeline using set 0 and vertex binding 0, then a compute
+     * pipeline using set 1. */
+    const uint8_t valid[] = {
+        0x01,
+        0x17, 0x00, 0x01, 0x01,                   /* PIPE_BIND graphics */
+        0x18, 0x00, 0x2A, 0x00, 0x00, 0x00,       /* SET_DESCRIPTOR 0 */
+        0x19, 0x00, 0x07, 0x00, 0x00, 0x00,       /* BIND_BUFFER vertex 0 */
+        0x19, 0x08, 0x08, 0x00, 0x00, 0x00,       /* BIND_BUFFER index */
+        0x1A,                                     /* BEGIN_PASS */
+        0x1F, 0x01, 0x00, 0x00, 0x00,             /* QUERY_BEGIN */
+        0x1C, 0x00, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00,
+        0x1D, 0x00, 0x00, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00,
+        0x20, 0x01, 0x00, 0x00, 0x00,             /* QUERY_END */
+        0x1B,                                     /* END_PASS */
+        0x17, 0x01, 0x02, 0x00,                   /* PIPE_BIND compute */
+        0x18, 0x01, 0x2B, 0x00, 0x00, 0x00,       /* SET_DESCRIPTOR 1 */
+        0x1E, 0x08, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+        0x03, 0x04, 0x05};
+    assert(gdsl_verify(valid, sizeof(valid), GDSL_VERIFY_LEVEL_PHASE, &report) == 0);
+    print_report("draw_valid", &report);
+    assert(report.success);
+
+    /* Each draw names the first thing it is missing. */
+    const uint8_t missing[] = {
+        0x01,
+        0x1C, 0x00, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, /* no pipeline */
+        0x17, 0x00, 0x01, 0x00,
+        0x1C, 0x00, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, /* no pass */
+        0x1A,
+        0x1C, 0x00, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, /* no set 0 */
+        0x18, 0x00, 0x2A, 0x00, 0x00, 0x00,
+        0x1C, 0x00, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, /* fine */
+        0x1D, 0x00, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, /* no index */
+        0x17, 0x01, 0x00, 0x00,
+        0x1E, 0x01, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+        0x03, 0x04, 0x05};
+    assert(gdsl_verify(missing, sizeof(missing), GDSL_VERIFY_LEVEL_PHASE, &report) == 0);
+    print_report("draw_missing", &report);
+    assert(report.error_count == 7);
+    assert(strcmp(report.diagnostics[0].message,
+                  "DRAW without a bound graphics pipeline") == 0);
+    assert(strcmp(report.diagnostics[1].message, "DRAW outside a render pass") == 0);
+    assert(strcmp(report.diagnostics[2].message,
+                  "DRAW without descriptor set 0 bound") == 0);
+    assert(strcmp(report.diagnostics[3].message,
+                  "DRAW_INDEXED without a bound index buffer") == 0);
+    assert(strcmp(report.diagnostics[4].message,
+                  "DISPATCH inside a render pass") == 0);
+    assert(strcmp(report.diagnostics[5].message, "SUBMIT inside a render pass") == 0);
+    assert(has_diagnostic(&report, "END_STREAM inside a render pass"));
+
+    /* Nesting counters; bindings end with the command buffer. */
+    const uint8_t nesting[] = {
+        0x01, 0x1B, 0x20, 0x00, 0x00, 0x00, 0x00,
+        0x1A, 0x1A, 0x1B, 0x1B,
+        0x1F, 0x00, 0x00, 0x00, 0x00, 0x1F, 0x01, 0x00, 0x00, 0x00,
+        0x17, 0x00, 0x00, 0x00,
+        0x03, 0x04,
+        0x01, 0x1A,
+        0x1C, 0x00, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00,
+        0x1B, 0x03, 0x04, 0x05};
+    assert(gdsl_verify(nesting, sizeof(nesting), GDSL_VERIFY_LEVEL_PHASE, &report) == 0);
+    print_report("draw_nesting", &report);
+    assert(report.error_count == 5);
+    assert(strcmp(report.diagnostics[0].message, "END_PASS without BEGIN_PASS") == 0);
+    assert(strcmp(report.diagnostics[1].message, "QUERY_END without QUERY_BEGIN") == 0);
+    assert(strcmp(report.diagnostics[2].message, "nested BEGIN_PASS not allowed") == 0);
+    assert(strcmp(report.diagnostics[3].message, "SUBMIT with 2 active queries") == 0);
+    assert(strcmp(report.diagnostics[4].message,
+                  "DRAW without a bound graphics pipeline") == 0);
+
+    /* Runs of draws: skipped once one passes, each reported otherwise, and
+     * the same through the encoded form. */
+    enum { DRAWS = 100 };
+    uint8_t runs[2][1 + 4 + 1 + DRAWS * 9 + 4];
+    for (int bound = 0; bound < 2; ++bound) {
+        size_t n = 0;
+        runs[bound][n++] = 0x01;
+        const uint8_t pipe[] = {0x17, (uint8_t)(bound ? 0x00 : 0x05), 0x00, 0x00};
+        memcpy(runs[bound] + n, pipe, sizeof(pipe));
+        n += sizeof(pipe);
+        runs[bound][n++] = 0x1A;
+        for (int d = 0; d < DRAWS; ++d) {
+            const uint8_t draw[] = {0x1C, (uint8_t)d, 0x00, 0x00, 0x00,
+                                    0x03, 0x00, 0x00, 0x00};
+            memcpy(runs[bound] + n, draw, sizeof(draw));
+            n += sizeof(draw);
+        }
+        const uint8_t tail[] = {0x1B, 0x03, 0x04, 0x05};
+        memcpy(runs[bound] + n, tail, sizeof(tail));
+        n += sizeof(tail);
+
+        assert(gdsl_verify(runs[bound], n, GDSL_VERIFY_LEVEL_PHASE, &report) == 0);
+        assert(report.instruction_count == 3 + DRAWS + 4);
+        assert(report.error_count == (bound ? 0 : 1 + DRAWS));
+
+        uint8_t *encoded = NULL;
+        size_t encoded_length = 0;
+        static gdsl_verify_report_t encoded_report;
+        assert(gdsl_encode(runs[bound], n, &encoded, &encoded_length) == 0);
+        assert(gdsl_verify_encoded(encoded, encoded_length, GDSL_VERIFY_LEVEL_PHASE,
+                                   NULL, &encoded_report) == 0);
+        assert(encoded_report.instruction_count == report.instruction_count);
+        assert(encoded_report.error_count == report.error_count);
+        free(encoded);
+    }
+
+    /* Binding rules start at PHASE level. */
+    assert(gdsl_verify(missing, sizeof(missing), GDSL_VERIFY_LEVEL_SYNTAX, &report) == 0);
+    assert(report.success);
+}
+
 int main(void) {
     test_valid_program();
     test_missing_begin();
     test_unknown_opcode();
     test_snapshot_constraints();
+    test_batch_matches_single();
+    test_early_exit_limits();
+    test_neutral_runs();
+    test_snapshot_index();
+    test_snapshot_resources();
+    test_aggregated_diagnostics();
+    test_collector_is_deterministic();
+    test_verify_file_windows();
+    test_multi_device_sync();
+    test_device_passes_match_serial();
+    test_race_detection();
+    test_draw_validation();
     puts("All verify tests completed.");
     return 0;
 }
@@ -0,0 +1,166 @@
+#include "gdsl/verifyd.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+static const uint8_t good_stream[] = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06};
+static const uint8_t bad_stream[] = {0x03, 0x04, 0x05, 0x06};
+
+static void *serve(void *arg) {
+    gdsl_verifyd_server_run((gdsl_verifyd_server_t *)arg);
+    return NULL;
+}
+
+static void *map_region(size_t size) {
+    void *region = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    assert(region != MAP_FAILED);
+    return region;
+}
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static void test_verify_through_daemon(void) {
+    size_t size = gdsl_verifyd_region_size(8, 4096);
+    void *region = map_region(size);
+    int rc = gdsl_verifyd_region_init(region, size, 8, 4096);
+    assert(rc == 0);
+
+    gdsl_pool_options_t pool_options;
+    memset(&pool_options, 0, sizeof(pool_options));
+    pool_options.thread_count = 2;
+    gdsl_pool_t *pool = NULL;
+    rc = gdsl_pool_create(&pool_options, &pool);
+    assert(rc == 0);
+
+    gdsl_verifyd_server_options_t options;
+    memset(&options, 0, sizeof(options));
+    options.pool = pool;
+    gdsl_verifyd_server_t *server = NULL;
+    rc = gdsl_verifyd_server_create(region, &options, &server);
+    assert(rc == 0);
+
+    pthread_t thread;
+    rc = pthread_create(&thread, NULL, serve, server);
+    assert(rc == 0);
+
+    gdsl_verifyd_report_t report;
+    rc = gdsl_verifyd_verify(region, good_stream, sizeof(good_stream),
+                             GDSL_VERIFY_LEVEL_DOMAIN, &report);
+    assert(rc == 0);
+    assert(report.success);
+    assert(report.instruction_count == sizeof(good_stream));
+    assert(!(report.flags & GDSL_VERIFYD_REPORT_CACHED));
+
+    rc = gdsl_verifyd_verify(region, bad_stream, sizeof(bad_stream),
+                             GDSL_VERIFY_LEVEL_PHASE, &report);
+    assert(rc == 0);
+    assert(!report.success);
+    assert(report.error_count > 0);
+    assert(report.first_error[0] != '\0');
+    printf("verifyd: first error at %llu: %s\n",
+           (unsigned long long)report.first_error_index, report.first_error);
+
+    /* Same stream and level again: served from the shared cache. */
+    double start = now_us();
+    const int rounds = 1000;
+    for (int i = 0; i < rounds; ++i) {
+        rc = gdsl_verifyd_verify(region, good_stream, sizeof(good_stream),
+                                 GDSL_VERIFY_LEVEL_DOMAIN, &report);
+        assert(rc == 0);
+        assert(report.success);
+        assert(report.flags & GDSL_VERIFYD_REPORT_CACHED);
+    }
+    printf("verifyd: cached round trip %.2f us\n", (now_us() - start) / rounds);
+
+    /* A different process attached to the same region. */
+    pid_t child = fork();
+    assert(child >= 0);
+    if (child == 0) {
+        gdsl_verifyd_slot_t slot;
+        if (gdsl_verifyd_acquire(region, sizeof(bad_stream), &slot) != 0) {
+            _exit(1);
+        }
+        memcpy(slot.data, bad_stream, sizeof(bad_stream));
+        gdsl_verifyd_report_t child_report;
+        if (gdsl_verifyd_submit(&slot, sizeof(bad_stream),
+                                GDSL_VERIFY_LEVEL_PHASE, &child_report) != 0) {
+            _exit(1);
+        }
+        _exit(child_report.success == 0 &&
+                      (child_report.flags & GDSL_VERIFYD_REPORT_CACHED)
+                  ? 0
+                  : 1);
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    /* Oversized submissions are rejected before they reach the ring. */
+    gdsl_verifyd_slot_t slot;
+    assert(gdsl_verifyd_acquire(region, 8192, &slot) != 0);
+
+    gdsl_verifyd_request_stop(region);
+    pthread_join(thread, NULL);
+    gdsl_verifyd_server_destroy(server);
+    gdsl_pool_destroy(pool);
+    munmap(region, size);
+}
+
+typedef struct {
+    void *region;
+    int rc;
+} waiting_client_t;
+
+static void *submit_and_wait(void *arg) {
+    waiting_client_t *client = (waiting_client_t *)arg;
+    gdsl_verifyd_report_t report;
+    client->rc = gdsl_verifyd_verify(client->region, good_stream, sizeof(good_stream),
+                                     GDSL_VERIFY_LEVEL_DOMAIN, &report);
+    return NULL;
+}
+
+static void test_stop_withdraws_waiting_client(void) {
+    size_t size = gdsl_verifyd_region_size(2, 4096);
+    void *region = map_region(size);
+    int rc = gdsl_verifyd_region_init(region, size, 2, 4096);
+    assert(rc == 0);
+    gdsl_verifyd_server_t *server = NULL;
+    rc = gdsl_verifyd_server_create(region, NULL, &server);
+    assert(rc == 0);
+
+    /* No server is polling: the client waits until stop is requested. */
+    waiting_client_t client = {region, 0};
+    pthread_t thread;
+    rc = pthread_create(&thread, NULL, submit_and_wait, &client);
+    assert(rc == 0);
+    struct timespec pause = {0, 20000000L};
+    nanosleep(&pause, NULL);
+    gdsl_verifyd_request_stop(region);
+    pthread_join(thread, NULL);
+    assert(client.rc == -1);
+
+    /* The withdrawn slot's ring entry is drained without a report; popping
+     * it is what frees the slot, so the ring never holds it twice. */
+    assert(gdsl_verifyd_server_poll(server) == 0);
+
+    gdsl_verifyd_server_destroy(server);
+    munmap(region, size);
+}
+
+int main(void) {
+    test_verify_through_daemon();
+    test_stop_withdraws_waiting_client();
+    puts("All verifyd tests completed.");
+    return 0;
+}
@@ -0,0 +1,204 @@
+#define _FILE_OFFSET_BITS 64
+
+#include "gdsl/bisect.h"
+#include "gdsl/merkle.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * Finds the first checkpoint at which two replays diverge. Root logs hold one
+ * heap_merkle_root per checkpoint, 16 bytes each (lo then hi, little-endian),
+ * and only the records the search probes are read. Given the two runs' heap
+ * dumps at that checkpoint, it also lists the pages that differ. Exits with 0
+ * when the runs agree, 1 when they diverge and 2 on errors.
+ */
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+            "usage: %s --roots-a FILE --roots-b FILE\n"
+            "          [--heap-a FILE --heap-b FILE] [--page-size BYTES]\n",
+            argv0);
+}
+
+typedef struct {
+    int fd[2];
+} roots_probe_t;
+
+static int read_root(int fd, size_t checkpoint, gdsl_merkle_hash_t *out) {
+    uint8_t record[16];
+    if (pread(fd, record, sizeof(record), (off_t)checkpoint * 16) != (ssize_t)sizeof(record)) {
+        return -1;
+    }
+    out->lo = 0;
+    out->hi = 0;
+    for (int i = 0; i < 8; ++i) {
+        out->lo |= (uint64_t)record[i] << (8 * i);
+        out->hi |= (uint64_t)record[8 + i] << (8 * i);
+    }
+    return 0;
+}
+
+static int probe_roots(void *ctx, size_t checkpoint) {
+    roots_probe_t *probe = (roots_probe_t *)ctx;
+    gdsl_merkle_hash_t a;
+    gdsl_merkle_hash_t b;
+    if (read_root(probe->fd[0], checkpoint, &a) != 0 ||
+        read_root(probe->fd[1], checkpoint, &b) != 0) {
+        return -1;
+    }
+    return gdsl_merkle_equal(a, b);
+}
+
+static int open_roots(const char *path, size_t *out_count) {
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        perror(path);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+    *out_count = (size_t)st.st_size / 16;
+    return fd;
+}
+
+/* Maps path read-only and builds its page tree. */
+static int build_tree(const char *path, size_t page_size, gdsl_merkle_tree_t *out) {
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        perror(path);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+    size_t length = (size_t)st.st_size;
+    void *heap = NULL;
+    if (length > 0) {
+        heap = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (heap == MAP_FAILED) {
+            perror(path);
+            close(fd);
+            return -1;
+        }
+    }
+    close(fd);
+    int rc = gdsl_merkle_build((const uint8_t *)heap, length, page_size, NULL, out);
+    if (heap) {
+        munmap(heap, length);
+    }
+    return rc;
+}
+
+static int report_pages(const char *heap_a, const char *heap_b, size_t page_size) {
+    gdsl_merkle_tree_t a;
+    gdsl_merkle_tree_t b;
+    if (build_tree(heap_a, page_size, &a) != 0) {
+        return -1;
+    }
+    if (build_tree(heap_b, page_size, &b) != 0) {
+        gdsl_merkle_destroy(&a);
+        return -1;
+    }
+    size_t count = 0;
+    int rc = gdsl_bisect_pages(&a, &b, NULL, 0, &count);
+    size_t *pages = rc == 0 ? (size_t *)malloc((count ? count : 1) * sizeof(size_t)) : NULL;
+    if (pages && gdsl_bisect_pages(&a, &b, pages, count, &count) == 0) {
+        printf("%zu page(s) of %zu bytes differ:", count, a.page_size);
+        for (size_t i = 0; i < count; ++i) {
+            printf(" %zu", pages[i]);
+        }
+        printf("\n");
+    } else {
+        rc = -1;
+    }
+    free(pages);
+    gdsl_merkle_destroy(&a);
+    gdsl_merkle_destroy(&b);
+    return rc;
+}
+
+int main(int argc, char **argv) {
+    const char *roots_a = NULL;
+    const char *roots_b = NULL;
+    const char *heap_a = NULL;
+    const char *heap_b = NULL;
+    unsigned long page_size = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            return 2;
+        }
+        if (strcmp(argv[i], "--roots-a") == 0) {
+            roots_a = argv[++i];
+        } else if (strcmp(argv[i], "--roots-b") == 0) {
+            roots_b = argv[++i];
+        } else if (strcmp(argv[i], "--heap-a") == 0) {
+            heap_a = argv[++i];
+        } else if (strcmp(argv[i], "--heap-b") == 0) {
+            heap_b = argv[++i];
+        } else if (strcmp(argv[i], "--page-size") == 0) {
+            page_size = strtoul(argv[++i], NULL, 0);
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (!roots_a || !roots_b || (!heap_a != !heap_b)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    roots_probe_t probe;
+    memset(&probe, 0, sizeof(probe));
+    size_t count_a = 0;
+    size_t count_b = 0;
+    probe.fd[0] = open_roots(roots_a, &count_a);
+    probe.fd[1] = probe.fd[0] >= 0 ? open_roots(roots_b, &count_b) : -1;
+    if (probe.fd[1] < 0) {
+        if (probe.fd[0] >= 0) {
+            close(probe.fd[0]);
+        }
+        return 2;
+    }
+    size_t count = count_a < count_b ? count_a : count_b;
+    size_t checkpoint = GDSL_BISECT_NONE;
+    size_t probes = 0;
+    int rc = gdsl_bisect_search(count, probe_roots, &probe, &checkpoint, &probes);
+    close(probe.fd[0]);
+    close(probe.fd[1]);
+    if (rc != 0) {
+        fprintf(stderr, "gdsl-bisect: cannot read the root logs\n");
+        return 2;
+    }
+
+    if (checkpoint == GDSL_BISECT_NONE) {
+        printf("%zu checkpoint(s) agree (%zu probes)\n", count, probes);
+        if (count_a != count_b) {
+            printf("runs have %zu and %zu checkpoints\n", count_a, count_b);
+            return 1;
+        }
+        return 0;
+    }
+    if (checkpoint == 0) {
+        printf("first divergence at checkpoint 0 (%zu probes)\n", probes);
+    } else {
+        printf("first divergence at checkpoint %zu, in the interval after checkpoint %zu "
+               "(%zu probes)\n",
+               checkpoint, checkpoint - 1, probes);
+    }
+    if (heap_a && report_pages(heap_a, heap_b, page_size) != 0) {
+        fprintf(stderr, "gdsl-bisect: cannot compare the heaps\n");
+        return 2;
+    }
+    return 1;
+}
@@ -0,0 +1,108 @@
+#include "gdsl/codegen.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+            "usage: %s --opcodes NAME[,NAME...] --prefix IDENT --output FILE.c\n"
+            "          [--header FILE.h] [--level syntax|phase|domain]\n",
+            argv0);
+}
+
+static const char *base_name(const char *path) {
+    const char *slash = strrchr(path, '/');
+    return slash ? slash + 1 : path;
+}
+
+static size_t parse_opcodes(char *list, uint8_t *opcodes, size_t max_opcodes) {
+    size_t count = 0;
+    for (char *name = strtok(list, ","); name; name = strtok(NULL, ",")) {
+        int opcode = gdsl_codegen_opcode(name);
+        if (opcode < 0 || count == max_opcodes) {
+            fprintf(stderr, "gdsl-verifier-gen: unknown opcode %s\n", name);
+            return 0;
+        }
+        opcodes[count++] = (uint8_t)opcode;
+    }
+    return count;
+}
+
+int main(int argc, char **argv) {
+    char *opcode_list = NULL;
+    const char *prefix = NULL;
+    const char *output = NULL;
+    const char *header = NULL;
+    gdsl_verify_level_t level = GDSL_VERIFY_LEVEL_DOMAIN;
+
+    for (int i = 1; i < argc; ++i) {
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            return 2;
+        }
+        if (strcmp(argv[i], "--opcodes") == 0) {
+            opcode_list = argv[++i];
+        } else if (strcmp(argv[i], "--prefix") == 0) {
+            prefix = argv[++i];
+        } else if (strcmp(argv[i], "--output") == 0) {
+            output = argv[++i];
+        } else if (strcmp(argv[i], "--header") == 0) {
+            header = argv[++i];
+        } else if (strcmp(argv[i], "--level") == 0) {
+            const char *name = argv[++i];
+            if (strcmp(name, "syntax") == 0) {
+                level = GDSL_VERIFY_LEVEL_SYNTAX;
+            } else if (strcmp(name, "phase") == 0) {
+                level = GDSL_VERIFY_LEVEL_PHASE;
+            } else if (strcmp(name, "domain") == 0) {
+                level = GDSL_VERIFY_LEVEL_DOMAIN;
+            } else {
+                usage(argv[0]);
+                return 2;
+            }
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (!opcode_list || !prefix || !output) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    uint8_t opcodes[256];
+    size_t opcode_count = parse_opcodes(opcode_list, opcodes, 256);
+    if (opcode_count == 0) {
+        return 2;
+    }
+
+    FILE *source = fopen(output, "w");
+    FILE *header_file = header ? fopen(header, "w") : NULL;
+    if (!source || (header && !header_file)) {
+        perror("gdsl-verifier-gen");
+        return 1;
+    }
+
+    gdsl_codegen_options_t options;
+    memset(&options, 0, sizeof(options));
+    options.level = level;
+    options.opcodes = opcodes;
+    options.opcode_count = opcode_count;
+    options.prefix = prefix;
+    options.header_name = header ? base_name(header) : NULL;
+
+    int rc = gdsl_codegen_verifier(&options, source, header_file);
+    if (fclose(source) != 0 || (header_file && fclose(header_file) != 0)) {
+        rc = -1;
+    }
+    if (rc != 0) {
+        fprintf(stderr, "gdsl-verifier-gen: generation failed\n");
+        remove(output);
+        if (header) {
+            remove(header);
+        }
+        return 1;
+    }
+    return 0;
+}
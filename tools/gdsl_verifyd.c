@@ -0,0 +1,99 @@
+#include "gdsl/pool.h"
+#include "gdsl/verifyd.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+static void *g_region;
+
+static void handle_signal(int signo) {
+    (void)signo;
+    gdsl_verifyd_request_stop(g_region);
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+            "usage: %s [--name /shm-name] [--slots N] [--slot-size BYTES]\n"
+            "          [--threads N] [--cache N]\n",
+            argv0);
+}
+
+int main(int argc, char **argv) {
+    const char *name = "/gdsl-verifyd";
+    unsigned long slots = 64;
+    unsigned long slot_size = 1ul << 20;
+    unsigned long threads = 0;
+    unsigned long cache = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            return 2;
+        }
+        if (strcmp(argv[i], "--name") == 0) {
+            name = argv[++i];
+        } else if (strcmp(argv[i], "--slots") == 0) {
+            slots = strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--slot-size") == 0) {
+            slot_size = strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--threads") == 0) {
+            threads = strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--cache") == 0) {
+            cache = strtoul(argv[++i], NULL, 0);
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (slots == 0 || slots > (1ul << 16) || slot_size > 0xFFFFFFFFul) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    size_t region_size = 0;
+    if (gdsl_verifyd_map(name, 1, (uint32_t)slots, (uint32_t)slot_size,
+                         &g_region, &region_size) != 0) {
+        perror("gdsl-verifyd: shm");
+        return 1;
+    }
+
+    gdsl_pool_options_t pool_options;
+    memset(&pool_options, 0, sizeof(pool_options));
+    pool_options.thread_count = threads;
+    gdsl_pool_t *pool = NULL;
+    if (gdsl_pool_create(&pool_options, &pool) != 0) {
+        fprintf(stderr, "gdsl-verifyd: cannot create pool\n");
+        gdsl_verifyd_unmap(g_region, region_size);
+        shm_unlink(name);
+        return 1;
+    }
+
+    gdsl_verifyd_server_options_t options;
+    memset(&options, 0, sizeof(options));
+    options.pool = pool;
+    options.cache_entries = cache;
+    gdsl_verifyd_server_t *server = NULL;
+    if (gdsl_verifyd_server_create(g_region, &options, &server) != 0) {
+        fprintf(stderr, "gdsl-verifyd: cannot create server\n");
+        gdsl_pool_destroy(pool);
+        gdsl_verifyd_unmap(g_region, region_size);
+        shm_unlink(name);
+        return 1;
+    }
+
+    signal(SIGINT, handle_signal);
+    signal(SIGTERM, handle_signal);
+    fprintf(stderr, "gdsl-verifyd: serving %s (%lu slots x %lu bytes, %zu threads)\n",
+            name, slots, slot_size, gdsl_pool_thread_count(pool));
+
+    int rc = gdsl_verifyd_server_run(server);
+
+    gdsl_verifyd_server_destroy(server);
+    gdsl_pool_destroy(pool);
+    gdsl_verifyd_unmap(g_region, region_size);
+    shm_unlink(name);
+    return rc == 0 ? 0 : 1;
+}